@@ -0,0 +1,49 @@
+// Measures the per-element cost of passing operator callables as std::function delegates
+// (the previous signatures, still accepted) against passing the lambda itself as a template parameter.
+// See harness.h for the command line options.
+#include <functional>
+#include <string>
+#include "harness.h"
+#include "../lib/linq.h"
+
+using namespace std;
+
+typedef struct { int id, proj_id; double score; string name; } record;
+
+int main(int argc, char **argv) {
+	bench::suite suite(argc, argv);
+	const size_t count = 1 << 20;
+	linq::array<int> ints(count);
+	linq::array<record> records(count);
+	for (size_t c = 0; c < count; c++) {
+		ints[c] = int((c * 2654435761u) % 1000);
+		records[c] = { int(c), int(c % 64), double(ints[c]) / 3.0, "record" };
+	}
+	auto name = [count](const char *op, const char *impl) { return string(op) + "/" + to_string(count) + "/" + impl; };
+
+	linq::array<int>::conditional int_cond = [](const int &item) { return item < 500; };
+	suite.run(name("where<int>", "delegate"), count, [&] { bench::keep(ints.where(int_cond).size()); });
+	suite.run(name("where<int>", "template"), count, [&] { bench::keep(ints.where([](const int &item) { return item < 500; }).size()); });
+
+	linq::array<int>::conversion<int> int_conv = [](const int &item) { return item * 3 + 1; };
+	suite.run(name("select<int>", "delegate"), count, [&] { bench::keep(ints.select<int>(int_conv).size()); });
+	suite.run(name("select<int>", "template"), count, [&] { bench::keep(ints.select([](const int &item) { return item * 3 + 1; }).size()); });
+
+	linq::array<int>::conditional int_miss = [](const int &item) { return item < 0; };
+	suite.run(name("first_or_default<int>", "delegate"), count, [&] { bench::keep(ints.first_or_default(0, int_miss)); });
+	suite.run(name("first_or_default<int>", "template"), count, [&] { bench::keep(ints.first_or_default(0, [](const int &item) { return item < 0; })); });
+
+	linq::array<record>::conditional rec_cond = [](const record &item) { return item.proj_id == 7; };
+	suite.run(name("where<record>", "delegate"), count, [&] { bench::keep(records.where(rec_cond).size()); });
+	suite.run(name("where<record>", "template"), count, [&] { bench::keep(records.where([](const record &item) { return item.proj_id == 7; }).size()); });
+
+	linq::array<record>::conversion<double> rec_conv = [](const record &item) { return item.score * 2.0; };
+	suite.run(name("select<record>", "delegate"), count, [&] { bench::keep(records.select<double>(rec_conv).size()); });
+	suite.run(name("select<record>", "template"), count, [&] { bench::keep(records.select([](const record &item) { return item.score * 2.0; }).size()); });
+
+	linq::array<record>::conditional rec_miss = [](const record &item) { return item.id < 0; };
+	suite.run(name("first_or_default<record>", "delegate"), count, [&] { bench::keep(records.first_or_default(records[0], rec_miss).id); });
+	suite.run(name("first_or_default<record>", "template"), count, [&] { bench::keep(records.first_or_default(records[0], [](const record &item) { return item.id < 0; }).id); });
+
+	return suite.finish();
+}
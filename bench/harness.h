@@ -0,0 +1,146 @@
+// Minimal microbenchmark harness shared by the benchmarks in this directory.
+// Measures the time per element of a case, and counts every heap allocation made while it runs with the global
+// operator new/delete replaced by linq.h under LINQ_CHECK_ALLOCATIONS. As the replacements are not inline, include
+// this header from exactly one translation unit of each benchmark executable, before anything else includes linq.h.
+//
+// Every benchmark executable built on it accepts:
+//   --filter <text>     only run the cases whose name contains the text
+//   --csv <path>        also write the results as CSV, one row per case
+//   --baseline <path>   compare against the CSV of an earlier run, and exit with 1 if any case got slower
+//   --tolerance <frac>  relative slowdown allowed before a case counts as a regression (default 0.10)
+//   --min-time <ms>     minimum measured time per case (default 50)
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#define LINQ_CHECK_ALLOCATIONS
+#include "../lib/linq.h"
+
+// The counters only move when linq.h saw LINQ_CHECK_ALLOCATIONS the first time it was included
+static_assert(sizeof(linq::allocation_guard) != 0, "include harness.h before linq.h");
+
+namespace bench {
+	using ::linq::core::allocations;
+
+	/// <summary>Stops the optimizer from discarding the result of a benchmarked expression.</summary>
+	template<class _Ty>
+	inline void keep(const _Ty &value) {
+		asm volatile("" : : "r"(&value) : "memory");
+	}
+
+	struct result {
+		::std::string name;      // operator/type/size/implementation
+		size_t elements;
+		double ns_per_element;
+		double bytes_per_run;
+		double allocs_per_run;
+	};
+
+	class suite {
+	public:
+		suite(int argc, char **argv) : _tolerance(0.10), _min_time(50.0) {
+			for (int i = 1; i < argc; i++) {
+				::std::string arg = argv[i];
+				const char *value = i + 1 < argc ? argv[i + 1] : "";
+				if (arg == "--filter") { _filter = value; i++; }
+				else if (arg == "--csv") { _csv = value; i++; }
+				else if (arg == "--baseline") { _baseline = value; i++; }
+				else if (arg == "--tolerance") { _tolerance = ::std::atof(value); i++; }
+				else if (arg == "--min-time") { _min_time = ::std::atof(value); i++; }
+				else {
+					::std::fprintf(stderr, "usage: %s [--filter text] [--csv path] [--baseline path] [--tolerance frac] [--min-time ms]\n", argv[0]);
+					::std::exit(2);
+				}
+			}
+			::std::printf("%-44s %12s %14s %10s\n", "case", "ns/element", "bytes/run", "allocs/run");
+		}
+
+		/// <summary>Whether a case with the given name would be run, so expensive inputs can be skipped.</summary>
+		bool selected(const ::std::string &name) const { return _filter.empty() || name.find(_filter) != ::std::string::npos; }
+
+		/// <summary>
+		/// Runs the case repeatedly until at least the minimum time has passed, then records its averages.
+		/// </summary>
+		template<class _Fn>
+		void run(const ::std::string &name, size_t elements, _Fn &&fn) {
+			if (!selected(name)) return;
+			fn(); // warm up
+			size_t runs = 0;
+			size_t count_before = allocations().count, bytes_before = allocations().bytes;
+			auto start = ::std::chrono::steady_clock::now();
+			double elapsed = 0;
+			do {
+				fn();
+				runs++;
+				elapsed = ::std::chrono::duration<double, ::std::milli>(::std::chrono::steady_clock::now() - start).count();
+			} while (elapsed < _min_time || runs < 3);
+			result res;
+			res.name = name;
+			res.elements = elements;
+			res.ns_per_element = elapsed * 1e6 / (double(elements) * runs);
+			res.bytes_per_run = double(allocations().bytes - bytes_before) / runs;
+			res.allocs_per_run = double(allocations().count - count_before) / runs;
+			::std::printf("%-44s %12.3f %14.0f %10.1f\n", name.c_str(), res.ns_per_element, res.bytes_per_run, res.allocs_per_run);
+			::std::fflush(stdout);
+			_results.push_back(res);
+		}
+
+		/// <summary>Writes the CSV and compares against the baseline, if requested.</summary>
+		/// <returns>Process exit code: 1 if a regression was found against the baseline; otherwise 0.</returns>
+		int finish() const {
+			if (!_csv.empty()) {
+				::std::ofstream out(_csv);
+				out << "name,elements,ns_per_element,bytes_per_run,allocs_per_run\n";
+				for (auto &res : _results) {
+					out << res.name << ',' << res.elements << ',' << res.ns_per_element << ',' << res.bytes_per_run << ',' << res.allocs_per_run << '\n';
+				}
+			}
+			if (_baseline.empty()) return 0;
+			::std::ifstream in(_baseline);
+			if (!in) {
+				::std::fprintf(stderr, "unable to read baseline %s\n", _baseline.c_str());
+				return 2;
+			}
+			::std::map<::std::string, result> previous;
+			::std::string line;
+			::std::getline(in, line); // header
+			while (::std::getline(in, line)) {
+				::std::istringstream row(line);
+				result res;
+				::std::string field;
+				::std::getline(row, res.name, ',');
+				::std::getline(row, field, ','); res.elements = ::std::strtoull(field.c_str(), nullptr, 10);
+				::std::getline(row, field, ','); res.ns_per_element = ::std::atof(field.c_str());
+				::std::getline(row, field, ','); res.bytes_per_run = ::std::atof(field.c_str());
+				::std::getline(row, field, ','); res.allocs_per_run = ::std::atof(field.c_str());
+				previous[res.name] = res;
+			}
+			int regressions = 0;
+			::std::printf("\n%-44s %12s %12s %8s\n", "compared to baseline", "before ns", "after ns", "change");
+			for (auto &res : _results) {
+				auto found = previous.find(res.name);
+				if (found == previous.end()) continue;
+				double change = res.ns_per_element / found->second.ns_per_element - 1.0;
+				// More allocations than before is a regression regardless of timing noise
+				bool slower = change > _tolerance || res.allocs_per_run > found->second.allocs_per_run;
+				::std::printf("%-44s %12.3f %12.3f %+7.1f%%%s\n", res.name.c_str(), found->second.ns_per_element, res.ns_per_element, change * 100.0, slower ? "  REGRESSION" : "");
+				regressions += slower;
+			}
+			::std::printf("%d regression(s)\n", regressions);
+			return regressions ? 1 : 0;
+		}
+
+	private:
+		::std::string _filter, _csv, _baseline;
+		double _tolerance, _min_time;
+		::std::vector<result> _results;
+	};
+}
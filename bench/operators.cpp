@@ -0,0 +1,485 @@
+// Compares every linq::array operator, in both its method and macro forms, against the raw loop or STL algorithm
+// it replaces, over several element types and list sizes. See harness.h for the command line options.
+#define LINQ_USE_MACROS
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "harness.h"
+#include "../lib/linq.h"
+
+using namespace std;
+
+struct point { int id; float x, y; };
+struct named { int id; string name; };
+
+// Every element type exposes an integer key in [0, 1000) through key(), which the benchmarked lambdas work on.
+// The keys 1000 and 1001 are reserved for the sentinels searched for by first and last.
+inline int key(int item) { return item; }
+inline int key(double item) { return int(item); }
+inline int key(const point &item) { return item.id; }
+inline int key(const named &item) { return item.id; }
+
+template<class _Ty> _Ty make(int key);
+template<> int make<int>(int key) { return key; }
+template<> double make<double>(int key) { return key + 0.25; }
+template<> point make<point>(int key) { return { key, key * 0.5f, key * 2.0f }; }
+template<> named make<named>(int key) { return { key, "element #" + to_string(key) + " of the benchmark" }; }
+
+// Ordering for linq::ascending/descending and std::sort
+inline bool operator<(const point &left, const point &right) { return left.id < right.id; }
+inline bool operator>(const point &left, const point &right) { return left.id > right.id; }
+inline bool operator<(const named &left, const named &right) { return left.name < right.name; }
+inline bool operator>(const named &left, const named &right) { return left.name > right.name; }
+
+template<class _Ty> const char *type_name();
+template<> const char *type_name<int>() { return "int"; }
+template<> const char *type_name<double>() { return "double"; }
+template<> const char *type_name<point>() { return "point"; }
+template<> const char *type_name<named>() { return "named"; }
+
+// Structured conditions are only vectorized for arithmetic elements
+template<class _Ty, class _Name>
+void run_structured(bench::suite &suite, const linq::array<_Ty> &items, _Name &name, true_type) {
+	suite.run(name("where_structured", "linq"), items.size(), [&] { bench::keep(items.where(linq::item < 500)); });
+	suite.run(name("where_structured", "macro"), items.size(), [&] { bench::keep(FROM(items) WHERE_ITEM < 500 END); });
+	suite.run(name("where_range", "linq"), items.size(), [&] { bench::keep(items.where(linq::between(250, 750))); });
+	suite.run(name("where_range", "loop"), items.size(), [&] {
+		vector<_Ty> result;
+		for (auto &item : items) {
+			if (item >= 250 && item <= 750) result.push_back(item);
+		}
+		bench::keep(result);
+	});
+}
+template<class _Ty, class _Name>
+void run_structured(bench::suite&, const linq::array<_Ty>&, _Name&, false_type) {}
+
+// Aggregations are vectorized for int and double, and summed through the lazy query for the other types
+template<class _Ty, class _Name>
+void run_aggregates(bench::suite &suite, const linq::array<_Ty> &items, _Name &name, true_type) {
+	suite.run(name("sum", "linq"), items.size(), [&] { bench::keep(items.sum()); });
+	suite.run(name("sum", "par"), items.size(), [&] { bench::keep(items.sum(linq::par)); });
+	suite.run(name("sum", "accumulate"), items.size(), [&] { bench::keep(accumulate(items.begin(), items.end(), _Ty())); });
+	suite.run(name("minmax", "linq"), items.size(), [&] { bench::keep(items.minmax()); });
+	suite.run(name("minmax", "minmax_element"), items.size(), [&] { bench::keep(*minmax_element(items.begin(), items.end()).first); });
+	suite.run(name("count_structured", "linq"), items.size(), [&] { bench::keep(items.count(linq::between(250, 750))); });
+	suite.run(name("count_structured", "count_if"), items.size(), [&] {
+		bench::keep(count_if(items.begin(), items.end(), [](const _Ty &item) { return item >= 250 && item <= 750; }));
+	});
+}
+template<class _Ty, class _Name>
+void run_aggregates(bench::suite &suite, const linq::array<_Ty> &items, _Name &name, false_type) {
+	suite.run(name("sum", "linq"), items.size(), [&] { bench::keep(items.sum([](const _Ty &item) { return key(item); })); });
+	suite.run(name("sum", "loop"), items.size(), [&] {
+		int total = 0;
+		for (auto &item : items) total += key(item);
+		bench::keep(total);
+	});
+}
+
+// Size of the right list of the predicate joins, which compare every pair of elements
+static const int join_width = 16;
+
+template<class _Ty>
+void run_type(bench::suite &suite, size_t size) {
+	string prefix = string(type_name<_Ty>()) + "/" + to_string(size) + "/";
+	auto name = [&](const char *op, const char *impl) { return string(op) + "/" + prefix + impl; };
+
+	linq::array<_Ty> items;
+	items.reserve(size);
+	for (size_t c = 0; c < size; c++) {
+		items.push_back(make<_Ty>(int((c * 2654435761u) % 1000)));
+	}
+	// Sentinels at each end, so first and last search the whole list
+	items.back() = make<_Ty>(1000);
+	items.front() = make<_Ty>(1001);
+	linq::array<_Ty> right;
+	for (int c = 0; c < join_width; c++) {
+		right.push_back(make<_Ty>(c));
+	}
+
+	// where
+	suite.run(name("where", "linq"), size, [&] { bench::keep(items.where([](const _Ty &item) { return key(item) < 500; })); });
+	suite.run(name("where", "macro"), size, [&] { bench::keep(FROM(items) WHERE { return key(item) < 500; } END); });
+	suite.run(name("where", "loop"), size, [&] {
+		vector<_Ty> result;
+		for (auto &item : items) {
+			if (key(item) < 500) result.push_back(item);
+		}
+		bench::keep(result);
+	});
+
+	run_structured(suite, items, name, is_arithmetic<_Ty>());
+	run_aggregates(suite, items, name, is_arithmetic<_Ty>());
+
+	// select
+	suite.run(name("select", "linq"), size, [&] { bench::keep(items.select([](const _Ty &item) { return key(item) * 3; })); });
+	suite.run(name("select", "macro"), size, [&] { bench::keep(FROM(items) SELECT(int) { return key(item) * 3; } END); });
+	suite.run(name("select", "loop"), size, [&] {
+		vector<int> result(items.size());
+		for (size_t c = 0; c < items.size(); c++) result[c] = key(items[c]) * 3;
+		bench::keep(result);
+	});
+
+	// orderby sorts in place, so each run sorts a fresh copy of the list
+	suite.run(name("orderby_ascending", "linq"), size, [&] { auto copy = items; bench::keep(copy.orderby(linq::ascending)); });
+	suite.run(name("orderby_ascending", "macro"), size, [&] { bench::keep(FROM(items) ORDERBY(ASCENDING) END); });
+	suite.run(name("orderby_ascending", "std_sort"), size, [&] { vector<_Ty> copy(items); sort(copy.begin(), copy.end(), std::less<_Ty>()); bench::keep(copy); });
+	suite.run(name("orderby_descending", "linq"), size, [&] { auto copy = items; bench::keep(copy.orderby(linq::descending)); });
+	suite.run(name("orderby_descending", "macro"), size, [&] { bench::keep(FROM(items) ORDERBY(DESCENDING) END); });
+	suite.run(name("orderby_descending", "std_sort"), size, [&] { vector<_Ty> copy(items); sort(copy.begin(), copy.end(), std::greater<_Ty>()); bench::keep(copy); });
+
+	// orderby on a selected key, against a comparator which selects the key from both sides of every comparison
+	auto by_key = [](const _Ty &item) { return key(item); };
+	suite.run(name("orderby_key", "linq"), size, [&] { auto copy = items; bench::keep(copy.orderby_key(by_key)); });
+	suite.run(name("orderby_key", "macro"), size, [&] { bench::keep(FROM(items) ORDERBY(ASCENDING(KEY(int) { return key(item); })) END); });
+	suite.run(name("orderby_key", "comparator"), size, [&] {
+		auto copy = items;
+		bench::keep(copy.orderby([](const _Ty &left, const _Ty &right) { return key(left) < key(right); }));
+	});
+	suite.run(name("orderby_key", "std_stable_sort"), size, [&] {
+		vector<_Ty> copy(items);
+		stable_sort(copy.begin(), copy.end(), [](const _Ty &left, const _Ty &right) { return key(left) < key(right); });
+		bench::keep(copy);
+	});
+	suite.run(name("orderby_keys", "linq"), size, [&] {
+		auto copy = items;
+		bench::keep(copy.orderby(linq::descending([](const _Ty &item) { return key(item) % 10; }), linq::ascending(by_key)));
+	});
+	suite.run(name("orderby_keys", "std_stable_sort"), size, [&] {
+		vector<_Ty> copy(items);
+		stable_sort(copy.begin(), copy.end(), [](const _Ty &left, const _Ty &right) {
+			return key(left) % 10 != key(right) % 10 ? key(left) % 10 > key(right) % 10 : key(left) < key(right);
+		});
+		bench::keep(copy);
+	});
+
+	// A copy, where, select and orderby chain, with every intermediate array taken from the heap or from an arena
+	// which is released and reused on every run
+	linq::arena scope;
+	suite.run(name("chain", "heap"), size, [&] {
+		bench::keep(linq::array<_Ty>(items).where([](const _Ty &item) { return key(item) < 500; }).select([](const _Ty &item) { return key(item) * 3; }).orderby(linq::descending));
+	});
+	suite.run(name("chain", "arena"), size, [&] {
+		{
+			auto result = linq::from(items, scope).where([](const _Ty &item) { return key(item) < 500; }).select([](const _Ty &item) { return key(item) * 3; }).orderby(linq::descending);
+			bench::keep(result);
+		}
+		scope.release();
+	});
+	// The same chain written into buffers which are refilled on every run, with the temporaries kept in a query context,
+	// so nothing is allocated once the first run has sized the buffers
+	linq::query_context context;
+	linq::array<_Ty> filtered;
+	linq::array<int> projected, ordered;
+	suite.run(name("chain", "into"), size, [&] {
+		items.where([](const _Ty &item) { return key(item) < 500; }, linq::into(filtered, context));
+		filtered.select([](const _Ty &item) { return key(item) * 3; }, linq::into(projected, context));
+		bench::keep(projected.orderby(linq::descending, linq::into(ordered, context)));
+	});
+
+	// groupby, into the 1000 distinct keys
+	suite.run(name("groupby", "linq"), size, [&] { bench::keep(items.groupby([](const _Ty &item) { return key(item); })); });
+	suite.run(name("groupby", "macro"), size, [&] { bench::keep(FROM(items) GROUPBY(int) { return key(item); } END); });
+	suite.run(name("groupby", "unordered_map"), size, [&] {
+		unordered_map<int, vector<_Ty>> groups;
+		for (auto &item : items) groups[key(item)].push_back(item);
+		bench::keep(groups);
+	});
+	suite.run(name("groupby_summary", "linq"), size, [&] {
+		bench::keep(items.groupby([](const _Ty &item) { return key(item); }, linq::summarize([](const _Ty &item) { return key(item) * 3; })));
+	});
+	suite.run(name("groupby_summary", "unordered_map"), size, [&] {
+		struct summary { size_t count; int sum, min, max; };
+		unordered_map<int, summary> groups;
+		for (auto &item : items) {
+			int value = key(item) * 3;
+			auto found = groups.emplace(key(item), summary{ 0, 0, value, value }).first;
+			found->second.count++;
+			found->second.sum += value;
+			found->second.min = min(found->second.min, value);
+			found->second.max = max(found->second.max, value);
+		}
+		bench::keep(groups);
+	});
+
+	// top 100, against sorting everything and slicing
+	suite.run(name("top_k", "linq"), size, [&] { bench::keep(items.top_k(100, linq::descending)); });
+	suite.run(name("top_k", "par"), size, [&] { bench::keep(items.top_k(linq::par, 100, linq::descending)); });
+	suite.run(name("top_k", "lazy_macro"), size, [&] { bench::keep((LAZY_FROM(items) ORDERBY(DESCENDING) TAKE(100) END).to_vector()); });
+	suite.run(name("top_k", "sort_take"), size, [&] { auto copy = items; bench::keep(copy.orderby(linq::descending).take(100)); });
+	suite.run(name("top_k", "partial_sort"), size, [&] {
+		vector<_Ty> copy(items);
+		size_t count = min<size_t>(100, copy.size());
+		partial_sort(copy.begin(), copy.begin() + count, copy.end(), std::greater<_Ty>());
+		copy.resize(count);
+		bench::keep(copy);
+	});
+
+	// join, where each element of the list pairs with exactly one element of the right list
+	suite.run(name("pair_join", "linq"), size, [&] {
+		bench::keep(items.join(right, [](const _Ty &left, const _Ty &right) { return key(left) % join_width == key(right); }));
+	});
+	suite.run(name("pair_join", "macro"), size, [&] {
+		bench::keep(FROM(items) PAIR_JOIN(_Ty) right ON { return key(left) % join_width == key(right); } END);
+	});
+	suite.run(name("pair_join", "loop"), size, [&] {
+		vector<linq::core::merge_pair<_Ty, _Ty>> result;
+		for (auto &l : items) {
+			for (auto &r : right) {
+				if (key(l) % join_width == key(r)) result.push_back({ l, r });
+			}
+		}
+		bench::keep(result);
+	});
+	suite.run(name("merge_join", "linq"), size, [&] {
+		bench::keep(items.join(right,
+			[](const _Ty &left, const _Ty &right) { return key(left) + key(right); },
+			[](const _Ty &left, const _Ty &right) { return key(left) % join_width == key(right); }));
+	});
+	suite.run(name("merge_join", "macro"), size, [&] {
+		bench::keep(FROM(items) MERGE_JOIN(_Ty, int) right INTO(int) { return key(left) + key(right); } ON { return key(left) % join_width == key(right); } END);
+	});
+	suite.run(name("merge_join", "loop"), size, [&] {
+		vector<int> result;
+		for (auto &l : items) {
+			for (auto &r : right) {
+				if (key(l) % join_width == key(r)) result.push_back(key(l) + key(r));
+			}
+		}
+		bench::keep(result);
+	});
+	suite.run(name("equi_join", "linq"), size, [&] {
+		bench::keep(items.join(right,
+			[](const _Ty &left) { return key(left) % join_width; },
+			[](const _Ty &right) { return key(right); },
+			[](const _Ty &left, const _Ty &right) { return key(left) + key(right); }));
+	});
+	suite.run(name("equi_join", "macro"), size, [&] {
+		bench::keep(FROM(items) EQUI_JOIN(_Ty) right LEFT_KEY { return key(left) % join_width; } RIGHT_KEY { return key(right); } INTO(int) { return key(left) + key(right); } END);
+	});
+	vector<int> joined;
+	suite.run(name("equi_join", "into"), size, [&] {
+		bench::keep(items.join(right,
+			[](const _Ty &left) { return key(left) % join_width; },
+			[](const _Ty &right) { return key(right); },
+			[](const _Ty &left, const _Ty &right) { return key(left) + key(right); }, linq::into(joined, context)));
+	});
+	suite.run(name("equi_join", "unordered_map"), size, [&] {
+		unordered_multimap<int, const _Ty*> index;
+		for (auto &r : right) index.emplace(key(r), &r);
+		vector<int> result;
+		for (auto &l : items) {
+			auto range = index.equal_range(key(l) % join_width);
+			for (auto it = range.first; it != range.second; ++it) result.push_back(key(l) + key(*it->second));
+		}
+		bench::keep(result);
+	});
+
+	// first/last, searching the whole list for the sentinel at the far end, and the defaults missing entirely
+	_Ty fallback = make<_Ty>(0);
+	suite.run(name("first", "linq"), size, [&] { bench::keep(items.first([](const _Ty &item) { return key(item) == 1000; })); });
+	suite.run(name("first", "macro"), size, [&] { bench::keep(FROM(items) FIRST { return key(item) == 1000; } END); });
+	suite.run(name("first", "find_if"), size, [&] { bench::keep(*find_if(items.begin(), items.end(), [](const _Ty &item) { return key(item) == 1000; })); });
+	suite.run(name("first_or_default", "linq"), size, [&] { bench::keep(items.first_or_default(fallback, [](const _Ty &item) { return key(item) < 0; })); });
+	suite.run(name("first_or_default", "macro"), size, [&] { bench::keep(FROM(items) FIRST_OR_DEFAULT(fallback) { return key(item) < 0; } END); });
+	suite.run(name("first_or_default", "find_if"), size, [&] {
+		auto found = find_if(items.begin(), items.end(), [](const _Ty &item) { return key(item) < 0; });
+		bench::keep(found == items.end() ? fallback : *found);
+	});
+	// How first_or_default used to miss: by catching the error thrown from first
+	suite.run(name("first_or_default", "try_catch"), size, [&] {
+		_Ty result;
+		try { result = items.first([](const _Ty &item) { return key(item) < 0; }); }
+		catch (...) { result = fallback; }
+		bench::keep(result);
+	});
+	// The non-throwing searches, hitting the sentinel at the far end and missing entirely
+	suite.run(name("find_first_hit", "linq"), size, [&] { bench::keep(items.find_first([](const _Ty &item) { return key(item) == 1000; })); });
+	suite.run(name("find_first_hit", "lazy"), size, [&] { bench::keep(items.lazy().find_first([](const _Ty &item) { return key(item) == 1000; })); });
+	suite.run(name("find_first_miss", "linq"), size, [&] { bench::keep(items.find_first([](const _Ty &item) { return key(item) < 0; })); });
+	suite.run(name("find_first_miss", "lazy"), size, [&] { bench::keep(items.lazy().find_first([](const _Ty &item) { return key(item) < 0; })); });
+	suite.run(name("index_of_miss", "linq"), size, [&] { bench::keep(items.index_of([](const _Ty &item) { return key(item) < 0; })); });
+	suite.run(name("none", "linq"), size, [&] { bench::keep(items.none([](const _Ty &item) { return key(item) < 0; })); });
+	// Looking up the sentinel by key, by scanning with first against through indexes built once up front. These count
+	// lookups rather than elements.
+	auto hashed = items.build_index(by_key);
+	auto sorted = items.build_sorted_index(by_key);
+	suite.run(name("index_lookup", "first"), 1, [&] { bench::keep(items.first([](const _Ty &item) { return key(item) == 1000; })); });
+	suite.run(name("index_lookup", "hashed"), 1, [&] { bench::keep(*hashed.find(1000)); });
+	suite.run(name("index_lookup", "sorted"), 1, [&] { bench::keep(*sorted.find(1000)); });
+	suite.run(name("last", "linq"), size, [&] { bench::keep(items.last([](const _Ty &item) { return key(item) == 1001; })); });
+	suite.run(name("last", "macro"), size, [&] { bench::keep(FROM(items) LAST { return key(item) == 1001; } END); });
+	suite.run(name("last", "find_if"), size, [&] { bench::keep(*find_if(items.rbegin(), items.rend(), [](const _Ty &item) { return key(item) == 1001; })); });
+	suite.run(name("last_or_default", "linq"), size, [&] { bench::keep(items.last_or_default(fallback, [](const _Ty &item) { return key(item) < 0; })); });
+	suite.run(name("last_or_default", "macro"), size, [&] { bench::keep(FROM(items) LAST_OR_DEFAULT(fallback) { return key(item) < 0; } END); });
+	suite.run(name("last_or_default", "find_if"), size, [&] {
+		auto found = find_if(items.rbegin(), items.rend(), [](const _Ty &item) { return key(item) < 0; });
+		bench::keep(found == items.rend() ? fallback : *found);
+	});
+}
+
+// A wide telemetry record, of which the filter and sum below only read two fields
+struct telemetry { int id, device; double value; char payload[176]; };
+
+// Filtering on one field of wide records and summing another, stored as rows and as columns
+void run_columns(bench::suite &suite, size_t size) {
+	auto name = [size](const char *op, const char *impl) { return string(op) + "/telemetry/" + to_string(size) + "/" + impl; };
+	if (!suite.selected(name("columns", "rows")) && !suite.selected(name("columns", "loop")) && !suite.selected(name("columns", "linq"))) return;
+	linq::array<telemetry> rows;
+	rows.reserve(size);
+	for (size_t c = 0; c < size; c++) {
+		rows.push_back({ int(c), int(c * 7919 % 1000), double(c % 1000) * 0.5, {} });
+	}
+	auto cols = linq::columns_of(rows, &telemetry::id, &telemetry::device, &telemetry::value);
+	suite.run(name("columns", "rows"), size, [&] {
+		bench::keep(rows.where([](const telemetry &item) { return item.device < 50; }).sum([](const telemetry &item) { return item.value; }));
+	});
+	suite.run(name("columns", "loop"), size, [&] {
+		double total = 0;
+		for (auto &item : rows) {
+			if (item.device < 50) total += item.value;
+		}
+		bench::keep(total);
+	});
+	suite.run(name("columns", "linq"), size, [&] { bench::keep(cols.where(&telemetry::device, linq::item < 50).sum(&telemetry::value)); });
+}
+
+// Reconciling a large list of ids against a small one, as a nightly diff would: half of the small list's ids are found
+// in the large one, and the large one holds each id about twice
+void run_sets(bench::suite &suite, size_t size) {
+	auto name = [size](const char *op, const char *impl) { return string(op) + "/ids/" + to_string(size) + "/" + impl; };
+	bool any = false;
+	for (const char *op : { "distinct", "intersect", "except" }) {
+		for (const char *impl : { "linq", "par", "unordered_set", "orderby_unique" }) any = any || suite.selected(name(op, impl));
+	}
+	if (!any) return;
+	linq::array<long long> ids, known;
+	ids.reserve(size);
+	for (size_t c = 0; c < size; c++) {
+		ids.push_back((long long)((c * 2654435761u) % (size / 2 + 1)) * 7919);
+	}
+	for (size_t c = 0; c < size / 16; c++) {
+		known.push_back((long long)(c * 2) * 7919 + (c % 2));
+	}
+
+	suite.run(name("distinct", "linq"), size, [&] { bench::keep(ids.distinct()); });
+	suite.run(name("distinct", "par"), size, [&] { bench::keep(ids.distinct(linq::par)); });
+	suite.run(name("distinct", "unordered_set"), size, [&] {
+		unordered_set<long long> seen;
+		vector<long long> result;
+		for (long long id : ids) {
+			if (seen.insert(id).second) result.push_back(id);
+		}
+		bench::keep(result);
+	});
+	// How duplicates used to be removed, losing the original order
+	suite.run(name("distinct", "orderby_unique"), size, [&] {
+		auto copy = ids;
+		copy.orderby(linq::ascending);
+		copy.erase(unique(copy.begin(), copy.end()), copy.end());
+		bench::keep(copy);
+	});
+	suite.run(name("intersect", "linq"), size, [&] { bench::keep(ids.intersect(known)); });
+	suite.run(name("intersect", "par"), size, [&] { bench::keep(ids.intersect(linq::par, known)); });
+	suite.run(name("intersect", "unordered_set"), size, [&] {
+		unordered_set<long long> other(known.begin(), known.end()), seen;
+		vector<long long> result;
+		for (long long id : ids) {
+			if (other.count(id) && seen.insert(id).second) result.push_back(id);
+		}
+		bench::keep(result);
+	});
+	suite.run(name("except", "linq"), size, [&] { bench::keep(ids.except(known)); });
+	suite.run(name("except", "par"), size, [&] { bench::keep(ids.except(linq::par, known)); });
+	suite.run(name("except", "unordered_set"), size, [&] {
+		unordered_set<long long> other(known.begin(), known.end()), seen;
+		vector<long long> result;
+		for (long long id : ids) {
+			if (!other.count(id) && seen.insert(id).second) result.push_back(id);
+		}
+		bench::keep(result);
+	});
+}
+
+// Rolling aggregates of a time series over windows of 256 samples, sliding one sample at a time: rescanning every window
+// in a select, as before, against the incremental windows of an array and of a lazy query
+struct reading { long long time; double value; };
+void run_windows(bench::suite &suite, size_t size) {
+	const size_t width = 256;
+	auto name = [size](const char *op, const char *impl) { return string(op) + "/readings/" + to_string(size) + "/" + impl; };
+	bool any = false;
+	for (const char *op : { "window_sum", "window_max" }) {
+		for (const char *impl : { "rescan", "linq", "lazy" }) any = any || suite.selected(name(op, impl));
+	}
+	if (!any) return;
+	linq::array<reading> readings;
+	readings.reserve(size);
+	for (size_t c = 0; c < size; c++) {
+		readings.push_back({ (long long)c * 1000, double((c * 2654435761u) % 10007) * 0.01 });
+	}
+	auto value = [](const reading &item) { return item.value; };
+	auto starts = linq::array<size_t>(size - width + 1);
+	for (size_t c = 0; c < starts.size(); c++) starts[c] = c;
+
+	suite.run(name("window_sum", "rescan"), size, [&] {
+		bench::keep(starts.select([&](size_t start) {
+			double total = 0;
+			for (size_t c = start; c < start + width; c++) total += readings[c].value;
+			return total;
+		}));
+	});
+	suite.run(name("window_sum", "linq"), size, [&] { bench::keep(readings.window(width, 1).sum(value)); });
+	suite.run(name("window_sum", "lazy"), size, [&] { bench::keep(readings.lazy().window(width, 1).sum(value).to_vector()); });
+	suite.run(name("window_max", "rescan"), size, [&] {
+		bench::keep(starts.select([&](size_t start) {
+			double found = readings[start].value;
+			for (size_t c = start + 1; c < start + width; c++) found = max(found, readings[c].value);
+			return found;
+		}));
+	});
+	suite.run(name("window_max", "linq"), size, [&] { bench::keep(readings.window(width, 1).max(value)); });
+	suite.run(name("window_max", "lazy"), size, [&] { bench::keep(readings.lazy().window(width, 1).max(value).to_vector()); });
+}
+
+// A static table of status codes, searched for the first server error: copied into a linq::array on every call as
+// before, queried in place at runtime as a fixed_array, and folded entirely at compile time. These count lookups, made
+// in batches so the clock is not read around each one.
+struct is_server_error { constexpr bool operator()(int code) const { return code >= 500; } };
+static constexpr int status_codes[] = { 100, 101, 200, 201, 202, 204, 206, 301, 302, 303, 304, 307, 308, 400, 401, 403,
+	404, 405, 406, 408, 409, 410, 411, 412, 413, 414, 415, 416, 417, 418, 421, 422, 423, 424, 425, 426, 428, 429, 431, 451,
+	500, 501, 502, 503, 504, 505 };
+void run_fixed(bench::suite &suite) {
+	auto name = [](const char *impl) { return string("fixed_lookup/status/46/") + impl; };
+	const size_t count = sizeof(status_codes) / sizeof(status_codes[0]);
+	const size_t batch = 1000;
+	suite.run(name("from"), batch, [&] {
+		for (size_t c = 0; c < batch; c++) bench::keep(linq::from(status_codes, count).first(is_server_error()));
+	});
+	suite.run(name("fixed"), batch, [&] {
+		for (size_t c = 0; c < batch; c++) bench::keep(linq::fixed(status_codes).first(is_server_error()));
+	});
+	suite.run(name("constexpr"), batch, [&] {
+		for (size_t c = 0; c < batch; c++) {
+			constexpr int code = linq::fixed(status_codes).first(is_server_error());
+			bench::keep(code);
+		}
+	});
+}
+
+int main(int argc, char **argv) {
+	bench::suite suite(argc, argv);
+	run_fixed(suite);
+	for (size_t size : { size_t(1) << 10, size_t(1) << 16, size_t(1) << 20 }) {
+		run_type<int>(suite, size);
+		run_type<double>(suite, size);
+		run_type<point>(suite, size);
+		run_type<named>(suite, size);
+		run_columns(suite, size);
+		run_sets(suite, size);
+		run_windows(suite, size);
+	}
+	return suite.finish();
+}
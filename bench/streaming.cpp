@@ -0,0 +1,116 @@
+// Compares querying a file through linq::from_file, which streams it in chunks, against loading every record into a
+// linq::array first and querying that. bytes/run shows the memory each approach allocates per pass over the file.
+// Also compares querying records as a producer thread makes them, through a linq::channel, against collecting them into
+// a shared vector and querying a snapshot of it. See harness.h for the command line options.
+#define LINQ_USE_MMAP
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "harness.h"
+#include "../lib/linq.h"
+
+using namespace std;
+
+struct reading { int sensor; float value; };
+
+inline reading parse(const char *line) {
+	char *next;
+	reading result;
+	result.sensor = int(strtol(line, &next, 10));
+	result.value = strtof(next + 1, nullptr);
+	return result;
+}
+
+int main(int argc, char **argv) {
+	bench::suite suite(argc, argv);
+	const string text_path = "streaming.csv.tmp", binary_path = "streaming.bin.tmp";
+	for (size_t size : { size_t(1) << 16, size_t(1) << 20 }) {
+		{
+			ofstream text(text_path), binary(binary_path, ios::binary);
+			for (size_t c = 0; c < size; c++) {
+				reading item = { int((c * 2654435761u) % 1000), float(c % 977) * 0.5f };
+				text << item.sensor << ',' << item.value << '\n';
+				binary.write(reinterpret_cast<const char*>(&item), sizeof(item));
+			}
+		}
+		string suffix = "/" + to_string(size) + "/";
+		auto by_value = [](const reading &item) { return double(item.value); };
+		auto hot = [](const reading &item) { return item.sensor < 100; };
+
+		// Text, parsed line by line
+		suite.run("filter_sum_text" + suffix + "from_file", size, [&] {
+			bench::keep(linq::from_file(text_path, linq::lines([](const linq::text_line &line) { return parse(line.c_str()); })).where(hot).sum(by_value));
+		});
+		suite.run("filter_sum_text" + suffix + "load_array", size, [&] {
+			ifstream in(text_path);
+			linq::array<reading> items;
+			string line;
+			while (getline(in, line)) items.push_back(parse(line.c_str()));
+			bench::keep(items.where(hot).sum(by_value));
+		});
+		suite.run("filter_sum_text" + suffix + "getline_loop", size, [&] {
+			ifstream in(text_path);
+			string line;
+			double total = 0;
+			while (getline(in, line)) {
+				reading item = parse(line.c_str());
+				if (hot(item)) total += item.value;
+			}
+			bench::keep(total);
+		});
+
+		// Binary, fixed size records
+		suite.run("filter_sum_binary" + suffix + "from_file", size, [&] {
+			bench::keep(linq::from_file(binary_path, linq::records<reading>()).where(hot).sum(by_value));
+		});
+		suite.run("filter_sum_binary" + suffix + "load_array", size, [&] {
+			ifstream in(binary_path, ios::binary);
+			in.seekg(0, ios::end);
+			linq::array<reading> items(size_t(in.tellg()) / sizeof(reading));
+			in.seekg(0);
+			in.read(reinterpret_cast<char*>(items.data()), streamsize(items.size() * sizeof(reading)));
+			bench::keep(items.where(hot).sum(by_value));
+		});
+		suite.run("filter_sum_binary" + suffix + "mapped_file", size, [&] {
+			bench::keep(linq::mapped_file<reading>(binary_path).where(hot).sum(by_value));
+		});
+
+		// Records made by a producer thread
+		auto produce = [size](size_t c) { return reading{ int((c * 2654435761u) % 1000), float(c % 977) * 0.5f }; };
+		suite.run("filter_sum_produced" + suffix + "channel", size, [&] {
+			linq::channel<reading> channel;
+			thread producer([&] {
+				{
+					linq::channel<reading>::writer out(channel);
+					for (size_t c = 0; c < size; c++) out.push(produce(c));
+				}
+				channel.close();
+			});
+			bench::keep(channel.lazy().where(hot).sum(by_value));
+			producer.join();
+		});
+		suite.run("filter_sum_produced" + suffix + "snapshot", size, [&] {
+			mutex lock;
+			vector<reading> shared;
+			thread producer([&] {
+				for (size_t c = 0; c < size; c++) {
+					lock_guard<mutex> guard(lock);
+					shared.push_back(produce(c));
+				}
+			});
+			producer.join();
+			vector<reading> snapshot;
+			{
+				lock_guard<mutex> guard(lock);
+				snapshot = shared;
+			}
+			bench::keep(linq::from(snapshot).where(hot).sum(by_value));
+		});
+	}
+	remove(text_path.c_str());
+	remove(binary_path.c_str());
+	return suite.finish();
+}
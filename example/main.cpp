@@ -40,9 +40,27 @@ int main() {
 	// Select the evens and the convert the array to a vector
 	vec = FROM(nums, 10) WHERE { return item % 2 == 0; }  TO_VECTOR END;
 
+	// Parallel versions of the operators produce the same results in the same order, using all cores
+	auto par_evens = linq::from(nums, 10).where(linq::par, [](int item) { return item % 2 == 0; }).orderby(linq::par, linq::descending);
+	auto par_descs = par_evens.select(linq::par, [](int item) -> description { return { item, "even" }; });
+	// Sorting a temporary hands back the sorted array itself, so the chain can be iterated directly
+	for (int item : linq::from(nums, 10).where(linq::par, [](int item) { return item % 2 == 1; }).orderby(linq::par, linq::descending)) {
+		cout << item << ' ';
+	}
+	cout << endl;
+
+	// Lazy version of the odds and evens queries. Nothing is evaluated until the terminal at the end of the chain
+	vec = linq::lazy(nums, 10).where([](auto item) { return item % 2 == 1; }).orderby(linq::descending).to_vector();
+	vec = LAZY_FROM(nums, 10) WHERE { return item % 2 == 0; } ORDERBY(DESCENDING) TO_VECTOR END;
+	// Lazy queries can also be iterated directly, evaluating a single element at a time
+	for (auto desc : LAZY_FROM(nums, 10) WHERE { return item > 5; } SELECT(description) { return { item, "big" }; } END) {
+		cout << desc.i << ' ' << desc.desc << endl;
+	}
+
 	typedef struct { int id, proj_id; string name; } Employee;
 	typedef struct { int id; string name; } Project;
 	typedef struct { struct { int id; string name; } employee; string proj_name; } EmployeeProject;
+	typedef struct { int proj_id; size_t employees; } ProjectSize;
 	Employee employees[3] = { { 0, 0, "Joe" }, { 1, 1, "Jane" }, { 2, 1, "Alex" } };
 	vector<Project> projects = { { 0, "Financial Inc." }, { 1, "Contracts R Us" } };
 	// First method of joining using the MERGE_JOIN
@@ -67,5 +85,26 @@ int main() {
 		.join<Project>(projects, [](auto left, auto right) -> bool { return left.proj_id == right.id; }) // left/right condition
 		.select<EmployeeProject>([](auto item) ->EmployeeProject { return { { item.left.id, item.left.name }, item.right.name }; });
 
+	// Equi-join on matching keys. Hashes the smaller list instead of comparing every pair
+	empProjs = linq::from(employees, 3)
+		.join(projects,
+			[](const Employee &left) { return left.proj_id; }, // left key
+			[](const Project &right) { return right.id; }, // right key
+			[](const Employee &left, const Project &right) -> EmployeeProject { return { { left.id, left.name }, right.name }; });
+	// Macro version of the equi-join
+	empProjs = FROM(employees, 3)
+		EQUI_JOIN(Project) projects
+		LEFT_KEY { return left.proj_id; }
+		RIGHT_KEY { return right.id; }
+		INTO(EmployeeProject) { return { { left.id, left.name }, right.name }; }
+		END;
+	// Count the employees of each project with a group join
+	auto projSizes = FROM(projects)
+		GROUP_JOIN(Employee) linq::from(employees, 3)
+		LEFT_KEY { return left.id; }
+		RIGHT_KEY { return right.proj_id; }
+		INTO(ProjectSize) { return { left.id, right.size() }; }
+		END;
+
 	return 0;
 }
@@ -16,64 +16,139 @@
 /// <summary>Performs an item selection which is expected to transform the data in some way.</summary>
 /// <param name="type">The new type being created and returned for the new array.</param>
 /// <example>SELECT(int) { return str.size(); }</example>
-#define SELECT(type) END.select<type>([](auto __LINQ_ELEM__) -> type
+#define SELECT(type) END.template select<type>([](const auto &__LINQ_ELEM__) -> type
 
 /// <summary>Performs a conditional for filtering the list.</summary>
 /// <example>WHERE { return item > 10; }</example>
-#define WHERE END.where([](auto __LINQ_ELEM__) -> bool
+#define WHERE END.where([](const auto &__LINQ_ELEM__) -> bool
+
+/// <summary>
+/// Performs a structured conditional for filtering the list, comparing each item against constants with <see cref="ITEM"/>.
+/// On arrays of int, float and double it is evaluated with vector instructions.
+/// </summary>
+/// <example>WHERE_ITEM > 10 END</example>
+/// <example>WHERE_ITEM >= low && ITEM < high END</example>
+#define WHERE_ITEM END.where(::linq::item
+/// <summary>The item being tested in a structured conditional. See <see cref="WHERE_ITEM"/>.</summary>
+#define ITEM ::linq::item
 
 /// <summary>Performs a sort on the list. Can be given the predefined ASCENDING or DESCENDING for comparable types, or any predicate.</summary>
 /// <param name="pred">Predicate used for comparing the two items for which should go first.</param>
 /// <example>ORDERBY(ASCENDING)</example>
 /// <example>ORDERBY(PREDICATE { return left > right; })</example>
+/// <example>ORDERBY(DESCENDING(KEY(int) { return item.score; }))</example>
 #define ORDERBY(pred) END.orderby(pred
+/// <summary>Adds a less significant key to the key sort directly before it, in a lazy query.</summary>
+/// <param name="order">Key created with ASCENDING or DESCENDING.</param>
+/// <example>LAZY_FROM(list) ORDERBY(DESCENDING(KEY(int) { return item.score; })) THENBY(ASCENDING(KEY(int) { return item.id; })) END</example>
+#define THENBY(order) END.thenby(order
+
+/// <summary>Groups the list by the key returned from the lambda body that follows.</summary>
+/// <param name="type">Type of the key.</param>
+/// <example>GROUPBY(int) { return item.id; }</example>
+#define GROUPBY(type) END.template groupby<type>([](const auto &__LINQ_ELEM__) -> type
+
+/// <summary>Keeps the first items of the list. In a lazy query, directly after <see cref="ORDERBY"/> only those items are ever sorted.</summary>
+/// <param name="count">Maximum number of items to be kept.</param>
+/// <example>LAZY_FROM(list) ORDERBY(DESCENDING) TAKE(10) END</example>
+#define TAKE(count) END.take(count
+/// <summary>Discards the first items of the list.</summary>
+/// <param name="count">Number of items to be discarded.</param>
+#define SKIP(count) END.skip(count
+/// <summary>Keeps the items of the list up to the first which does not satisfy the condition in the lambda body that follows.</summary>
+#define TAKE_WHILE END.take_while([](const auto &__LINQ_ELEM__) -> bool
+/// <summary>Keeps the first items of the list by the predicate, in order, without sorting the whole list.</summary>
+/// <param name="count">Maximum number of items to be kept.</param>
+/// <param name="pred">Predicate used for comparing the two items for which should go first.</param>
+/// <example>TOP_K(10, DESCENDING)</example>
+#define TOP_K(count, pred) END.top_k(count, pred
 
 /// <summary>Helper for creating a predicate lambda for the ORDERBY macro.</summary>
 /// <see cref="ORDERBY"/>
-#define PREDICATE [](auto __LINQ_LEFT__, auto __LINQ_RIGHT__) -> bool
+#define PREDICATE [](const auto &__LINQ_LEFT__, const auto &__LINQ_RIGHT__) -> bool
+/// <summary>Helper for creating a key selector lambda for ASCENDING or DESCENDING in the ORDERBY and THENBY macros.</summary>
+/// <param name="type">Type of the key.</param>
+/// <see cref="ORDERBY"/>
+#define KEY(type) [](const auto &__LINQ_ELEM__) -> type
 
 /// <summary>Performs a join on the current list and the provided list. This results in an array of <see cref="linq::core::merge_pair"/>.</summary>
 /// <param name="type">The type contained within the list to be joined.</param>
 /// <example>JOIN(int) nums</example>
-#define PAIR_JOIN(type) END.join<type>(
+#define PAIR_JOIN(type) END.template join<type>(
 
 /// <summary>Performs a join on the current list and the provided list. Unlike <see cref="JOIN"/> it requires the <see cref="INTO"/> macro to create a merger of the two paired elements.</summary>
 /// <param name="type">The type contained within the list to be joined.</param>
 /// <param name="merge_type">The new type to be created for each joined pair</param>
 /// <example>MERGE_JOIN(int, myPair) nums INTO { return { left, right }; }</example>
-#define MERGE_JOIN(type, merge_type) END.join<type, merge_type>(
+#define MERGE_JOIN(type, merge_type) END.template join<type, merge_type>(
+
+/// <summary>
+/// Performs an equi-join on the current list and the provided list, matching elements whose <see cref="LEFT_KEY"/> and <see cref="RIGHT_KEY"/> are equal.
+/// Uses a hash or merge join rather than comparing every pair, and requires the <see cref="INTO"/> macro to merge the matched elements.
+/// </summary>
+/// <param name="type">The type contained within the list to be joined.</param>
+/// <example>EQUI_JOIN(Project) projects LEFT_KEY { return left.proj_id; } RIGHT_KEY { return right.id; } INTO(myPair) { return { left, right }; }</example>
+#define EQUI_JOIN(type) END.template join<type>(
+/// <summary>
+/// Performs a left outer equi-join. As <see cref="EQUI_JOIN"/>, but elements without a match are merged once with a null <c>right</c> pointer.
+/// </summary>
+/// <example>LEFT_JOIN(Project) projects LEFT_KEY { return left.proj_id; } RIGHT_KEY { return right.id; } INTO(myPair) { return { left, right ? right->name : "" }; }</example>
+#define LEFT_JOIN(type) END.template left_join<type>(
+/// <summary>
+/// Performs a full outer equi-join on a <see cref="linq::array"/>. As <see cref="LEFT_JOIN"/>, but both <c>left</c> and <c>right</c> are pointers,
+/// and unmatched elements of the joined list are merged with a null <c>left</c> pointer.
+/// </summary>
+#define OUTER_JOIN(type) END.template outer_join<type>(
+/// <summary>
+/// Performs a group join. Each element is merged once with a range (<c>right</c>) over all elements of the provided list with an equal key.
+/// </summary>
+/// <example>GROUP_JOIN(Employee) employees LEFT_KEY { return left.id; } RIGHT_KEY { return right.proj_id; } INTO(size_t) { return right.size(); }</example>
+#define GROUP_JOIN(type) END.template group_join<type>(
+/// <summary>Selects the key of the elements of the current list for <see cref="EQUI_JOIN"/>, <see cref="LEFT_JOIN"/>, <see cref="OUTER_JOIN"/> and <see cref="GROUP_JOIN"/>.</summary>
+#define LEFT_KEY , [](const auto &__LINQ_LEFT__)
+/// <summary>Selects the key of the elements of the joined list for <see cref="EQUI_JOIN"/>, <see cref="LEFT_JOIN"/>, <see cref="OUTER_JOIN"/> and <see cref="GROUP_JOIN"/>.</summary>
+#define RIGHT_KEY , [](const auto &__LINQ_RIGHT__)
 
 /// <summary>
 /// (Optional) Performs a conditional check between the left and right during either a <see cref="JOIN"/> or <see cref="MERGE_JOIN"/>.
 /// Note: For <see cref="MERGE_JOIN"/>, must come after the <see cref="INTO"/> statement
 /// </summary>
 /// <example>JOIN(obj) myObjects ON { return left.ref_id == right.id; }</example>
-#define ON , [](auto __LINQ_LEFT__, auto __LINQ_RIGHT__) -> bool
+#define ON , [](const auto &__LINQ_LEFT__, const auto &__LINQ_RIGHT__) -> bool
 
 /// <summary>Used with <see cref="MERGE_JOIN"/> to define how the paired items are merged into a new type.</summary>
 /// <param name="type">The type to be created from the merged items.</param>
 /// <example>MERGE_JOIN(int, myPair) nums INTO { return { left, right }; }</example>
-#define INTO(type) , [](auto __LINQ_LEFT__, auto __LINQ_RIGHT__) -> type
+#define INTO(type) , [](const auto &__LINQ_LEFT__, const auto &__LINQ_RIGHT__) -> type
 
 /// <summary>Simple helper macro for calling <see cref="linq::from"/> and needed for starting a LINQ query when using the defined macros.</summary>
 /// <example>FROM(vecOfItems)</example>
 /// <example>FROM(cArray, count)</example>
 #define FROM(param, ...) ::linq::from(param,##__VA_ARGS__
 
+/// <summary>
+/// Starts a deferred LINQ query with <see cref="linq::lazy"/>. The source is not copied and every following operator
+/// is only evaluated once the query reaches a terminal (<see cref="TO_VECTOR"/>, <see cref="TO_ARRAY"/>, <see cref="FIRST"/>,
+/// a range-based for loop, or assignment to a <see cref="linq::array"/>).
+/// </summary>
+/// <example>LAZY_FROM(vecOfItems)</example>
+/// <example>LAZY_FROM(cArray, count)</example>
+#define LAZY_FROM(param, ...) ::linq::lazy(param,##__VA_ARGS__
+
 /// <summary>
 /// Searches the array for the first item which satisfies the provided condition.
 /// Throws <see cref="std::logic_error"/> if the condition is never satisfied.
 /// </summary>
 /// <exception cref="std::logic_error">Thrown if no items satisfy the condition.</exception>
 /// <example>FROM(nums) FIRST { return item % 2; }</example>
-#define FIRST END.first([](auto item) -> bool
+#define FIRST END.first([](const auto &__LINQ_ELEM__) -> bool
 /// <summary>
 /// Searches the array for the first item which satisfies the provided condition.
 /// Returns the provided <paramref name="defaultValue"/> if the condition is never satisfied.
 /// </summary>
 /// <param name="defaultValue">Default value to be returned if no items satisfy the condition.</param>
 /// <example>FROM(nums) FIRST_OR_DEFAULT(42) { return item % 2; }</example>
-#define FIRST_OR_DEFAULT(defaultValue) END.first_or_default(defaultValue, [](auto item) -> bool
+#define FIRST_OR_DEFAULT(defaultValue) END.first_or_default(defaultValue, [](const auto &__LINQ_ELEM__) -> bool
 
 /// <summary>
 /// Searches the array for the last item which satisfies the provided condition.
@@ -81,20 +156,66 @@
 /// </summary>
 /// <exception cref="std::logic_error">Thrown if no items satisfy the condition.</exception>
 /// <example>FROM(nums) LAST { return item % 2; }</example>
-#define LAST END.last([](auto item) -> bool
+#define LAST END.last([](const auto &__LINQ_ELEM__) -> bool
 /// <summary>
 /// Searches the array for the last item which satisfies the provided condition.
 /// Returns the provided <paramref name="defaultValue"/> if the condition is never satisfied.
 /// </summary>
 /// <param name="defaultValue">Default value to be returned if no items satisfy the condition.</param>
 /// <example>FROM(nums) LAST_OR_DEFAULT(42) { return item % 2; }</example>
-#define LAST_OR_DEFAULT(defaultValue) END.last_or_default(defaultValue, [](auto item) -> bool
+#define LAST_OR_DEFAULT(defaultValue) END.last_or_default(defaultValue, [](const auto &__LINQ_ELEM__) -> bool
+
+/// <summary>
+/// Searches for the first item which satisfies the provided condition, without throwing if there is none.
+/// On an array this gives a pointer to the item, and on a lazy query an optional copy of it; either is empty on a miss.
+/// </summary>
+/// <example>if (auto found = FROM(nums) FIND_FIRST { return item % 2; } END) use(*found);</example>
+#define FIND_FIRST END.find_first([](const auto &__LINQ_ELEM__) -> bool
+/// <summary>
+/// Searches for the last item which satisfies the provided condition, without throwing if there is none.
+/// On an array this gives a pointer to the item, and on a lazy query an optional copy of it; either is empty on a miss.
+/// </summary>
+/// <example>if (auto found = FROM(nums) FIND_LAST { return item % 2; } END) use(*found);</example>
+#define FIND_LAST END.find_last([](const auto &__LINQ_ELEM__) -> bool
+/// <summary>Finds the position of the first item which satisfies the provided condition, or <see cref="linq::npos"/> if there is none.</summary>
+/// <example>FROM(nums) INDEX_OF { return item % 2; } END</example>
+#define INDEX_OF END.index_of([](const auto &__LINQ_ELEM__) -> bool
+/// <summary>Checks whether any item satisfies the provided condition, stopping at the first which does.</summary>
+/// <example>FROM(nums) ANY { return item % 2; } END</example>
+#define ANY END.any([](const auto &__LINQ_ELEM__) -> bool
+/// <summary>Checks whether every item satisfies the provided condition, stopping at the first which does not.</summary>
+/// <example>FROM(nums) ALL { return item % 2; } END</example>
+#define ALL END.all([](const auto &__LINQ_ELEM__) -> bool
+/// <summary>Checks whether no item satisfies the provided condition, stopping at the first which does.</summary>
+/// <example>FROM(nums) NONE { return item % 2; } END</example>
+#define NONE END.none([](const auto &__LINQ_ELEM__) -> bool
+
+/// <summary>Removes every item equal to one before it.</summary>
+/// <example>FROM(nums) DISTINCT END</example>
+#define DISTINCT END.distinct(
+/// <summary>Removes every item whose key equals that of an item before it.</summary>
+/// <example>FROM(people) DISTINCT_BY { return item.email; } END</example>
+#define DISTINCT_BY END.distinct([](const auto &__LINQ_ELEM__)
+/// <summary>Appends the items of another list whose keys are not found already, after removing duplicates.</summary>
+/// <example>FROM(nums) UNION_WITH(more) END</example>
+#define UNION_WITH(other) END.union_with(other
+/// <summary>Keeps the distinct items which are also found in another list.</summary>
+/// <example>FROM(ids) INTERSECT(known) END</example>
+#define INTERSECT(other) END.intersect(other
+/// <summary>Keeps the distinct items which are not found in another list.</summary>
+/// <example>FROM(ids) EXCEPT(known) END</example>
+#define EXCEPT(other) END.except(other
 
 /// <summary>
 /// Helper macro which converts the <see cref="linq::array"/> into a <see cref="std::vector"/>.
 /// </summary>
 #define TO_VECTOR END.to_vector(
 
+/// <summary>
+/// Helper macro which evaluates a deferred query into a <see cref="linq::array"/>.
+/// </summary>
+#define TO_ARRAY END.to_array(
+
 
 /*** Custom lambda expression alternatives ***/
 
@@ -102,7 +223,7 @@
 /// <param name="type">The new type being created and returned for the new array.</param>
 /// <param name="lambda_item_type">Lambda of the form: _Ret(_Ty item)</param>
 /// <example>SELECT_L(int) [](auto item) -> int { return str.size(); }</example>
-#define SELECT_L(type) END.select<type>(
+#define SELECT_L(type) END.template select<type>(
 
 /// <summary>Performs a conditional for filtering the list using a fully defined lambda.</summary>
 /// <example>WHERE_L [](auto item) -> bool { return item > 10; }</example>
@@ -19,11 +19,85 @@
 #endif
 #endif
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <exception>
+#include <fstream>
+#include <istream>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <tuple>
+#include <utility>
+#include <cerrno>
+#include <cstddef>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <system_error>
+
+#if !defined(LINQ_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define LINQ_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC allows every intrinsic in any function, leaving the runtime dispatch to choose which may run
+#define LINQ_TARGET_SSSE3
+#define LINQ_TARGET_AVX2
+#define LINQ_TARGET_AVX512
+#else
+#define LINQ_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define LINQ_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define LINQ_TARGET_AVX512 __attribute__((target("avx512f,popcnt")))
+#endif
+#endif
+
+#ifdef LINQ_PROFILE
+#include <chrono>
+#include <cstdio>
+#endif
+
+#ifdef LINQ_USE_MMAP
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#endif
 
 namespace linq {
 	namespace core {
+		/// <summary>
+		/// Sort order on the key selected from each element, created by calling <see cref="linq::ascending"/> or
+		/// <see cref="linq::descending"/> with a key selector. See <see cref="array::orderby"/>.
+		/// </summary>
+		/// <typeparam name="_Fn">Type of the key selector.</typeparam>
+		/// <typeparam name="_Descending">Whether the keys are sorted in descending order.</typeparam>
+		template<class _Fn, bool _Descending>
+		struct key_order {
+			typedef _Fn selector_type;
+			static const bool descending = _Descending;
+			_Fn selector;
+		};
+		template<class _Ty>
+		struct is_key_order : ::std::false_type {};
+		template<class _Fn, bool _Descending>
+		struct is_key_order<key_order<_Fn, _Descending>> : ::std::true_type {};
+
 		// TEMPLATE STRUCT more
 		template<class _Ty = void>
 		struct more
@@ -61,6 +135,15 @@ namespace linq {
 			{	// transparently apply operator> to operands
 				return (static_cast<_Ty1&&>(_Left) > static_cast<_Ty2&&>(_Right));
 			}
+			/// <summary>
+			/// Creates a descending sort order on the key selected from each element, which is computed once per element.
+			/// </summary>
+			/// <param name="selector">Lambda which selects the key of each element.</param>
+			template<class _Fn>
+			constexpr key_order<::std::decay_t<_Fn>, true> operator()(_Fn &&selector) const
+			{
+				return { ::std::forward<_Fn>(selector) };
+			}
 		};
 		// TEMPLATE STRUCT less
 		template<class _Ty = void>
@@ -99,6 +182,15 @@ namespace linq {
 			{	// transparently apply operator< to operands
 				return (static_cast<_Ty1&&>(_Left) < static_cast<_Ty2&&>(_Right));
 			}
+			/// <summary>
+			/// Creates an ascending sort order on the key selected from each element, which is computed once per element.
+			/// </summary>
+			/// <param name="selector">Lambda which selects the key of each element.</param>
+			template<class _Fn>
+			constexpr key_order<::std::decay_t<_Fn>, false> operator()(_Fn &&selector) const
+			{
+				return { ::std::forward<_Fn>(selector) };
+			}
 		};
 
 		/// <summary>
@@ -111,246 +203,9339 @@ namespace linq {
 			_Left left;
 			_Right right;
 		};
-	}
 
-	/// <summary>predicate used for sorting objects in ascending order</summary>
-	core::less<> ascending;
-	/// <summary>predicate used for sorting objects in descending order</summary>
-	core::more<> descending;
-
-	/// <summary>
-	/// Extension to the standard std::vector class. Provides specialized query methods for processing lists.
-	/// </summary>
-	/// <typeparam name="_Ty">Type for the elements to be held</typeparam>
-	template<class _Ty>
-	class array : public ::std::vector<_Ty> {
-	public:
-#ifdef _VECTOR_
-		array() : vector() {}
-		array(const ::std::size_t &_Count) : vector(_Count) {}
-		array(const ::std::vector<_Ty>&_Vec) : vector(_Vec) {}
-		array(::std::vector<_Ty>&& _Right) : vector(_Right) {}
-		array(::std::initializer_list<_Ty> _Ilist) : vector(_Ilist) {}
-		template<class _Iter, class = ::std::enable_if_t<::std::_Is_iterator<_Iter>::value>>
-		array(_Iter _First, _Iter _Last, const _Alloc& _Al = _Alloc()) : vector(_First, _Last, _Al) {}
-#elif _STL_VECTOR_H
-		array() : ::std::vector<_Ty>() {}
-		array(::std::size_t __n) : ::std::vector<_Ty>(__n) {}
-		array(const ::std::vector<_Ty>&__x) : ::std::vector<_Ty>(__x) {}
-		array(::std::vector<_Ty>&& __x) : ::std::vector<_Ty>(__x) {}
-		array(::std::initializer_list<_Ty> __l) : ::std::vector<_Ty>(__l) {}
-		template<typename _InputIterator, typename = std::_RequireInputIter<_InputIterator>>
-		array(_InputIterator __first, _InputIterator __last) : ::std::vector<_Ty>(__first, __last) {}
-#endif
+		/// <summary>
+		/// Result type of invoking a callable of type <typeparamref name="_Fn"/> with the provided argument types.
+		/// </summary>
+		template<class _Fn, class... _Args>
+		using invoke_result_t = decltype(::std::declval<_Fn>()(::std::declval<_Args>()...));
 
-	public:
 		/// <summary>
-		/// Delegate used for transforming the provided data into a new state which is returned by the call.
+		/// Minimal optional value holder used where a query needs to hold onto an element that may not exist.
 		/// </summary>
-		template<class _Ret>
-		using conversion = ::std::function<_Ret(const _Ty&)>;
+		/// <typeparam name="_Ty">The type of the value being held.</typeparam>
+		template<class _Ty>
+		class optional {
+		public:
+			optional() : _has(false) {}
+			optional(const _Ty &_Val) : _has(false) { emplace(_Val); }
+			optional(_Ty &&_Val) : _has(false) { emplace(::std::move(_Val)); }
+			optional(const optional &_Right) : _has(false) { if (_Right._has) emplace(*_Right); }
+			optional(optional &&_Right) : _has(false) { if (_Right._has) emplace(::std::move(*_Right)); }
+			~optional() { reset(); }
+
+			// Assignment always rebuilds the value as lambdas (and types holding them) are not assignable.
+			optional& operator=(const optional &_Right) {
+				if (this != &_Right) {
+					if (_Right._has) emplace(*_Right);
+					else reset();
+				}
+				return *this;
+			}
+			optional& operator=(optional &&_Right) {
+				if (this != &_Right) {
+					if (_Right._has) emplace(::std::move(*_Right));
+					else reset();
+				}
+				return *this;
+			}
+
+			/// <summary>
+			/// Destroys any held value and constructs a new one in place from the provided arguments.
+			/// </summary>
+			/// <returns>Reference to the newly constructed value.</returns>
+			template<class... _Args>
+			_Ty& emplace(_Args&&... _Vals) {
+				reset();
+				::new (static_cast<void*>(&_storage)) _Ty(::std::forward<_Args>(_Vals)...);
+				_has = true;
+				return **this;
+			}
+			/// <summary>Destroys the held value if there is one.</summary>
+			void reset() {
+				if (_has) {
+					(**this).~_Ty();
+					_has = false;
+				}
+			}
+
+			inline bool has_value() const { return _has; }
+			inline explicit operator bool() const { return _has; }
+			inline _Ty& operator*() { return *reinterpret_cast<_Ty*>(&_storage); }
+			inline const _Ty& operator*() const { return *reinterpret_cast<const _Ty*>(&_storage); }
+			inline _Ty* operator->() { return reinterpret_cast<_Ty*>(&_storage); }
+			inline const _Ty* operator->() const { return reinterpret_cast<const _Ty*>(&_storage); }
+
+		private:
+			typename ::std::aligned_storage<sizeof(_Ty), alignof(_Ty)>::type _storage;
+			bool _has;
+		};
+
 		/// <summary>
-		/// Delegate for applying conditions on the provided item and returning a bool result.
+		/// Holds on to the element most recently produced by an enumerator. References are kept by address,
+		/// while elements produced by value (such as the output of a selection) are kept by copy.
 		/// </summary>
-		typedef ::std::function<bool(const _Ty&)> conditional;
+		/// <typeparam name="_Ref">The reference type produced by the enumerator.</typeparam>
+		template<class _Ref, bool = ::std::is_lvalue_reference<_Ref>::value>
+		class element_cache {
+		public:
+			typedef _Ref reference;
+			inline void set(_Ref _Val) { _ptr = ::std::addressof(_Val); }
+			inline _Ref get() const { return *_ptr; }
+		private:
+			::std::remove_reference_t<_Ref> *_ptr = nullptr;
+		};
+		template<class _Ref>
+		class element_cache<_Ref, false> {
+		public:
+			typedef const ::std::decay_t<_Ref>& reference;
+			template<class _Arg>
+			inline void set(_Arg &&_Val) { _val.emplace(::std::forward<_Arg>(_Val)); }
+			inline reference get() const { return *_val; }
+		private:
+			optional<::std::decay_t<_Ref>> _val;
+		};
+
 		/// <summary>
-		/// Delegate for comparing two items and returning a bool result.
+		/// Returns the distance between the two iterators when it can be found in constant time; otherwise zero.
+		/// Only ever used as a hint for reserving storage.
 		/// </summary>
-		template<class _Ty2>
-		using comparison = ::std::function<bool(const _Ty&, const _Ty2&)>;
+		template<class _Iter>
+		inline ::std::size_t distance_hint(const _Iter &_First, const _Iter &_Last, ::std::random_access_iterator_tag) {
+			return static_cast<::std::size_t>(_Last - _First);
+		}
+		template<class _Iter>
+		inline ::std::size_t distance_hint(const _Iter &, const _Iter &, ::std::input_iterator_tag) {
+			return 0;
+		}
+		template<class _Iter>
+		inline ::std::size_t distance_hint(const _Iter &_First, const _Iter &_Last) {
+			return distance_hint(_First, _Last, typename ::std::iterator_traits<_Iter>::iterator_category());
+		}
+
+		/// <summary>Trait for whether <typeparamref name="_Iter"/> is an input iterator, used to tell iterator ranges from counts.</summary>
+		template<class _Iter, class = void>
+		struct is_input_iterator : ::std::false_type {};
+		template<class _Iter>
+		struct is_input_iterator<_Iter, ::std::enable_if_t<::std::is_convertible<typename ::std::iterator_traits<_Iter>::iterator_category, ::std::input_iterator_tag>::value>>
+			: ::std::true_type {};
+
 		/// <summary>
-		/// Delegate that is expected to merge two items into a new item which is then returned by the call.
+		/// Trait for whether two objects of type <typeparamref name="_Ty"/> can be compared with operator&lt;.
 		/// </summary>
-		template<class _Ty2, class _Ret>
-		using merger = ::std::function<_Ret(const _Ty&, const _Ty2&)>;
+		template<class _Ty, class = void>
+		struct is_less_comparable : ::std::false_type {};
+		template<class _Ty>
+		struct is_less_comparable<_Ty, decltype(void(::std::declval<const _Ty&>() < ::std::declval<const _Ty&>()))> : ::std::true_type {};
 
-	public:
 		/// <summary>
-		/// Performs an item selection which is expected to transform the data in some way and return a new array.
+		/// Spreads the bits of a hash value across the table using Fibonacci hashing, so weak hashes (such as the
+		/// identity hash used for integers) still distribute evenly over a power of two number of buckets.
 		/// </summary>
-		/// <param name="selector">Lambda which defines how each item is transformed into the new type.</param>
-		/// <param name="result">The array to be filled with the new items.</param>
-		/// <typeparam name="_Ret">The new type being created and returned for the new array.</typeparam>
-		template<class _Ret>
-		void select(const conversion<_Ret> &selector, array<_Ret> &result) const {
-			result.resize(this->size());
-			for (::std::size_t c = 0, l = this->size(); c < l; c++) {
-				result[c] = selector((*this)[c]);
-			}
+		/// <param name="hash">The hash value to be spread.</param>
+		/// <param name="shift">64 minus the log2 of the number of buckets.</param>
+		inline ::std::size_t hash_bucket(::std::size_t hash, unsigned shift) {
+			return static_cast<::std::size_t>((static_cast<unsigned long long>(hash) * 0x9E3779B97F4A7C15ull) >> shift);
 		}
-
 		/// <summary>
-		/// Performs an item selection which is expected to transform the data in some way and return a new array.
+		/// Finds the number of bits needed for a power of two bucket count able to hold <paramref name="count"/> items at a load factor of at most 1.
 		/// </summary>
-		/// <param name="selector">Lambda which defines how each item is transformed into the new type.</param>
-		/// <typeparam name="_Ret">The new type being created and returned for the new array.</typeparam>
-		/// <returns>The new array of transformed items.</returns>
-		template<class _Ret>
-		inline array<_Ret> select(const conversion<_Ret> &selector) const {
-			array<_Ret> result(this->size());
-			select(selector, result);
-			return result;
+		inline unsigned hash_bits(::std::size_t count) {
+			unsigned bits = 4;
+			while ((::std::size_t(1) << bits) < count) bits++;
+			return bits;
 		}
 
 		/// <summary>
-		/// Performs a conditional for filtering the list and returns a new list containing those filtered items.
+		/// Hash table mapping keys to the positions of the elements they were computed from. Each key is computed
+		/// once and stored alongside two flat index arrays (bucket heads and chain links), so building the table costs
+		/// three allocations regardless of the number of elements. Elements with equal keys are always visited in
+		/// ascending position order.
 		/// </summary>
-		/// <param name="conditional">The lambda which determines if an item is to be added to the new list.</param>
-		/// <returns>The new list of filtered items.</returns>
-		array<_Ty> where(const conditional &condition) const {
-			// Record of elements to keep
-			::std::vector<size_t> keep;
-			// Loop through elements to see which are being kept and which are to be thrown
-			for (::std::size_t c = 0, l = this->size(); c < l; c++) {
-				// If we are to keep the element
-				if (condition((*this)[c])) {
-					// Add the element's index to the 'keep' list
-					keep.push_back(c);
+		/// <typeparam name="_Key">The key type.</typeparam>
+		/// <typeparam name="_Hash">The hash functor for the key.</typeparam>
+		template<class _Key, class _Hash = ::std::hash<_Key>>
+		class hash_index {
+		public:
+			static const ::std::size_t npos = ~::std::size_t(0);
+
+			hash_index() : _shift(64) {}
+
+			/// <summary>
+			/// Rebuilds the table from the provided keys, where each key's position is its index in the vector.
+			/// </summary>
+			/// <param name="keys">Keys to be indexed. They are swapped with the keys held before, so that the storage of both is kept.</param>
+			void build(::std::vector<_Key> &&keys) {
+				_keys.swap(keys);
+				unsigned bits = hash_bits(_keys.size());
+				_shift = 64 - bits;
+				_heads.assign(::std::size_t(1) << bits, npos);
+				_next.resize(_keys.size());
+				// Insert in reverse so that each chain ends up in ascending order
+				for (::std::size_t c = _keys.size(); c-- > 0;) {
+					::std::size_t &head = _heads[hash_bucket(_hash(_keys[c]), _shift)];
+					_next[c] = head;
+					head = c;
 				}
 			}
-			array<_Ty> result(keep.size());
-			// We will now take each element we are keeping and move them into sequential
-			// order at the begining of our original list
-			for (::std::size_t c = 0, last = 0, l = keep.size(); c < l; c++) {
-				if (keep[c] != last) {
-					// swap elements
-					const _Ty &right = (*this)[keep[c]];
-					result[c] = ::std::move(right);
+			/// <summary>
+			/// Rebuilds the table by computing the key of each element in the range [first, first + count).
+			/// </summary>
+			template<class _Iter, class _Sel>
+			void build(_Iter first, ::std::size_t count, _Sel &selector) {
+				::std::vector<_Key> keys;
+				keys.reserve(count);
+				for (::std::size_t c = 0; c < count; c++, ++first) {
+					keys.emplace_back(selector(*first));
 				}
-				last++;
+				build(::std::move(keys));
 			}
-			// trim the tail off of our original array
-			return result;
-		}
 
-		/// <summary>
-		/// Performs a sort on this list.
-		/// </summary>
-		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
-		/// <typeparam name="_Pr">The type of the predicate object, method or lambda</typeparam>
-		/// <returns>A reference to this list (used for chaining calls).</returns>
-		template<class _Pr>
-		inline array<_Ty>& orderby(const _Pr &pred) {
-			::std::sort(this->begin(), this->end(), pred);
-			return *this;
-		}
+			/// <summary>Finds the position of the first element with the provided key; otherwise <see cref="npos"/>.</summary>
+			inline ::std::size_t find(const _Key &key) const {
+				if (_keys.empty()) return npos;
+				::std::size_t c = _heads[hash_bucket(_hash(key), _shift)];
+				while (c != npos && !(_keys[c] == key)) c = _next[c];
+				return c;
+			}
+			/// <summary>Finds the position of the next element sharing the key of the element at <paramref name="position"/>; otherwise <see cref="npos"/>.</summary>
+			inline ::std::size_t find_next(::std::size_t position) const {
+				const _Key &key = _keys[position];
+				::std::size_t c = _next[position];
+				while (c != npos && !(_keys[c] == key)) c = _next[c];
+				return c;
+			}
+			/// <summary>Calls <paramref name="fn"/> with the position of every element with the provided key, in ascending order.</summary>
+			template<class _Fn>
+			inline void for_each(const _Key &key, _Fn &&fn) const {
+				for (::std::size_t c = find(key); c != npos; c = find_next(c)) {
+					fn(c);
+				}
+			}
+
+			inline ::std::size_t size() const { return _keys.size(); }
+			inline const ::std::vector<_Key>& keys() const { return _keys; }
+
+		private:
+			::std::vector<_Key> _keys;
+			::std::vector<::std::size_t> _heads;
+			::std::vector<::std::size_t> _next;
+			unsigned _shift;
+			_Hash _hash;
+		};
+		template<class _Key, class _Hash>
+		const ::std::size_t hash_index<_Key, _Hash>::npos;
 
 		/// <summary>
-		/// Performs a join on the current list and the provided list and performs a merge of the paired items.
+		/// Open addressing hash table which numbers distinct keys in the order they are first inserted. The keys are held
+		/// densely in that order, while each slot of the table holds just the number of its key and 32 bits of its hash.
+		/// Linear probing therefore walks one small contiguous array, and keys are only compared once the hash bits match.
 		/// </summary>
-		/// <param name="arr">Array to be joined with this one.</param>
-		/// <param name="merge">Lambda that performs the merge.</param>
-		/// <param name="on">Conditional lambda that determines if two elements should be paired.</param>
-		/// <typeparam name="_Ty2">The type contained in the array being joined.</typeparam>
-		/// <typeparam name="_Ret">The type to be returned in the new merged array.</typeparam>
-		/// <returns>New array of merged items.</returns>
-		template<class _Ty2, class _Ret>
-		array<_Ret> join(const array<_Ty2> &arr, const merger<_Ty2, _Ret> &merge, const comparison<_Ty2> &on) const {
-			array<_Ret> merged;
-			for (auto first : *this) {
-				for (auto second : arr) {
-					if (on(first, second)) {
-						merged.push_back(merge(first, second));
+		/// <typeparam name="_Key">The key type.</typeparam>
+		/// <typeparam name="_Hash">The hash functor for the key.</typeparam>
+		template<class _Key, class _Hash = ::std::hash<_Key>>
+		class group_table {
+		public:
+			static const ::std::size_t npos = ~::std::size_t(0);
+
+			group_table() : _shift(64) {}
+
+			/// <summary>
+			/// Finds the number of the provided key, numbering it after every key found so far if it is new.
+			/// </summary>
+			/// <returns>Number of the key, which equals <see cref="size"/> minus one if the key was new.</returns>
+			template<class _Arg>
+			inline ::std::size_t insert(_Arg &&key) {
+				const ::std::size_t hash = _hash(key);
+				return insert(::std::forward<_Arg>(key), hash);
+			}
+			/// <summary>Inserts the provided key, whose hash has already been computed with <see cref="hash"/>.</summary>
+			template<class _Arg>
+			::std::size_t insert(_Arg &&key, ::std::size_t hash) {
+				if ((_keys.size() + 1) * 2 > _slots.size()) {
+					_grow();
+				}
+				const ::std::size_t mask = _slots.size() - 1;
+				const ::std::uint32_t tag = _tag(hash);
+				for (::std::size_t s = hash_bucket(hash, _shift);; s = (s + 1) & mask) {
+					slot &at = _slots[s];
+					if (at.id == _empty) {
+						if (_keys.size() == _empty) {
+							throw ::std::logic_error("too many distinct keys");
+						}
+						at.id = static_cast<::std::uint32_t>(_keys.size());
+						at.tag = tag;
+						_keys.emplace_back(::std::forward<_Arg>(key));
+						_hashes.push_back(hash);
+						return at.id;
+					}
+					if (at.tag == tag && _keys[at.id] == key) {
+						return at.id;
 					}
 				}
 			}
-			return merged;
-		}
+			/// <summary>Finds the number of the provided key; otherwise <see cref="npos"/>.</summary>
+			inline ::std::size_t find(const _Key &key) const { return find(key, _hash(key)); }
+			/// <summary>Finds the number of the provided key, whose hash has already been computed with <see cref="hash"/>; otherwise <see cref="npos"/>.</summary>
+			::std::size_t find(const _Key &key, ::std::size_t hash) const {
+				if (_keys.empty()) return npos;
+				const ::std::size_t mask = _slots.size() - 1;
+				const ::std::uint32_t tag = _tag(hash);
+				for (::std::size_t s = hash_bucket(hash, _shift);; s = (s + 1) & mask) {
+					const slot &at = _slots[s];
+					if (at.id == _empty) return npos;
+					if (at.tag == tag && _keys[at.id] == key) return at.id;
+				}
+			}
+			/// <summary>
+			/// Renumbers the keys, the key numbered i becoming number <paramref name="rank"/>[i].
+			/// </summary>
+			/// <param name="rank">Permutation of the numbers [0, size).</param>
+			void reorder(const ::std::vector<::std::size_t> &rank) {
+				::std::vector<::std::size_t> order(_keys.size());
+				for (::std::size_t c = 0; c < rank.size(); c++) {
+					order[rank[c]] = c;
+				}
+				::std::vector<_Key> keys;
+				::std::vector<::std::size_t> hashes;
+				keys.reserve(_keys.size());
+				hashes.reserve(_keys.size());
+				for (::std::size_t id : order) {
+					keys.emplace_back(::std::move(_keys[id]));
+					hashes.push_back(_hashes[id]);
+				}
+				_keys = ::std::move(keys);
+				_hashes = ::std::move(hashes);
+				for (slot &at : _slots) {
+					if (at.id != _empty) at.id = static_cast<::std::uint32_t>(rank[at.id]);
+				}
+			}
+
+			/// <summary>Sizes the table for <paramref name="count"/> distinct keys, so inserting them does not rehash.</summary>
+			void reserve(::std::size_t count) {
+				_keys.reserve(count);
+				_hashes.reserve(count);
+				if (count * 2 > _slots.size()) {
+					_grow(count * 2);
+				}
+			}
+
+			/// <summary>The hash of the provided key, as used by the table.</summary>
+			inline ::std::size_t hash(const _Key &key) const { return _hash(key); }
+			/// <summary>The hash of the key with the provided number.</summary>
+			inline ::std::size_t hash_of(::std::size_t id) const { return _hashes[id]; }
+			inline ::std::size_t size() const { return _keys.size(); }
+			inline bool empty() const { return _keys.empty(); }
+			/// <summary>The keys, each at the index of its number.</summary>
+			inline const ::std::vector<_Key>& keys() const { return _keys; }
+
+		private:
+			struct slot {
+				::std::uint32_t id;
+				::std::uint32_t tag;
+			};
+			static const ::std::uint32_t _empty = ~::std::uint32_t(0);
+
+			static inline ::std::uint32_t _tag(::std::size_t hash) {
+				return static_cast<::std::uint32_t>(static_cast<unsigned long long>(hash) ^ (static_cast<unsigned long long>(hash) >> 32));
+			}
+			/// <summary>Doubles the number of slots, or raises it to at least <paramref name="slots"/>, placing every key again from its stored hash.</summary>
+			void _grow(::std::size_t slots = 0) {
+				const unsigned bits = hash_bits(::std::max(_slots.size() * 2, slots));
+
+				_shift = 64 - bits;
+				_slots.assign(::std::size_t(1) << bits, slot{ _empty, 0 });
+				const ::std::size_t mask = _slots.size() - 1;
+				for (::std::size_t id = 0; id < _keys.size(); id++) {
+					::std::size_t s = hash_bucket(_hashes[id], _shift);
+					while (_slots[s].id != _empty) s = (s + 1) & mask;
+					_slots[s] = slot{ static_cast<::std::uint32_t>(id), _tag(_hashes[id]) };
+				}
+			}
+
+			::std::vector<slot> _slots;
+			::std::vector<_Key> _keys;
+			::std::vector<::std::size_t> _hashes;
+			unsigned _shift;
+			_Hash _hash;
+		};
+		template<class _Key, class _Hash>
+		const ::std::size_t group_table<_Key, _Hash>::npos;
+
 		/// <summary>
-		/// Performs a join on the current list and the provided list and pairs the items into <see cref="linq::core::merge_pair"/>.
+		/// Register blocked bloom filter over hash values. Each key sets four bits within a single 64-bit word, so testing a
+		/// key costs one load and a mask compare whatever the outcome. At 16 bits per key about 0.5% of the keys which were
+		/// never inserted are reported as possibly present; the rest are rejected without probing a table.
 		/// </summary>
-		/// <param name="arr">Array to be joined with this one.</param>
-		/// <param name="on">Conditional lambda that determines if two elements should be paired.</param>
-		/// <typeparam name="_Ty2">The type contained in the array being joined.</typeparam>
-		/// <returns>New array of paired items.</returns>
-		template<class _Ty2>
-		inline array<core::merge_pair<_Ty, _Ty2>> join(const array<_Ty2> &arr, const comparison<_Ty2> &on) const {
-			return join<_Ty2, core::merge_pair<_Ty, _Ty2>>(arr, [](auto left, auto right)->core::merge_pair<_Ty, _Ty2> { return { left, right }; }, on);
+		class bloom_filter {
+		public:
+			bloom_filter() : _shift(64) {}
+
+			/// <summary>Clears the filter and sizes it for <paramref name="count"/> keys.</summary>
+			void reset(::std::size_t count) {
+				const unsigned bits = hash_bits(count / 4);
+				_shift = 64 - bits;
+				_words.assign(::std::size_t(1) << bits, 0);
+			}
+			/// <summary>Adds a key by its hash.</summary>
+			inline void insert(::std::size_t hash) {
+				const unsigned long long mixed = _mix(hash);
+				_words[static_cast<::std::size_t>(mixed >> _shift)] |= _mask(mixed);
+			}
+			/// <summary>Tests for a key by its hash.</summary>
+			/// <returns>False if the key was certainly never inserted; otherwise true.</returns>
+			inline bool may_contain(::std::size_t hash) const {
+				const unsigned long long mixed = _mix(hash), mask = _mask(mixed);
+				return (_words[static_cast<::std::size_t>(mixed >> _shift)] & mask) == mask;
+			}
+
+		private:
+			static inline unsigned long long _mix(::std::size_t hash) { return static_cast<unsigned long long>(hash) * 0x9E3779B97F4A7C15ull; }
+			/// <summary>The bits of a key within its word, chosen by four 6-bit fields of the mixed hash below those choosing the word.</summary>
+			static inline unsigned long long _mask(unsigned long long mixed) {
+				return (1ull << ((mixed >> 8) & 63)) | (1ull << ((mixed >> 14) & 63)) | (1ull << ((mixed >> 20) & 63)) | (1ull << ((mixed >> 26) & 63));
+			}
+
+			::std::vector<unsigned long long> _words;
+			unsigned _shift;
+		};
+		/// <summary>
+		/// Whether probing a table of <paramref name="keys"/> keys <paramref name="probes"/> times is worth screening with a
+		/// <see cref="bloom_filter"/>: the table must be too large to stay in cache, and the probes must greatly outnumber
+		/// its keys, so that most of them are likely to miss.
+		/// </summary>
+		inline bool screen_probes(::std::size_t keys, ::std::size_t probes) {
+			return keys >= 4096 && probes / 4 >= keys;
 		}
 
+		/// <summary>Key selector which selects the element itself.</summary>
+		struct identity {
+			template<class _Ty>
+			constexpr _Ty&& operator()(_Ty &&item) const { return ::std::forward<_Ty>(item); }
+		};
+		/// <summary>The type of the keys <typeparamref name="_Fn"/> selects from elements of type <typeparamref name="_Ty"/>.</summary>
+		template<class _Fn, class _Ty>
+		using set_key_t = ::std::decay_t<invoke_result_t<_Fn&, const _Ty&>>;
+
+		/// <summary>The set operations run by <see cref="run_set"/>.</summary>
+		enum class set_operation { distinct, union_with, intersect, except };
+
 		/// <summary>
-		/// Searches the array for the first item which satisfies the provided condition.
-		/// Throws <see cref="std::logic_error"/> if the condition is never satisfied.
+		/// One input of a set operation: the elements of a random access range, visited either in order or through a list of
+		/// ascending positions, such as those falling into one hash partition. Hashes may be supplied when already known.
 		/// </summary>
-		/// <param name="condition">Condition to be satisfied.</param>
-		/// <exception cref="std::logic_error">Thrown if no items satisfy the condition.</exception>
-		/// <returns>The first item found which satisfies the condition; otherwise an error is thrown.</returns>
-		_Ty first(const conditional &condition) const {
-			for (auto it = this->begin(), end = this->end(); it != end; it++) {
-				if (condition(*it)) {
-					return *it;
+		template<class _Iter, class _Fn>
+		struct set_side {
+			_Iter first;
+			::std::size_t count;
+			_Fn *selector;
+			/// <summary>Positions of the elements visited; null to visit [0, count).</summary>
+			const ::std::size_t *positions;
+			/// <summary>Hash of each element's key, indexed by position; null to compute them.</summary>
+			const ::std::size_t *hashes;
+
+			inline ::std::size_t position(::std::size_t c) const { return positions ? positions[c] : c; }
+			inline auto key(::std::size_t c) const { return (*selector)(first[position(c)]); }
+			template<class _Table, class _Key>
+			inline ::std::size_t hash(::std::size_t c, const _Table &table, const _Key &key) const { return hashes ? hashes[position(c)] : table.hash(key); }
+		};
+		template<class _Iter, class _Fn>
+		inline set_side<_Iter, _Fn> make_set_side(_Iter first, ::std::size_t count, _Fn &selector) { return { first, count, &selector, nullptr, nullptr }; }
+
+		/// <summary>
+		/// Sequential core of the hash based set operations over a left and a right input, using a single table. The positions
+		/// of the elements kept are reported in output order, by keep(false, position) for the left input followed by
+		/// keep(true, position) for the right, which only <see cref="set_operation::union_with"/> keeps elements from.
+		/// Every operation keeps only the first element with each key, in the order of its input.
+		/// </summary>
+		/// <remarks>
+		/// Intersect and except number the keys of the smaller input. When that is the left input, each distinct key
+		/// remembers where it first appears, the right input marks those it contains, and the marks pick the elements kept.
+		/// Otherwise the left input is streamed through the keys of the right. When one input is much larger, its probes are
+		/// first screened by a <see cref="bloom_filter"/> over the keys of the other.
+		/// </remarks>
+		template<set_operation _Op, class _Key, class _Left, class _Right, class _Keep>
+		void run_set(const _Left &left, const _Right &right, _Keep &&keep) {
+			group_table<_Key> table;
+			auto insert_all = [&](const auto &side, bool right_side, bool report) {
+				for (::std::size_t c = 0; c < side.count; c++) {
+					_Key key = side.key(c);
+					const ::std::size_t hash = side.hash(c, table, key), seen = table.size();
+					if (table.insert(::std::move(key), hash) == seen && report) {
+						keep(right_side, side.position(c));
+					}
+				}
+			};
+			if (_Op == set_operation::distinct || _Op == set_operation::union_with) {
+				table.reserve(left.count + (_Op == set_operation::union_with ? right.count : 0));
+				insert_all(left, false, true);
+				if (_Op == set_operation::union_with) {
+					insert_all(right, true, true);
+				}
+				return;
+			}
+			const bool intersect = _Op == set_operation::intersect;
+			bloom_filter bloom;
+			if (left.count <= right.count) {
+				table.reserve(left.count);
+				::std::vector<::std::size_t> firsts;
+				for (::std::size_t c = 0; c < left.count; c++) {
+					_Key key = left.key(c);
+					const ::std::size_t hash = left.hash(c, table, key), seen = table.size();
+					if (table.insert(::std::move(key), hash) == seen) {
+						firsts.push_back(left.position(c));
+					}
+				}
+				const bool screen = screen_probes(table.size(), right.count);
+				if (screen) {
+					bloom.reset(table.size());
+					for (::std::size_t id = 0; id < table.size(); id++) bloom.insert(table.hash_of(id));
+				}
+				::std::vector<char> found(table.size(), 0);
+				for (::std::size_t c = 0; c < right.count; c++) {
+					_Key key = right.key(c);
+					const ::std::size_t hash = right.hash(c, table, key);
+					if (screen && !bloom.may_contain(hash)) continue;
+					const ::std::size_t id = table.find(key, hash);
+					if (id != group_table<_Key>::npos) found[id] = 1;
+				}
+				for (::std::size_t id = 0; id < firsts.size(); id++) {
+					if (bool(found[id]) == intersect) {
+						keep(false, firsts[id]);
+					}
+				}
+				return;
+			}
+			table.reserve(right.count + (intersect ? 0 : left.count));
+			insert_all(right, true, false);
+
+			if (!intersect) {
+				// A key new to the table is in neither the right input nor the left elements before it
+				insert_all(left, false, true);
+				return;
+			}
+			const ::std::size_t known = table.size();
+			const bool screen = screen_probes(known, left.count);
+			if (screen) {
+				bloom.reset(known);
+				for (::std::size_t id = 0; id < known; id++) bloom.insert(table.hash_of(id));
+			}
+			::std::vector<char> emitted(known, 0);
+			for (::std::size_t c = 0; c < left.count; c++) {
+				_Key key = left.key(c);
+				const ::std::size_t hash = left.hash(c, table, key);
+				if (screen && !bloom.may_contain(hash)) continue;
+				const ::std::size_t id = table.find(key, hash);
+				if (id != group_table<_Key>::npos && !emitted[id]) {
+					emitted[id] = 1;
+					keep(false, left.position(c));
 				}
 			}
-			throw ::std::logic_error("no elements match the given conditional");
 		}
 
+
 		/// <summary>
-		/// Searches the array for the first item which satisfies the provided condition.
-		/// Returns the provided <paramref name="defaultValue"/> if the condition is never satisfied.
+		/// Non-owning range over the elements of a random access sequence found at a list of positions.
+		/// Used to hand a group of matched elements to a lambda without copying them.
 		/// </summary>
-		/// <param name="condition">Condition to be satisfied.</param>
-		/// <param name="defaultValue">Default value to be returned if no items satisfy the condition.</param>
-		/// <returns>The first item found which satisfies the condition; otherwise the provided <paramref name="defaultValue"/>.</returns>
-		inline _Ty first_or_default(_Ty defaultValue, const conditional &condition) const {
-			try { return first(condition); }
-			catch (...) { return defaultValue; }
+		/// <typeparam name="_Iter">Random access iterator to the start of the sequence.</typeparam>
+		template<class _Iter>
+		class indirect_range {
+		public:
+			typedef decltype(*::std::declval<_Iter&>()) reference;
+			typedef ::std::remove_cv_t<::std::remove_reference_t<reference>> value_type;
+
+			class iterator {
+			public:
+				typedef ::std::forward_iterator_tag iterator_category;
+				typedef typename indirect_range::value_type value_type;
+				typedef typename indirect_range::reference reference;
+				typedef ::std::ptrdiff_t difference_type;
+				typedef const value_type* pointer;
+
+				iterator(_Iter base, const ::std::size_t *pos) : _base(base), _pos(pos) {}
+				inline reference operator*() const { return _base[*_pos]; }
+				inline pointer operator->() const { return ::std::addressof(_base[*_pos]); }
+				inline iterator& operator++() { ++_pos; return *this; }
+				inline iterator operator++(int) { iterator tmp = *this; ++_pos; return tmp; }
+				inline bool operator==(const iterator &_Right) const { return _pos == _Right._pos; }
+				inline bool operator!=(const iterator &_Right) const { return _pos != _Right._pos; }
+			private:
+				_Iter _base;
+				const ::std::size_t *_pos;
+			};
+			typedef iterator const_iterator;
+
+			indirect_range(_Iter base, const ::std::size_t *first, const ::std::size_t *last) : _base(base), _first(first), _last(last) {}
+
+			inline iterator begin() const { return iterator(_base, _first); }
+			inline iterator end() const { return iterator(_base, _last); }
+			inline ::std::size_t size() const { return static_cast<::std::size_t>(_last - _first); }
+			inline bool empty() const { return _first == _last; }
+			inline reference operator[](::std::size_t index) const { return _base[_first[index]]; }
+
+		private:
+			_Iter _base;
+			const ::std::size_t *_first, *_last;
+		};
+
+		/// <summary>
+		/// Checks if both key lists are in ascending order, which is only possible for keys comparable with operator&lt;.
+		/// </summary>
+		template<class _Key>
+		inline bool equi_join_sorted(const ::std::vector<_Key> &lkeys, const ::std::vector<_Key> &rkeys, ::std::true_type) {
+			return ::std::is_sorted(lkeys.begin(), lkeys.end()) && ::std::is_sorted(rkeys.begin(), rkeys.end());
+		}
+		template<class _Key>
+		inline bool equi_join_sorted(const ::std::vector<_Key>&, const ::std::vector<_Key>&, ::std::false_type) {
+			return false;
 		}
 
 		/// <summary>
-		/// Searches the array for the last item which satisfies the provided condition.
-		/// Throws <see cref="std::logic_error"/> if the condition is never satisfied.
+		/// Temporaries of <see cref="equi_join"/>, which may be kept in a <see cref="linq::query_context"/> so that joining
+		/// again reuses their storage.
 		/// </summary>
-		/// <param name="condition">Condition to be satisfied.</param>
-		/// <exception cref="std::logic_error">Thrown if no items satisfy the condition.</exception>
-		/// <returns>The last item found which satisfies the condition; otherwise an error is thrown.</returns>
-		_Ty last(const conditional &condition) const {
-			for (auto it = this->rbegin(), end = this->rend(); it != end; it++) {
-				if (condition(*it)) {
-					return *it;
+		template<class _Key>
+		struct join_scratch {
+			/// <summary>Key of each left element, filled in by the caller.</summary>
+			::std::vector<_Key> lkeys;
+			/// <summary>Key of each right element, filled in by the caller.</summary>
+			::std::vector<_Key> rkeys;
+			::std::vector<::std::size_t> matches, offsets, fill;
+			hash_index<_Key> table;
+		};
+
+		/// <summary>
+		/// Equi-join driver shared by the key based joins. For every left position, in order, <paramref name="fn"/> is called
+		/// with the left position and the range of matching right positions (ascending), so the output order always matches a
+		/// nested loop join. When both key lists are already sorted a merge is used; otherwise the smaller side is hashed.
+		/// </summary>
+		/// <param name="scratch">The keys of both sides, and the storage for the temporaries of the join.</param>
+		/// <param name="fn">Called as fn(size_t left, const size_t *first, const size_t *last).</param>
+		/// <returns>Number of lookups made: one per element of the side streamed through the table, or of both sides for a merge.</returns>
+		template<class _Key, class _Fn>
+		::std::size_t equi_join(join_scratch<_Key> &scratch, _Fn &&fn) {
+			::std::vector<_Key> &lkeys = scratch.lkeys, &rkeys = scratch.rkeys;
+			::std::vector<::std::size_t> &matches = scratch.matches;
+			hash_index<_Key> &table = scratch.table;
+			const ::std::size_t nl = lkeys.size(), nr = rkeys.size();
+			if (equi_join_sorted(lkeys, rkeys, is_less_comparable<_Key>())) {
+				// Sort-merge: each left key matches one contiguous run of right keys
+				::std::size_t r = 0;
+				for (::std::size_t l = 0; l < nl; l++) {
+					while (r < nr && rkeys[r] < lkeys[l]) r++;
+					matches.clear();
+					for (::std::size_t e = r; e < nr && !(lkeys[l] < rkeys[e]); e++) {
+						matches.push_back(e);
+					}
+					fn(l, matches.data(), matches.data() + matches.size());
 				}
+				return nl + nr;
+			}
+			if (nr <= nl) {
+				// Hash the right side and stream the left side through it
+				table.build(::std::move(rkeys));
+				for (::std::size_t l = 0; l < nl; l++) {
+					matches.clear();
+					table.for_each(lkeys[l], [&matches](::std::size_t r) { matches.push_back(r); });
+					fn(l, matches.data(), matches.data() + matches.size());
+				}
+				return nl;
+			}
+			else {
+				// Hash the left side, probe with the right side, then bucket the matches by left position
+				// (counting sort) so they can be handed out in left order.
+				table.build(::std::move(lkeys));
+				::std::vector<::std::size_t> &offsets = scratch.offsets, &fill = scratch.fill;
+				offsets.assign(nl + 1, 0);
+				for (::std::size_t r = 0; r < nr; r++) {
+					table.for_each(rkeys[r], [&offsets](::std::size_t l) { offsets[l + 1]++; });
+				}
+				for (::std::size_t l = 0; l < nl; l++) {
+					offsets[l + 1] += offsets[l];
+				}
+				matches.resize(offsets[nl]);
+				fill.assign(offsets.begin(), offsets.end() - 1);
+				for (::std::size_t r = 0; r < nr; r++) {
+					table.for_each(rkeys[r], [&](::std::size_t l) { matches[fill[l]++] = r; });
+				}
+				for (::std::size_t l = 0; l < nl; l++) {
+					fn(l, matches.data() + offsets[l], matches.data() + offsets[l + 1]);
+				}
+				return nr;
 			}
-			throw ::std::logic_error("no elements match the given conditional");
 		}
 		/// <summary>
-		/// Searches the array for the last item which satisfies the provided condition.
-		/// Returns the provided <paramref name="defaultValue"/> if the condition is never satisfied.
+		/// Checks whether the element at position <paramref name="lpos"/> goes before the one at <paramref name="rpos"/>, with
+		/// elements which are equal by the predicate ordered by position, as a stable sort would leave them. The predicate is
+		/// only called a second time when the left element comes first and is not already known to go first.
 		/// </summary>
-		/// <param name="condition">Condition to be satisfied.</param>
-		/// <param name="defaultValue">Default value to be returned if no items satisfy the condition.</param>
-		/// <returns>The last item found which satisfies the condition; otherwise the provided <paramref name="defaultValue"/>.</returns>
-		_Ty last_or_default(_Ty defaultValue, const conditional &condition) const {
-			try { return last(condition); }
-			catch (...) { return defaultValue; }
+		template<class _Pr, class _Ty>
+		inline bool before_at(_Pr &pred, const _Ty &left, ::std::size_t lpos, const _Ty &right, ::std::size_t rpos) {
+			return pred(left, right) || (lpos < rpos && !pred(right, left));
 		}
 
 		/// <summary>
-		/// Helper method which converts this <see cref="linq::array"/> into a <see cref="std::vector"/>.
+		/// Bounded heap keeping the <c>count</c> elements which go first by a predicate, out of any number of elements pushed.
+		/// The top of the heap is the kept element which goes last, so most elements are rejected after a single comparison
+		/// with it, and selecting k of n elements costs O(n log k) time while never holding more than k elements. Each element
+		/// is pushed with its position in the input, which orders elements equal by the predicate, so the kept elements are
+		/// always the first k of a stable sort, whatever order they are pushed in.
 		/// </summary>
-		/// <returns><see cref="std::vector"/> containing a copy of the elements of this <see cref="linq::array"/>.</returns>
-		inline ::std::vector<_Ty> to_vector() const {
-			return ::std::vector<_Ty>(*this);
-		}
-	};
+		/// <typeparam name="_Ty">Type of the elements.</typeparam>
+		/// <typeparam name="_Pr">Predicate determining if the left element should go before the right.</typeparam>
+		template<class _Ty, class _Pr>
+		class top_k_heap {
+		public:
+			/// <summary>A kept element and its position in the input.</summary>
+			struct entry {
+				_Ty item;
+				::std::size_t position;
+			};
+			typedef ::std::vector<entry> storage_type;
 
-	/// <summary>
-	/// Helper function for converting a <see cref="std::vector"/> to an <see cref="linq::array"/>.
-	/// </summary>
-	/// <param name="vec">The <see cref="std::vector"/> to be converted to a <see cref="linq::array"/>.</param>
-	/// <returns><see cref="linq::array"/> containing a copy of the elements from the provided <paramref name="vec"/>.</returns>
-	template<class _Ty>
-	inline array<_Ty> from(const ::std::vector<_Ty> &vec) { return array<_Ty>(vec); }
-	/// <summary>
-	/// Helper function for converting a C-style array pointer into an <see cref="linq::array"/>.
-	/// </summary>
-	/// <param name="c_arr">The pointer to a C-Style array to be converted to a <see cref="linq::array"/>.</param>
-	/// <param name="size">The size of the C-Style array.</param>
-	/// <returns><see cref="linq::array"/> containing a copy of the elements from the provided <paramref name="c_arr"/>.</returns>
-	template<class _Ty>
-	inline array<_Ty> from(const _Ty *c_arr, const size_t &size) {
-		return array<_Ty>(c_arr, c_arr + size);
-	}
-}
+			top_k_heap(::std::size_t count, _Pr &pred, ::std::size_t expected = 0) : _count(count), _pred(&pred), _full(false) {
+				_heap.reserve(::std::min(count, expected));
+			}
+			/// <summary>Creates a heap which keeps its elements in the provided storage, emptied first, so that its capacity is reused.</summary>
+			top_k_heap(::std::size_t count, _Pr &pred, ::std::size_t expected, storage_type &&storage)
+				: _heap(::std::move(storage)), _count(count), _pred(&pred), _full(false) {
+				_heap.clear();
+				_heap.reserve(::std::min(count, expected));
+			}
 
+			template<class _Arg>
+			inline void push(_Arg &&item, ::std::size_t position) {
+				if (_full) {
+					if (before_at(*_pred, item, position, _heap.front().item, _heap.front().position)) {
+						_replace_top(::std::forward<_Arg>(item), position);
+					}
+				}
+				else if (_count) {
+					_heap.push_back(entry{ ::std::forward<_Arg>(item), position });
+					::std::push_heap(_heap.begin(), _heap.end(), _order());
+					_full = _heap.size() == _count;
+				}
+			}
+			/// <summary>Takes the kept elements, in heap order.</summary>
+			inline storage_type release() { return ::std::move(_heap); }
+			/// <summary>Sorts the kept elements in place, and returns them.</summary>
+			inline storage_type& sort() {
+				::std::sort_heap(_heap.begin(), _heap.end(), _order());
+				return _heap;
+			}
+			/// <summary>Takes the kept elements, sorted.</summary>
+			::std::vector<_Ty> sorted() {
+				::std::vector<_Ty> result;
+				result.reserve(_heap.size());
+				for (entry &kept : sort()) {
+					result.push_back(::std::move(kept.item));
+				}
+				return result;
+			}
+
+		private:
+			/// <summary>Order of the entries: by the predicate, then by position.</summary>
+			struct order {
+				_Pr *pred;
+				inline bool operator()(const entry &left, const entry &right) const { return before_at(*pred, left.item, left.position, right.item, right.position); }
+			};
+			inline order _order() const { return order{ _pred }; }
+
+			/// <summary>Replaces the top of the heap, sifting the new element down to its place.</summary>
+			template<class _Arg>
+			void _replace_top(_Arg &&item, ::std::size_t position) {
+				const ::std::size_t size = _heap.size();
+				::std::size_t hole = 0;
+				for (::std::size_t child = 1; child < size; child = hole * 2 + 1) {
+					if (child + 1 < size && _order()(_heap[child], _heap[child + 1])) {
+						child++;
+					}
+					if (!before_at(*_pred, item, position, _heap[child].item, _heap[child].position)) {
+						break;
+					}
+					_heap[hole] = ::std::move(_heap[child]);
+					hole = child;
+				}
+				_heap[hole].item = ::std::forward<_Arg>(item);
+				_heap[hole].position = position;
+			}
+
+			storage_type _heap;
+			::std::size_t _count;
+			_Pr *_pred;
+			bool _full;
+		};
+
+		/// <summary>Unsigned integer type of the provided size in bytes.</summary>
+		template<::std::size_t _Bytes> struct uint_of;
+		template<> struct uint_of<1> { typedef ::std::uint8_t type; };
+		template<> struct uint_of<2> { typedef ::std::uint16_t type; };
+		template<> struct uint_of<4> { typedef ::std::uint32_t type; };
+		template<> struct uint_of<8> { typedef ::std::uint64_t type; };
+
+		/// <summary>
+		/// Maps keys onto unsigned integers which sort in the same order, so they can be radix sorted. Defined for integral
+		/// keys, by flipping the sign bit of signed ones, and for float and double keys, by flipping the sign bit of positive
+		/// numbers and every bit of negative ones. NaNs with the sign bit clear sort after infinity.
+		/// </summary>
+		template<class _Key, class = void>
+		struct radix_traits {
+			static const bool value = false;
+			static const unsigned bits = 0;
+		};
+		template<class _Key>
+		struct radix_traits<_Key, ::std::enable_if_t<::std::is_integral<_Key>::value>> {
+			static const bool value = true;
+			static const unsigned bits = sizeof(_Key) * 8;
+			typedef typename uint_of<sizeof(_Key)>::type type;
+			static inline type encode(_Key key) {
+				return static_cast<type>(static_cast<type>(key) ^ (::std::is_signed<_Key>::value ? static_cast<type>(type(1) << (bits - 1)) : type(0)));
+			}
+		};
+		template<class _Key>
+		struct radix_traits<_Key, ::std::enable_if_t<::std::is_floating_point<_Key>::value && (sizeof(_Key) == 4 || sizeof(_Key) == 8)>> {
+			static const bool value = true;
+			static const unsigned bits = sizeof(_Key) * 8;
+			typedef typename uint_of<sizeof(_Key)>::type type;
+			static inline type encode(_Key key) {
+				type code;
+				key = key == 0 ? _Key(0) : key; // -0 and 0 are equal
+				::std::memcpy(&code, &key, sizeof(code));
+				const type sign = type(1) << (bits - 1);
+				return (code & sign) ? type(~code) : type(code | sign);
+			}
+		};
+
+		inline constexpr bool all_of(::std::initializer_list<bool> values) {
+			for (bool value : values) {
+				if (!value) return false;
+			}
+			return true;
+		}
+		inline constexpr unsigned sum_of(::std::initializer_list<unsigned> values) {
+			unsigned sum = 0;
+			for (unsigned value : values) {
+				sum += value;
+			}
+			return sum;
+		}
+
+		/// <summary>Type of the key an order of type <typeparamref name="_Order"/> selects from an element of type <typeparamref name="_Ty"/>.</summary>
+		template<class _Order, class _Ty>
+		using order_key_t = ::std::decay_t<invoke_result_t<typename _Order::selector_type&, const _Ty&>>;
+
+		/// <summary>
+		/// Computes the keys of a list of <see cref="key_order"/>s. When every key can be radix sorted and together they fit
+		/// in 64 bits, the keys of an element are packed into one unsigned integer, most significant key first, with the bits
+		/// of descending keys inverted; that integer then sorts in the order of the whole list of keys.
+		/// </summary>
+		template<class _Ty, class _Orders>
+		struct key_sort_traits;
+		template<class _Ty, class... _Orders>
+		struct key_sort_traits<_Ty, ::std::tuple<_Orders...>> {
+			typedef ::std::tuple<_Orders...> orders_type;
+			typedef ::std::tuple<order_key_t<_Orders, _Ty>...> keys_type;
+			static const unsigned bits = sum_of({ radix_traits<order_key_t<_Orders, _Ty>>::bits... });
+			static const bool packable = all_of({ radix_traits<order_key_t<_Orders, _Ty>>::value... }) && bits <= 64;
+			typedef ::std::conditional_t<(bits <= 32), ::std::uint32_t, ::std::uint64_t> packed_type;
+
+			template<::std::size_t _I = 0>
+			static inline ::std::enable_if_t<(_I == sizeof...(_Orders)), packed_type> pack(const _Ty&, orders_type&, packed_type packed = 0) {
+				return packed;
+			}
+			template<::std::size_t _I = 0>
+			static inline ::std::enable_if_t<(_I < sizeof...(_Orders)), packed_type> pack(const _Ty &item, orders_type &orders, packed_type packed = 0) {
+				typedef ::std::tuple_element_t<_I, orders_type> order;
+				typedef radix_traits<order_key_t<order, _Ty>> traits;
+				typename traits::type code = traits::encode(::std::get<_I>(orders).selector(item));
+				if (order::descending) {
+					code = static_cast<typename traits::type>(~code);
+				}
+				return pack<_I + 1>(item, orders, _shift_in<traits::bits>(packed, code, ::std::integral_constant<bool, _I == 0>()));
+			}
+
+			static inline keys_type keys(const _Ty &item, orders_type &orders) {
+				return _keys(item, orders, ::std::index_sequence_for<_Orders...>());
+			}
+			/// <summary>Checks whether the left keys go before the right keys, comparing each key with operator&lt; in turn.</summary>
+			template<::std::size_t _I = 0>
+			static inline ::std::enable_if_t<(_I == sizeof...(_Orders)), bool> less(const keys_type&, const keys_type&) {
+				return false;
+			}
+			template<::std::size_t _I = 0>
+			static inline ::std::enable_if_t<(_I < sizeof...(_Orders)), bool> less(const keys_type &left, const keys_type &right) {
+				const bool descending = ::std::tuple_element_t<_I, orders_type>::descending;
+				const auto &l = ::std::get<_I>(left), &r = ::std::get<_I>(right);
+				if (descending ? r < l : l < r) return true;
+				if (descending ? l < r : r < l) return false;
+				return less<_I + 1>(left, right);
+			}
+
+		private:
+			template<unsigned _Bits, class _Code>
+			static inline packed_type _shift_in(packed_type, _Code code, ::std::true_type) { return code; }
+			template<unsigned _Bits, class _Code>
+			static inline packed_type _shift_in(packed_type packed, _Code code, ::std::false_type) { return static_cast<packed_type>((packed << _Bits) | code); }
+			template<::std::size_t... _I>
+			static inline keys_type _keys(const _Ty &item, orders_type &orders, ::std::index_sequence<_I...>) {
+				return keys_type(::std::get<_I>(orders).selector(item)...);
+			}
+		};
+
+		/// <summary>Packed sort key of an element, and the position of the element.</summary>
+		template<class _Key, class _Index>
+		struct radix_item {
+			_Key key;
+			_Index index;
+		};
+		/// <summary>
+		/// Stable LSD radix sort, one byte per pass. The counts of every pass are taken in one read of the items, and passes
+		/// in which every item has the same byte are skipped.
+		/// </summary>
+		/// <returns>Whichever of <paramref name="items"/> and <paramref name="scratch"/> holds the sorted items.</returns>
+		template<class _Key, class _Index>
+		radix_item<_Key, _Index>* radix_sort(radix_item<_Key, _Index> *items, radix_item<_Key, _Index> *scratch, ::std::size_t count) {
+			const unsigned passes = sizeof(_Key);
+			if (count == 0) {
+				return items;
+			}
+			::std::size_t counts[passes][256] = {};
+			for (::std::size_t c = 0; c < count; c++) {
+				const _Key key = items[c].key;
+				for (unsigned p = 0; p < passes; p++) {
+					counts[p][(key >> (p * 8)) & 0xff]++;
+				}
+			}
+			for (unsigned p = 0; p < passes; p++) {
+				::std::size_t *offsets = counts[p];
+				if (offsets[(items[0].key >> (p * 8)) & 0xff] == count) {
+					continue;
+				}
+				::std::size_t total = 0;
+				for (unsigned b = 0; b < 256; b++) {
+					const ::std::size_t n = offsets[b];
+					offsets[b] = total;
+					total += n;
+				}
+				for (::std::size_t c = 0; c < count; c++) {
+					scratch[offsets[(items[c].key >> (p * 8)) & 0xff]++] = items[c];
+				}
+				::std::swap(items, scratch);
+			}
+			return items;
+		}
+
+		/// <summary>
+		/// Temporaries of <see cref="sort_by_keys"/>, which may be kept in a <see cref="linq::query_context"/> so that
+		/// sorting again reuses their storage. <typeparamref name="_Index"/> must be able to hold every position sorted.
+		/// </summary>
+		template<class _Traits, class _Index>
+		struct key_sort_scratch {
+			typedef radix_item<typename _Traits::packed_type, _Index> item_type;
+			/// <summary>Buffer of packed keys which only ever grows. Left uninitialized, as every item is written before it is read.</summary>
+			struct buffer {
+				::std::unique_ptr<item_type[]> data;
+				::std::size_t capacity = 0;
+
+				inline item_type* reserve(::std::size_t count) {
+					if (count > capacity) {
+						data.reset(new item_type[count]);
+						capacity = count;
+					}
+					return data.get();
+				}
+			};
+			/// <summary>Packed keys, and the second buffer of the radix sort.</summary>
+			buffer items, spare;
+			/// <summary>Cached keys, when they cannot be packed.</summary>
+			::std::vector<typename _Traits::keys_type> keys;
+			::std::vector<_Index> positions;
+		};
+
+		/// <summary>
+		/// Sorts a list by the keys of a list of <see cref="key_order"/>s, computing each key exactly once, and calls
+		/// <paramref name="emit"/> with the position of every element in sorted order. Elements with equal keys keep
+		/// their order. Packed keys (see <see cref="key_sort_traits"/>) are radix sorted; other keys are cached and their
+		/// positions sorted with a comparison sort.
+		/// </summary>
+		/// <param name="first">Random access iterator to the first element.</param>
+		/// <param name="count">Number of elements.</param>
+		/// <param name="orders">Tuple of the <see cref="key_order"/>s, most significant first.</param>
+		/// <param name="emit">Called as emit(size_t position) for every element in sorted order.</param>
+		template<class _Iter, class _Orders, class _Fn>
+		inline void sort_by_keys(_Iter first, ::std::size_t count, _Orders &orders, _Fn &&emit) {
+			typedef key_sort_traits<::std::decay_t<decltype(*first)>, _Orders> traits;
+			if (count <= 0xffffffffu) {
+				key_sort_scratch<traits, ::std::uint32_t> scratch;
+				sort_by_keys(first, count, orders, emit, scratch);
+			}
+			else {
+				key_sort_scratch<traits, ::std::size_t> scratch;
+				sort_by_keys(first, count, orders, emit, scratch);
+			}
+		}
+		/// <summary>Sorts as <see cref="sort_by_keys"/> does, keeping the temporaries in <paramref name="scratch"/>.</summary>
+		template<class _Traits, class _Index, class _Iter, class _Orders, class _Fn>
+		inline void sort_by_keys(_Iter first, ::std::size_t count, _Orders &orders, _Fn &&emit, key_sort_scratch<_Traits, _Index> &scratch) {
+			sort_by_keys(first, count, orders, emit, scratch, ::std::integral_constant<bool, _Traits::packable>());
+		}
+		template<class _Traits, class _Index, class _Iter, class _Orders, class _Fn>
+		void sort_by_keys(_Iter first, ::std::size_t count, _Orders &orders, _Fn &emit, key_sort_scratch<_Traits, _Index> &scratch, ::std::true_type) {
+			typedef typename key_sort_scratch<_Traits, _Index>::item_type item;
+			item *items = scratch.items.reserve(count);
+			for (::std::size_t c = 0; c < count; c++) {
+				items[c] = item{ _Traits::pack(first[c], orders), static_cast<_Index>(c) };
+			}
+			const item *sorted = items;
+			// Below a few hundred items the 256 buckets of each pass cost more than they save
+			if (count < 256) {
+				::std::sort(items, items + count, [](const item &left, const item &right) {
+					return left.key < right.key || (left.key == right.key && left.index < right.index);
+				});
+			}
+			else {
+				sorted = radix_sort(items, scratch.spare.reserve(count), count);
+			}
+			for (::std::size_t c = 0; c < count; c++) {
+				emit(static_cast<::std::size_t>(sorted[c].index));
+			}
+		}
+		template<class _Traits, class _Index, class _Iter, class _Orders, class _Fn>
+		void sort_by_keys(_Iter first, ::std::size_t count, _Orders &orders, _Fn &emit, key_sort_scratch<_Traits, _Index> &scratch, ::std::false_type) {
+			::std::vector<typename _Traits::keys_type> &keys = scratch.keys;
+			::std::vector<_Index> &positions = scratch.positions;
+			keys.clear();
+			keys.reserve(count);
+			positions.resize(count);
+			for (::std::size_t c = 0; c < count; c++) {
+				keys.emplace_back(_Traits::keys(first[c], orders));
+				positions[c] = static_cast<_Index>(c);
+			}
+			::std::sort(positions.begin(), positions.end(), [&keys](_Index left, _Index right) {
+				return _Traits::less(keys[left], keys[right]) || (left < right && !_Traits::less(keys[right], keys[left]));
+			});
+			for (_Index position : positions) {
+				emit(static_cast<::std::size_t>(position));
+			}
+		}
+
+		/*** Enumerators ***
+		 * Enumerators are the building blocks of a lazy query and follow the .Net IEnumerator model.
+		 * Each one exposes:
+		 *   reference       - the type produced by current()
+		 *   value_type      - the decayed element type
+		 *   move_next()     - advances to the next element, returning false once exhausted
+		 *   current()       - the element the enumerator is currently sitting on
+		 *   size_hint()     - the exact number of remaining elements if cheaply known; otherwise zero
+		 * Operators wrap the enumerator of the previous stage, so a whole chain runs as a single pass
+		 * once a terminal operation pulls from it.
+		 */
+
+		/// <summary>
+		/// Enumerates over the iterator range [first, last) without owning the underlying elements.
+		/// </summary>
+		/// <typeparam name="_Iter">The iterator type for the range.</typeparam>
+		template<class _Iter>
+		class range_enumerator {
+		public:
+			typedef decltype(*::std::declval<_Iter&>()) reference;
+			typedef ::std::remove_cv_t<::std::remove_reference_t<reference>> value_type;
+
+			range_enumerator(_Iter _First, _Iter _Last) : _cur(_First), _next(_First), _last(_Last) {}
+
+			inline bool move_next() {
+				if (_next == _last) return false;
+				_cur = _next++;
+				return true;
+			}
+			inline reference current() const { return *_cur; }
+			inline ::std::size_t size_hint() const { return distance_hint(_next, _last); }
+
+		private:
+			_Iter _cur, _next, _last;
+		};
+
+		/// <summary>
+		/// Enumerates over a container that it shares ownership of. Used when a query is started from a temporary,
+		/// so the elements live as long as the query (and any copies of it) does.
+		/// </summary>
+		/// <typeparam name="_Cont">The type of container being owned.</typeparam>
+		template<class _Cont>
+		class owning_enumerator {
+		public:
+			typedef range_enumerator<typename _Cont::const_iterator> range_type;
+			typedef typename range_type::reference reference;
+			typedef typename range_type::value_type value_type;
+
+			explicit owning_enumerator(_Cont &&_Src)
+				: _owner(::std::make_shared<const _Cont>(::std::move(_Src))), _range(_owner->begin(), _owner->end()) {}
+
+			inline bool move_next() { return _range.move_next(); }
+			inline reference current() const { return _range.current(); }
+			inline ::std::size_t size_hint() const { return _range.size_hint(); }
+
+		private:
+			::std::shared_ptr<const _Cont> _owner;
+			range_type _range;
+		};
+
+		/// <summary>
+		/// Enumerates only the elements of the source which satisfy the provided condition.
+		/// </summary>
+		template<class _Src, class _Pr>
+		class where_enumerator {
+		public:
+			typedef typename _Src::reference reference;
+			typedef typename _Src::value_type value_type;
+
+			where_enumerator(_Src _Source, _Pr _Pred) : _src(::std::move(_Source)), _pred(::std::move(_Pred)) {}
+
+			inline bool move_next() {
+				while (_src.move_next()) {
+					if (_pred(_src.current())) {
+						return true;
+					}
+				}
+				return false;
+			}
+			inline reference current() const { return _src.current(); }
+			inline ::std::size_t size_hint() const { return 0; }
+
+		private:
+			_Src _src;
+			mutable _Pr _pred;
+		};
+
+		/// <summary>
+		/// Enumerates the transformation of each element of the source. The selector is applied once per element, as the
+		/// enumerator advances, and its result is held until the next one, so later stages may read it as often as they need.
+		/// </summary>
+		/// <typeparam name="_Ret">The explicitly requested result type, or void to use the selector's own return type.</typeparam>
+		template<class _Src, class _Fn, class _Ret = void>
+		class select_enumerator {
+		public:
+			typedef ::std::conditional_t<::std::is_void<_Ret>::value,
+				invoke_result_t<_Fn&, typename _Src::reference>, _Ret> result_type;
+			typedef typename element_cache<result_type>::reference reference;
+			typedef ::std::remove_cv_t<::std::remove_reference_t<result_type>> value_type;
+
+			select_enumerator(_Src _Source, _Fn _Selector) : _src(::std::move(_Source)), _fn(::std::move(_Selector)) {}
+
+			inline bool move_next() {
+				if (!_src.move_next()) return false;
+				_current.set(static_cast<result_type>(_fn(_src.current())));
+				return true;
+			}
+			inline reference current() const { return _current.get(); }
+			inline ::std::size_t size_hint() const { return _src.size_hint(); }
+
+		private:
+			_Src _src;
+			_Fn _fn;
+			element_cache<result_type> _current;
+		};
+
+		/// <summary>
+		/// Sorting barrier within a lazy query. Nothing is pulled from the source until the first call to
+		/// <see cref="move_next"/>, at which point the source is drained into a buffer and sorted.
+		/// </summary>
+		/// <typeparam name="_Stable">Whether elements which are equal keep their order, using <see cref="std::stable_sort"/>.</typeparam>
+		template<class _Src, class _Pr, bool _Stable = false>
+		class order_enumerator {
+		public:
+			typedef typename _Src::value_type value_type;
+			typedef const value_type& reference;
+
+			order_enumerator(_Src _Source, _Pr _Pred) : _src(::std::move(_Source)), _pred(::std::move(_Pred)), _index(0), _sorted(false) {}
+
+			bool move_next() {
+				if (!_sorted) {
+					_buffer.reserve(_src.size_hint());
+					while (_src.move_next()) {
+						_buffer.emplace_back(_src.current());
+					}
+					if (_Stable) ::std::stable_sort(_buffer.begin(), _buffer.end(), _pred);
+					else ::std::sort(_buffer.begin(), _buffer.end(), _pred);
+					_sorted = true;
+					_index = 0;
+				}
+				else {
+					_index++;
+				}
+				return _index < _buffer.size();
+			}
+			inline reference current() const { return _buffer[_index]; }
+			inline ::std::size_t size_hint() const { return _sorted ? _buffer.size() - _index : _src.size_hint(); }
+			inline const _Src& source() const { return _src; }
+			inline const _Pr& predicate() const { return _pred; }
+
+		private:
+			_Src _src;
+			_Pr _pred;
+			::std::vector<value_type> _buffer;
+			::std::size_t _index;
+			bool _sorted;
+		};
+
+		/// <summary>
+		/// Sorting barrier on the keys of a list of <see cref="key_order"/>s. Once the source has been drained into a buffer,
+		/// the key of every element is computed once and sorted by <see cref="sort_by_keys"/>; the buffer itself is never
+		/// moved, the stages after this one stream from it in the sorted order of the positions.
+		/// </summary>
+		/// <typeparam name="_Orders">Tuple of the <see cref="key_order"/>s, most significant first.</typeparam>
+		template<class _Src, class _Orders>
+		class key_sort_enumerator {
+		public:
+			typedef typename _Src::value_type value_type;
+			typedef const value_type& reference;
+
+			key_sort_enumerator(_Src _Source, _Orders _Keys) : _src(::std::move(_Source)), _orders(::std::move(_Keys)), _index(0), _sorted(false) {}
+
+			bool move_next() {
+				if (!_sorted) {
+					_buffer.reserve(_src.size_hint());
+					while (_src.move_next()) {
+						_buffer.emplace_back(_src.current());
+					}
+					_positions.reserve(_buffer.size());
+					sort_by_keys(_buffer.begin(), _buffer.size(), _orders, [this](::std::size_t position) { _positions.push_back(position); });
+					_sorted = true;
+					_index = 0;
+				}
+				else {
+					_index++;
+				}
+				return _index < _positions.size();
+			}
+			inline reference current() const { return _buffer[_positions[_index]]; }
+			inline ::std::size_t size_hint() const { return _sorted ? _positions.size() - _index : _src.size_hint(); }
+			inline const _Src& source() const { return _src; }
+			inline const _Orders& orders() const { return _orders; }
+
+		private:
+			_Src _src;
+			_Orders _orders;
+			::std::vector<value_type> _buffer;
+			::std::vector<::std::size_t> _positions;
+			::std::size_t _index;
+			bool _sorted;
+		};
+
+		/// <summary>
+		/// Replaces a sorting barrier which is followed by a take: only the first <c>count</c> elements by the predicate are
+		/// kept while the source is drained, see <see cref="top_k_heap"/>, and then sorted.
+		/// </summary>
+		template<class _Src, class _Pr>
+		class top_k_enumerator {
+		public:
+			typedef typename _Src::value_type value_type;
+			typedef const value_type& reference;
+
+			top_k_enumerator(_Src _Source, _Pr _Pred, ::std::size_t _Count) : _src(::std::move(_Source)), _pred(::std::move(_Pred)), _count(_Count), _index(0), _sorted(false) {}
+
+			bool move_next() {
+				if (!_sorted) {
+					top_k_heap<value_type, _Pr> heap(_count, _pred, _src.size_hint());
+					for (::std::size_t position = 0; _src.move_next(); position++) {
+						heap.push(_src.current(), position);
+					}
+					heap.sort();
+					_buffer = heap.release();
+					_sorted = true;
+					_index = 0;
+				}
+				else {
+					_index++;
+				}
+				return _index < _buffer.size();
+			}
+			inline reference current() const { return _buffer[_index].item; }
+			inline ::std::size_t size_hint() const { return _sorted ? _buffer.size() - _index : ::std::min(_count, _src.size_hint()); }
+
+		private:
+			_Src _src;
+			_Pr _pred;
+			typename top_k_heap<value_type, _Pr>::storage_type _buffer;
+			::std::size_t _count;
+			::std::size_t _index;
+			bool _sorted;
+		};
+
+		/// <summary>
+		/// Passes through at most <c>count</c> elements of the source, without pulling any more from it.
+		/// </summary>
+		template<class _Src>
+		class take_enumerator {
+		public:
+			typedef typename _Src::reference reference;
+			typedef typename _Src::value_type value_type;
+
+			take_enumerator(_Src _Source, ::std::size_t _Count) : _src(::std::move(_Source)), _left(_Count) {}
+
+			inline bool move_next() {
+				if (_left == 0) return false;
+				_left--;
+				return _src.move_next();
+			}
+			inline reference current() const { return _src.current(); }
+			inline ::std::size_t size_hint() const { return ::std::min(_left, _src.size_hint()); }
+
+		private:
+			_Src _src;
+			::std::size_t _left;
+		};
+
+		/// <summary>
+		/// Passes through the elements of the source after the first <c>count</c>.
+		/// </summary>
+		template<class _Src>
+		class skip_enumerator {
+		public:
+			typedef typename _Src::reference reference;
+			typedef typename _Src::value_type value_type;
+
+			skip_enumerator(_Src _Source, ::std::size_t _Count) : _src(::std::move(_Source)), _skip(_Count) {}
+
+			inline bool move_next() {
+				for (; _skip > 0; _skip--) {
+					if (!_src.move_next()) {
+						_skip = 0;
+						return false;
+					}
+				}
+				return _src.move_next();
+			}
+			inline reference current() const { return _src.current(); }
+			inline ::std::size_t size_hint() const {
+				::std::size_t hint = _src.size_hint();
+				return hint > _skip ? hint - _skip : 0;
+			}
+			inline const _Src& source() const { return _src; }
+			inline ::std::size_t count() const { return _skip; }
+
+		private:
+			_Src _src;
+			::std::size_t _skip;
+		};
+
+		/// <summary>
+		/// Passes through the elements of the source until the first one which fails the condition.
+		/// </summary>
+		template<class _Src, class _Pr>
+		class take_while_enumerator {
+		public:
+			typedef typename _Src::reference reference;
+			typedef typename _Src::value_type value_type;
+
+			take_while_enumerator(_Src _Source, _Pr _Cond) : _src(::std::move(_Source)), _cond(::std::move(_Cond)), _done(false) {}
+
+			inline bool move_next() {
+				_done = _done || !_src.move_next() || !_cond(_src.current());
+				return !_done;
+			}
+			inline reference current() const { return _src.current(); }
+			inline ::std::size_t size_hint() const { return 0; }
+
+		private:
+			_Src _src;
+			_Pr _cond;
+			bool _done;
+		};
+
+		/// <summary>
+		/// Chooses the stage added by <see cref="query::take"/>. A take directly after a sort, or after a sort and a skip,
+		/// becomes a <see cref="top_k_enumerator"/> so the sort never holds more than the elements it hands on.
+		/// </summary>
+		template<class _Enum>
+		struct take_stage {
+			typedef take_enumerator<_Enum> type;
+			static inline type make(const _Enum &source, ::std::size_t count) { return type(source, count); }
+		};
+		template<class _Src, class _Pr>
+		struct take_stage<order_enumerator<_Src, _Pr, false>> {
+			typedef top_k_enumerator<_Src, _Pr> type;
+			static inline type make(const order_enumerator<_Src, _Pr, false> &source, ::std::size_t count) {
+				return type(source.source(), source.predicate(), count);
+			}
+		};
+		template<class _Src, class _Pr>
+		struct take_stage<skip_enumerator<order_enumerator<_Src, _Pr, false>>> {
+			typedef skip_enumerator<top_k_enumerator<_Src, _Pr>> type;
+			static inline type make(const skip_enumerator<order_enumerator<_Src, _Pr, false>> &source, ::std::size_t count) {
+				const order_enumerator<_Src, _Pr, false> &sort = source.source();
+				// Saturates rather than wrapping when taking "everything" after a skip
+				const ::std::size_t keep = count > ~::std::size_t(0) - source.count() ? ~::std::size_t(0) : source.count() + count;
+				return type(top_k_enumerator<_Src, _Pr>(sort.source(), sort.predicate(), keep), source.count());
+			}
+		};
+
+		/// <summary>
+		/// Extends the keys of a <see cref="key_sort_enumerator"/> with <see cref="query::thenby"/>, which is only possible
+		/// directly after sorting on a key.
+		/// </summary>
+		template<class _Enum, class _Order>
+		struct thenby_stage {
+			static_assert(sizeof(_Enum) == 0, "thenby can only follow an orderby on a key, such as orderby(linq::ascending(selector))");
+		};
+		template<class _Src, class... _Orders, class _Order>
+		struct thenby_stage<key_sort_enumerator<_Src, ::std::tuple<_Orders...>>, _Order> {
+			typedef key_sort_enumerator<_Src, ::std::tuple<_Orders..., _Order>> type;
+			static inline type make(const key_sort_enumerator<_Src, ::std::tuple<_Orders...>> &source, const _Order &order) {
+				return type(source.source(), ::std::tuple_cat(source.orders(), ::std::make_tuple(order)));
+			}
+		};
+
+		/// <summary>
+		/// Nested-loop join between the source and the iterator range [first, last). For each element of the source,
+		/// every element of the range satisfying the condition produces one merged element.
+		/// </summary>
+		/// <typeparam name="_Ret">The explicitly requested result type, or void to use the merge's own return type.</typeparam>
+		template<class _Src, class _Iter, class _Merge, class _On, class _Ret = void>
+		class join_enumerator {
+		public:
+			typedef ::std::conditional_t<::std::is_void<_Ret>::value,
+				invoke_result_t<_Merge&, typename element_cache<typename _Src::reference>::reference, decltype(*::std::declval<_Iter&>())>, _Ret> reference;
+			typedef ::std::remove_cv_t<::std::remove_reference_t<reference>> value_type;
+
+			join_enumerator(_Src _Source, _Iter _First, _Iter _Last, _Merge _Merger, _On _Cond)
+				: _src(::std::move(_Source)), _first(_First), _last(_Last), _next(_Last), _match(_Last), _merge(::std::move(_Merger)), _on(::std::move(_Cond)) {}
+
+			bool move_next() {
+				for (;;) {
+					while (_next != _last) {
+						_Iter it = _next++;
+						if (_on(_left.get(), *it)) {
+							_match = it;
+							return true;
+						}
+					}
+					if (!_src.move_next()) {
+						return false;
+					}
+					_left.set(_src.current());
+					_next = _first;
+				}
+			}
+			inline reference current() const { return _merge(_left.get(), *_match); }
+			inline ::std::size_t size_hint() const { return 0; }
+
+		private:
+			_Src _src;
+			_Iter _first, _last, _next, _match;
+			element_cache<typename _Src::reference> _left;
+			mutable _Merge _merge;
+			mutable _On _on;
+		};
+
+		/// <summary>
+		/// Key type used to match the elements of an equi-join: the common type of the left and right key selectors' results.
+		/// </summary>
+		template<class _LKey, class _RKey, class _Left, class _Right>
+		using join_key_t = ::std::decay_t<::std::common_type_t<invoke_result_t<_LKey&, const _Left&>, invoke_result_t<_RKey&, const _Right&>>>;
+
+		/// <summary>
+		/// Hash join between the source and the random access range [first, last). The right side is hashed by key
+		/// the first time the enumerator is advanced; the source is then streamed through the table, so the output
+		/// is in the same order a nested loop join would produce. When <typeparamref name="_Left"/> is true every
+		/// element of the source without a match is merged once with a null right pointer.
+		/// </summary>
+		template<class _Src, class _Iter, class _LKey, class _RKey, class _Merge, class _Ret, bool _Left>
+		class hash_join_enumerator {
+		public:
+			typedef typename element_cache<typename _Src::reference>::reference left_reference;
+			typedef ::std::remove_cv_t<::std::remove_reference_t<decltype(*::std::declval<_Iter&>())>> right_type;
+			typedef ::std::conditional_t<_Left, const right_type*, const right_type&> right_argument;
+			typedef ::std::conditional_t<::std::is_void<_Ret>::value,
+				invoke_result_t<_Merge&, left_reference, right_argument>, _Ret> reference;
+			typedef ::std::remove_cv_t<::std::remove_reference_t<reference>> value_type;
+			typedef join_key_t<_LKey, _RKey, typename _Src::value_type, right_type> key_type;
+
+			hash_join_enumerator(_Src _Source, _Iter _First, _Iter _Last, _LKey _LeftKey, _RKey _RightKey, _Merge _Merger)
+				: _src(::std::move(_Source)), _first(_First), _count(static_cast<::std::size_t>(_Last - _First)),
+				_lkey(::std::move(_LeftKey)), _rkey(::std::move(_RightKey)), _merge(::std::move(_Merger)),
+				_match(hash_index<key_type>::npos), _probing(false), _matched(false) {}
+
+			bool move_next() {
+				if (!_table) {
+					auto table = ::std::make_shared<hash_index<key_type>>();
+					table->build(_first, _count, _rkey);
+					_table = ::std::move(table);
+				}
+				for (;;) {
+					if (_probing) {
+						_match = _matched ? _table->find_next(_match) : _table->find(*_key);
+						if (_match != hash_index<key_type>::npos) {
+							_matched = true;
+							return true;
+						}
+						_probing = false;
+						if (_Left && !_matched) {
+							return true;
+						}
+					}
+					if (!_src.move_next()) {
+						return false;
+					}
+					_left.set(_src.current());
+					_key.emplace(_lkey(_left.get()));
+					_probing = true;
+					_matched = false;
+				}
+			}
+			inline reference current() const { return _current(::std::integral_constant<bool, _Left>()); }
+			inline ::std::size_t size_hint() const { return 0; }
+
+		private:
+			inline reference _current(::std::false_type) const { return _merge(_left.get(), _first[_match]); }
+			inline reference _current(::std::true_type) const {
+				return _merge(_left.get(), _match == hash_index<key_type>::npos ? nullptr : ::std::addressof(_first[_match]));
+			}
+
+			_Src _src;
+			_Iter _first;
+			::std::size_t _count;
+			mutable _LKey _lkey;
+			mutable _RKey _rkey;
+			mutable _Merge _merge;
+			::std::shared_ptr<const hash_index<key_type>> _table;
+			element_cache<typename _Src::reference> _left;
+			optional<key_type> _key;
+			::std::size_t _match;
+			bool _probing, _matched;
+		};
+
+		/// <summary>
+		/// Hash group join between the source and the random access range [first, last). Produces exactly one element for
+		/// each element of the source, merging it with an <see cref="indirect_range"/> over all of its matches.
+		/// </summary>
+		template<class _Src, class _Iter, class _LKey, class _RKey, class _Merge, class _Ret>
+		class group_join_enumerator {
+		public:
+			typedef typename element_cache<typename _Src::reference>::reference left_reference;
+			typedef ::std::remove_cv_t<::std::remove_reference_t<decltype(*::std::declval<_Iter&>())>> right_type;
+			typedef ::std::conditional_t<::std::is_void<_Ret>::value,
+				invoke_result_t<_Merge&, left_reference, const indirect_range<_Iter>&>, _Ret> reference;
+			typedef ::std::remove_cv_t<::std::remove_reference_t<reference>> value_type;
+			typedef join_key_t<_LKey, _RKey, typename _Src::value_type, right_type> key_type;
+
+			group_join_enumerator(_Src _Source, _Iter _First, _Iter _Last, _LKey _LeftKey, _RKey _RightKey, _Merge _Merger)
+				: _src(::std::move(_Source)), _first(_First), _count(static_cast<::std::size_t>(_Last - _First)),
+				_lkey(::std::move(_LeftKey)), _rkey(::std::move(_RightKey)), _merge(::std::move(_Merger)) {}
+
+			bool move_next() {
+				if (!_table) {
+					auto table = ::std::make_shared<hash_index<key_type>>();
+					table->build(_first, _count, _rkey);
+					_table = ::std::move(table);
+				}
+				if (!_src.move_next()) {
+					return false;
+				}
+				_left.set(_src.current());
+				_matches.clear();
+				_table->for_each(_lkey(_left.get()), [this](::std::size_t r) { _matches.push_back(r); });
+				return true;
+			}
+			inline reference current() const {
+				return _merge(_left.get(), indirect_range<_Iter>(_first, _matches.data(), _matches.data() + _matches.size()));
+			}
+			inline ::std::size_t size_hint() const { return _src.size_hint(); }
+
+		private:
+			_Src _src;
+			_Iter _first;
+			::std::size_t _count;
+			mutable _LKey _lkey;
+			mutable _RKey _rkey;
+			mutable _Merge _merge;
+			::std::shared_ptr<const hash_index<key_type>> _table;
+			element_cache<typename _Src::reference> _left;
+			::std::vector<::std::size_t> _matches;
+		};
+
+		/// <summary>
+		/// Enumerates the elements of the source whose key has not been seen before, in order. The keys seen so far are
+		/// numbered in a <see cref="group_table"/>, so each element costs one hash probe.
+		/// </summary>
+		template<class _Src, class _Fn>
+		class distinct_enumerator {
+		public:
+			typedef typename _Src::reference reference;
+			typedef typename _Src::value_type value_type;
+			typedef set_key_t<_Fn, value_type> key_type;
+
+			distinct_enumerator(_Src _Source, _Fn _Selector) : _src(::std::move(_Source)), _fn(::std::move(_Selector)) {}
+
+			inline bool move_next() {
+				while (_src.move_next()) {
+					const ::std::size_t seen = _seen.size();
+					if (_seen.insert(static_cast<key_type>(_fn(_src.current()))) == seen) {
+						return true;
+					}
+				}
+				return false;
+			}
+			inline reference current() const { return _src.current(); }
+			inline ::std::size_t size_hint() const { return 0; }
+
+		private:
+			_Src _src;
+			mutable _Fn _fn;
+			group_table<key_type> _seen;
+		};
+
+		/// <summary>
+		/// Enumerates the elements of the source whose key is (<typeparamref name="_Intersect"/>) or is not found among the keys
+		/// of the random access range [first, last), keeping only the first element with each key. The keys of the range
+		/// are numbered once, when the query is evaluated. An intersection remembers which of them it has produced, while a
+		/// difference adds the keys it produces to the same table. When the source is known to be much larger than the range,
+		/// the probes of an intersection are screened by a <see cref="bloom_filter"/> first.
+		/// </summary>
+		template<class _Src, class _Iter, class _Fn, bool _Intersect>
+		class set_filter_enumerator {
+		public:
+			typedef typename _Src::reference reference;
+			typedef typename _Src::value_type value_type;
+			typedef set_key_t<_Fn, value_type> key_type;
+
+			set_filter_enumerator(_Src _Source, _Iter _First, _Iter _Last, _Fn _Selector)
+				: _src(::std::move(_Source)), _first(_First), _count(static_cast<::std::size_t>(_Last - _First)), _fn(::std::move(_Selector)),
+				_built(false), _screen(false) {}
+
+			bool move_next() {
+				if (!_built) {
+					_build();
+				}
+				while (_src.move_next()) {
+					key_type key = _fn(_src.current());
+					const ::std::size_t hash = _table.hash(key);
+					if (!_Intersect) {
+						const ::std::size_t seen = _table.size();
+						if (_table.insert(::std::move(key), hash) == seen) {
+							return true;
+						}
+						continue;
+					}
+					if (_screen && !_bloom.may_contain(hash)) continue;
+					const ::std::size_t id = _table.find(key, hash);
+					if (id != group_table<key_type>::npos && !_emitted[id]) {
+						_emitted[id] = 1;
+						return true;
+					}
+				}
+				return false;
+			}
+			inline reference current() const { return _src.current(); }
+			inline ::std::size_t size_hint() const { return 0; }
+
+		private:
+			void _build() {
+				_built = true;
+				_table.reserve(_count);
+				for (::std::size_t c = 0; c < _count; c++) {
+					_table.insert(static_cast<key_type>(_fn(_first[c])));
+				}
+				if (_Intersect) {
+					_emitted.assign(_table.size(), 0);
+					_screen = screen_probes(_table.size(), _src.size_hint());
+					if (_screen) {
+						_bloom.reset(_table.size());
+						for (::std::size_t id = 0; id < _table.size(); id++) _bloom.insert(_table.hash_of(id));
+					}
+				}
+			}
+
+			_Src _src;
+			_Iter _first;
+			::std::size_t _count;
+			mutable _Fn _fn;
+			group_table<key_type> _table;
+			bloom_filter _bloom;
+			::std::vector<char> _emitted;
+			bool _built, _screen;
+		};
+
+		/// <summary>
+		/// Enumerates the distinct elements of the source followed by those of the random access range [first, last) whose
+		/// keys were not produced already, keeping only the first element with each key.
+		/// </summary>
+		template<class _Src, class _Iter, class _Fn>
+		class union_enumerator {
+		public:
+			typedef typename _Src::value_type value_type;
+			// Elements come from either input, so they can only be handed on by reference when both give the same reference
+			typedef ::std::conditional_t<::std::is_same<typename _Src::reference, decltype(*::std::declval<_Iter&>())>::value,
+				typename _Src::reference, value_type> reference;
+			typedef set_key_t<_Fn, value_type> key_type;
+
+			union_enumerator(_Src _Source, _Iter _First, _Iter _Last, _Fn _Selector)
+				: _src(::std::move(_Source)), _first(_First), _last(_Last), _fn(::std::move(_Selector)), _second(false) {}
+
+			bool move_next() {
+				if (!_second) {
+					while (_src.move_next()) {
+						if (_insert(_src.current())) {
+							return true;
+						}
+					}
+					_second = true;
+					_at = _first;
+				}
+				else {
+					++_at;
+				}
+				for (; _at != _last; ++_at) {
+					if (_insert(*_at)) {
+						return true;
+					}
+				}
+				return false;
+			}
+			inline reference current() const { return _second ? reference(*_at) : reference(_src.current()); }
+			inline ::std::size_t size_hint() const { return 0; }
+
+		private:
+			template<class _Ty>
+			inline bool _insert(_Ty &&item) {
+				const ::std::size_t seen = _table.size();
+				return _table.insert(static_cast<key_type>(_fn(item))) == seen;
+			}
+
+			_Src _src;
+			_Iter _first, _last, _at;
+			mutable _Fn _fn;
+			group_table<key_type> _table;
+			bool _second;
+		};
+
+
+		/// <summary>
+		/// Input iterator over an enumerator, allowing lazy queries to be used in range-based for loops
+		/// and with algorithms expecting iterators.
+		/// </summary>
+		template<class _Enum>
+		class enumerator_iterator {
+		public:
+			typedef ::std::input_iterator_tag iterator_category;
+			typedef typename _Enum::value_type value_type;
+			typedef typename _Enum::reference reference;
+			typedef ::std::ptrdiff_t difference_type;
+			typedef const value_type* pointer;
+
+			/// <summary>Creates the end iterator.</summary>
+			enumerator_iterator() {}
+			/// <summary>Creates an iterator positioned on the first element of a copy of the provided enumerator.</summary>
+			explicit enumerator_iterator(const _Enum &_Src) : _enum(_Src) { _advance(); }
+
+			inline reference operator*() const { return _enum->current(); }
+			inline enumerator_iterator& operator++() { _advance(); return *this; }
+			inline void operator++(int) { _advance(); }
+			// Iterators are only ever compared against the end, so equality is whether both are exhausted.
+			inline bool operator==(const enumerator_iterator &_Right) const { return _enum.has_value() == _Right._enum.has_value(); }
+			inline bool operator!=(const enumerator_iterator &_Right) const { return !(*this == _Right); }
+
+		private:
+			inline void _advance() {
+				if (!_enum->move_next()) {
+					_enum.reset();
+				}
+			}
+			optional<_Enum> _enum;
+		};
+	}
+
+	/// <summary>
+	/// predicate used for sorting objects in ascending order. Called with a key selector, as in
+	/// <c>linq::ascending([](const auto &amp;item) { return item.id; })</c>, it creates a sort order on that key instead.
+	/// </summary>
+	constexpr core::less<> ascending{};
+	/// <summary>
+	/// predicate used for sorting objects in descending order. Called with a key selector, as in
+	/// <c>linq::descending([](const auto &amp;item) { return item.id; })</c>, it creates a sort order on that key instead.
+	/// </summary>
+	constexpr core::more<> descending{};
+
+	/// <summary>
+	/// Work stealing thread pool used by the parallel operators. Each worker owns a task queue which it takes work from
+	/// (newest first), and steals the oldest task from the other queues once its own runs dry. A thread waiting on a
+	/// <see cref="parallel_for"/> helps run queued tasks until none are left to steal, and only then sleeps until its own
+	/// tasks have finished, so parallel operators may safely be nested.
+	/// </summary>
+	class thread_pool {
+	public:
+		/// <summary>
+		/// Starts a pool with the provided number of worker threads. The thread calling <see cref="parallel_for"/> always
+		/// takes part in the work as well, so a pool of zero workers runs everything on the calling thread.
+		/// </summary>
+		/// <param name="workers">The number of worker threads to start.</param>
+		explicit thread_pool(::std::size_t workers) : _pending(0), _next(0), _stop(false) {
+			// One queue per worker; threads outside of the pool spread their tasks over these
+			for (::std::size_t c = 0; c < workers; c++) {
+				_queues.emplace_back(new task_queue());
+			}
+			_threads.reserve(workers);
+			for (::std::size_t c = 0; c < workers; c++) {
+				_threads.emplace_back([this, c] { _work(c); });
+			}
+		}
+		~thread_pool() {
+			{
+				::std::lock_guard<::std::mutex> lock(_sleep_lock);
+				_stop = true;
+			}
+			_wake.notify_all();
+			for (auto &thread : _threads) {
+				thread.join();
+			}
+		}
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		/// <summary>
+		/// The pool used by parallel operators when none is provided. It is started on first use with one worker less than
+		/// the number of hardware threads, as the calling thread makes up the last one.
+		/// </summary>
+		static thread_pool& shared() {
+			static thread_pool pool(::std::thread::hardware_concurrency() > 1 ? ::std::thread::hardware_concurrency() - 1 : 0);
+			return pool;
+		}
+
+		/// <summary>The number of threads taking part in a <see cref="parallel_for"/>: the workers plus the calling thread.</summary>
+		inline ::std::size_t concurrency() const { return _threads.size() + 1; }
+
+		/// <summary>
+		/// Decides how many tasks <paramref name="count"/> elements should be split into, so that no task is smaller than
+		/// <paramref name="grain"/> elements while still leaving a few tasks per thread to balance the load.
+		/// </summary>
+		inline ::std::size_t partition(::std::size_t count, ::std::size_t grain) const {
+			if (grain == 0) grain = 1;
+			::std::size_t tasks = (count + grain - 1) / grain;
+			return ::std::max<::std::size_t>(1, ::std::min(tasks, concurrency() * 4));
+		}
+
+		/// <summary>
+		/// Runs fn(0) ... fn(tasks - 1) across the pool and returns once all of them have finished.
+		/// If any task throws, the first exception is rethrown on the calling thread after every task has finished.
+		/// </summary>
+		/// <param name="tasks">The number of tasks to run.</param>
+		/// <param name="fn">Callable invoked with the index of each task. Must be safe to call concurrently.</param>
+		template<class _Fn>
+		void parallel_for(::std::size_t tasks, _Fn &&fn) {
+			if (tasks == 0) return;
+			if (tasks == 1 || _threads.empty()) {
+				for (::std::size_t t = 0; t < tasks; t++) fn(t);
+				return;
+			}
+			const ::std::size_t self = _self();
+			task_group group(tasks);
+			// The tasks only capture a pointer and an index, which std::function holds without allocating
+			::std::pair<::std::remove_reference_t<_Fn>*, task_group*> job(::std::addressof(fn), &group);
+			for (::std::size_t t = 1; t < tasks; t++) {
+				// The group may be gone as soon as its last task finishes, so only the pool is touched afterwards
+				_push(self, [this, &job, t] { if (job.second->run(*job.first, t)) _finished(); });
+			}
+			group.run(fn, 0);
+			while (!group.done()) {
+				if (_try_run(self)) continue;
+				// Nothing left to steal: sleep until the group finishes or new tasks are queued
+				::std::unique_lock<::std::mutex> lock(_sleep_lock);
+				_wake.wait(lock, [this, &group] { return group.done() || _pending.load(::std::memory_order_acquire) > 0; });
+			}
+			group.rethrow();
+		}
+
+	private:
+		/// <summary>
+		/// Queue of the tasks pushed to one thread: the tasks from <c>head</c> on are still waiting. Its storage is only
+		/// emptied once every task is taken, never freed, so queueing stops allocating once the pool has warmed up.
+		/// </summary>
+		struct task_queue {
+			::std::mutex lock;
+			::std::vector<::std::function<void()>> tasks;
+			::std::size_t head = 0;
+
+			inline bool empty() const { return head == tasks.size(); }
+			inline ::std::function<void()> take_back() {
+				::std::function<void()> task = ::std::move(tasks.back());
+				tasks.pop_back();
+				_trim();
+				return task;
+			}
+			inline ::std::function<void()> take_front() {
+				::std::function<void()> task = ::std::move(tasks[head++]);
+				_trim();
+				return task;
+			}
+
+		private:
+			inline void _trim() {
+				if (head == tasks.size()) {
+					tasks.clear();
+					head = 0;
+				}
+				else if (head >= 64 && head * 2 > tasks.size()) {
+					tasks.erase(tasks.begin(), tasks.begin() + static_cast<::std::ptrdiff_t>(head));
+					head = 0;
+				}
+			}
+		};
+		/// <summary>Tracks the completion of the tasks of one <see cref="parallel_for"/> and the first error raised by them.</summary>
+		class task_group {
+		public:
+			explicit task_group(::std::size_t tasks) : _remaining(tasks) {}
+			/// <summary>Runs one task of the group, returning whether it was the last one to finish.</summary>
+			template<class _Fn>
+			bool run(_Fn &fn, ::std::size_t task) {
+				try { fn(task); }
+				catch (...) {
+					::std::lock_guard<::std::mutex> lock(_error_lock);
+					if (!_error) _error = ::std::current_exception();
+				}
+				return _remaining.fetch_sub(1, ::std::memory_order_acq_rel) == 1;
+			}
+			inline bool done() const { return _remaining.load(::std::memory_order_acquire) == 0; }
+			inline void rethrow() { if (_error) ::std::rethrow_exception(_error); }
+		private:
+			::std::atomic<::std::size_t> _remaining;
+			::std::mutex _error_lock;
+			::std::exception_ptr _error;
+		};
+
+		/// <summary>Value of <see cref="_self"/> on threads which are not workers of this pool, and so own no queue.</summary>
+		static constexpr ::std::size_t _outside = static_cast<::std::size_t>(-1);
+		/// <summary>Index of the queue owned by the calling thread, or <see cref="_outside"/> for threads outside of the pool.</summary>
+		inline ::std::size_t _self() const {
+			return _current_pool() == this ? _current_index() : _outside;
+		}
+		static const thread_pool*& _current_pool() { static thread_local const thread_pool *pool = nullptr; return pool; }
+		static ::std::size_t& _current_index() { static thread_local ::std::size_t index = 0; return index; }
+
+		void _push(::std::size_t self, ::std::function<void()> &&task) {
+			// Workers keep their own tasks close; outside threads spread theirs over the workers
+			::std::size_t target = self != _outside ? self : _next.fetch_add(1, ::std::memory_order_relaxed) % _threads.size();
+			{
+				::std::lock_guard<::std::mutex> lock(_queues[target]->lock);
+				_queues[target]->tasks.push_back(::std::move(task));
+			}
+			_pending.fetch_add(1, ::std::memory_order_release);
+			{
+				::std::lock_guard<::std::mutex> lock(_sleep_lock);
+			}
+			_wake.notify_one();
+		}
+		/// <summary>Wakes the threads sleeping in <see cref="parallel_for"/> once the last task of a group has finished.</summary>
+		void _finished() {
+			{
+				::std::lock_guard<::std::mutex> lock(_sleep_lock);
+			}
+			_wake.notify_all();
+		}
+		bool _try_run(::std::size_t self) {
+			::std::function<void()> task;
+			if (self != _outside) {
+				// Newest task from our own queue first
+				::std::lock_guard<::std::mutex> lock(_queues[self]->lock);
+				if (!_queues[self]->empty()) {
+					task = _queues[self]->take_back();
+				}
+			}
+			// Then steal the oldest task from everyone else, starting after our own queue
+			const ::std::size_t l = _queues.size(), first = self != _outside ? self + 1 : 0, victims = self != _outside ? l - 1 : l;
+			for (::std::size_t c = 0; !task && c < victims; c++) {
+				task_queue &victim = *_queues[(first + c) % l];
+				::std::lock_guard<::std::mutex> lock(victim.lock);
+				if (!victim.empty()) {
+					task = victim.take_front();
+				}
+			}
+			if (!task) return false;
+			_pending.fetch_sub(1, ::std::memory_order_acq_rel);
+			task();
+			return true;
+		}
+		void _work(::std::size_t index) {
+			_current_pool() = this;
+			_current_index() = index;
+			for (;;) {
+				if (_try_run(index)) continue;
+				::std::unique_lock<::std::mutex> lock(_sleep_lock);
+				_wake.wait(lock, [this] { return _stop || _pending.load(::std::memory_order_acquire) > 0; });
+				if (_stop && _pending.load(::std::memory_order_acquire) == 0) return;
+			}
+		}
+
+		::std::vector<::std::unique_ptr<task_queue>> _queues;
+		::std::vector<::std::thread> _threads;
+		::std::atomic<::std::size_t> _pending;
+		::std::atomic<::std::size_t> _next;
+		::std::mutex _sleep_lock;
+		::std::condition_variable _wake;
+		bool _stop;
+	};
+
+	/// <summary>
+	/// Execution policy requesting the sequential version of an operator. Exists so generic code can pass either policy.
+	/// </summary>
+	struct sequenced_policy {};
+	/// <summary>
+	/// Execution policy requesting the parallel version of an operator. Parallel operators produce exactly the same elements,
+	/// in the same order, as their sequential versions; the lambdas given to them must be safe to call concurrently.
+	/// </summary>
+	struct parallel_policy {
+		/// <summary>Pool to run on; null for <see cref="thread_pool::shared"/>.</summary>
+		thread_pool *pool;
+		/// <summary>Smallest number of elements worth handing to a single task.</summary>
+		::std::size_t grain;
+
+		constexpr parallel_policy(thread_pool *_Pool = nullptr, ::std::size_t _Grain = 4096) : pool(_Pool), grain(_Grain) {}
+
+		/// <summary>Copy of this policy which runs on the provided pool.</summary>
+		constexpr parallel_policy on(thread_pool &_Pool) const { return parallel_policy(&_Pool, grain); }
+		/// <summary>Copy of this policy with a different minimum number of elements per task.</summary>
+		constexpr parallel_policy with_grain(::std::size_t _Grain) const { return parallel_policy(pool, _Grain); }
+		inline thread_pool& get_pool() const { return pool ? *pool : thread_pool::shared(); }
+	};
+	/// <summary>Trait for whether <typeparamref name="_Ty"/> is one of the execution policies.</summary>
+	template<class _Ty>
+	struct is_execution_policy : ::std::integral_constant<bool,
+		::std::is_same<::std::decay_t<_Ty>, sequenced_policy>::value || ::std::is_same<::std::decay_t<_Ty>, parallel_policy>::value> {};
+
+	/// <summary>Runs an operator sequentially.</summary>
+	constexpr sequenced_policy seq{};
+	/// <summary>Runs an operator in parallel on the shared <see cref="thread_pool"/>. Use <c>linq::par.on(pool)</c> for another pool.</summary>
+	constexpr parallel_policy par{};
+
+	namespace core {
+		/// <summary>
+		/// Start of the <paramref name="task"/>'th of <paramref name="tasks"/> equally sized slices of <paramref name="count"/> elements.
+		/// The end of a slice is the start of the next one.
+		/// </summary>
+		inline ::std::size_t slice_begin(::std::size_t count, ::std::size_t tasks, ::std::size_t task) {
+			return static_cast<::std::size_t>(static_cast<unsigned long long>(count) * task / tasks);
+		}
+
+		/// <summary>
+		/// Finds how many elements of the sorted range <paramref name="a"/> are among the first <paramref name="outputs"/>
+		/// elements of the stable merge of <paramref name="a"/> and <paramref name="b"/>. Lets a single merge be split
+		/// into independent pieces.
+		/// </summary>
+		template<class _Iter, class _Pr>
+		::std::size_t merge_corank(::std::size_t outputs, _Iter a, ::std::size_t na, _Iter b, ::std::size_t nb, _Pr &pred) {
+			::std::size_t lo = outputs > nb ? outputs - nb : 0, hi = ::std::min(outputs, na);
+			while (lo < hi) {
+				::std::size_t mid = lo + (hi - lo) / 2, j = outputs - mid;
+				// a[mid] belongs in front of b[j - 1], so more elements must be taken from a
+				if (j > 0 && !pred(b[j - 1], a[mid])) lo = mid + 1;
+				else hi = mid;
+			}
+			return lo;
+		}
+
+		/// <summary>
+		/// Stable parallel merge sort. Slices of the range are sorted concurrently, after which neighbouring runs are merged
+		/// in rounds, with every merge split into independent pieces so the later rounds keep all threads busy. The result
+		/// is identical to <see cref="std::stable_sort"/>.
+		/// </summary>
+		template<class _Ty, class _Pr>
+		void parallel_stable_sort(_Ty *data, ::std::size_t count, _Pr &pred, thread_pool &pool, ::std::size_t grain) {
+			const ::std::size_t tasks = pool.partition(count, grain);
+			if (tasks <= 1) {
+				::std::stable_sort(data, data + count, pred);
+				return;
+			}
+			::std::vector<::std::size_t> runs(tasks + 1);
+			for (::std::size_t t = 0; t <= tasks; t++) {
+				runs[t] = slice_begin(count, tasks, t);
+			}
+			pool.parallel_for(tasks, [&](::std::size_t t) { ::std::stable_sort(data + runs[t], data + runs[t + 1], pred); });
+
+			::std::vector<_Ty> buffer(::std::make_move_iterator(data), ::std::make_move_iterator(data + count));
+			_Ty *src = buffer.data(), *dst = data;
+			struct piece { ::std::size_t a, na, b, nb, out; };
+			::std::vector<piece> pieces;
+			while (runs.size() > 2) {
+				pieces.clear();
+				::std::vector<::std::size_t> merged;
+				for (::std::size_t r = 0; r + 1 < runs.size(); r += 2) {
+					merged.push_back(runs[r]);
+					if (r + 2 >= runs.size()) {
+						// Odd run out, carried over as it is
+						pieces.push_back({ runs[r], runs[r + 1] - runs[r], runs[r + 1], 0, runs[r] });
+						continue;
+					}
+					::std::size_t a = runs[r], na = runs[r + 1] - a, b = runs[r + 1], nb = runs[r + 2] - b;
+					::std::size_t parts = ::std::max<::std::size_t>(1, (na + nb) * tasks / count);
+					::std::size_t prev_i = 0, prev_d = 0;
+					for (::std::size_t p = 1; p <= parts; p++) {
+						::std::size_t d = slice_begin(na + nb, parts, p);
+						::std::size_t i = merge_corank(d, src + a, na, src + b, nb, pred);
+						pieces.push_back({ a + prev_i, i - prev_i, b + (prev_d - prev_i), (d - i) - (prev_d - prev_i), a + prev_d });
+						prev_i = i;
+						prev_d = d;
+					}
+				}
+				merged.push_back(count);
+				pool.parallel_for(pieces.size(), [&](::std::size_t p) {
+					const piece &pc = pieces[p];
+					::std::merge(::std::make_move_iterator(src + pc.a), ::std::make_move_iterator(src + pc.a + pc.na),
+						::std::make_move_iterator(src + pc.b), ::std::make_move_iterator(src + pc.b + pc.nb), dst + pc.out, pred);
+				});
+				runs.swap(merged);
+				::std::swap(src, dst);
+			}
+			if (src != data) {
+				pool.parallel_for(tasks, [&](::std::size_t t) {
+					::std::move(src + slice_begin(count, tasks, t), src + slice_begin(count, tasks, t + 1), data + slice_begin(count, tasks, t));
+				});
+			}
+		}
+
+		/// <summary>
+		/// Splits the elements of a random access range into 2^bits partitions by the hash of their keys, in parallel, so that
+		/// equal keys always fall into the same partition. Keeps the hash of every key, and lists the positions falling into
+		/// each partition in ascending order, ready to be visited through a <see cref="set_side"/>.
+		/// </summary>
+		template<class _Key>
+		class hash_partition {
+		public:
+			template<class _Iter, class _Fn>
+			void build(thread_pool &pool, ::std::size_t grain, _Iter first, ::std::size_t count, _Fn &selector, unsigned bits) {
+				const ::std::size_t partitions = ::std::size_t(1) << bits, tasks = pool.partition(count, grain);
+				_hashes.resize(count);
+				_positions.resize(count);
+				::std::vector<::std::size_t> offsets(tasks * partitions, 0);
+				const ::std::hash<_Key> hasher;
+				pool.parallel_for(tasks, [&](::std::size_t t) {
+					::std::size_t *counts = offsets.data() + t * partitions;
+					for (::std::size_t c = slice_begin(count, tasks, t), l = slice_begin(count, tasks, t + 1); c < l; c++) {
+						_hashes[c] = hasher(static_cast<_Key>(selector(first[c])));
+						counts[_partition(_hashes[c], bits)]++;
+					}
+				});
+				// Each slice writes its positions after those of the slices before it, so every partition stays in order
+				_starts.assign(partitions + 1, 0);
+				::std::size_t offset = 0;
+				for (::std::size_t p = 0; p < partitions; p++) {
+					_starts[p] = offset;
+					for (::std::size_t t = 0; t < tasks; t++) {
+						const ::std::size_t n = offsets[t * partitions + p];
+						offsets[t * partitions + p] = offset;
+						offset += n;
+					}
+				}
+				_starts[partitions] = offset;
+				pool.parallel_for(tasks, [&](::std::size_t t) {
+					::std::size_t *next = offsets.data() + t * partitions;
+					for (::std::size_t c = slice_begin(count, tasks, t), l = slice_begin(count, tasks, t + 1); c < l; c++) {
+						_positions[next[_partition(_hashes[c], bits)]++] = c;
+					}
+				});
+			}
+			/// <summary>The elements of partition <paramref name="p"/> of the range the partitions were built from.</summary>
+			template<class _Iter, class _Fn>
+			inline set_side<_Iter, _Fn> side(::std::size_t p, _Iter first, _Fn &selector) const {
+				return { first, _starts[p + 1] - _starts[p], &selector, _positions.data() + _starts[p], _hashes.data() };
+			}
+
+		private:
+			/// <summary>
+			/// Picks the partition by mixing the hash with a different multiplier from <see cref="hash_bucket"/> and the
+			/// <see cref="bloom_filter"/>, so the bits they use still vary among the keys of one partition.
+			/// </summary>
+			static inline ::std::size_t _partition(::std::size_t hash, unsigned bits) {
+				return bits ? static_cast<::std::size_t>((static_cast<unsigned long long>(hash) * 0xD6E8FEB86659FD93ull) >> (64 - bits)) : 0;
+			}
+
+
+			::std::vector<::std::size_t> _hashes;
+			::std::vector<::std::size_t> _positions;
+			::std::vector<::std::size_t> _starts;
+		};
+	}
+
+
+	namespace core {
+		/// <summary>Comparison made by a single term of an <see cref="item_predicate"/>.</summary>
+		enum class compare_op : unsigned char { lt, le, gt, ge, eq, ne };
+
+		/// <summary>Comparison of an element against a constant <paramref name="value"/>.</summary>
+		template<class _Val>
+		struct compare_term {
+			compare_op op;
+			_Val value;
+		};
+
+		/// <summary>
+		/// Compares the <paramref name="_Item"/> element against the <paramref name="_Value"/> constant.
+		/// </summary>
+		template<class _Ty, class _Val>
+		inline bool compare(compare_op op, const _Ty &_Item, const _Val &_Value) {
+			switch (op) {
+			case compare_op::lt: return _Item < _Value;
+			case compare_op::le: return _Item <= _Value;
+			case compare_op::gt: return _Item > _Value;
+			case compare_op::ge: return _Item >= _Value;
+			case compare_op::eq: return _Item == _Value;
+			case compare_op::ne: return _Item != _Value;
+			}
+			return false;
+		}
+
+		/// <summary>
+		/// Structured condition made of a conjunction of <typeparamref name="_N"/> comparisons of the element against constants.
+		/// It is called like any other condition, but <see cref="linq::array::where"/> can also see inside it and run it
+		/// through the vectorized filter kernels for arrays of int, float and double. Built with <see cref="linq::item"/>.
+		/// </summary>
+		/// <typeparam name="_Val">Type of the constants compared against.</typeparam>
+		/// <typeparam name="_N">Number of comparisons which must all hold.</typeparam>
+		template<class _Val, ::std::size_t _N>
+		class item_predicate {
+		public:
+			typedef _Val value_type;
+
+			item_predicate(compare_op op, _Val value) : _terms{ { op, value } } {
+				static_assert(_N == 1, "a single comparison has one term");
+			}
+			template<class _Val1, ::std::size_t _N1, class _Val2, ::std::size_t _N2>
+			item_predicate(const item_predicate<_Val1, _N1> &_Left, const item_predicate<_Val2, _N2> &_Right) {
+				static_assert(_N == _N1 + _N2, "a conjunction holds the terms of both sides");
+				for (::std::size_t c = 0; c < _N1; c++) {
+					_terms[c] = { _Left[c].op, static_cast<_Val>(_Left[c].value) };
+				}
+				for (::std::size_t c = 0; c < _N2; c++) {
+					_terms[_N1 + c] = { _Right[c].op, static_cast<_Val>(_Right[c].value) };
+				}
+			}
+
+			/// <summary>Tests the provided element against every term.</summary>
+			template<class _Ty>
+			inline bool operator()(const _Ty &item) const {
+				for (::std::size_t c = 0; c < _N; c++) {
+					if (!compare(_terms[c].op, item, _terms[c].value)) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			static constexpr ::std::size_t size() { return _N; }
+			inline const compare_term<_Val>& operator[](::std::size_t index) const { return _terms[index]; }
+
+		private:
+			compare_term<_Val> _terms[_N];
+		};
+
+		/// <summary>
+		/// Joins two structured conditions so that both must hold. Constants of different types are converted to their common type.
+		/// </summary>
+		template<class _Val1, ::std::size_t _N1, class _Val2, ::std::size_t _N2>
+		inline item_predicate<::std::common_type_t<_Val1, _Val2>, _N1 + _N2> operator&&(const item_predicate<_Val1, _N1> &_Left, const item_predicate<_Val2, _N2> &_Right) {
+			return { _Left, _Right };
+		}
+
+		/// <summary>
+		/// Branch free filtering kernels. Each filters <c>count</c> elements from <c>in</c> into <c>out</c>, which must either
+		/// have room for <c>count</c> elements or be the same as <c>in</c>, and returns how many elements were kept. Every
+		/// kernel writes each element before deciding whether to keep it, and the vector kernels write whole vectors of
+		/// elements at a time, so they never write past the position of the element being read and can filter in place.
+		/// </summary>
+		namespace simd {
+			/// <summary>Instruction sets the filter kernels are compiled for, from least to most capable.</summary>
+			enum class isa { scalar, ssse3, avx2, avx512 };
+
+			/// <summary>Most terms a vector kernel will hold in registers; longer conjunctions use the scalar kernel.</summary>
+			const ::std::size_t max_terms = 8;
+			/// <summary>Number of independent accumulators the summing kernels add the elements into.</summary>
+			const ::std::size_t sum_lanes = 16;
+
+			/// <summary>Adds two values, wrapping around on overflow for integers as the vector instructions do.</summary>
+			template<class _Ty>
+			inline _Ty wrapping_add(_Ty a, _Ty b) { return a + b; }
+			inline ::std::int32_t wrapping_add(::std::int32_t a, ::std::int32_t b) {
+				return static_cast<::std::int32_t>(static_cast<::std::uint32_t>(a) + static_cast<::std::uint32_t>(b));
+			}
+
+			/// <summary>
+			/// Scalar filter kernel, used when no vector kernel is available and for the elements left over after the last whole vector.
+			/// </summary>
+			template<class _Ty>
+			::std::size_t filter_scalar(const _Ty *in, ::std::size_t count, _Ty *out, const compare_term<_Ty> *terms, ::std::size_t nterms) {
+				::std::size_t kept = 0;
+				for (::std::size_t c = 0; c < count; c++) {
+					const _Ty item = in[c];
+					bool pass = true;
+					for (::std::size_t t = 0; t < nterms; t++) {
+						pass &= compare(terms[t].op, item, terms[t].value);
+					}
+					out[kept] = item;
+					kept += pass;
+				}
+				return kept;
+			}
+
+			/// <summary>
+			/// Sums every element into the accumulators which follow each other in <paramref name="lanes"/>, the c'th element going to the
+			/// accumulator c % <see cref="sum_lanes"/>. The vector kernels hold these same accumulators in their registers, so every
+			/// kernel adds exactly the same numbers in exactly the same order and gives bit for bit the same floating point sums.
+			/// </summary>
+			template<class _Ty>
+			void sum_scalar(const _Ty *in, ::std::size_t count, _Ty *lanes) {
+				for (::std::size_t c = 0; c < count; c++) {
+					lanes[c % sum_lanes] = wrapping_add(lanes[c % sum_lanes], in[c]);
+				}
+			}
+			/// <summary>
+			/// Finds the smallest and the largest of at least one element.
+			/// </summary>
+			/// <returns>False if a NaN was found, in which case <paramref name="low"/> and <paramref name="high"/> are unspecified.</returns>
+			template<class _Ty>
+			bool extrema_scalar(const _Ty *in, ::std::size_t count, _Ty &low, _Ty &high) {
+				low = high = in[0];
+				bool ordered = true;
+				for (::std::size_t c = 0; c < count; c++) {
+					const _Ty item = in[c];
+					ordered &= item == item;
+					if (item < low) low = item;
+					if (high < item) high = item;
+				}
+				return ordered;
+			}
+			/// <summary>Counts the elements which satisfy every term.</summary>
+			template<class _Ty>
+			::std::size_t count_scalar(const _Ty *in, ::std::size_t count, const compare_term<_Ty> *terms, ::std::size_t nterms) {
+				::std::size_t kept = 0;
+				for (::std::size_t c = 0; c < count; c++) {
+					bool pass = true;
+					for (::std::size_t t = 0; t < nterms; t++) {
+						pass &= compare(terms[t].op, in[c], terms[t].value);
+					}
+					kept += pass;
+				}
+				return kept;
+			}
+
+#ifdef LINQ_SIMD_X86
+			/// <summary>
+			/// Finds the most capable instruction set supported by both the processor and the operating system.
+			/// </summary>
+			inline isa detect() {
+#if defined(_MSC_VER) && !defined(__clang__)
+				int info[4];
+				__cpuid(info, 0);
+				const int leaves = info[0];
+				__cpuid(info, 1);
+				const bool ssse3 = (info[2] & (1 << 9)) != 0, osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+				if (!ssse3) return isa::scalar;
+				if (!osxsave || !avx || leaves < 7) return isa::ssse3;
+				const unsigned long long xcr0 = _xgetbv(0);
+				if ((xcr0 & 0x6) != 0x6) return isa::ssse3;
+				__cpuidex(info, 7, 0);
+				if ((info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6) return isa::avx512;
+				if ((info[1] & (1 << 5)) != 0) return isa::avx2;
+				return isa::ssse3;
+#else
+				__builtin_cpu_init();
+				if (__builtin_cpu_supports("avx512f")) return isa::avx512;
+				if (__builtin_cpu_supports("avx2")) return isa::avx2;
+				if (__builtin_cpu_supports("ssse3")) return isa::ssse3;
+				return isa::scalar;
+#endif
+			}
+#endif
+
+			/// <summary>
+			/// Instruction set the filter kernels run with, detected once on first use. Always scalar when <c>LINQ_NO_SIMD</c>
+			/// is defined or the target is not x86.
+			/// </summary>
+			inline isa level() {
+#ifdef LINQ_SIMD_X86
+				static const isa detected = detect();
+				return detected;
+#else
+				return isa::scalar;
+#endif
+			}
+
+#ifdef LINQ_SIMD_X86
+			inline unsigned popcount(unsigned bits) {
+#if defined(_MSC_VER) && !defined(__clang__)
+				return __popcnt(bits);
+#else
+				return static_cast<unsigned>(__builtin_popcount(bits));
+#endif
+			}
+
+			/// <summary>
+			/// Lookup tables moving the kept 32-bit lanes of a vector to its front. The masks index lanes of 32 bits even for doubles,
+			/// whose compare results set both halves of a lane, so the same tables serve every element type.
+			/// </summary>
+			struct compress_tables {
+				/// <summary>Eight 4-bit lane indices per AVX2 mask, for <c>_mm256_permutevar8x32_epi32</c>.</summary>
+				::std::uint32_t avx2[256];
+				/// <summary>Byte shuffle per SSSE3 mask, for <c>_mm_shuffle_epi8</c>.</summary>
+				alignas(16) ::std::uint8_t ssse3[16][16];
+
+				compress_tables() {
+					for (unsigned mask = 0; mask < 256; mask++) {
+						::std::uint32_t packed = 0;
+						unsigned kept = 0;
+						for (unsigned lane = 0; lane < 8; lane++) {
+							if (mask & (1u << lane)) {
+								packed |= lane << (4 * kept++);
+							}
+						}
+						avx2[mask] = packed;
+					}
+					for (unsigned mask = 0; mask < 16; mask++) {
+						unsigned kept = 0;
+						for (unsigned lane = 0; lane < 4; lane++) {
+							if (mask & (1u << lane)) {
+								for (unsigned byte = 0; byte < 4; byte++) {
+									ssse3[mask][4 * kept + byte] = static_cast<::std::uint8_t>(4 * lane + byte);
+								}
+								kept++;
+							}
+						}
+						for (unsigned byte = 4 * kept; byte < 16; byte++) {
+							ssse3[mask][byte] = 0x80;
+						}
+					}
+				}
+				static const compress_tables& get() {
+					static const compress_tables tables;
+					return tables;
+				}
+			};
+
+			/// <summary>Per element type SSSE3 operations, with comparisons returning one mask bit per 32-bit lane.</summary>
+			template<class _Ty>
+			struct ssse3_ops;
+			template<>
+			struct ssse3_ops<::std::int32_t> {
+				typedef __m128i vec;
+				LINQ_TARGET_SSSE3 static vec load(const ::std::int32_t *src) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)); }
+				LINQ_TARGET_SSSE3 static vec broadcast(::std::int32_t value) { return _mm_set1_epi32(value); }
+				LINQ_TARGET_SSSE3 static vec zero() { return _mm_setzero_si128(); }
+				LINQ_TARGET_SSSE3 static void store(::std::int32_t *dst, vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v); }
+				LINQ_TARGET_SSSE3 static vec add(vec a, vec b) { return _mm_add_epi32(a, b); }
+				// SSSE3 has no 32-bit integer min or max, so select with a compare instead
+				LINQ_TARGET_SSSE3 static vec min(vec a, vec b) { const __m128i greater = _mm_cmpgt_epi32(a, b); return _mm_or_si128(_mm_and_si128(greater, b), _mm_andnot_si128(greater, a)); }
+				LINQ_TARGET_SSSE3 static vec max(vec a, vec b) { const __m128i greater = _mm_cmpgt_epi32(a, b); return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b)); }
+				LINQ_TARGET_SSSE3 static vec unordered(vec nans, vec) { return nans; }
+				LINQ_TARGET_SSSE3 static bool any(vec) { return false; }
+				LINQ_TARGET_SSSE3 static __m128i bits(vec v) { return v; }
+				LINQ_TARGET_SSSE3 static unsigned mask(vec v, vec value, compare_op op) {
+					switch (op) {
+					case compare_op::lt: return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, value)));
+					case compare_op::le: return ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, value))) & 0xf;
+					case compare_op::gt: return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, value)));
+					case compare_op::ge: return ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, value))) & 0xf;
+					case compare_op::eq: return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, value)));
+					case compare_op::ne: return ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, value))) & 0xf;
+					}
+					return 0;
+				}
+			};
+			template<>
+			struct ssse3_ops<float> {
+				typedef __m128 vec;
+				LINQ_TARGET_SSSE3 static vec load(const float *src) { return _mm_loadu_ps(src); }
+				LINQ_TARGET_SSSE3 static vec broadcast(float value) { return _mm_set1_ps(value); }
+				LINQ_TARGET_SSSE3 static vec zero() { return _mm_setzero_ps(); }
+				LINQ_TARGET_SSSE3 static void store(float *dst, vec v) { _mm_storeu_ps(dst, v); }
+				LINQ_TARGET_SSSE3 static vec add(vec a, vec b) { return _mm_add_ps(a, b); }
+				LINQ_TARGET_SSSE3 static vec min(vec a, vec b) { return _mm_min_ps(a, b); }
+				LINQ_TARGET_SSSE3 static vec max(vec a, vec b) { return _mm_max_ps(a, b); }
+				LINQ_TARGET_SSSE3 static vec unordered(vec nans, vec v) { return _mm_or_ps(nans, _mm_cmpunord_ps(v, v)); }
+				LINQ_TARGET_SSSE3 static bool any(vec v) { return _mm_movemask_ps(v) != 0; }
+				LINQ_TARGET_SSSE3 static __m128i bits(vec v) { return _mm_castps_si128(v); }
+				LINQ_TARGET_SSSE3 static unsigned mask(vec v, vec value, compare_op op) {
+					switch (op) {
+					case compare_op::lt: return _mm_movemask_ps(_mm_cmplt_ps(v, value));
+					case compare_op::le: return _mm_movemask_ps(_mm_cmple_ps(v, value));
+					case compare_op::gt: return _mm_movemask_ps(_mm_cmpgt_ps(v, value));
+					case compare_op::ge: return _mm_movemask_ps(_mm_cmpge_ps(v, value));
+					case compare_op::eq: return _mm_movemask_ps(_mm_cmpeq_ps(v, value));
+					case compare_op::ne: return _mm_movemask_ps(_mm_cmpneq_ps(v, value));
+					}
+					return 0;
+				}
+			};
+			template<>
+			struct ssse3_ops<double> {
+				typedef __m128d vec;
+				LINQ_TARGET_SSSE3 static vec load(const double *src) { return _mm_loadu_pd(src); }
+				LINQ_TARGET_SSSE3 static vec broadcast(double value) { return _mm_set1_pd(value); }
+				LINQ_TARGET_SSSE3 static vec zero() { return _mm_setzero_pd(); }
+				LINQ_TARGET_SSSE3 static void store(double *dst, vec v) { _mm_storeu_pd(dst, v); }
+				LINQ_TARGET_SSSE3 static vec add(vec a, vec b) { return _mm_add_pd(a, b); }
+				LINQ_TARGET_SSSE3 static vec min(vec a, vec b) { return _mm_min_pd(a, b); }
+				LINQ_TARGET_SSSE3 static vec max(vec a, vec b) { return _mm_max_pd(a, b); }
+				LINQ_TARGET_SSSE3 static vec unordered(vec nans, vec v) { return _mm_or_pd(nans, _mm_cmpunord_pd(v, v)); }
+				LINQ_TARGET_SSSE3 static bool any(vec v) { return _mm_movemask_pd(v) != 0; }
+				LINQ_TARGET_SSSE3 static __m128i bits(vec v) { return _mm_castpd_si128(v); }
+				LINQ_TARGET_SSSE3 static unsigned mask(vec v, vec value, compare_op op) {
+					switch (op) {
+					case compare_op::lt: return _mm_movemask_ps(_mm_castpd_ps(_mm_cmplt_pd(v, value)));
+					case compare_op::le: return _mm_movemask_ps(_mm_castpd_ps(_mm_cmple_pd(v, value)));
+					case compare_op::gt: return _mm_movemask_ps(_mm_castpd_ps(_mm_cmpgt_pd(v, value)));
+					case compare_op::ge: return _mm_movemask_ps(_mm_castpd_ps(_mm_cmpge_pd(v, value)));
+					case compare_op::eq: return _mm_movemask_ps(_mm_castpd_ps(_mm_cmpeq_pd(v, value)));
+					case compare_op::ne: return _mm_movemask_ps(_mm_castpd_ps(_mm_cmpneq_pd(v, value)));
+					}
+					return 0;
+				}
+			};
+
+			/// <summary>SSSE3 filter kernel, compacting the kept lanes of each 16 byte vector with a byte shuffle.</summary>
+			template<class _Ty>
+			LINQ_TARGET_SSSE3 ::std::size_t filter_ssse3(const _Ty *in, ::std::size_t count, _Ty *out, const compare_term<_Ty> *terms, ::std::size_t nterms) {
+				typedef ssse3_ops<_Ty> ops;
+				const ::std::size_t lanes = 16 / sizeof(_Ty);
+				typename ops::vec values[max_terms];
+				for (::std::size_t t = 0; t < nterms; t++) {
+					values[t] = ops::broadcast(terms[t].value);
+				}
+				const compress_tables &tables = compress_tables::get();
+				::std::size_t kept = 0, c = 0;
+				for (; c + lanes <= count; c += lanes) {
+					const typename ops::vec v = ops::load(in + c);
+					unsigned mask = 0xf;
+					for (::std::size_t t = 0; t < nterms; t++) {
+						mask &= ops::mask(v, values[t], terms[t].op);
+					}
+					const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(tables.ssse3[mask]));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + kept), _mm_shuffle_epi8(ops::bits(v), shuffle));
+					// Processors with only SSSE3 may lack the popcnt instruction
+					kept += ((0x4332322132212110ull >> (4 * mask)) & 0xf) * 4 / sizeof(_Ty);
+				}
+				return kept + filter_scalar(in + c, count - c, out + kept, terms, nterms);
+			}
+
+			/// <summary>SSSE3 summing kernel, see <see cref="sum_scalar"/>.</summary>
+			template<class _Ty>
+			LINQ_TARGET_SSSE3 void sum_ssse3(const _Ty *in, ::std::size_t count, _Ty *lanes) {
+				typedef ssse3_ops<_Ty> ops;
+				const ::std::size_t width = 16 / sizeof(_Ty), regs = sum_lanes / width;
+				typename ops::vec acc[regs];
+				for (::std::size_t r = 0; r < regs; r++) {
+					acc[r] = ops::load(lanes + r * width);
+				}
+				::std::size_t c = 0;
+				for (; c + sum_lanes <= count; c += sum_lanes) {
+					for (::std::size_t r = 0; r < regs; r++) {
+						acc[r] = ops::add(acc[r], ops::load(in + c + r * width));
+					}
+				}
+				for (::std::size_t r = 0; r < regs; r++) {
+					ops::store(lanes + r * width, acc[r]);
+				}
+				sum_scalar(in + c, count - c, lanes);
+			}
+			/// <summary>SSSE3 extrema kernel, see <see cref="extrema_scalar"/>.</summary>
+			template<class _Ty>
+			LINQ_TARGET_SSSE3 bool extrema_ssse3(const _Ty *in, ::std::size_t count, _Ty &low, _Ty &high) {
+				typedef ssse3_ops<_Ty> ops;
+				const ::std::size_t width = 16 / sizeof(_Ty);
+				if (count < 2 * width) {
+					return extrema_scalar(in, count, low, high);
+				}
+				typename ops::vec lo = ops::load(in), hi = lo;
+				typename ops::vec nans = ops::unordered(ops::zero(), lo);
+				::std::size_t c = width;
+				for (; c + width <= count; c += width) {
+					const typename ops::vec v = ops::load(in + c);
+					lo = ops::min(lo, v);
+					hi = ops::max(hi, v);
+					nans = ops::unordered(nans, v);
+				}
+				if (ops::any(nans)) {
+					return false;
+				}
+				_Ty lows[width], highs[width];
+				ops::store(lows, lo);
+				ops::store(highs, hi);
+				// None of the lanes hold a NaN, so plain comparisons find the extrema among them
+				low = lows[0];
+				high = highs[0];
+				for (::std::size_t l = 1; l < width; l++) {
+					if (lows[l] < low) low = lows[l];
+					if (high < highs[l]) high = highs[l];
+				}
+				for (; c < count; c++) {
+					if (in[c] != in[c]) return false;
+					if (in[c] < low) low = in[c];
+					if (high < in[c]) high = in[c];
+				}
+				return true;
+			}
+			/// <summary>SSSE3 counting kernel, see <see cref="count_scalar"/>.</summary>
+			template<class _Ty>
+			LINQ_TARGET_SSSE3 ::std::size_t count_ssse3(const _Ty *in, ::std::size_t count, const compare_term<_Ty> *terms, ::std::size_t nterms) {
+				typedef ssse3_ops<_Ty> ops;
+				const ::std::size_t width = 16 / sizeof(_Ty);
+				typename ops::vec values[max_terms];
+				for (::std::size_t t = 0; t < nterms; t++) {
+					values[t] = ops::broadcast(terms[t].value);
+				}
+				::std::size_t kept = 0, c = 0;
+				for (; c + width <= count; c += width) {
+					const typename ops::vec v = ops::load(in + c);
+					unsigned mask = ~0u;
+					for (::std::size_t t = 0; t < nterms; t++) {
+						mask &= ops::mask(v, values[t], terms[t].op);
+					}
+					kept += ((0x4332322132212110ull >> (4 * mask)) & 0xf) * 4 / sizeof(_Ty);
+				}
+				return kept + count_scalar(in + c, count - c, terms, nterms);
+			}
+
+			/// <summary>Per element type AVX2 operations, with comparisons returning one mask bit per 32-bit lane.</summary>
+			template<class _Ty>
+			struct avx2_ops;
+			template<>
+			struct avx2_ops<::std::int32_t> {
+				typedef __m256i vec;
+				LINQ_TARGET_AVX2 static vec load(const ::std::int32_t *src) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)); }
+				LINQ_TARGET_AVX2 static vec broadcast(::std::int32_t value) { return _mm256_set1_epi32(value); }
+				LINQ_TARGET_AVX2 static vec zero() { return _mm256_setzero_si256(); }
+				LINQ_TARGET_AVX2 static void store(::std::int32_t *dst, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), v); }
+				LINQ_TARGET_AVX2 static vec add(vec a, vec b) { return _mm256_add_epi32(a, b); }
+				LINQ_TARGET_AVX2 static vec min(vec a, vec b) { return _mm256_min_epi32(a, b); }
+				LINQ_TARGET_AVX2 static vec max(vec a, vec b) { return _mm256_max_epi32(a, b); }
+				LINQ_TARGET_AVX2 static vec unordered(vec nans, vec) { return nans; }
+				LINQ_TARGET_AVX2 static bool any(vec) { return false; }
+				LINQ_TARGET_AVX2 static __m256i bits(vec v) { return v; }
+				LINQ_TARGET_AVX2 static unsigned mask(vec v, vec value, compare_op op) {
+					switch (op) {
+					case compare_op::lt: return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(value, v)));
+					case compare_op::le: return ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, value))) & 0xff;
+					case compare_op::gt: return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, value)));
+					case compare_op::ge: return ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(value, v))) & 0xff;
+					case compare_op::eq: return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, value)));
+					case compare_op::ne: return ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, value))) & 0xff;
+					}
+					return 0;
+				}
+			};
+			template<>
+			struct avx2_ops<float> {
+				typedef __m256 vec;
+				LINQ_TARGET_AVX2 static vec load(const float *src) { return _mm256_loadu_ps(src); }
+				LINQ_TARGET_AVX2 static vec broadcast(float value) { return _mm256_set1_ps(value); }
+				LINQ_TARGET_AVX2 static vec zero() { return _mm256_setzero_ps(); }
+				LINQ_TARGET_AVX2 static void store(float *dst, vec v) { _mm256_storeu_ps(dst, v); }
+				LINQ_TARGET_AVX2 static vec add(vec a, vec b) { return _mm256_add_ps(a, b); }
+				LINQ_TARGET_AVX2 static vec min(vec a, vec b) { return _mm256_min_ps(a, b); }
+				LINQ_TARGET_AVX2 static vec max(vec a, vec b) { return _mm256_max_ps(a, b); }
+				LINQ_TARGET_AVX2 static vec unordered(vec nans, vec v) { return _mm256_or_ps(nans, _mm256_cmp_ps(v, v, _CMP_UNORD_Q)); }
+				LINQ_TARGET_AVX2 static bool any(vec v) { return _mm256_movemask_ps(v) != 0; }
+				LINQ_TARGET_AVX2 static __m256i bits(vec v) { return _mm256_castps_si256(v); }
+				LINQ_TARGET_AVX2 static unsigned mask(vec v, vec value, compare_op op) {
+					switch (op) {
+					case compare_op::lt: return _mm256_movemask_ps(_mm256_cmp_ps(v, value, _CMP_LT_OQ));
+					case compare_op::le: return _mm256_movemask_ps(_mm256_cmp_ps(v, value, _CMP_LE_OQ));
+					case compare_op::gt: return _mm256_movemask_ps(_mm256_cmp_ps(v, value, _CMP_GT_OQ));
+					case compare_op::ge: return _mm256_movemask_ps(_mm256_cmp_ps(v, value, _CMP_GE_OQ));
+					case compare_op::eq: return _mm256_movemask_ps(_mm256_cmp_ps(v, value, _CMP_EQ_OQ));
+					case compare_op::ne: return _mm256_movemask_ps(_mm256_cmp_ps(v, value, _CMP_NEQ_UQ));
+					}
+					return 0;
+				}
+			};
+			template<>
+			struct avx2_ops<double> {
+				typedef __m256d vec;
+				LINQ_TARGET_AVX2 static vec load(const double *src) { return _mm256_loadu_pd(src); }
+				LINQ_TARGET_AVX2 static vec broadcast(double value) { return _mm256_set1_pd(value); }
+				LINQ_TARGET_AVX2 static vec zero() { return _mm256_setzero_pd(); }
+				LINQ_TARGET_AVX2 static void store(double *dst, vec v) { _mm256_storeu_pd(dst, v); }
+				LINQ_TARGET_AVX2 static vec add(vec a, vec b) { return _mm256_add_pd(a, b); }
+				LINQ_TARGET_AVX2 static vec min(vec a, vec b) { return _mm256_min_pd(a, b); }
+				LINQ_TARGET_AVX2 static vec max(vec a, vec b) { return _mm256_max_pd(a, b); }
+				LINQ_TARGET_AVX2 static vec unordered(vec nans, vec v) { return _mm256_or_pd(nans, _mm256_cmp_pd(v, v, _CMP_UNORD_Q)); }
+				LINQ_TARGET_AVX2 static bool any(vec v) { return _mm256_movemask_pd(v) != 0; }
+				LINQ_TARGET_AVX2 static __m256i bits(vec v) { return _mm256_castpd_si256(v); }
+				LINQ_TARGET_AVX2 static unsigned mask(vec v, vec value, compare_op op) {
+					switch (op) {
+					case compare_op::lt: return _mm256_movemask_ps(_mm256_castpd_ps(_mm256_cmp_pd(v, value, _CMP_LT_OQ)));
+					case compare_op::le: return _mm256_movemask_ps(_mm256_castpd_ps(_mm256_cmp_pd(v, value, _CMP_LE_OQ)));
+					case compare_op::gt: return _mm256_movemask_ps(_mm256_castpd_ps(_mm256_cmp_pd(v, value, _CMP_GT_OQ)));
+					case compare_op::ge: return _mm256_movemask_ps(_mm256_castpd_ps(_mm256_cmp_pd(v, value, _CMP_GE_OQ)));
+					case compare_op::eq: return _mm256_movemask_ps(_mm256_castpd_ps(_mm256_cmp_pd(v, value, _CMP_EQ_OQ)));
+					case compare_op::ne: return _mm256_movemask_ps(_mm256_castpd_ps(_mm256_cmp_pd(v, value, _CMP_NEQ_UQ)));
+					}
+					return 0;
+				}
+			};
+
+			/// <summary>AVX2 filter kernel, compacting the kept lanes of each 32 byte vector with a lane permute.</summary>
+			template<class _Ty>
+			LINQ_TARGET_AVX2 ::std::size_t filter_avx2(const _Ty *in, ::std::size_t count, _Ty *out, const compare_term<_Ty> *terms, ::std::size_t nterms) {
+				typedef avx2_ops<_Ty> ops;
+				const ::std::size_t lanes = 32 / sizeof(_Ty);
+				typename ops::vec values[max_terms];
+				for (::std::size_t t = 0; t < nterms; t++) {
+					values[t] = ops::broadcast(terms[t].value);
+				}
+				const ::std::uint32_t *table = compress_tables::get().avx2;
+				const __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+				::std::size_t kept = 0, c = 0;
+				for (; c + lanes <= count; c += lanes) {
+					const typename ops::vec v = ops::load(in + c);
+					unsigned mask = 0xff;
+					for (::std::size_t t = 0; t < nterms; t++) {
+						mask &= ops::mask(v, values[t], terms[t].op);
+					}
+					// Unpack the eight 4-bit lane indices; the permute only reads the low 3 bits of each
+					const __m256i order = _mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(table[mask])), shifts);
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + kept), _mm256_permutevar8x32_epi32(ops::bits(v), order));
+					kept += popcount(mask) * 4 / sizeof(_Ty);
+				}
+				return kept + filter_scalar(in + c, count - c, out + kept, terms, nterms);
+			}
+
+			/// <summary>AVX2 summing kernel, see <see cref="sum_scalar"/>.</summary>
+			template<class _Ty>
+			LINQ_TARGET_AVX2 void sum_avx2(const _Ty *in, ::std::size_t count, _Ty *lanes) {
+				typedef avx2_ops<_Ty> ops;
+				const ::std::size_t width = 32 / sizeof(_Ty), regs = sum_lanes / width;
+				typename ops::vec acc[regs];
+				for (::std::size_t r = 0; r < regs; r++) {
+					acc[r] = ops::load(lanes + r * width);
+				}
+				::std::size_t c = 0;
+				for (; c + sum_lanes <= count; c += sum_lanes) {
+					for (::std::size_t r = 0; r < regs; r++) {
+						acc[r] = ops::add(acc[r], ops::load(in + c + r * width));
+					}
+				}
+				for (::std::size_t r = 0; r < regs; r++) {
+					ops::store(lanes + r * width, acc[r]);
+				}
+				sum_scalar(in + c, count - c, lanes);
+			}
+			/// <summary>AVX2 extrema kernel, see <see cref="extrema_scalar"/>.</summary>
+			template<class _Ty>
+			LINQ_TARGET_AVX2 bool extrema_avx2(const _Ty *in, ::std::size_t count, _Ty &low, _Ty &high) {
+				typedef avx2_ops<_Ty> ops;
+				const ::std::size_t width = 32 / sizeof(_Ty);
+				if (count < 2 * width) {
+					return extrema_scalar(in, count, low, high);
+				}
+				typename ops::vec lo = ops::load(in), hi = lo;
+				typename ops::vec nans = ops::unordered(ops::zero(), lo);
+				::std::size_t c = width;
+				for (; c + width <= count; c += width) {
+					const typename ops::vec v = ops::load(in + c);
+					lo = ops::min(lo, v);
+					hi = ops::max(hi, v);
+					nans = ops::unordered(nans, v);
+				}
+				if (ops::any(nans)) {
+					return false;
+				}
+				_Ty lows[width], highs[width];
+				ops::store(lows, lo);
+				ops::store(highs, hi);
+				// None of the lanes hold a NaN, so plain comparisons find the extrema among them
+				low = lows[0];
+				high = highs[0];
+				for (::std::size_t l = 1; l < width; l++) {
+					if (lows[l] < low) low = lows[l];
+					if (high < highs[l]) high = highs[l];
+				}
+				for (; c < count; c++) {
+					if (in[c] != in[c]) return false;
+					if (in[c] < low) low = in[c];
+					if (high < in[c]) high = in[c];
+				}
+				return true;
+			}
+			/// <summary>AVX2 counting kernel, see <see cref="count_scalar"/>.</summary>
+			template<class _Ty>
+			LINQ_TARGET_AVX2 ::std::size_t count_avx2(const _Ty *in, ::std::size_t count, const compare_term<_Ty> *terms, ::std::size_t nterms) {
+				typedef avx2_ops<_Ty> ops;
+				const ::std::size_t width = 32 / sizeof(_Ty);
+				typename ops::vec values[max_terms];
+				for (::std::size_t t = 0; t < nterms; t++) {
+					values[t] = ops::broadcast(terms[t].value);
+				}
+				::std::size_t kept = 0, c = 0;
+				for (; c + width <= count; c += width) {
+					const typename ops::vec v = ops::load(in + c);
+					unsigned mask = ~0u;
+					for (::std::size_t t = 0; t < nterms; t++) {
+						mask &= ops::mask(v, values[t], terms[t].op);
+					}
+					kept += popcount(mask) * 4 / sizeof(_Ty);
+				}
+				return kept + count_scalar(in + c, count - c, terms, nterms);
+			}
+
+			/// <summary>Per element type AVX-512 operations, with comparisons returning one mask bit per element.</summary>
+			template<class _Ty>
+			struct avx512_ops;
+			template<>
+			struct avx512_ops<::std::int32_t> {
+				typedef __m512i vec;
+				LINQ_TARGET_AVX512 static vec load(const ::std::int32_t *src) { return _mm512_loadu_si512(src); }
+				LINQ_TARGET_AVX512 static vec broadcast(::std::int32_t value) { return _mm512_set1_epi32(value); }
+				LINQ_TARGET_AVX512 static vec zero() { return _mm512_setzero_si512(); }
+				LINQ_TARGET_AVX512 static void store(::std::int32_t *dst, vec v) { _mm512_storeu_si512(dst, v); }
+				LINQ_TARGET_AVX512 static vec add(vec a, vec b) { return _mm512_add_epi32(a, b); }
+				LINQ_TARGET_AVX512 static vec min(vec a, vec b) { return _mm512_min_epi32(a, b); }
+				LINQ_TARGET_AVX512 static vec max(vec a, vec b) { return _mm512_max_epi32(a, b); }
+				LINQ_TARGET_AVX512 static unsigned unordered(unsigned nans, vec) { return nans; }
+				LINQ_TARGET_AVX512 static bool any(unsigned nans) { return nans != 0; }
+				LINQ_TARGET_AVX512 static void compress(::std::int32_t *dst, unsigned mask, vec v) { _mm512_storeu_si512(dst, _mm512_maskz_compress_epi32(static_cast<__mmask16>(mask), v)); }
+				LINQ_TARGET_AVX512 static unsigned mask(vec v, vec value, compare_op op) {
+					switch (op) {
+					case compare_op::lt: return _mm512_cmp_epi32_mask(v, value, _MM_CMPINT_LT);
+					case compare_op::le: return _mm512_cmp_epi32_mask(v, value, _MM_CMPINT_LE);
+					case compare_op::gt: return _mm512_cmp_epi32_mask(v, value, _MM_CMPINT_NLE);
+					case compare_op::ge: return _mm512_cmp_epi32_mask(v, value, _MM_CMPINT_NLT);
+					case compare_op::eq: return _mm512_cmp_epi32_mask(v, value, _MM_CMPINT_EQ);
+					case compare_op::ne: return _mm512_cmp_epi32_mask(v, value, _MM_CMPINT_NE);
+					}
+					return 0;
+				}
+			};
+			template<>
+			struct avx512_ops<float> {
+				typedef __m512 vec;
+				LINQ_TARGET_AVX512 static vec load(const float *src) { return _mm512_loadu_ps(src); }
+				LINQ_TARGET_AVX512 static vec broadcast(float value) { return _mm512_set1_ps(value); }
+				LINQ_TARGET_AVX512 static vec zero() { return _mm512_setzero_ps(); }
+				LINQ_TARGET_AVX512 static void store(float *dst, vec v) { _mm512_storeu_ps(dst, v); }
+				LINQ_TARGET_AVX512 static vec add(vec a, vec b) { return _mm512_add_ps(a, b); }
+				LINQ_TARGET_AVX512 static vec min(vec a, vec b) { return _mm512_min_ps(a, b); }
+				LINQ_TARGET_AVX512 static vec max(vec a, vec b) { return _mm512_max_ps(a, b); }
+				LINQ_TARGET_AVX512 static unsigned unordered(unsigned nans, vec v) { return nans | _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q); }
+				LINQ_TARGET_AVX512 static bool any(unsigned nans) { return nans != 0; }
+				LINQ_TARGET_AVX512 static void compress(float *dst, unsigned mask, vec v) { _mm512_storeu_ps(dst, _mm512_maskz_compress_ps(static_cast<__mmask16>(mask), v)); }
+				LINQ_TARGET_AVX512 static unsigned mask(vec v, vec value, compare_op op) {
+					switch (op) {
+					case compare_op::lt: return _mm512_cmp_ps_mask(v, value, _CMP_LT_OQ);
+					case compare_op::le: return _mm512_cmp_ps_mask(v, value, _CMP_LE_OQ);
+					case compare_op::gt: return _mm512_cmp_ps_mask(v, value, _CMP_GT_OQ);
+					case compare_op::ge: return _mm512_cmp_ps_mask(v, value, _CMP_GE_OQ);
+					case compare_op::eq: return _mm512_cmp_ps_mask(v, value, _CMP_EQ_OQ);
+					case compare_op::ne: return _mm512_cmp_ps_mask(v, value, _CMP_NEQ_UQ);
+					}
+					return 0;
+				}
+			};
+			template<>
+			struct avx512_ops<double> {
+				typedef __m512d vec;
+				LINQ_TARGET_AVX512 static vec load(const double *src) { return _mm512_loadu_pd(src); }
+				LINQ_TARGET_AVX512 static vec broadcast(double value) { return _mm512_set1_pd(value); }
+				LINQ_TARGET_AVX512 static vec zero() { return _mm512_setzero_pd(); }
+				LINQ_TARGET_AVX512 static void store(double *dst, vec v) { _mm512_storeu_pd(dst, v); }
+				LINQ_TARGET_AVX512 static vec add(vec a, vec b) { return _mm512_add_pd(a, b); }
+				LINQ_TARGET_AVX512 static vec min(vec a, vec b) { return _mm512_min_pd(a, b); }
+				LINQ_TARGET_AVX512 static vec max(vec a, vec b) { return _mm512_max_pd(a, b); }
+				LINQ_TARGET_AVX512 static unsigned unordered(unsigned nans, vec v) { return nans | _mm512_cmp_pd_mask(v, v, _CMP_UNORD_Q); }
+				LINQ_TARGET_AVX512 static bool any(unsigned nans) { return nans != 0; }
+				LINQ_TARGET_AVX512 static void compress(double *dst, unsigned mask, vec v) { _mm512_storeu_pd(dst, _mm512_maskz_compress_pd(static_cast<__mmask8>(mask), v)); }
+				LINQ_TARGET_AVX512 static unsigned mask(vec v, vec value, compare_op op) {
+					switch (op) {
+					case compare_op::lt: return _mm512_cmp_pd_mask(v, value, _CMP_LT_OQ);
+					case compare_op::le: return _mm512_cmp_pd_mask(v, value, _CMP_LE_OQ);
+					case compare_op::gt: return _mm512_cmp_pd_mask(v, value, _CMP_GT_OQ);
+					case compare_op::ge: return _mm512_cmp_pd_mask(v, value, _CMP_GE_OQ);
+					case compare_op::eq: return _mm512_cmp_pd_mask(v, value, _CMP_EQ_OQ);
+					case compare_op::ne: return _mm512_cmp_pd_mask(v, value, _CMP_NEQ_UQ);
+					}
+					return 0;
+				}
+			};
+
+			/// <summary>AVX-512 filter kernel, compacting the kept lanes of each 64 byte vector with a masked compress.</summary>
+			template<class _Ty>
+			LINQ_TARGET_AVX512 ::std::size_t filter_avx512(const _Ty *in, ::std::size_t count, _Ty *out, const compare_term<_Ty> *terms, ::std::size_t nterms) {
+				typedef avx512_ops<_Ty> ops;
+				const ::std::size_t lanes = 64 / sizeof(_Ty);
+				const unsigned all = (1u << lanes) - 1;
+				typename ops::vec values[max_terms];
+				for (::std::size_t t = 0; t < nterms; t++) {
+					values[t] = ops::broadcast(terms[t].value);
+				}
+				::std::size_t kept = 0, c = 0;
+				for (; c + lanes <= count; c += lanes) {
+					const typename ops::vec v = ops::load(in + c);
+					unsigned mask = all;
+					for (::std::size_t t = 0; t < nterms; t++) {
+						mask &= ops::mask(v, values[t], terms[t].op);
+					}
+					ops::compress(out + kept, mask, v);
+					kept += popcount(mask);
+				}
+				return kept + filter_scalar(in + c, count - c, out + kept, terms, nterms);
+			}
+			/// <summary>AVX-512 summing kernel, see <see cref="sum_scalar"/>.</summary>
+			template<class _Ty>
+			LINQ_TARGET_AVX512 void sum_avx512(const _Ty *in, ::std::size_t count, _Ty *lanes) {
+				typedef avx512_ops<_Ty> ops;
+				const ::std::size_t width = 64 / sizeof(_Ty), regs = sum_lanes / width;
+				typename ops::vec acc[regs];
+				for (::std::size_t r = 0; r < regs; r++) {
+					acc[r] = ops::load(lanes + r * width);
+				}
+				::std::size_t c = 0;
+				for (; c + sum_lanes <= count; c += sum_lanes) {
+					for (::std::size_t r = 0; r < regs; r++) {
+						acc[r] = ops::add(acc[r], ops::load(in + c + r * width));
+					}
+				}
+				for (::std::size_t r = 0; r < regs; r++) {
+					ops::store(lanes + r * width, acc[r]);
+				}
+				sum_scalar(in + c, count - c, lanes);
+			}
+			/// <summary>AVX-512 extrema kernel, see <see cref="extrema_scalar"/>.</summary>
+			template<class _Ty>
+			LINQ_TARGET_AVX512 bool extrema_avx512(const _Ty *in, ::std::size_t count, _Ty &low, _Ty &high) {
+				typedef avx512_ops<_Ty> ops;
+				const ::std::size_t width = 64 / sizeof(_Ty);
+				if (count < 2 * width) {
+					return extrema_scalar(in, count, low, high);
+				}
+				typename ops::vec lo = ops::load(in), hi = lo;
+				unsigned nans = ops::unordered(0u, lo);
+				::std::size_t c = width;
+				for (; c + width <= count; c += width) {
+					const typename ops::vec v = ops::load(in + c);
+					lo = ops::min(lo, v);
+					hi = ops::max(hi, v);
+					nans = ops::unordered(nans, v);
+				}
+				if (ops::any(nans)) {
+					return false;
+				}
+				_Ty lows[width], highs[width];
+				ops::store(lows, lo);
+				ops::store(highs, hi);
+				// None of the lanes hold a NaN, so plain comparisons find the extrema among them
+				low = lows[0];
+				high = highs[0];
+				for (::std::size_t l = 1; l < width; l++) {
+					if (lows[l] < low) low = lows[l];
+					if (high < highs[l]) high = highs[l];
+				}
+				for (; c < count; c++) {
+					if (in[c] != in[c]) return false;
+					if (in[c] < low) low = in[c];
+					if (high < in[c]) high = in[c];
+				}
+				return true;
+			}
+			/// <summary>AVX-512 counting kernel, see <see cref="count_scalar"/>.</summary>
+			template<class _Ty>
+			LINQ_TARGET_AVX512 ::std::size_t count_avx512(const _Ty *in, ::std::size_t count, const compare_term<_Ty> *terms, ::std::size_t nterms) {
+				typedef avx512_ops<_Ty> ops;
+				const ::std::size_t width = 64 / sizeof(_Ty);
+				typename ops::vec values[max_terms];
+				for (::std::size_t t = 0; t < nterms; t++) {
+					values[t] = ops::broadcast(terms[t].value);
+				}
+				::std::size_t kept = 0, c = 0;
+				for (; c + width <= count; c += width) {
+					const typename ops::vec v = ops::load(in + c);
+					unsigned mask = ~0u;
+					for (::std::size_t t = 0; t < nterms; t++) {
+						mask &= ops::mask(v, values[t], terms[t].op);
+					}
+					kept += popcount(mask);
+				}
+				return kept + count_scalar(in + c, count - c, terms, nterms);
+			}
+
+#endif
+
+			/// <summary>
+			/// Filters with the fastest kernel the processor supports.
+			/// </summary>
+			template<class _Ty>
+			inline ::std::size_t filter(const _Ty *in, ::std::size_t count, _Ty *out, const compare_term<_Ty> *terms, ::std::size_t nterms) {
+#ifdef LINQ_SIMD_X86
+				if (nterms <= max_terms) {
+					switch (level()) {
+					case isa::avx512: return filter_avx512(in, count, out, terms, nterms);
+					case isa::avx2: return filter_avx2(in, count, out, terms, nterms);
+					case isa::ssse3: return filter_ssse3(in, count, out, terms, nterms);
+					case isa::scalar: break;
+					}
+				}
+#endif
+				return filter_scalar(in, count, out, terms, nterms);
+			}
+
+			/// <summary>Sums with the fastest kernel the processor supports. See <see cref="sum_scalar"/>.</summary>
+			template<class _Ty>
+			inline void sum(const _Ty *in, ::std::size_t count, _Ty *lanes) {
+#ifdef LINQ_SIMD_X86
+				switch (level()) {
+				case isa::avx512: return sum_avx512(in, count, lanes);
+				case isa::avx2: return sum_avx2(in, count, lanes);
+				case isa::ssse3: return sum_ssse3(in, count, lanes);
+				case isa::scalar: break;
+				}
+#endif
+				sum_scalar(in, count, lanes);
+			}
+			/// <summary>Finds the extrema with the fastest kernel the processor supports. See <see cref="extrema_scalar"/>.</summary>
+			template<class _Ty>
+			inline bool extrema(const _Ty *in, ::std::size_t count, _Ty &low, _Ty &high) {
+#ifdef LINQ_SIMD_X86
+				switch (level()) {
+				case isa::avx512: return extrema_avx512(in, count, low, high);
+				case isa::avx2: return extrema_avx2(in, count, low, high);
+				case isa::ssse3: return extrema_ssse3(in, count, low, high);
+				case isa::scalar: break;
+				}
+#endif
+				return extrema_scalar(in, count, low, high);
+			}
+			/// <summary>Counts with the fastest kernel the processor supports. See <see cref="count_scalar"/>.</summary>
+			template<class _Ty>
+			inline ::std::size_t count(const _Ty *in, ::std::size_t count, const compare_term<_Ty> *terms, ::std::size_t nterms) {
+#ifdef LINQ_SIMD_X86
+				if (nterms <= max_terms) {
+					switch (level()) {
+					case isa::avx512: return count_avx512(in, count, terms, nterms);
+					case isa::avx2: return count_avx2(in, count, terms, nterms);
+					case isa::ssse3: return count_ssse3(in, count, terms, nterms);
+					case isa::scalar: break;
+					}
+				}
+#endif
+				return count_scalar(in, count, terms, nterms);
+			}
+
+			/// <summary>Element types with vector filter kernels.</summary>
+			template<class _Ty>
+			struct is_vector_element : ::std::integral_constant<bool,
+				::std::is_same<_Ty, ::std::int32_t>::value || ::std::is_same<_Ty, float>::value || ::std::is_same<_Ty, double>::value> {};
+
+			/// <summary>
+			/// Whether a comparison of a <typeparamref name="_Ty"/> element with a <typeparamref name="_Val"/> constant can be
+			/// made between two <typeparamref name="_Ty"/> values instead, with exactly the same outcome.
+			/// </summary>
+			template<class _Ty, class _Val>
+			struct is_narrowable_term : ::std::integral_constant<bool,
+				::std::is_same<::std::common_type_t<_Ty, _Val>, _Ty>::value || (::std::is_same<_Ty, float>::value && ::std::is_same<_Val, double>::value)> {};
+
+			/// <summary>
+			/// Rewrites a term against a constant of the element's own type. When a double constant has no exact float equivalent,
+			/// it is rounded toward the side which keeps the comparison's outcome for every float.
+			/// </summary>
+			/// <returns>False if the term cannot be rewritten, and so must be tested as it is.</returns>
+			template<class _Ty, class _Val>
+			inline bool narrow(const compare_term<_Val> &term, compare_term<_Ty> &result) {
+				result = { term.op, static_cast<_Ty>(term.value) };
+				return true;
+			}
+			inline bool narrow(const compare_term<double> &term, compare_term<float> &result) {
+				if (!(::std::fabs(term.value) <= FLT_MAX)) {
+					return false;
+				}
+				const float nearest = static_cast<float>(term.value);
+				if (static_cast<double>(nearest) == term.value) {
+					result = { term.op, nearest };
+					return true;
+				}
+				const float above = nearest > term.value ? nearest : ::std::nextafter(nearest, HUGE_VALF);
+				const float below = nearest < term.value ? nearest : ::std::nextafter(nearest, -HUGE_VALF);
+				switch (term.op) {
+				case compare_op::lt: case compare_op::ge: result = { term.op, above }; return true;
+				case compare_op::le: case compare_op::gt: result = { term.op, below }; return true;
+				default: return false;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Whether filtering an array of <typeparamref name="_Ty"/> with the condition <typeparamref name="_Pr"/> can run
+		/// through the vector filter kernels.
+		/// </summary>
+		template<class _Ty, class _Pr>
+		struct is_vector_filter : ::std::false_type {};
+		template<class _Ty, class _Val, ::std::size_t _N>
+		struct is_vector_filter<_Ty, item_predicate<_Val, _N>> : ::std::integral_constant<bool,
+			simd::is_vector_element<_Ty>::value && simd::is_narrowable_term<_Ty, _Val>::value> {};
+
+		/// <summary>
+		/// Filters <paramref name="count"/> elements into the back of <paramref name="result"/> with a kernel, staging each block
+		/// of kept elements in a small buffer on the stack so no more than the kept elements ever need allocating. The share of
+		/// elements kept from the first block, with some slack, is used to reserve room for the rest.
+		/// </summary>
+		/// <param name="kernel">Callable of the form <c>size_t(const _Ty *in, size_t count, _Ty *out)</c>, following the rules of the <see cref="simd"/> kernels.</param>
+		template<class _Ty, class _Cont, class _Kernel>
+		void filter_blocks(const _Ty *in, ::std::size_t count, _Cont &result, _Kernel &&kernel) {
+			const ::std::size_t block = 2048;
+			_Ty buffer[block];
+			for (::std::size_t c = 0; c < count; c += block) {
+				const ::std::size_t kept = kernel(in + c, ::std::min(block, count - c), buffer);
+				if (c == 0 && count > block) {
+					const ::std::size_t estimate = kept * ((count + block - 1) / block);
+					result.reserve(result.size() + estimate + estimate / 16 + block);
+				}
+				result.insert(result.end(), buffer, buffer + kept);
+			}
+		}
+
+		/// <summary>
+		/// Reproducible floating point sum. Elements are added in blocks of <see cref="block"/>, each spread over
+		/// <see cref="simd::sum_lanes"/> accumulators which are then added together pairwise, and the sums of the blocks are
+		/// in turn added pairwise. The outcome only depends on the order of the elements, never on the instruction set used
+		/// or on how many threads summed the blocks, and the pairwise additions keep the rounding error far below that of a
+		/// single running total.
+		/// </summary>
+		template<class _Ty>
+		class pairwise_sum {
+		public:
+			static const ::std::size_t block = 4096;
+
+			pairwise_sum() : _lanes(), _count(0), _blocks(0), _levels() {}
+
+			/// <summary>Adds the next element.</summary>
+			inline void add(const _Ty &item) {
+				_lanes[_count % simd::sum_lanes] = simd::wrapping_add(_lanes[_count % simd::sum_lanes], item);
+				if (++_count == block) {
+					add_block(fold(_lanes));
+					_count = 0;
+				}
+			}
+			/// <summary>Adds the sum of the next whole block of elements, or of the last elements when fewer than a block remain.</summary>
+			void add_block(_Ty sum) {
+				::std::size_t level = 0;
+				for (; _blocks & (1ull << level); level++) {
+					sum = simd::wrapping_add(_levels[level], sum);
+				}
+				_levels[level] = sum;
+				_blocks++;
+			}
+			/// <summary>Sum of every element added so far.</summary>
+			_Ty result() const {
+				pairwise_sum rest(*this);
+				if (rest._count != 0) {
+					rest.add_block(fold(rest._lanes));
+				}
+				_Ty total = _Ty();
+				bool first = true;
+				for (::std::size_t level = 0; level < 64; level++) {
+					if (rest._blocks & (1ull << level)) {
+						total = first ? rest._levels[level] : simd::wrapping_add(rest._levels[level], total);
+						first = false;
+					}
+				}
+				return total;
+			}
+
+			/// <summary>Adds the <see cref="simd::sum_lanes"/> accumulators of a block together pairwise, clearing them.</summary>
+			static _Ty fold(_Ty *lanes) {
+				for (::std::size_t width = simd::sum_lanes / 2; width > 0; width /= 2) {
+					for (::std::size_t l = 0; l < width; l++) {
+						lanes[l] = simd::wrapping_add(lanes[l], lanes[l + width]);
+					}
+				}
+				_Ty sum = lanes[0];
+				::std::fill(lanes, lanes + simd::sum_lanes, _Ty());
+				return sum;
+			}
+
+		private:
+			_Ty _lanes[simd::sum_lanes];
+			::std::size_t _count;
+			unsigned long long _blocks;
+			_Ty _levels[64];
+		};
+
+		/// <summary>Running total of values which are not floating point, added in order.</summary>
+		template<class _Ty>
+		class running_sum {
+		public:
+			running_sum() : _total() {}
+			inline void add(const _Ty &item) { _total = simd::wrapping_add(_total, item); }
+			inline _Ty result() const { return _total; }
+		private:
+			_Ty _total;
+		};
+
+		/// <summary>How values of type <typeparamref name="_Ty"/> are summed.</summary>
+		template<class _Ty>
+		using summation = ::std::conditional_t<::std::is_floating_point<_Ty>::value, pairwise_sum<_Ty>, running_sum<_Ty>>;
+
+		/// <summary>Type in which values of type <typeparamref name="_Ty"/> are summed to take their average, wide enough not to overflow for integers.</summary>
+		template<class _Ty>
+		using average_sum_t = ::std::conditional_t<::std::is_integral<_Ty>::value,
+			::std::conditional_t<::std::is_signed<_Ty>::value, long long, unsigned long long>, _Ty>;
+		/// <summary>Type of the average of values of type <typeparamref name="_Ty"/>: double for integers, otherwise the type itself.</summary>
+		template<class _Ty>
+		using average_t = ::std::conditional_t<::std::is_integral<_Ty>::value, double, _Ty>;
+
+		/// <summary>Whether the provided value is a floating point NaN.</summary>
+		template<class _Ty>
+		inline bool is_nan(const _Ty &value, ::std::true_type) { return value != value; }
+		template<class _Ty>
+		inline bool is_nan(const _Ty&, ::std::false_type) { return false; }
+		template<class _Ty>
+		inline bool is_nan(const _Ty &value) { return is_nan(value, ::std::is_floating_point<_Ty>()); }
+
+		/// <summary>Thrown by the aggregations which have no result for an empty sequence.</summary>
+		inline void throw_empty() {
+			throw ::std::logic_error("the sequence contains no elements");
+		}
+		/// <summary>Thrown by first and last when no item satisfies their condition.</summary>
+		inline void throw_no_match() {
+			throw ::std::logic_error("no elements match the given conditional");
+		}
+		/// <summary>Thrown when an item is added to a <see cref="fixed_array"/> which is already full.</summary>
+		inline void throw_full() {
+			throw ::std::logic_error("the fixed_array is full");
+		}
+		/// <summary>Thrown when a <see cref="fixed_array"/> is copied into a <see cref="std::array"/> of a different size.</summary>
+		inline void throw_size_mismatch() {
+			throw ::std::logic_error("the std::array must have exactly as many elements as the fixed_array");
+		}
+
+		/// <summary>Functor adding two values with operator+, usable in constant expressions.</summary>
+		struct plus {
+			template<class _Ty>
+			constexpr _Ty operator()(const _Ty &_Left, const _Ty &_Right) const { return _Left + _Right; }
+		};
+	}
+
+	/// <summary>Position returned by index_of when no item satisfies the condition.</summary>
+	constexpr ::std::size_t npos = ~::std::size_t(0);
+
+
+	/// <summary>
+	/// Placeholder for the element being tested, used to build structured conditions from comparisons against constants,
+	/// such as <c>linq::item &gt; threshold</c>, joined with <c>&amp;&amp;</c>. These behave exactly as the equivalent lambda,
+	/// but when given to <see cref="linq::array::where"/> on an array of int, float or double they are evaluated many elements
+	/// at a time with the widest vector instructions the processor supports.
+	/// </summary>
+	struct item_placeholder {};
+	constexpr item_placeholder item{};
+
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 1> operator<(item_placeholder, _Val value) { return { core::compare_op::lt, value }; }
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 1> operator<=(item_placeholder, _Val value) { return { core::compare_op::le, value }; }
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 1> operator>(item_placeholder, _Val value) { return { core::compare_op::gt, value }; }
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 1> operator>=(item_placeholder, _Val value) { return { core::compare_op::ge, value }; }
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 1> operator==(item_placeholder, _Val value) { return { core::compare_op::eq, value }; }
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 1> operator!=(item_placeholder, _Val value) { return { core::compare_op::ne, value }; }
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 1> operator<(_Val value, item_placeholder) { return { core::compare_op::gt, value }; }
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 1> operator<=(_Val value, item_placeholder) { return { core::compare_op::ge, value }; }
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 1> operator>(_Val value, item_placeholder) { return { core::compare_op::lt, value }; }
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 1> operator>=(_Val value, item_placeholder) { return { core::compare_op::le, value }; }
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 1> operator==(_Val value, item_placeholder) { return { core::compare_op::eq, value }; }
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 1> operator!=(_Val value, item_placeholder) { return { core::compare_op::ne, value }; }
+
+	/// <summary>
+	/// Structured condition which holds for elements within the inclusive range [<paramref name="low"/>, <paramref name="high"/>].
+	/// </summary>
+	template<class _Val, class = ::std::enable_if_t<::std::is_arithmetic<_Val>::value>>
+	inline core::item_predicate<_Val, 2> between(_Val low, _Val high) { return item >= low && item <= high; }
+
+	/// <summary>
+	/// Count, sum, smallest and largest of the values selected from the elements of one group, produced by
+	/// <see cref="array::groupby"/> when given <see cref="summarize"/>.
+	/// </summary>
+	/// <typeparam name="_Key">Type of the group key.</typeparam>
+	/// <typeparam name="_Val">Type of the summarized values.</typeparam>
+	template<class _Key, class _Val>
+	struct group_summary {
+		_Key key;
+		::std::size_t count;
+		_Val sum;
+		_Val min;
+		_Val max;
+
+		/// <summary>Average of the values. Integers are averaged as a double.</summary>
+		inline core::average_t<_Val> average() const { return static_cast<core::average_t<_Val>>(sum) / static_cast<core::average_t<_Val>>(count); }
+	};
+
+	namespace core {
+		/// <summary>Selector of the values to be summarized by a fused <see cref="array::groupby"/>, created by <see cref="linq::summarize"/>.</summary>
+		template<class _Fn>
+		struct summarizer {
+			_Fn selector;
+		};
+		template<class _Ty>
+		struct is_summarizer : ::std::false_type {};
+		template<class _Fn>
+		struct is_summarizer<summarizer<_Fn>> : ::std::true_type {};
+		/// <summary>Key type of a groupby: <typeparamref name="_Key"/>, unless void for the return type of the key selector.</summary>
+		template<class _Key, class _Fn, class _Ref>
+		using group_key_t = ::std::conditional_t<::std::is_void<_Key>::value, ::std::decay_t<invoke_result_t<_Fn&, _Ref>>, _Key>;
+	}
+
+	/// <summary>
+	/// Has <see cref="array::groupby"/> summarize a value selected from each element of every group, instead of
+	/// collecting the elements themselves. See <see cref="group_summary"/>.
+	/// </summary>
+	/// <param name="selector">Lambda which selects the value to be summarized from each element.</param>
+	template<class _Fn>
+	inline core::summarizer<::std::decay_t<_Fn>> summarize(_Fn &&selector) { return { ::std::forward<_Fn>(selector) }; }
+
+	/// <summary>
+	/// Aggregate of one time window, produced by the aggregates of a <see cref="windowed"/> query over windows of time.
+	/// </summary>
+	/// <typeparam name="_Key">Type of the time key.</typeparam>
+	/// <typeparam name="_Val">Type of the aggregated value.</typeparam>
+	template<class _Key, class _Val>
+	struct window_result {
+		/// <summary>Start of the window. The window holds the elements from here up to, but excluding, start plus its length.</summary>
+		_Key start;
+		::std::size_t count;
+		_Val value;
+	};
+
+	namespace core {
+		/*** Windows ***
+		 * The aggregates of a windowed query are kept up to date as elements enter and leave each window, so moving a window
+		 * costs O(1) amortized rather than rescanning all of it. Every aggregator offers:
+		 *   push(value)     - adds the newest value
+		 *   pop()           - removes the oldest value
+		 *   result()        - the aggregate of the values held, of which there must be at least one
+		 *   size(), clear()
+		 */
+
+		/// <summary>Thrown when a window is given a size, length or step which is not greater than zero.</summary>
+		inline void throw_empty_window() {
+			throw ::std::logic_error("the size and step of a window must be greater than zero");
+		}
+
+		/// <summary>
+		/// Double ended queue held in a single buffer whose capacity is a power of two, wrapping around its end. Once grown to
+		/// the largest number of values held at once, pushing and popping at either end never allocates.
+		/// </summary>
+		template<class _Ty>
+		class ring_buffer {
+		public:
+			ring_buffer() : _head(0), _size(0) {}
+
+			inline ::std::size_t size() const { return _size; }
+			inline bool empty() const { return _size == 0; }
+			inline _Ty& front() { return _items[_head]; }
+			inline const _Ty& front() const { return _items[_head]; }
+			inline _Ty& back() { return _items[(_head + _size - 1) & (_items.size() - 1)]; }
+			inline const _Ty& back() const { return _items[(_head + _size - 1) & (_items.size() - 1)]; }
+
+			inline void push_back(_Ty item) {
+				if (_size == _items.size()) _grow();
+				_items[(_head + _size++) & (_items.size() - 1)] = ::std::move(item);
+			}
+			inline void pop_front() {
+				_head = (_head + 1) & (_items.size() - 1);
+				_size--;
+			}
+			inline void pop_back() { _size--; }
+			inline void clear() { _head = _size = 0; }
+
+		private:
+			void _grow() {
+				::std::vector<_Ty> grown(_items.empty() ? 16 : _items.size() * 2);
+				for (::std::size_t c = 0; c < _size; c++) {
+					grown[c] = ::std::move(_items[(_head + c) & (_items.size() - 1)]);
+				}
+				_items.swap(grown);
+				_head = 0;
+			}
+
+			::std::vector<_Ty> _items;
+			::std::size_t _head, _size;
+		};
+
+		/// <summary>
+		/// Running total of the integers in a window: each value is added as it enters and subtracted as it leaves. The
+		/// arithmetic wraps around, so the total is exact whenever the sum of the window itself fits in the type.
+		/// </summary>
+		template<class _Ty>
+		class window_running_sum {
+			typedef ::std::make_unsigned_t<_Ty> unsigned_type;
+		public:
+			window_running_sum() : _total(0) {}
+
+			inline void push(const _Ty &value) {
+				_total += static_cast<unsigned_type>(value);
+				_values.push_back(value);
+			}
+			inline void pop() {
+				_total -= static_cast<unsigned_type>(_values.front());
+				_values.pop_front();
+			}
+			inline _Ty result() const { return static_cast<_Ty>(_total); }
+			inline ::std::size_t size() const { return _values.size(); }
+			inline void clear() {
+				_total = 0;
+				_values.clear();
+			}
+
+		private:
+			unsigned_type _total;
+			ring_buffer<_Ty> _values;
+		};
+
+		/// <summary>
+		/// Two-stack aggregation of the values in a window with any associative operation, which needs no inverse. New values
+		/// are pushed onto a back stack, which also keeps the aggregate of everything on it. Values leave from a front stack
+		/// holding the aggregate of each value with every newer one on it; when it runs out, the back stack is moved over in
+		/// a single pass. Each value is thus combined a constant number of times, and the result is one more combination.
+		/// </summary>
+		/// <typeparam name="_Op">Associative operation combining an older value on the left with a newer one on the right.</typeparam>
+		template<class _Ty, class _Op>
+		class window_fold {
+		public:
+			explicit window_fold(_Op _Combine = _Op()) : _op(::std::move(_Combine)), _back_total() {}
+
+			inline void push(const _Ty &value) {
+				_back_total = _back.empty() ? value : _op(_back_total, value);
+				_back.push_back(value);
+			}
+			inline void pop() {
+				if (_front.empty()) {
+					for (::std::size_t c = _back.size(); c-- > 0;) {
+						_front.push_back(_front.empty() ? _back[c] : _op(_back[c], _front.back()));
+					}
+					_back.clear();
+				}
+				_front.pop_back();
+			}
+			inline _Ty result() const {
+				if (_front.empty()) return _back_total;
+				if (_back.empty()) return _front.back();
+				return _op(_front.back(), _back_total);
+			}
+			inline ::std::size_t size() const { return _front.size() + _back.size(); }
+			inline void clear() {
+				_front.clear();
+				_back.clear();
+			}
+
+		private:
+			mutable _Op _op;
+			::std::vector<_Ty> _front, _back;
+			_Ty _back_total;
+		};
+
+		/// <summary>
+		/// Smallest or largest value in a window, from a monotonic queue: a value is dropped as soon as a newer one is at
+		/// least as good, as it can never be the result again, so the front of the queue is always the result. A NaN held
+		/// by the window is the result until it leaves, as for <see cref="query::min"/>.
+		/// </summary>
+		/// <typeparam name="_Better">Predicate for whether the left value is strictly better than the right.</typeparam>
+		template<class _Ty, class _Better>
+		class window_extreme {
+		public:
+			window_extreme() : _pushed(0), _popped(0), _nan_at(0), _nan(), _has_nan(false) {}
+
+			inline void push(const _Ty &value) {
+				if (is_nan(value)) {
+					_nan = value;
+					_nan_at = _pushed;
+					_has_nan = true;
+				}
+				else {
+					while (!_queue.empty() && !_better(_queue.back().second, value)) _queue.pop_back();
+					_queue.push_back({ _pushed, value });
+				}
+				_pushed++;
+			}
+			inline void pop() {
+				if (!_queue.empty() && _queue.front().first == _popped) _queue.pop_front();
+				_popped++;
+			}
+			inline _Ty result() const { return _has_nan && _nan_at >= _popped ? _nan : _queue.front().second; }
+			inline ::std::size_t size() const { return _pushed - _popped; }
+			inline void clear() {
+				_queue.clear();
+				_pushed = _popped = 0;
+				_has_nan = false;
+			}
+
+		private:
+			ring_buffer<::std::pair<::std::size_t, _Ty>> _queue;
+			::std::size_t _pushed, _popped, _nan_at;
+			_Ty _nan;
+			bool _has_nan;
+			_Better _better;
+		};
+
+		/// <summary>
+		/// How the values of type <typeparamref name="_Ty"/> in a window are summed: integers with a running total, and
+		/// everything else, floating point included, with <see cref="window_fold"/>, which never subtracts and so never
+		/// accumulates rounding error as the window moves.
+		/// </summary>
+		template<class _Ty>
+		using window_sum_t = ::std::conditional_t<::std::is_integral<_Ty>::value && !::std::is_same<_Ty, bool>::value,
+			window_running_sum<_Ty>, window_fold<_Ty, plus>>;
+
+		/// <summary>Average of the values in a window. Integers are summed as 64-bit integers and averaged as a double.</summary>
+		template<class _Ty>
+		class window_mean {
+		public:
+			inline void push(const _Ty &value) { _sum.push(static_cast<average_sum_t<_Ty>>(value)); }
+			inline void pop() { _sum.pop(); }
+			inline average_t<_Ty> result() const { return static_cast<average_t<_Ty>>(_sum.result()) / static_cast<average_t<_Ty>>(_sum.size()); }
+			inline ::std::size_t size() const { return _sum.size(); }
+			inline void clear() { _sum.clear(); }
+
+		private:
+			window_sum_t<average_sum_t<_Ty>> _sum;
+		};
+
+		template<class _Src, class _Fn, class _Agg>
+		class count_window_enumerator;
+		template<class _Src, class _Key, class _Dur, class _Fn, class _Agg>
+		class time_window_enumerator;
+
+		/// <summary>Windows of <c>size</c> consecutive elements, one starting every <c>step</c> elements.</summary>
+		struct count_frame {
+			::std::size_t size, step;
+
+			count_frame(::std::size_t _Size, ::std::size_t _Step) : size(_Size), step(_Step) {
+				if (size == 0 || step == 0) throw_empty_window();
+			}
+			/// <summary>Number of windows over <paramref name="items"/> elements.</summary>
+			inline ::std::size_t windows(::std::size_t items) const { return items >= size ? (items - size) / step + 1 : 0; }
+
+			template<class _Src, class _Fn, class _Agg>
+			using enumerator = count_window_enumerator<_Src, _Fn, _Agg>;
+		};
+
+		/// <summary>
+		/// Windows of time: the window k holds the elements whose key is in [origin + k * step, origin + k * step + length),
+		/// where the origin is the key of the first element.
+		/// </summary>
+		template<class _Key, class _Dur>
+		struct time_frame {
+			_Key key;
+			_Dur length, step;
+
+			time_frame(_Key _Selector, _Dur _Length, _Dur _Step) : key(::std::move(_Selector)), length(_Length), step(_Step) {
+				if (!(_Dur() < length) || !(_Dur() < step)) throw_empty_window();
+			}
+			/// <summary>Number of windows over <paramref name="items"/> elements, which is unknown until they are seen.</summary>
+			inline ::std::size_t windows(::std::size_t) const { return 0; }
+
+			template<class _Src, class _Fn, class _Agg>
+			using enumerator = time_window_enumerator<_Src, _Key, _Dur, _Fn, _Agg>;
+		};
+
+		/// <summary>
+		/// Enumerates the aggregate of each window of a <see cref="count_frame"/>. Only whole windows are produced. When the
+		/// windows overlap, each move slides the window along by <c>step</c> elements; otherwise the elements between
+		/// windows are skipped and the aggregator starts afresh.
+		/// </summary>
+		/// <typeparam name="_Fn">Selector of the value aggregated from each element.</typeparam>
+		/// <typeparam name="_Agg">Aggregator of the selected values, such as <see cref="window_extreme"/>.</typeparam>
+		template<class _Src, class _Fn, class _Agg>
+		class count_window_enumerator {
+		public:
+			typedef decltype(::std::declval<const _Agg&>().result()) reference;
+			typedef ::std::remove_cv_t<::std::remove_reference_t<reference>> value_type;
+
+			count_window_enumerator(_Src _Source, const count_frame &_Frame, _Fn _Selector, _Agg _Aggregator)
+				: _src(::std::move(_Source)), _frame(_Frame), _sel(::std::move(_Selector)), _agg(::std::move(_Aggregator)), _started(false), _done(false) {}
+
+			bool move_next() {
+				if (_done) return false;
+				if (!_started) {
+					_started = true;
+					return _fill();
+				}
+				if (_frame.step < _frame.size) {
+					for (::std::size_t c = 0; c < _frame.step; c++) {
+						if (!_src.move_next()) {
+							_done = true;
+							return false;
+						}
+						_agg.pop();
+						_agg.push(_sel(_src.current()));
+					}
+					return true;
+				}
+				for (::std::size_t c = _frame.size; c < _frame.step; c++) {
+					if (!_src.move_next()) {
+						_done = true;
+						return false;
+					}
+				}
+				_agg.clear();
+				return _fill();
+			}
+			inline reference current() const { return _agg.result(); }
+			inline ::std::size_t size_hint() const {
+				const ::std::size_t hint = _src.size_hint();
+				return _done ? 0 : _started ? hint / _frame.step : _frame.windows(hint);
+			}
+
+		private:
+			bool _fill() {
+				for (::std::size_t c = 0; c < _frame.size; c++) {
+					if (!_src.move_next()) {
+						_done = true;
+						return false;
+					}
+					_agg.push(_sel(_src.current()));
+				}
+				return true;
+			}
+
+			_Src _src;
+			count_frame _frame;
+			mutable _Fn _sel;
+			_Agg _agg;
+			bool _started, _done;
+		};
+
+		/// <summary>
+		/// Enumerates the aggregate of each window of a <see cref="time_frame"/> which holds at least one element, in order of
+		/// time, as a <see cref="window_result"/>. The elements must arrive in ascending order of key. A window is produced
+		/// once the first element past its end arrives, or the source ends, and empty windows are jumped over in one step.
+		/// Only the keys of the elements in the current window are kept, to know when each one leaves.
+		/// </summary>
+		/// <typeparam name="_Key">Selector of the time key of each element.</typeparam>
+		/// <typeparam name="_Dur">Type of the length and step of the windows, added to and dividing differences of keys.</typeparam>
+		/// <typeparam name="_Fn">Selector of the value aggregated from each element.</typeparam>
+		/// <typeparam name="_Agg">Aggregator of the selected values, such as <see cref="window_extreme"/>.</typeparam>
+		template<class _Src, class _Key, class _Dur, class _Fn, class _Agg>
+		class time_window_enumerator {
+			typedef ::std::decay_t<invoke_result_t<_Key&, typename _Src::reference>> key_type;
+		public:
+			typedef window_result<key_type, ::std::decay_t<decltype(::std::declval<const _Agg&>().result())>> value_type;
+			typedef value_type reference;
+
+			time_window_enumerator(_Src _Source, const time_frame<_Key, _Dur> &_Frame, _Fn _Selector, _Agg _Aggregator)
+				: _src(::std::move(_Source)), _frame(_Frame), _sel(::std::move(_Selector)), _agg(::std::move(_Aggregator)),
+				_origin(), _start(), _next(), _started(false), _emitted(false), _pending(false) {}
+
+			bool move_next() {
+				if (_emitted) {
+					_start = _start + _frame.step;
+					_emitted = false;
+				}
+				else if (!_started) {
+					_started = true;
+					if (!_pull()) return false;
+					_origin = _start = _next;
+				}
+				for (;;) {
+					while (!_keys.empty() && _keys.front() < _start) {
+						_keys.pop_front();
+						_agg.pop();
+					}
+					if (_keys.empty()) {
+						if (!_pending) return false;
+						_jump();
+					}
+					// Elements falling between windows, when the step is longer than the length
+					while (_pending && _next < _start) _pull();
+					while (_pending && _next < _start + _frame.length) {
+						_keys.push_back(_next);
+						_agg.push(_sel(_src.current()));
+						_pull();
+					}
+					if (!_keys.empty()) return _emitted = true;
+				}
+			}
+			inline reference current() const { return { _start, _agg.size(), _agg.result() }; }
+			inline ::std::size_t size_hint() const { return 0; }
+
+		private:
+			inline bool _pull() {
+				_pending = _src.move_next();
+				if (_pending) _next = _frame.key(_src.current());
+				return _pending;
+			}
+			/// <summary>Moves the start to the first window which ends after the next element, skipping the empty windows before it.</summary>
+			void _jump() {
+				if (_next < _origin + _frame.length) return;
+				const long long k = static_cast<long long>((_next - _origin - _frame.length) / _frame.step) + 1;
+				key_type start = _origin + _frame.step * k;
+				// Corrects the rounding of floating point keys
+				while (!(_next < start + _frame.length)) start = start + _frame.step;
+				if (_start < start) _start = start;
+			}
+
+			_Src _src;
+			time_frame<_Key, _Dur> _frame;
+			mutable _Fn _sel;
+			_Agg _agg;
+			ring_buffer<key_type> _keys;
+			key_type _origin, _start, _next;
+			bool _started, _emitted, _pending;
+		};
+	}
+
+	/// <summary>
+	/// Monotonic memory resource for the temporaries of a query, used through <see cref="arena_allocator"/>. Allocations
+	/// are carved one after another out of large blocks, so allocating is a pointer bump with no locking, and nothing is
+	/// given back until <see cref="release"/> frees everything at once. Each block is twice the size of the one before it.
+	/// An arena is not safe to allocate from concurrently: give each thread (or each request) its own.
+	/// </summary>
+	class arena {
+	public:
+		/// <summary>Creates an arena whose first block, taken from the heap on first use, is <paramref name="block_size"/> bytes.</summary>
+		explicit arena(::std::size_t block_size = 4096)
+			: _head(nullptr), _next(nullptr), _end(nullptr), _buffer(nullptr), _block_size(::std::max<::std::size_t>(block_size, 256)) {}
+		/// <summary>
+		/// Creates an arena which allocates from the provided buffer, such as an array on the stack, and only takes blocks
+		/// from the heap once the buffer is used up.
+		/// </summary>
+		/// <param name="buffer">Memory to be allocated from first, which must outlive the arena.</param>
+		/// <param name="size">Size of the buffer in bytes.</param>
+		arena(void *buffer, ::std::size_t size)
+			: _head(nullptr), _next(static_cast<char*>(buffer)), _end(static_cast<char*>(buffer) + size), _buffer(static_cast<char*>(buffer)),
+			_block_size(::std::max<::std::size_t>(size * 2, 256)) {}
+		~arena() {
+			while (_head != nullptr) {
+				block *prev = _head->prev;
+				::operator delete(_head);
+				_head = prev;
+			}
+		}
+		arena(const arena&) = delete;
+		arena& operator=(const arena&) = delete;
+
+		/// <summary>Allocates <paramref name="bytes"/> bytes aligned to <paramref name="alignment"/>, which must be a power of two.</summary>
+		/// <exception cref="std::bad_alloc">Thrown if a new block cannot be allocated.</exception>
+		void* allocate(::std::size_t bytes, ::std::size_t alignment = alignof(::std::max_align_t)) {
+			char *first = _align(_next, alignment);
+			if (_next == nullptr || first > _end || bytes > static_cast<::std::size_t>(_end - first)) {
+				first = _grow(bytes, alignment);
+			}
+			_next = first + bytes;
+			return first;
+		}
+		/// <summary>
+		/// Gives back an allocation. Only the most recent allocation is reclaimed straight away, so that temporaries freed in
+		/// reverse order are reused; anything else stays allocated until <see cref="release"/>.
+		/// </summary>
+		inline void deallocate(void *ptr, ::std::size_t bytes) {
+			if (static_cast<char*>(ptr) + bytes == _next) {
+				_next = static_cast<char*>(ptr);
+			}
+		}
+		/// <summary>
+		/// Frees everything allocated from the arena at once, which must no longer be in use. The largest block is kept for
+		/// the next query, so an arena reused by one thread stops going to the heap once it has grown large enough.
+		/// </summary>
+		void release() {
+			if (_head == nullptr) {
+				_next = _buffer;
+				return;
+			}
+			block *older = _head->prev;
+			_head->prev = nullptr;
+			while (older != nullptr) {
+				block *prev = older->prev;
+				::operator delete(older);
+				older = prev;
+			}
+			_next = reinterpret_cast<char*>(_head + 1);
+			_end = reinterpret_cast<char*>(_head) + _head->size;
+		}
+		/// <summary>Number of bytes the arena holds in blocks taken from the heap.</summary>
+		inline ::std::size_t capacity() const {
+			::std::size_t total = 0;
+			for (block *b = _head; b != nullptr; b = b->prev) {
+				total += b->size;
+			}
+			return total;
+		}
+
+	private:
+		struct alignas(::std::max_align_t) block {
+			block *prev;
+			::std::size_t size;
+		};
+
+		static inline char* _align(char *ptr, ::std::size_t alignment) {
+			return reinterpret_cast<char*>((reinterpret_cast<::std::uintptr_t>(ptr) + alignment - 1) & ~static_cast<::std::uintptr_t>(alignment - 1));
+		}
+		char* _grow(::std::size_t bytes, ::std::size_t alignment) {
+			const ::std::size_t needed = sizeof(block) + bytes + alignment;
+			if (needed < bytes) {
+				throw ::std::bad_alloc();
+			}
+			::std::size_t size = _block_size;
+			while (size < needed) {
+				size *= 2;
+			}
+			block *fresh = static_cast<block*>(::operator new(size));
+			fresh->prev = _head;
+			fresh->size = size;
+			_head = fresh;
+			_block_size = size * 2;
+			_end = reinterpret_cast<char*>(fresh) + size;
+			return _align(reinterpret_cast<char*>(fresh + 1), alignment);
+		}
+
+		block *_head;
+		char *_next, *_end;
+		char *_buffer;
+		::std::size_t _block_size;
+	};
+
+	/// <summary>
+	/// Standard allocator taking its memory from an <see cref="arena"/>. An <see cref="linq::array"/> using it passes it on
+	/// to every array its operators produce, so all of the intermediate results of a query come from the one arena and are
+	/// freed together. The allocator follows its contents when an array is moved or swapped, and stays with the array
+	/// when one is copied into it.
+	/// </summary>
+	/// <typeparam name="_Ty">Type of the allocated elements.</typeparam>
+	template<class _Ty>
+	class arena_allocator {
+	public:
+		typedef _Ty value_type;
+		typedef ::std::false_type propagate_on_container_copy_assignment;
+		typedef ::std::true_type propagate_on_container_move_assignment;
+		typedef ::std::true_type propagate_on_container_swap;
+
+		arena_allocator(arena &_Source) noexcept : _arena(&_Source) {}
+		template<class _Ty2>
+		arena_allocator(const arena_allocator<_Ty2> &_Right) noexcept : _arena(_Right.resource()) {}
+
+		_Ty* allocate(::std::size_t count) {
+			if (count > ~::std::size_t(0) / sizeof(_Ty)) {
+				throw ::std::bad_alloc();
+			}
+			return static_cast<_Ty*>(_arena->allocate(count * sizeof(_Ty), alignof(_Ty)));
+		}
+		inline void deallocate(_Ty *ptr, ::std::size_t count) noexcept { _arena->deallocate(ptr, count * sizeof(_Ty)); }
+
+		/// <summary>The arena the memory comes from.</summary>
+		inline arena* resource() const noexcept { return _arena; }
+
+		template<class _Ty2>
+		inline bool operator==(const arena_allocator<_Ty2> &_Right) const noexcept { return _arena == _Right.resource(); }
+		template<class _Ty2>
+		inline bool operator!=(const arena_allocator<_Ty2> &_Right) const noexcept { return _arena != _Right.resource(); }
+
+	private:
+		arena *_arena;
+	};
+
+	/// <summary>
+	/// Scratch space for the operators which write <see cref="into"/> storage owned by the caller, so that a query run over
+	/// and over (once per tick of a processing loop, say) stops allocating once its buffers have grown large enough. The
+	/// temporaries an operator would otherwise allocate on every call, such as the flags of a parallel where or the hash
+	/// table of a key based join, are kept in the context between calls and only ever grow. A context must only be used by
+	/// one query at a time.
+	/// </summary>
+	class query_context {
+	public:
+		query_context() {}
+		~query_context() { clear(); }
+		query_context(const query_context&) = delete;
+		query_context& operator=(const query_context&) = delete;
+
+		/// <summary>
+		/// Finds the scratch object of type <typeparamref name="_Ty"/> kept for the slot, default constructing it on first use.
+		/// Operators needing several objects of one type tell them apart by slot.
+		/// </summary>
+		template<class _Ty>
+		_Ty& scratch(::std::size_t slot = 0) {
+			const void *type = _type<_Ty>();
+			for (const entry &found : _entries) {
+				if (found.type == type && found.slot == slot) {
+					return *static_cast<_Ty*>(found.object);
+				}
+			}
+			::std::unique_ptr<_Ty> object(new _Ty());
+			_entries.push_back(entry{ type, slot, object.get(), &_destroy<_Ty> });
+			return *object.release();
+		}
+		/// <summary>Frees every scratch object, and the storage they hold.</summary>
+		void clear() {
+			for (entry &found : _entries) {
+				found.destroy(found.object);
+			}
+			_entries.clear();
+		}
+		/// <summary>Number of scratch objects held.</summary>
+		inline ::std::size_t size() const { return _entries.size(); }
+
+	private:
+		struct entry {
+			const void *type;
+			::std::size_t slot;
+			void *object;
+			void (*destroy)(void*);
+		};
+
+		/// <summary>Address which is unique to each type, so that no RTTI is needed to tell the scratch objects apart.</summary>
+		template<class _Ty>
+		static const void* _type() {
+			static const char id = 0;
+			return &id;
+		}
+		template<class _Ty>
+		static void _destroy(void *object) { delete static_cast<_Ty*>(object); }
+
+		::std::vector<entry> _entries;
+	};
+
+	namespace core {
+		/// <summary>
+		/// Scratch object of an operator: the one kept in the <see cref="query_context"/> when one is given; otherwise one
+		/// local to the call.
+		/// </summary>
+		template<class _Ty>
+		class scratch {
+		public:
+			explicit scratch(query_context *context, ::std::size_t slot = 0) : _local(), _object(context ? &context->template scratch<_Ty>(slot) : &_local) {}
+			scratch(const scratch&) = delete;
+			scratch& operator=(const scratch&) = delete;
+
+			inline _Ty& operator*() const { return *_object; }
+			inline _Ty* operator->() const { return _object; }
+
+		private:
+			_Ty _local;
+			_Ty *_object;
+		};
+
+		/// <summary>
+		/// Output of an operator into a container owned by the caller, created by <see cref="linq::into"/>. The container is
+		/// emptied and refilled with emplace_back, so the items are constructed in place and its storage is reused.
+		/// </summary>
+		template<class _Cont>
+		class container_output {
+		public:
+			typedef _Cont& result_type;
+
+			container_output(_Cont &target, query_context *context) : _target(&target), _context(context) {}
+
+			/// <summary>Empties the container, making sure it has room for <paramref name="expected"/> items.</summary>
+			inline void start(::std::size_t expected) {
+				_target->clear();
+				_target->reserve(expected);
+			}
+			template<class... _Args>
+			inline void emplace(_Args &&...args) { _target->emplace_back(::std::forward<_Args>(args)...); }
+			inline _Cont& finish() const { return *_target; }
+
+			inline _Cont& container() const { return *_target; }
+			inline query_context* context() const { return _context; }
+
+		private:
+			_Cont *_target;
+			query_context *_context;
+		};
+		/// <summary>
+		/// Output of an operator through an output iterator, created by <see cref="linq::into"/>. Each item is assigned to the
+		/// iterator in order, and the advanced iterator is returned once the operator is done.
+		/// </summary>
+		template<class _Iter>
+		class iterator_output {
+		public:
+			typedef _Iter result_type;
+
+			iterator_output(_Iter target, query_context *context) : _target(target), _context(context) {}
+
+			inline void start(::std::size_t) {}
+			template<class _Arg>
+			inline void emplace(_Arg &&item) {
+				*_target = ::std::forward<_Arg>(item);
+				++_target;
+			}
+			inline _Iter finish() const { return _target; }
+
+			inline query_context* context() const { return _context; }
+
+		private:
+			_Iter _target;
+			query_context *_context;
+		};
+
+		/// <summary>Trait for whether <typeparamref name="_Cont"/> is a container which can be written to by <see cref="container_output"/>.</summary>
+		template<class _Cont, class = void>
+		struct is_output_container : ::std::false_type {};
+		template<class _Cont>
+		struct is_output_container<_Cont, decltype(void(::std::declval<_Cont&>().emplace_back(::std::declval<typename _Cont::value_type>())),
+			void(::std::declval<_Cont&>().reserve(::std::size_t())), void(::std::declval<_Cont&>().clear()))> : ::std::true_type {};
+
+		template<class _Ty>
+		struct is_output : ::std::false_type {};
+		template<class _Cont>
+		struct is_output<container_output<_Cont>> : ::std::true_type {};
+		template<class _Iter>
+		struct is_output<iterator_output<_Iter>> : ::std::true_type {};
+		/// <summary>The last of a list of types.</summary>
+		template<class _Ty, class... _More>
+		struct last_of { typedef typename last_of<_More...>::type type; };
+		template<class _Ty>
+		struct last_of<_Ty> { typedef _Ty type; };
+		/// <summary>Trait for whether the last of a list of arguments is an output, as taken by the key <see cref="array::orderby"/>.</summary>
+		template<class... _Ty>
+		struct is_last_output : ::std::false_type {};
+		template<class _Ty, class... _More>
+		struct is_last_output<_Ty, _More...> : is_output<typename last_of<_Ty, _More...>::type> {};
+
+		/// <summary>Trait for whether an output is a container of items of type <typeparamref name="_Ty"/>.</summary>
+		template<class _Out, class _Ty>
+		struct is_container_output_of : ::std::false_type {};
+		template<class _Cont, class _Ty>
+		struct is_container_output_of<container_output<_Cont>, _Ty> : ::std::is_same<typename _Cont::value_type, _Ty> {};
+		/// <summary>Trait for whether an output is a container which can be resized up front and then written to from several threads.</summary>
+		template<class _Ty>
+		struct is_resizable_output : ::std::false_type {};
+		template<class _Cont>
+		struct is_resizable_output<container_output<_Cont>> : ::std::is_default_constructible<typename _Cont::value_type> {};
+	}
+
+	/// <summary>
+	/// Has an operator write its results into storage owned by the caller rather than into a new array, such as
+	/// <c>arr.where(condition, linq::into(buffer))</c>. A container (a <see cref="std::vector"/> or <see cref="linq::array"/>)
+	/// is emptied and refilled, keeping its storage, and the operator returns a reference to it; nothing is allocated once
+	/// it has grown large enough, and its items never need to be default constructible.
+	/// </summary>
+	/// <param name="target">The container to be filled.</param>
+	template<class _Cont, class = ::std::enable_if_t<core::is_output_container<_Cont>::value>>
+	inline core::container_output<_Cont> into(_Cont &target) { return core::container_output<_Cont>(target, nullptr); }
+	/// <summary>
+	/// Has an operator write its results into a container owned by the caller, keeping its temporaries in the provided
+	/// <see cref="query_context"/> between calls.
+	/// </summary>
+	/// <param name="target">The container to be filled.</param>
+	/// <param name="context">Scratch space reused by the operator.</param>
+	template<class _Cont, class = ::std::enable_if_t<core::is_output_container<_Cont>::value>>
+	inline core::container_output<_Cont> into(_Cont &target, query_context &context) { return core::container_output<_Cont>(target, &context); }
+	/// <summary>
+	/// Has an operator write its results through an output iterator, such as a pointer into a preallocated buffer or a
+	/// <see cref="std::back_insert_iterator"/>. The operator returns the iterator past the last item written.
+	/// </summary>
+	/// <param name="target">The iterator the first item is written to.</param>
+	template<class _Iter, class = ::std::enable_if_t<!core::is_output_container<_Iter>::value>>
+	inline core::iterator_output<_Iter> into(_Iter target) { return core::iterator_output<_Iter>(target, nullptr); }
+	/// <summary>
+	/// Has an operator write its results through an output iterator, keeping its temporaries in the provided
+	/// <see cref="query_context"/> between calls.
+	/// </summary>
+	/// <param name="target">The iterator the first item is written to.</param>
+	/// <param name="context">Scratch space reused by the operator.</param>
+	template<class _Iter, class = ::std::enable_if_t<!core::is_output_container<_Iter>::value>>
+	inline core::iterator_output<_Iter> into(_Iter target, query_context &context) { return core::iterator_output<_Iter>(target, &context); }
+
+	namespace core {
+		/// <summary>
+		/// Heap allocations made by the whole program, which only move once LINQ_CHECK_ALLOCATIONS has replaced the global
+		/// operator new in one of its translation units.
+		/// </summary>
+		struct allocation_counters {
+			::std::atomic<::std::size_t> count{ 0 };
+			::std::atomic<::std::size_t> bytes{ 0 };
+		};
+		inline allocation_counters& allocations() {
+			static allocation_counters counters;
+			return counters;
+		}
+	}
+
+#ifdef LINQ_PROFILE
+	/// <summary>
+	/// Measurements of one call to an operator of <see cref="linq::array"/>, or of the evaluation of a lazy query, which are
+	/// handed to the sink given to <see cref="set_profile_sink"/>. Operators called by another operator, including those
+	/// called from the lambdas given to it on the same thread, are counted as part of the outer one.
+	/// </summary>
+	struct stage_profile {
+		/// <summary>Name of the operator, such as "where" or "join".</summary>
+		const char *name;
+		/// <summary>Wall time spent in the operator, including the lambdas it called.</summary>
+		::std::chrono::nanoseconds time;
+		/// <summary>Number of elements the operator was given (the left list of a join); zero for lazy queries, where it is not known.</summary>
+		::std::size_t input;
+		/// <summary>Number of elements produced.</summary>
+		::std::size_t output;
+		/// <summary>Number of calls to the lambdas given to the operator: conditions, selectors, keys, merges and the comparators of sequential sorts.</summary>
+		::std::size_t calls;
+		/// <summary>
+		/// Number of times a join looked for matching elements: every pair of elements for a condition based join, and
+		/// one lookup per element of the probing side for a key based join.
+		/// </summary>
+		::std::size_t comparisons;
+		/// <summary>Heap allocations made while the operator ran, counted only when LINQ_CHECK_ALLOCATIONS is defined in the program.</summary>
+		::std::size_t allocations;
+		/// <summary>Bytes requested by those allocations.</summary>
+		::std::size_t bytes;
+
+		/// <summary>Fraction of the input which made it into the output.</summary>
+		inline double selectivity() const { return input ? static_cast<double>(output) / static_cast<double>(input) : 0.0; }
+	};
+
+	/// <summary>Callback receiving the measurements of every operator call.</summary>
+	typedef ::std::function<void(const stage_profile&)> profile_sink;
+
+	namespace core {
+		inline profile_sink& current_profile_sink() {
+			static profile_sink sink;
+			return sink;
+		}
+	}
+	/// <summary>
+	/// Sets the callback which receives the measurements of every operator call, or removes it when given an empty one.
+	/// The sink is called on the thread which ran the operator, so it must be safe to call concurrently when queries run
+	/// on several threads, and it must not be changed while any query runs.
+	/// </summary>
+	inline void set_profile_sink(profile_sink sink) { core::current_profile_sink() = ::std::move(sink); }
+
+	/// <summary>
+	/// Sink which adds up the measurements of every operator by name, and reports them as a table ordered by time.
+	/// Recording is thread safe.
+	/// </summary>
+	class profile_summary {
+	public:
+		/// <summary>Totals of every call to one operator.</summary>
+		struct entry {
+			const char *name;
+			::std::size_t invocations;
+			::std::chrono::nanoseconds time;
+			::std::size_t input, output, calls, comparisons, allocations, bytes;
+		};
+
+		/// <summary>Adds the measurements of one operator call.</summary>
+		void record(const stage_profile &stage) {
+			::std::lock_guard<::std::mutex> lock(_lock);
+			auto found = ::std::find_if(_entries.begin(), _entries.end(), [&](const entry &item) { return ::std::strcmp(item.name, stage.name) == 0; });
+			if (found == _entries.end()) {
+				found = _entries.insert(_entries.end(), entry{ stage.name, 0, ::std::chrono::nanoseconds(0), 0, 0, 0, 0, 0, 0 });
+			}
+			found->invocations++;
+			found->time += stage.time;
+			found->input += stage.input;
+			found->output += stage.output;
+			found->calls += stage.calls;
+			found->comparisons += stage.comparisons;
+			found->allocations += stage.allocations;
+			found->bytes += stage.bytes;
+		}
+		/// <summary>Sink recording into this summary, for <see cref="set_profile_sink"/>. The summary must outlive its use.</summary>
+		inline profile_sink sink() { return [this](const stage_profile &stage) { record(stage); }; }
+
+		/// <summary>The totals of every operator, the most time consuming first.</summary>
+		::std::vector<entry> entries() const {
+			::std::vector<entry> sorted;
+			{
+				::std::lock_guard<::std::mutex> lock(_lock);
+				sorted = _entries;
+			}
+			::std::stable_sort(sorted.begin(), sorted.end(), [](const entry &left, const entry &right) { return left.time > right.time; });
+			return sorted;
+		}
+		/// <summary>Formats the totals as a table with a row per operator, the most time consuming first.</summary>
+		::std::string report() const {
+			char line[256];
+			::std::snprintf(line, sizeof(line), "%-14s %8s %12s %12s %12s %8s %14s %14s %10s %12s\n",
+				"operator", "calls", "time ms", "input", "output", "select%", "lambda calls", "comparisons", "allocs", "bytes");
+			::std::string text = line;
+			for (const entry &item : entries()) {
+				::std::snprintf(line, sizeof(line), "%-14s %8zu %12.3f %12zu %12zu %8.1f %14zu %14zu %10zu %12zu\n",
+					item.name, item.invocations, static_cast<double>(item.time.count()) / 1e6, item.input, item.output,
+					item.input ? 100.0 * static_cast<double>(item.output) / static_cast<double>(item.input) : 0.0,
+					item.calls, item.comparisons, item.allocations, item.bytes);
+				text += line;
+			}
+			return text;
+		}
+		/// <summary>Forgets everything recorded so far.</summary>
+		void clear() {
+			::std::lock_guard<::std::mutex> lock(_lock);
+			_entries.clear();
+		}
+
+	private:
+		mutable ::std::mutex _lock;
+		::std::vector<entry> _entries;
+	};
+#endif
+
+	namespace core {
+#ifdef LINQ_PROFILE
+		/// <summary>Lambda wrapper counting its calls, for the measurements of <see cref="stage_scope"/>.</summary>
+		template<class _Fn>
+		class counting {
+		public:
+			counting(_Fn &fn, ::std::size_t &count) : _fn(::std::addressof(fn)), _count(&count) {}
+			template<class... _Args>
+			inline decltype(auto) operator()(_Args &&...args) const {
+				++*_count;
+				return (*_fn)(::std::forward<_Args>(args)...);
+			}
+
+		private:
+			_Fn *_fn;
+			::std::size_t *_count;
+		};
+
+		/// <summary>
+		/// Measures one call to an operator, from its construction until its destruction, then hands the measurements to
+		/// the profile sink. Only the outermost scope on a thread measures anything, so operators implemented on top of
+		/// other operators are only counted once.
+		/// </summary>
+		class stage_scope {
+		public:
+			stage_scope(const char *name, ::std::size_t input) : _active(_depth()++ == 0 && current_profile_sink()) {
+				_stage = stage_profile{ name, ::std::chrono::nanoseconds(0), input, 0, 0, 0, 0, 0 };
+				if (_active) {
+					_allocations = allocations().count.load(::std::memory_order_relaxed);
+					_bytes = allocations().bytes.load(::std::memory_order_relaxed);
+					_start = ::std::chrono::steady_clock::now();
+				}
+			}
+			~stage_scope() {
+				_depth()--;
+				if (!_active) return;
+				_stage.time = ::std::chrono::duration_cast<::std::chrono::nanoseconds>(::std::chrono::steady_clock::now() - _start);
+				_stage.allocations = allocations().count.load(::std::memory_order_relaxed) - _allocations;
+				_stage.bytes = allocations().bytes.load(::std::memory_order_relaxed) - _bytes;
+				try { current_profile_sink()(_stage); }
+				catch (...) {}
+			}
+			stage_scope(const stage_scope&) = delete;
+			stage_scope& operator=(const stage_scope&) = delete;
+
+			/// <summary>Sets the number of elements produced.</summary>
+			inline void output(::std::size_t count) { _stage.output = count; }
+			/// <summary>Adds calls to the lambdas given to the operator.</summary>
+			inline void calls(::std::size_t count) { _stage.calls += count; }
+			/// <summary>Adds lookups of matching elements made by a join.</summary>
+			inline void comparisons(::std::size_t count) { _stage.comparisons += count; }
+			/// <summary>Wraps a lambda to count its calls. Not for lambdas called concurrently.</summary>
+			template<class _Fn>
+			inline counting<_Fn> counted(_Fn &fn) { return counting<_Fn>(fn, _stage.calls); }
+			/// <summary>Sets the number of elements produced from the size of a filled container. Unknown for iterators.</summary>
+			template<class _Cont>
+			inline void written(const container_output<_Cont> &out) { _stage.output = out.container().size(); }
+			template<class _Iter>
+			inline void written(const iterator_output<_Iter>&) {}
+
+		private:
+			static ::std::size_t& _depth() {
+				static thread_local ::std::size_t depth = 0;
+				return depth;
+			}
+
+			bool _active;
+			stage_profile _stage;
+			::std::size_t _allocations, _bytes;
+			::std::chrono::steady_clock::time_point _start;
+		};
+#else
+		/// <summary>Measures one call to an operator when LINQ_PROFILE is defined; otherwise does nothing and compiles away.</summary>
+		class stage_scope {
+		public:
+			inline stage_scope(const char*, ::std::size_t) {}
+			inline void output(::std::size_t) {}
+			inline void calls(::std::size_t) {}
+			inline void comparisons(::std::size_t) {}
+			template<class _Fn>
+			inline _Fn& counted(_Fn &fn) { return fn; }
+			template<class _Out>
+			inline void written(const _Out&) {}
+		};
+#endif
+	}
+
+	template<class _Ty, class _Alloc = ::std::allocator<_Ty>>
+	class array;
+	template<class _Key, class _Ty>
+	class grouping;
+	template<class _Cont, class _Fn>
+	class hashed_index;
+	template<class _Cont, class _Fn>
+	class sorted_index;
+	template<class _Enum, class _Frame, bool _Eager>
+	class windowed;
+
+	/// <summary>
+	/// Deferred query over a chain of enumerators. Operators such as <see cref="where"/> and <see cref="select"/> only
+	/// compose the chain; nothing is evaluated or allocated until a terminal operation (<see cref="to_vector"/>,
+	/// <see cref="to_array"/>, <see cref="first"/>, a range-based for loop, or conversion to a <see cref="linq::array"/>)
+	/// pulls the elements through every stage in a single pass.
+	/// </summary>
+	/// <typeparam name="_Enum">The enumerator at the end of the chain.</typeparam>
+	template<class _Enum>
+	class query {
+	public:
+		typedef _Enum enumerator;
+		typedef typename _Enum::reference reference;
+		typedef typename _Enum::value_type value_type;
+		typedef core::enumerator_iterator<_Enum> iterator;
+		typedef iterator const_iterator;
+
+		explicit query(_Enum _Src) : _enum(::std::move(_Src)) {}
+
+		/// <summary>Starts a new pass over the query.</summary>
+		inline iterator begin() const { return iterator(_enum); }
+		inline iterator end() const { return iterator(); }
+		/// <summary>Returns a fresh copy of the enumerator at the end of the chain, positioned before the first element.</summary>
+		inline _Enum get_enumerator() const { return _enum; }
+
+	public:
+		/// <summary>
+		/// Adds a filtering stage to the query.
+		/// </summary>
+		/// <param name="condition">The lambda which determines if an item continues through the query.</param>
+		/// <returns>The extended query.</returns>
+		template<class _Pr>
+		inline query<core::where_enumerator<_Enum, ::std::decay_t<_Pr>>> where(_Pr &&condition) const {
+			return query<core::where_enumerator<_Enum, ::std::decay_t<_Pr>>>({ _enum, ::std::forward<_Pr>(condition) });
+		}
+
+		/// <summary>
+		/// Adds a transformation stage to the query.
+		/// </summary>
+		/// <param name="selector">Lambda which defines how each item is transformed into the new type.</param>
+		/// <typeparam name="_Ret">(Optional) The new type being created; defaults to the return type of the selector.</typeparam>
+		/// <returns>The extended query.</returns>
+		template<class _Ret = void, class _Fn>
+		inline query<core::select_enumerator<_Enum, ::std::decay_t<_Fn>, _Ret>> select(_Fn &&selector) const {
+			return query<core::select_enumerator<_Enum, ::std::decay_t<_Fn>, _Ret>>({ _enum, ::std::forward<_Fn>(selector) });
+		}
+
+		/// <summary>
+		/// Adds a sorting stage to the query. The elements reaching this stage are buffered and sorted once
+		/// the query is evaluated; stages after it stream from that buffer.
+		/// </summary>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <returns>The extended query.</returns>
+		template<class _Pr, class = ::std::enable_if_t<!core::is_key_order<::std::decay_t<_Pr>>::value>>
+		inline query<core::order_enumerator<_Enum, ::std::decay_t<_Pr>>> orderby(_Pr &&pred) const {
+			return query<core::order_enumerator<_Enum, ::std::decay_t<_Pr>>>({ _enum, ::std::forward<_Pr>(pred) });
+		}
+		/// <summary>
+		/// Adds a stable sorting stage to the query: elements which are equal by the predicate keep their order.
+		/// </summary>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <returns>The extended query.</returns>
+		template<class _Pr>
+		inline query<core::order_enumerator<_Enum, ::std::decay_t<_Pr>, true>> stable_orderby(_Pr &&pred) const {
+			return query<core::order_enumerator<_Enum, ::std::decay_t<_Pr>, true>>({ _enum, ::std::forward<_Pr>(pred) });
+		}
+		/// <summary>
+		/// Adds a sorting stage on the keys selected from each element, created with <see cref="linq::ascending"/> or
+		/// <see cref="linq::descending"/>. Each key is computed once; see <see cref="array::orderby"/>. The sort is stable,
+		/// and can be refined with <see cref="thenby"/>.
+		/// </summary>
+		/// <param name="order">The most significant key.</param>
+		/// <param name="more">Less significant keys, in order of significance.</param>
+		/// <returns>The extended query.</returns>
+		template<class _Fn, bool _Descending, class... _More>
+		inline auto orderby(const core::key_order<_Fn, _Descending> &order, const _More &...more) const {
+			static_assert(core::all_of({ core::is_key_order<_More>::value... }), "every key of a key orderby must be created with linq::ascending or linq::descending");
+			typedef ::std::tuple<core::key_order<_Fn, _Descending>, _More...> orders;
+			return query<core::key_sort_enumerator<_Enum, orders>>({ _enum, orders(order, more...) });
+		}
+		/// <summary>Adds a stable sorting stage on the key selected from each element, in ascending order. See <see cref="orderby"/>.</summary>
+		/// <param name="selector">Lambda which selects the key of each element.</param>
+		template<class _Fn>
+		inline auto orderby_key(_Fn &&selector) const { return orderby(ascending(::std::forward<_Fn>(selector))); }
+		/// <summary>Adds a stable sorting stage on the key selected from each element, in descending order. See <see cref="orderby"/>.</summary>
+		/// <param name="selector">Lambda which selects the key of each element.</param>
+		template<class _Fn>
+		inline auto orderby_key_descending(_Fn &&selector) const { return orderby(descending(::std::forward<_Fn>(selector))); }
+		/// <summary>
+		/// Adds a less significant key to the sorting stage directly before it, which must sort on keys.
+		/// </summary>
+		/// <param name="order">The key, created with <see cref="linq::ascending"/> or <see cref="linq::descending"/>.</param>
+		/// <returns>The extended query.</returns>
+		template<class _Fn, bool _Descending>
+		inline auto thenby(const core::key_order<_Fn, _Descending> &order) const {
+			typedef core::thenby_stage<_Enum, core::key_order<_Fn, _Descending>> stage;
+			return query<typename stage::type>(stage::make(_enum, order));
+		}
+		/// <summary>Adds a less significant key, in ascending order, to the sorting stage directly before it. See <see cref="thenby"/>.</summary>
+		/// <param name="selector">Lambda which selects the key of each element.</param>
+		template<class _Fn>
+		inline auto thenby_key(_Fn &&selector) const { return thenby(ascending(::std::forward<_Fn>(selector))); }
+		/// <summary>Adds a less significant key, in descending order, to the sorting stage directly before it. See <see cref="thenby"/>.</summary>
+		/// <param name="selector">Lambda which selects the key of each element.</param>
+		template<class _Fn>
+		inline auto thenby_key_descending(_Fn &&selector) const { return thenby(descending(::std::forward<_Fn>(selector))); }
+
+		/// <summary>
+		/// Adds a stage which ends the query after its first <paramref name="count"/> items. Directly after an
+		/// <see cref="orderby"/> (optionally followed by a <see cref="skip"/>) the sort is replaced by a bounded heap, which
+		/// only ever holds the items it will hand on and costs O(n log k) rather than O(n log n).
+		/// </summary>
+		/// <param name="count">Maximum number of items to be kept.</param>
+		/// <returns>The extended query.</returns>
+		inline query<typename core::take_stage<_Enum>::type> take(::std::size_t count) const {
+			return query<typename core::take_stage<_Enum>::type>(core::take_stage<_Enum>::make(_enum, count));
+		}
+		/// <summary>
+		/// Adds a stage which discards the first <paramref name="count"/> items of the query.
+		/// </summary>
+		/// <param name="count">Number of items to be discarded.</param>
+		/// <returns>The extended query.</returns>
+		inline query<core::skip_enumerator<_Enum>> skip(::std::size_t count) const {
+			return query<core::skip_enumerator<_Enum>>(core::skip_enumerator<_Enum>(_enum, count));
+		}
+		/// <summary>
+		/// Adds a stage which ends the query at the first item which does not satisfy the condition.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied by every item kept.</param>
+		/// <returns>The extended query.</returns>
+		template<class _Pr>
+		inline query<core::take_while_enumerator<_Enum, ::std::decay_t<_Pr>>> take_while(_Pr &&condition) const {
+			return query<core::take_while_enumerator<_Enum, ::std::decay_t<_Pr>>>({ _enum, ::std::forward<_Pr>(condition) });
+		}
+		/// <summary>
+		/// Adds a stage which keeps only the first <paramref name="count"/> items by the predicate, in order. Equivalent to
+		/// <c>orderby(pred).take(count)</c>.
+		/// </summary>
+		/// <param name="count">Maximum number of items to be kept.</param>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <returns>The extended query.</returns>
+		template<class _Pr>
+		inline query<core::top_k_enumerator<_Enum, ::std::decay_t<_Pr>>> top_k(::std::size_t count, _Pr &&pred) const {
+			return query<core::top_k_enumerator<_Enum, ::std::decay_t<_Pr>>>({ _enum, ::std::forward<_Pr>(pred), count });
+		}
+		/// <summary>
+		/// Groups the items of the query into windows of <paramref name="size"/> consecutive items, one starting every
+		/// <paramref name="step"/> items, to be aggregated by the <see cref="windowed"/> returned. A step of one slides the
+		/// window along item by item, and a step equal to the size gives tumbling windows which never overlap. Only whole
+		/// windows are aggregated. The aggregates extend the query, streaming each window's result as the items arrive.
+		/// </summary>
+		/// <param name="size">Number of items in each window.</param>
+		/// <param name="step">Number of items between the starts of two windows.</param>
+		/// <exception cref="std::logic_error">Thrown if the size or step is zero.</exception>
+		inline windowed<_Enum, core::count_frame, false> window(::std::size_t size, ::std::size_t step) const {
+			return windowed<_Enum, core::count_frame, false>(_enum, core::count_frame(size, step), 0);
+		}
+		/// <summary>
+		/// Groups the items of the query into windows of time, to be aggregated by the <see cref="windowed"/> returned. Window
+		/// k holds the items whose key is at least <c>first + k * step</c> and less than that plus <paramref name="length"/>,
+		/// where <c>first</c> is the key of the first item, so a step equal to the length gives tumbling windows and a shorter
+		/// one gives overlapping windows. Every window holding at least one item is aggregated, as a <see cref="window_result"/>.
+		/// The items must be in ascending order of key.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the time of each item, such as a timestamp.</param>
+		/// <param name="length">Length of each window, such as a <see cref="std::chrono::duration"/>.</param>
+		/// <param name="step">Time between the starts of two windows.</param>
+		/// <exception cref="std::logic_error">Thrown if the length or step is not greater than zero.</exception>
+		template<class _Fn, class _Dur, class _Step>
+		inline auto window(_Fn &&key_selector, _Dur length, _Step step) const {
+			typedef core::time_frame<::std::decay_t<_Fn>, ::std::common_type_t<_Dur, _Step>> frame;
+			return windowed<_Enum, frame, false>(_enum, frame(::std::forward<_Fn>(key_selector), length, step), 0);
+		}
+
+		/// <summary>
+		/// Adds a join stage between the query and the provided container, merging each of the paired items.
+		/// The container is not copied and must outlive the evaluation of the query.
+		/// </summary>
+		/// <param name="arr">Container to be joined with this query.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <param name="on">Conditional lambda that determines if two elements should be paired.</param>
+		/// <typeparam name="_Ty2">(Optional) The type contained in the container being joined.</typeparam>
+		/// <typeparam name="_Ret">(Optional) The type to be produced by the merge; defaults to the return type of the merge.</typeparam>
+		/// <returns>The extended query.</returns>
+		template<class _Ty2 = void, class _Ret = void, class _Cont, class _Merge, class _On>
+		inline auto join(const _Cont &arr, _Merge &&merge, _On &&on) const {
+			typedef core::join_enumerator<_Enum, typename _Cont::const_iterator, ::std::decay_t<_Merge>, ::std::decay_t<_On>, _Ret> joined;
+			return query<joined>(joined(_enum, arr.begin(), arr.end(), ::std::forward<_Merge>(merge), ::std::forward<_On>(on)));
+		}
+		/// <summary>
+		/// Adds a join stage between the query and the provided container which pairs the items into <see cref="linq::core::merge_pair"/>.
+		/// The container is not copied and must outlive the evaluation of the query.
+		/// </summary>
+		/// <param name="arr">Container to be joined with this query.</param>
+		/// <param name="on">Conditional lambda that determines if two elements should be paired.</param>
+		/// <typeparam name="_Ty2">(Optional) The type contained in the container being joined.</typeparam>
+		/// <returns>The extended query.</returns>
+		template<class _Ty2 = void, class _Cont, class _On>
+		inline auto join(const _Cont &arr, _On &&on) const {
+			typedef ::std::conditional_t<::std::is_void<_Ty2>::value, typename _Cont::value_type, _Ty2> right_type;
+			return join<right_type, core::merge_pair<value_type, right_type>>(arr,
+				[](const value_type &left, const right_type &right) -> core::merge_pair<value_type, right_type> { return { left, right }; },
+				::std::forward<_On>(on));
+		}
+
+		/// <summary>
+		/// Adds an equi-join stage between the query and the provided random access container, pairing the elements whose keys
+		/// are equal and merging them. The container is hashed by key once, when the query is evaluated, after which each
+		/// element of the query is matched in constant time. The output is in the same order as the predicate based join.
+		/// The container is not copied and must outlive the evaluation of the query.
+		/// </summary>
+		/// <param name="arr">Container to be joined with this query.</param>
+		/// <param name="left_key">Lambda which selects the key of an element of this query.</param>
+		/// <param name="right_key">Lambda which selects the key of an element of the container.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <typeparam name="_Ty2">(Optional) The type contained in the container being joined.</typeparam>
+		/// <typeparam name="_Ret">(Optional) The type to be produced by the merge; defaults to the return type of the merge.</typeparam>
+		/// <returns>The extended query.</returns>
+		template<class _Ty2 = void, class _Ret = void, class _Cont, class _LKey, class _RKey, class _Merge>
+		inline auto join(const _Cont &arr, _LKey &&left_key, _RKey &&right_key, _Merge &&merge) const {
+			typedef core::hash_join_enumerator<_Enum, typename _Cont::const_iterator, ::std::decay_t<_LKey>, ::std::decay_t<_RKey>, ::std::decay_t<_Merge>, _Ret, false> joined;
+			return query<joined>(joined(_enum, arr.begin(), arr.end(), ::std::forward<_LKey>(left_key), ::std::forward<_RKey>(right_key), ::std::forward<_Merge>(merge)));
+		}
+		/// <summary>
+		/// Adds a left outer equi-join stage between the query and the provided random access container. Behaves as the key based
+		/// <see cref="join"/>, except every element of the query without a match is still merged once, with a null right pointer.
+		/// The merge is given a pointer to the right element: merge(const left&amp;, const right*).
+		/// The container is not copied and must outlive the evaluation of the query.
+		/// </summary>
+		/// <param name="arr">Container to be joined with this query.</param>
+		/// <param name="left_key">Lambda which selects the key of an element of this query.</param>
+		/// <param name="right_key">Lambda which selects the key of an element of the container.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <typeparam name="_Ty2">(Optional) The type contained in the container being joined.</typeparam>
+		/// <typeparam name="_Ret">(Optional) The type to be produced by the merge; defaults to the return type of the merge.</typeparam>
+		/// <returns>The extended query.</returns>
+		template<class _Ty2 = void, class _Ret = void, class _Cont, class _LKey, class _RKey, class _Merge>
+		inline auto left_join(const _Cont &arr, _LKey &&left_key, _RKey &&right_key, _Merge &&merge) const {
+			typedef core::hash_join_enumerator<_Enum, typename _Cont::const_iterator, ::std::decay_t<_LKey>, ::std::decay_t<_RKey>, ::std::decay_t<_Merge>, _Ret, true> joined;
+			return query<joined>(joined(_enum, arr.begin(), arr.end(), ::std::forward<_LKey>(left_key), ::std::forward<_RKey>(right_key), ::std::forward<_Merge>(merge)));
+		}
+		/// <summary>
+		/// Adds a group join stage between the query and the provided random access container. Each element of the query
+		/// produces exactly one merged element, with the merge given a range over every element of the container with an
+		/// equal key: merge(const left&amp;, const core::indirect_range&amp;). The range is only valid during the merge.
+		/// The container is not copied and must outlive the evaluation of the query.
+		/// </summary>
+		/// <param name="arr">Container to be joined with this query.</param>
+		/// <param name="left_key">Lambda which selects the key of an element of this query.</param>
+		/// <param name="right_key">Lambda which selects the key of an element of the container.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <typeparam name="_Ty2">(Optional) The type contained in the container being joined.</typeparam>
+		/// <typeparam name="_Ret">(Optional) The type to be produced by the merge; defaults to the return type of the merge.</typeparam>
+		/// <returns>The extended query.</returns>
+		template<class _Ty2 = void, class _Ret = void, class _Cont, class _LKey, class _RKey, class _Merge>
+		inline auto group_join(const _Cont &arr, _LKey &&left_key, _RKey &&right_key, _Merge &&merge) const {
+			typedef core::group_join_enumerator<_Enum, typename _Cont::const_iterator, ::std::decay_t<_LKey>, ::std::decay_t<_RKey>, ::std::decay_t<_Merge>, _Ret> joined;
+			return query<joined>(joined(_enum, arr.begin(), arr.end(), ::std::forward<_LKey>(left_key), ::std::forward<_RKey>(right_key), ::std::forward<_Merge>(merge)));
+		}
+
+		/*** Set operations ***
+		 * Each keeps only the first element with each key, in order, and holds a single hash table of keys while the query
+		 * runs. The container given to union_with, intersect and except must have random access iterators, is not copied,
+		 * and must outlive the evaluation of the query. Without a key selector the elements themselves are the keys.
+		 */
+
+		/// <summary>Adds a stage which drops every element equal to one before it.</summary>
+		/// <returns>The extended query.</returns>
+		inline query<core::distinct_enumerator<_Enum, core::identity>> distinct() const {
+			return query<core::distinct_enumerator<_Enum, core::identity>>({ _enum, core::identity() });
+		}
+		/// <summary>Adds a stage which drops every element whose key equals that of an element before it.</summary>
+		/// <param name="key_selector">Lambda which selects the key of each element.</param>
+		/// <returns>The extended query.</returns>
+		template<class _Fn>
+		inline query<core::distinct_enumerator<_Enum, ::std::decay_t<_Fn>>> distinct(_Fn &&key_selector) const {
+			return query<core::distinct_enumerator<_Enum, ::std::decay_t<_Fn>>>({ _enum, ::std::forward<_Fn>(key_selector) });
+		}
+		/// <summary>
+		/// Adds a stage producing the distinct elements of the query, followed by the elements of the container whose keys
+		/// were not produced already.
+		/// </summary>
+		/// <param name="arr">Container whose elements are appended.</param>
+		/// <param name="key_selector">(Optional) Lambda which selects the key of each element of either input.</param>
+		/// <returns>The extended query.</returns>
+		template<class _Cont, class _Fn = core::identity>
+		inline auto union_with(const _Cont &arr, _Fn &&key_selector = _Fn()) const {
+			typedef core::union_enumerator<_Enum, typename _Cont::const_iterator, ::std::decay_t<_Fn>> united;
+			return query<united>(united(_enum, arr.begin(), arr.end(), ::std::forward<_Fn>(key_selector)));
+		}
+		/// <summary>Adds a stage keeping the distinct elements of the query whose keys are found in the container.</summary>
+		/// <param name="arr">Container whose keys are searched.</param>
+		/// <param name="key_selector">(Optional) Lambda which selects the key of each element of either input.</param>
+		/// <returns>The extended query.</returns>
+		template<class _Cont, class _Fn = core::identity>
+		inline auto intersect(const _Cont &arr, _Fn &&key_selector = _Fn()) const {
+			typedef core::set_filter_enumerator<_Enum, typename _Cont::const_iterator, ::std::decay_t<_Fn>, true> filtered;
+			return query<filtered>(filtered(_enum, arr.begin(), arr.end(), ::std::forward<_Fn>(key_selector)));
+		}
+		/// <summary>Adds a stage keeping the distinct elements of the query whose keys are not found in the container.</summary>
+		/// <param name="arr">Container whose keys are excluded.</param>
+		/// <param name="key_selector">(Optional) Lambda which selects the key of each element of either input.</param>
+		/// <returns>The extended query.</returns>
+		template<class _Cont, class _Fn = core::identity>
+		inline auto except(const _Cont &arr, _Fn &&key_selector = _Fn()) const {
+			typedef core::set_filter_enumerator<_Enum, typename _Cont::const_iterator, ::std::decay_t<_Fn>, false> filtered;
+			return query<filtered>(filtered(_enum, arr.begin(), arr.end(), ::std::forward<_Fn>(key_selector)));
+		}
+
+
+	public:
+		/// <summary>
+		/// Evaluates the query into a new <see cref="std::vector"/>.
+		/// </summary>
+		/// <returns><see cref="std::vector"/> containing the results of the query.</returns>
+		::std::vector<value_type> to_vector() const {
+			::std::vector<value_type> result;
+			_fill(result);
+			return result;
+		}
+		/// <summary>
+		/// Evaluates the query into a new <see cref="linq::array"/>.
+		/// </summary>
+		/// <returns><see cref="linq::array"/> containing the results of the query.</returns>
+		array<value_type> to_array() const {
+			array<value_type> result;
+			_fill(result);
+			return result;
+		}
+		/// <summary>
+		/// Evaluates the query into a new <see cref="linq::array"/> whose storage comes from the provided allocator, such as
+		/// an <see cref="arena_allocator"/>.
+		/// </summary>
+		/// <param name="allocator">Allocator of the new array.</param>
+		/// <returns><see cref="linq::array"/> containing the results of the query.</returns>
+		template<class _Alloc>
+		array<value_type, _Alloc> to_array(const _Alloc &allocator) const {
+			array<value_type, _Alloc> result(allocator);
+			_fill(result);
+			return result;
+		}
+		/// <summary>Evaluates the query into a new <see cref="linq::array"/>.</summary>
+		inline operator array<value_type>() const { return to_array(); }
+		/// <summary>
+		/// Evaluates the query into storage owned by the caller, created by <see cref="linq::into"/>. A container is emptied
+		/// and refilled, keeping its storage, so a chain of streaming stages such as where and select evaluated into the same
+		/// container over and over allocates nothing once the container has grown large enough.
+		/// </summary>
+		/// <param name="out">Destination created by <see cref="linq::into"/>.</param>
+		/// <returns>The filled container, or the iterator past the last item written.</returns>
+		template<class _Out, class = ::std::enable_if_t<core::is_output<_Out>::value>>
+		typename _Out::result_type copy_to(_Out out) const {
+			core::stage_scope stage("query", 0);
+			_Enum e = _enum;
+			out.start(e.size_hint());
+			while (e.move_next()) {
+				out.emplace(e.current());
+			}
+			stage.written(out);
+			return out.finish();
+		}
+
+		/*** Searching ***
+		 * The terminals below never throw to report a miss: they return an empty optional, false or linq::npos instead, and
+		 * stop evaluating the query at the first item which decides their result. first, last and their _or_default forms
+		 * are written on top of them.
+		 */
+
+		/// <summary>Evaluates the query until the first item which satisfies the provided condition.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>The first item which satisfies the condition; otherwise an empty optional.</returns>
+		template<class _Pr>
+		core::optional<value_type> find_first(_Pr &&condition) const {
+			_Enum e = _enum;
+			while (e.move_next()) {
+				reference item = e.current();
+				if (condition(item)) {
+					return core::optional<value_type>(item);
+				}
+			}
+			return core::optional<value_type>();
+		}
+		/// <summary>Evaluates the whole query for the last item which satisfies the provided condition.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>The last item which satisfies the condition; otherwise an empty optional.</returns>
+		template<class _Pr>
+		inline core::optional<value_type> find_last(_Pr &&condition) const { return _find_last(condition); }
+		/// <summary>
+		/// Evaluates the query for the only item which satisfies the provided condition, stopping at the second one found.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>The item if exactly one satisfies the condition; otherwise, when none or several do, an empty optional.</returns>
+		template<class _Pr>
+		core::optional<value_type> single(_Pr &&condition) const {
+			core::optional<value_type> found;
+			_Enum e = _enum;
+			while (e.move_next()) {
+				reference item = e.current();
+				if (condition(item)) {
+					if (found) {
+						return core::optional<value_type>();
+					}
+					found.emplace(item);
+				}
+			}
+			return found;
+		}
+		/// <summary>Evaluates the query until the item at the provided position.</summary>
+		/// <param name="index">Zero based position of the item.</param>
+		/// <returns>The item at the position; otherwise, when the query is shorter, an empty optional.</returns>
+		core::optional<value_type> element_at(::std::size_t index) const {
+			_Enum e = _enum;
+			while (e.move_next()) {
+				if (index-- == 0) {
+					return core::optional<value_type>(e.current());
+				}
+			}
+			return core::optional<value_type>();
+		}
+		/// <summary>Evaluates the query until the first item which satisfies the provided condition.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>Zero based position of the first item which satisfies the condition; otherwise <see cref="linq::npos"/>.</returns>
+		template<class _Pr>
+		::std::size_t index_of(_Pr &&condition) const {
+			::std::size_t index = 0;
+			_Enum e = _enum;
+			while (e.move_next()) {
+				if (condition(e.current())) {
+					return index;
+				}
+				index++;
+			}
+			return npos;
+		}
+		/// <summary>Evaluates the query until the first item equal to the provided value.</summary>
+		/// <returns>True if any item equals the value; otherwise false.</returns>
+		inline bool contains(const value_type &value) const { return any([&value](reference item) { return item == value; }); }
+
+		/// <summary>
+		/// Evaluates the query until the first item which satisfies the provided condition.
+		/// Throws <see cref="std::logic_error"/> if the condition is never satisfied.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <exception cref="std::logic_error">Thrown if no items satisfy the condition.</exception>
+		/// <returns>The first item found which satisfies the condition; otherwise an error is thrown.</returns>
+		template<class _Pr>
+		value_type first(_Pr &&condition) const {
+			core::optional<value_type> found = find_first(condition);
+			if (!found) {
+				core::throw_no_match();
+			}
+			return ::std::move(*found);
+		}
+		/// <summary>
+		/// Evaluates the query until the first item which satisfies the provided condition.
+		/// Returns the provided <paramref name="defaultValue"/> if the condition is never satisfied.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <param name="defaultValue">Default value to be returned if no items satisfy the condition.</param>
+		/// <returns>The first item found which satisfies the condition; otherwise the provided <paramref name="defaultValue"/>.</returns>
+		template<class _Pr>
+		value_type first_or_default(const value_type &defaultValue, _Pr &&condition) const {
+			core::optional<value_type> found = find_first(condition);
+			return found ? ::std::move(*found) : defaultValue;
+		}
+
+		/// <summary>
+		/// Evaluates the whole query for the last item which satisfies the provided condition.
+		/// Throws <see cref="std::logic_error"/> if the condition is never satisfied.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <exception cref="std::logic_error">Thrown if no items satisfy the condition.</exception>
+		/// <returns>The last item found which satisfies the condition; otherwise an error is thrown.</returns>
+		template<class _Pr>
+		value_type last(_Pr &&condition) const {
+			core::optional<value_type> found = _find_last(condition);
+			if (!found) {
+				core::throw_no_match();
+			}
+			return ::std::move(*found);
+		}
+		/// <summary>
+		/// Evaluates the whole query for the last item which satisfies the provided condition.
+		/// Returns the provided <paramref name="defaultValue"/> if the condition is never satisfied.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <param name="defaultValue">Default value to be returned if no items satisfy the condition.</param>
+		/// <returns>The last item found which satisfies the condition; otherwise the provided <paramref name="defaultValue"/>.</returns>
+		template<class _Pr>
+		value_type last_or_default(const value_type &defaultValue, _Pr &&condition) const {
+			core::optional<value_type> found = _find_last(condition);
+			return found ? ::std::move(*found) : defaultValue;
+		}
+
+		/// <summary>
+		/// Evaluates the query and sums its items. Floating point items are summed pairwise, see <see cref="core::pairwise_sum"/>.
+		/// </summary>
+		/// <returns>The sum of the items; a default constructed value if there are none.</returns>
+		inline value_type sum() const { return sum([](reference item) -> value_type { return item; }); }
+		/// <summary>
+		/// Evaluates the query and sums a value selected from each of its items.
+		/// </summary>
+		/// <param name="selector">Lambda which selects the value to be summed from each item.</param>
+		/// <returns>The sum of the selected values; a default constructed value if there are none.</returns>
+		template<class _Fn>
+		auto sum(_Fn &&selector) const {
+			core::summation<::std::decay_t<core::invoke_result_t<_Fn&, reference>>> total;
+			_Enum e = _enum;
+			while (e.move_next()) {
+				total.add(selector(e.current()));
+			}
+			return total.result();
+		}
+
+		/// <summary>
+		/// Evaluates the query for its smallest item, the first one found if several are equal. A floating point NaN is returned if any item is NaN.
+		/// Throws <see cref="std::logic_error"/> if there are no items.
+		/// </summary>
+		/// <exception cref="std::logic_error">Thrown if there are no items.</exception>
+		inline value_type min() const { return min([](reference item) -> value_type { return item; }); }
+		/// <summary>
+		/// Evaluates the query for the smallest value selected from its items. A floating point NaN is returned if any value is NaN.
+		/// Throws <see cref="std::logic_error"/> if there are no items.
+		/// </summary>
+		/// <param name="selector">Lambda which selects the value to be compared from each item.</param>
+		/// <exception cref="std::logic_error">Thrown if there are no items.</exception>
+		template<class _Fn>
+		inline auto min(_Fn &&selector) const { return _extreme(selector, core::less<>()); }
+		/// <summary>
+		/// Evaluates the query for its largest item, the first one found if several are equal. A floating point NaN is returned if any item is NaN.
+		/// Throws <see cref="std::logic_error"/> if there are no items.
+		/// </summary>
+		/// <exception cref="std::logic_error">Thrown if there are no items.</exception>
+		inline value_type max() const { return max([](reference item) -> value_type { return item; }); }
+		/// <summary>
+		/// Evaluates the query for the largest value selected from its items. A floating point NaN is returned if any value is NaN.
+		/// Throws <see cref="std::logic_error"/> if there are no items.
+		/// </summary>
+		/// <param name="selector">Lambda which selects the value to be compared from each item.</param>
+		/// <exception cref="std::logic_error">Thrown if there are no items.</exception>
+		template<class _Fn>
+		inline auto max(_Fn &&selector) const { return _extreme(selector, core::more<>()); }
+		/// <summary>
+		/// Evaluates the query for both its smallest and largest items in a single pass.
+		/// Throws <see cref="std::logic_error"/> if there are no items.
+		/// </summary>
+		/// <exception cref="std::logic_error">Thrown if there are no items.</exception>
+		/// <returns>Pair of the smallest (first) and the largest (second) items.</returns>
+		inline ::std::pair<value_type, value_type> minmax() const { return minmax([](reference item) -> value_type { return item; }); }
+		/// <summary>
+		/// Evaluates the query for both the smallest and largest values selected from its items in a single pass.
+		/// Throws <see cref="std::logic_error"/> if there are no items.
+		/// </summary>
+		/// <param name="selector">Lambda which selects the value to be compared from each item.</param>
+		/// <exception cref="std::logic_error">Thrown if there are no items.</exception>
+		/// <returns>Pair of the smallest (first) and the largest (second) values.</returns>
+		template<class _Fn>
+		auto minmax(_Fn &&selector) const {
+			typedef ::std::decay_t<core::invoke_result_t<_Fn&, reference>> result_type;
+			_Enum e = _enum;
+			if (!e.move_next()) {
+				core::throw_empty();
+			}
+			result_type first = selector(e.current());
+			::std::pair<result_type, result_type> found(first, first);
+			while (e.move_next() && !core::is_nan(found.first)) {
+				result_type value = selector(e.current());
+				if (core::is_nan(value)) {
+					found.first = found.second = value;
+				}
+				else if (value < found.first) {
+					found.first = ::std::move(value);
+				}
+				else if (found.second < value) {
+					found.second = ::std::move(value);
+				}
+			}
+			return found;
+		}
+
+		/// <summary>
+		/// Evaluates the query for the average of its items. Integers are summed as 64-bit integers and averaged as a double.
+		/// Throws <see cref="std::logic_error"/> if there are no items.
+		/// </summary>
+		/// <exception cref="std::logic_error">Thrown if there are no items.</exception>
+		inline core::average_t<value_type> average() const { return average([](reference item) -> value_type { return item; }); }
+		/// <summary>
+		/// Evaluates the query for the average of a value selected from each of its items. Integers are summed as 64-bit integers and averaged as a double.
+		/// Throws <see cref="std::logic_error"/> if there are no items.
+		/// </summary>
+		/// <param name="selector">Lambda which selects the value to be averaged from each item.</param>
+		/// <exception cref="std::logic_error">Thrown if there are no items.</exception>
+		template<class _Fn>
+		auto average(_Fn &&selector) const {
+			typedef ::std::decay_t<core::invoke_result_t<_Fn&, reference>> value_t;
+			core::summation<core::average_sum_t<value_t>> total;
+			::std::size_t items = 0;
+			_Enum e = _enum;
+			while (e.move_next()) {
+				total.add(selector(e.current()));
+				items++;
+			}
+			if (items == 0) {
+				core::throw_empty();
+			}
+			return static_cast<core::average_t<value_t>>(total.result()) / static_cast<core::average_t<value_t>>(items);
+		}
+
+		/// <summary>Evaluates the query and counts its items.</summary>
+		::std::size_t count() const {
+			::std::size_t total = 0;
+			_Enum e = _enum;
+			while (e.move_next()) {
+				total++;
+			}
+			return total;
+		}
+		/// <summary>Evaluates the query and counts the items which satisfy the provided condition.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		template<class _Pr>
+		::std::size_t count(_Pr &&condition) const {
+			::std::size_t total = 0;
+			_Enum e = _enum;
+			while (e.move_next()) {
+				total += condition(e.current()) ? 1 : 0;
+			}
+			return total;
+		}
+
+		/// <summary>Evaluates the query until its first item, if any.</summary>
+		/// <returns>True if the query has any items; otherwise false.</returns>
+		inline bool any() const {
+			_Enum e = _enum;
+			return e.move_next();
+		}
+		/// <summary>Evaluates the query until the first item which satisfies the provided condition.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>True if any item satisfies the condition; otherwise false.</returns>
+		template<class _Pr>
+		bool any(_Pr &&condition) const {
+			_Enum e = _enum;
+			while (e.move_next()) {
+				if (condition(e.current())) {
+					return true;
+				}
+			}
+			return false;
+		}
+		/// <summary>Evaluates the query until the first item which does not satisfy the provided condition.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>True if every item satisfies the condition, or there are no items; otherwise false.</returns>
+		template<class _Pr>
+		bool all(_Pr &&condition) const {
+			_Enum e = _enum;
+			while (e.move_next()) {
+				if (!condition(e.current())) {
+					return false;
+				}
+			}
+			return true;
+		}
+		/// <summary>Evaluates the query until its first item, if any.</summary>
+		/// <returns>True if the query has no items; otherwise false.</returns>
+		inline bool none() const { return !any(); }
+		/// <summary>Evaluates the query until the first item which satisfies the provided condition.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>True if no item satisfies the condition; otherwise false.</returns>
+		template<class _Pr>
+		inline bool none(_Pr &&condition) const { return !any(::std::forward<_Pr>(condition)); }
+
+
+		/// <summary>
+		/// Evaluates the query, folding each item into an accumulated value from left to right.
+		/// </summary>
+		/// <param name="seed">The initial accumulated value.</param>
+		/// <param name="fn">Lambda of the form <c>_Acc(_Acc accumulated, const value_type &amp;item)</c> returning the next accumulated value.</param>
+		/// <returns>The final accumulated value; the <paramref name="seed"/> if there are no items.</returns>
+		template<class _Acc, class _Fn>
+		_Acc aggregate(_Acc seed, _Fn &&fn) const {
+			_Enum e = _enum;
+			while (e.move_next()) {
+				seed = fn(::std::move(seed), e.current());
+			}
+			return seed;
+		}
+
+		/// <summary>
+		/// Evaluates the query and groups its items by key. See <see cref="array::groupby"/>.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <typeparam name="_Key">(Optional) The key type; defaults to the return type of the key selector.</typeparam>
+		template<class _Key = void, class _Fn>
+		inline auto groupby(_Fn &&key_selector) const {
+			return to_array().template groupby<_Key>(::std::forward<_Fn>(key_selector));
+		}
+		/// <summary>
+		/// Evaluates the query and groups its items by key, sorting the groups by their keys. See <see cref="array::groupby"/>.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <param name="order">Predicate the keys are sorted by, such as <see cref="linq::ascending"/>.</param>
+		/// <typeparam name="_Key">(Optional) The key type; defaults to the return type of the key selector.</typeparam>
+		template<class _Key = void, class _Fn, class _Pr, class = ::std::enable_if_t<!core::is_summarizer<::std::decay_t<_Pr>>::value>>
+		inline auto groupby(_Fn &&key_selector, _Pr &&order) const {
+			return to_array().template groupby<_Key>(::std::forward<_Fn>(key_selector), ::std::forward<_Pr>(order));
+		}
+		/// <summary>
+		/// Evaluates the query and summarizes a value selected from the items of each group in a single pass, without
+		/// collecting the items of any group. See <see cref="group_summary"/>.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <param name="summary">Selector of the value to be summarized, created by <see cref="linq::summarize"/>.</param>
+		/// <typeparam name="_Key">(Optional) The key type; defaults to the return type of the key selector.</typeparam>
+		/// <returns>Array holding the summary of every group, in the order their keys were first found.</returns>
+		template<class _Key = void, class _Fn, class _Sel>
+		auto groupby(_Fn &&key_selector, core::summarizer<_Sel> summary) const {
+			typedef core::group_key_t<_Key, _Fn, reference> key_type;
+			typedef ::std::decay_t<core::invoke_result_t<_Sel&, reference>> value_t;
+			core::stage_scope stage("groupby", 0);
+			core::group_table<key_type> table;
+			array<group_summary<key_type, value_t>> result;
+			_Enum e = _enum;
+			while (e.move_next()) {
+				stage.calls(2);
+				reference item = e.current();
+				const ::std::size_t id = table.insert(key_selector(item));
+				value_t value = summary.selector(item);
+				if (id == result.size()) {
+					result.push_back({ table.keys()[id], 1, value, value, value });
+					continue;
+				}
+				group_summary<key_type, value_t> &found = result[id];
+				found.count++;
+				found.sum += value;
+				if (value < found.min) found.min = value;
+				if (found.max < value) found.max = value;
+			}
+			stage.output(result.size());
+			return result;
+		}
+		/// <summary>
+		/// Evaluates the query and summarizes a value selected from the items of each group in a single pass, sorting the
+		/// summaries by their keys. See <see cref="group_summary"/>.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <param name="summary">Selector of the value to be summarized, created by <see cref="linq::summarize"/>.</param>
+		/// <param name="order">Predicate the keys are sorted by, such as <see cref="linq::ascending"/>.</param>
+		/// <typeparam name="_Key">(Optional) The key type; defaults to the return type of the key selector.</typeparam>
+		template<class _Key = void, class _Fn, class _Sel, class _Pr>
+		auto groupby(_Fn &&key_selector, core::summarizer<_Sel> summary, _Pr &&order) const {
+			auto result = groupby<_Key>(::std::forward<_Fn>(key_selector), ::std::move(summary));
+			typedef typename decltype(result)::value_type summary_type;
+			::std::sort(result.begin(), result.end(), [&order](const summary_type &left, const summary_type &right) { return order(left.key, right.key); });
+			return result;
+		}
+
+	private:
+		template<class _Fn, class _Cmp>
+		auto _extreme(_Fn &selector, _Cmp better) const {
+			typedef ::std::decay_t<core::invoke_result_t<_Fn&, reference>> result_type;
+			_Enum e = _enum;
+			if (!e.move_next()) {
+				core::throw_empty();
+			}
+			result_type found = selector(e.current());
+			while (!core::is_nan(found) && e.move_next()) {
+				result_type value = selector(e.current());
+				if (core::is_nan(value) || better(value, found)) {
+					found = ::std::move(value);
+				}
+			}
+			return found;
+		}
+		template<class _Cont>
+		void _fill(_Cont &result) const {
+			core::stage_scope stage("query", 0);
+			_Enum e = _enum;
+			result.reserve(e.size_hint());
+			while (e.move_next()) {
+				result.emplace_back(e.current());
+			}
+			stage.output(result.size());
+		}
+		template<class _Pr>
+		core::optional<value_type> _find_last(_Pr &condition) const {
+			core::optional<value_type> found;
+			_Enum e = _enum;
+			while (e.move_next()) {
+				reference item = e.current();
+				if (condition(item)) {
+					found.emplace(item);
+				}
+			}
+			return found;
+		}
+
+		_Enum _enum;
+	};
+
+	/// <summary>
+	/// Extension to the standard std::vector class. Provides specialized query methods for processing lists.
+	/// </summary>
+	/// <typeparam name="_Ty">Type for the elements to be held</typeparam>
+	template<class _Ty, class _Alloc>
+	class array : public ::std::vector<_Ty, _Alloc> {
+		typedef ::std::vector<_Ty, _Alloc> base;
+	public:
+		/// <summary>Array of <typeparamref name="_Ty2"/> whose elements come from the same allocator as this array's, rebound to that type.</summary>
+		template<class _Ty2>
+		using rebind = array<_Ty2, typename ::std::allocator_traits<_Alloc>::template rebind_alloc<_Ty2>>;
+
+		array() : base() {}
+		explicit array(const _Alloc &_Al) : base(_Al) {}
+		array(const ::std::size_t &_Count, const _Alloc &_Al = _Alloc()) : base(_Count, _Al) {}
+		array(const ::std::size_t &_Count, const _Ty &_Val, const _Alloc &_Al = _Alloc()) : base(_Count, _Val, _Al) {}
+		array(const base &_Vec) : base(_Vec) {}
+		array(const base &_Vec, const _Alloc &_Al) : base(_Vec, _Al) {}
+		array(base &&_Right) : base(::std::move(_Right)) {}
+		array(::std::initializer_list<_Ty> _Ilist, const _Alloc &_Al = _Alloc()) : base(_Ilist, _Al) {}
+		template<class _Iter, class = ::std::enable_if_t<core::is_input_iterator<_Iter>::value>>
+		array(_Iter _First, _Iter _Last, const _Alloc &_Al = _Alloc()) : base(_First, _Last, _Al) {}
+
+	public:
+		/// <summary>
+		/// Delegate used for transforming the provided data into a new state which is returned by the call.
+		/// Kept for compatibility: every operator takes its callable as a template parameter, which also accepts these delegates.
+		/// </summary>
+		template<class _Ret>
+		using conversion = ::std::function<_Ret(const _Ty&)>;
+		/// <summary>
+		/// Delegate for applying conditions on the provided item and returning a bool result.
+		/// Kept for compatibility: every operator takes its callable as a template parameter, which also accepts these delegates.
+		/// </summary>
+		typedef ::std::function<bool(const _Ty&)> conditional;
+		/// <summary>
+		/// Delegate for comparing two items and returning a bool result.
+		/// Kept for compatibility: every operator takes its callable as a template parameter, which also accepts these delegates.
+		/// </summary>
+		template<class _Ty2>
+		using comparison = ::std::function<bool(const _Ty&, const _Ty2&)>;
+		/// <summary>
+		/// Delegate that is expected to merge two items into a new item which is then returned by the call.
+		/// Kept for compatibility: every operator takes its callable as a template parameter, which also accepts these delegates.
+		/// </summary>
+		template<class _Ty2, class _Ret>
+		using merger = ::std::function<_Ret(const _Ty&, const _Ty2&)>;
+
+	public:
+		/// <summary>
+		/// Performs an item selection which is expected to transform the data in some way and return a new array.
+		/// </summary>
+		/// <param name="selector">Lambda which defines how each item is transformed into the new type.</param>
+		/// <param name="result">The array to be filled with the new items, which is emptied first but keeps its storage.</param>
+		/// <typeparam name="_Ret">The new type being created and returned for the new array.</typeparam>
+		template<class _Ret, class _Fn, class _RAlloc>
+		inline void select(_Fn &&selector, array<_Ret, _RAlloc> &result) const {
+			select(selector, into(result));
+		}
+
+		/// <summary>
+		/// Performs an item selection which is expected to transform the data in some way and return a new array.
+		/// </summary>
+		/// <param name="selector">Lambda which defines how each item is transformed into the new type.</param>
+		/// <typeparam name="_Ret">(Optional) The new type being created; defaults to the return type of the selector.</typeparam>
+		/// <returns>The new array of transformed items.</returns>
+		template<class _Ret = void, class _Fn>
+		inline auto select(_Fn &&selector) const & {
+			core::stage_scope stage("select", this->size());
+			auto result = _to_array(lazy().template select<_Ret>(::std::forward<_Fn>(selector)));
+			stage.calls(this->size());
+			stage.output(result.size());
+			return result;
+		}
+		/// <summary>
+		/// Performs an item selection on this temporary array, handing each item to the selector as an rvalue so its resources
+		/// can be moved into the new item. When the new type is the same as the old one, the items are replaced in place and
+		/// the storage of this array is reused for the result.
+		/// </summary>
+		/// <param name="selector">Lambda which defines how each item is transformed into the new type.</param>
+		/// <typeparam name="_Ret">(Optional) The new type being created; defaults to the return type of the selector.</typeparam>
+		/// <returns>The new array of transformed items.</returns>
+		template<class _Ret = void, class _Fn>
+		inline auto select(_Fn &&selector) && {
+			typedef ::std::conditional_t<::std::is_void<_Ret>::value, ::std::decay_t<core::invoke_result_t<_Fn&, _Ty&&>>, _Ret> result_type;
+			core::stage_scope stage("select", this->size());
+			stage.calls(this->size());
+			auto result = ::std::move(*this).template _select_moved<result_type>(selector, ::std::is_same<result_type, _Ty>());
+			stage.output(result.size());
+			return result;
+		}
+
+		/// <summary>
+		/// Performs a conditional for filtering the list and returns a new list containing those filtered items.
+		/// </summary>
+		/// <param name="conditional">The lambda which determines if an item is to be added to the new list.</param>
+		/// <returns>The new list of filtered items.</returns>
+		template<class _Pr>
+		inline array where(_Pr &&condition) const & {
+			core::stage_scope stage("where", this->size());
+			array result = _where(condition, core::is_vector_filter<_Ty, ::std::decay_t<_Pr>>(), ::std::is_arithmetic<_Ty>());
+			stage.calls(this->size());
+			stage.output(result.size());
+			return result;
+		}
+		/// <summary>
+		/// Performs a conditional for filtering this temporary array in place. The kept items are moved down over the removed
+		/// ones and the storage of this array is reused for the result, so nothing is copied or allocated.
+		/// </summary>
+		/// <param name="conditional">The lambda which determines if an item is to be kept.</param>
+		/// <returns>The filtered list.</returns>
+		template<class _Pr>
+		inline array where(_Pr &&condition) && {
+			core::stage_scope stage("where", this->size());
+			stage.calls(this->size());
+			array result = ::std::move(*this)._where_moved(condition, core::is_vector_filter<_Ty, ::std::decay_t<_Pr>>(), ::std::is_arithmetic<_Ty>());
+			stage.output(result.size());
+			return result;
+		}
+
+		/// <summary>
+		/// Performs a sort on this list. The sort is stable, so items which are equal by the predicate keep their order and
+		/// the result is identical to that of the parallel <see cref="orderby"/>.
+		/// </summary>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <typeparam name="_Pr">The type of the predicate object, method or lambda</typeparam>
+		/// <returns>A reference to this list (used for chaining calls).</returns>
+		template<class _Pr>
+		inline array& orderby(const _Pr &pred) & {
+			core::stage_scope stage("orderby", this->size());
+			::std::stable_sort(this->begin(), this->end(), stage.counted(pred));
+			stage.output(this->size());
+			return *this;
+		}
+		/// <summary>
+		/// Performs a sort on this temporary list.
+		/// </summary>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <typeparam name="_Pr">The type of the predicate object, method or lambda</typeparam>
+		/// <returns>This list, moved out of the temporary (used for chaining calls).</returns>
+		template<class _Pr>
+		inline array orderby(const _Pr &pred) && {
+			orderby(pred);
+			return ::std::move(*this);
+		}
+
+		/// <summary>
+		/// Performs a stable sort on this list: items which are equal by the predicate keep their order.
+		/// </summary>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <returns>A reference to this list (used for chaining calls).</returns>
+		template<class _Pr>
+		inline array& stable_orderby(const _Pr &pred) & {
+			core::stage_scope stage("stable_orderby", this->size());
+			::std::stable_sort(this->begin(), this->end(), stage.counted(pred));
+			stage.output(this->size());
+			return *this;
+		}
+		/// <summary>
+		/// Performs a stable sort on this temporary list: items which are equal by the predicate keep their order.
+		/// </summary>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <returns>This list, moved out of the temporary (used for chaining calls).</returns>
+		template<class _Pr>
+		inline array stable_orderby(const _Pr &pred) && {
+			stable_orderby(pred);
+			return ::std::move(*this);
+		}
+
+
+		/// <summary>
+		/// Sorts this list on the keys selected from each item, created with <see cref="linq::ascending"/> or
+		/// <see cref="linq::descending"/>, such as <c>orderby(linq::descending(by_score), linq::ascending(by_name))</c>.
+		/// Every key is computed exactly once, rather than twice per comparison. Integral, float and double keys which fit
+		/// in 64 bits together are packed into one integer and radix sorted in linear time; any other keys are cached and
+		/// compared. The sort is stable: items with equal keys keep their order.
+		/// </summary>
+		/// <param name="order">The most significant key.</param>
+		/// <param name="more">Less significant keys, in order of significance.</param>
+		/// <returns>A reference to this list (used for chaining calls).</returns>
+		template<class _Fn, bool _Descending, class... _More, class = ::std::enable_if_t<!core::is_last_output<_More...>::value>>
+		inline array& orderby(const core::key_order<_Fn, _Descending> &order, const _More &...more) & {
+			static_assert(core::all_of({ core::is_key_order<_More>::value... }), "every key of a key orderby must be created with linq::ascending or linq::descending");
+			core::stage_scope stage("orderby", this->size());
+			_sort_by_keys(::std::tuple<core::key_order<_Fn, _Descending>, _More...>(order, more...));
+			stage.calls(this->size() * (1 + sizeof...(_More)));
+			stage.output(this->size());
+			return *this;
+		}
+		/// <summary>
+		/// Sorts this temporary list on the keys selected from each item. See <see cref="orderby"/>.
+		/// </summary>
+		/// <param name="order">The most significant key.</param>
+		/// <param name="more">Less significant keys, in order of significance.</param>
+		/// <returns>This list, moved out of the temporary (used for chaining calls).</returns>
+		template<class _Fn, bool _Descending, class... _More, class = ::std::enable_if_t<!core::is_last_output<_More...>::value>>
+		inline array orderby(const core::key_order<_Fn, _Descending> &order, const _More &...more) && {
+			orderby(order, more...);
+			return ::std::move(*this);
+		}
+		/// <summary>Sorts this list on the key selected from each item, in ascending order. See <see cref="orderby"/>.</summary>
+		/// <param name="selector">Lambda which selects the key of each item.</param>
+		template<class _Fn>
+		inline array& orderby_key(_Fn &&selector) & { return orderby(ascending(::std::forward<_Fn>(selector))); }
+		/// <summary>Sorts this temporary list on the key selected from each item, in ascending order. See <see cref="orderby"/>.</summary>
+		/// <param name="selector">Lambda which selects the key of each item.</param>
+		template<class _Fn>
+		inline array orderby_key(_Fn &&selector) && { return ::std::move(*this).orderby(ascending(::std::forward<_Fn>(selector))); }
+		/// <summary>Sorts this list on the key selected from each item, in descending order. See <see cref="orderby"/>.</summary>
+		/// <param name="selector">Lambda which selects the key of each item.</param>
+		template<class _Fn>
+		inline array& orderby_key_descending(_Fn &&selector) & { return orderby(descending(::std::forward<_Fn>(selector))); }
+		/// <summary>Sorts this temporary list on the key selected from each item, in descending order. See <see cref="orderby"/>.</summary>
+		/// <param name="selector">Lambda which selects the key of each item.</param>
+		template<class _Fn>
+		inline array orderby_key_descending(_Fn &&selector) && { return ::std::move(*this).orderby(descending(::std::forward<_Fn>(selector))); }
+
+		/// <summary>
+		/// Copies the first <paramref name="count"/> items of this list.
+		/// </summary>
+		/// <param name="count">Maximum number of items to be kept.</param>
+		/// <returns>New list of at most <paramref name="count"/> items.</returns>
+		inline array take(::std::size_t count) const & {
+			core::stage_scope stage("take", this->size());
+			array result(this->begin(), this->begin() + ::std::min(count, this->size()), this->get_allocator());
+			stage.output(result.size());
+			return result;
+		}
+		/// <summary>
+		/// Keeps the first <paramref name="count"/> items of this temporary list, discarding the rest in place.
+		/// </summary>
+		/// <param name="count">Maximum number of items to be kept.</param>
+		/// <returns>This list, moved out of the temporary.</returns>
+		inline array take(::std::size_t count) && {
+			core::stage_scope stage("take", this->size());
+			this->erase(this->begin() + ::std::min(count, this->size()), this->end());
+			stage.output(this->size());
+			return ::std::move(*this);
+		}
+		/// <summary>
+		/// Copies the items of this list after the first <paramref name="count"/>.
+		/// </summary>
+		/// <param name="count">Number of items to be discarded.</param>
+		/// <returns>New list of the remaining items.</returns>
+		inline array skip(::std::size_t count) const & {
+			core::stage_scope stage("skip", this->size());
+			array result(this->begin() + ::std::min(count, this->size()), this->end(), this->get_allocator());
+			stage.output(result.size());
+			return result;
+		}
+		/// <summary>
+		/// Discards the first <paramref name="count"/> items of this temporary list in place.
+		/// </summary>
+		/// <param name="count">Number of items to be discarded.</param>
+		/// <returns>This list, moved out of the temporary.</returns>
+		inline array skip(::std::size_t count) && {
+			core::stage_scope stage("skip", this->size());
+			this->erase(this->begin(), this->begin() + ::std::min(count, this->size()));
+			stage.output(this->size());
+			return ::std::move(*this);
+		}
+		/// <summary>
+		/// Copies the items of this list up to the first which does not satisfy the condition.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied by every item kept.</param>
+		/// <returns>New list of the leading items which satisfy the condition.</returns>
+		template<class _Pr>
+		inline array take_while(_Pr &&condition) const & {
+			core::stage_scope stage("take_while", this->size());
+			array result(this->begin(), ::std::find_if_not(this->begin(), this->end(), stage.counted(condition)), this->get_allocator());
+			stage.output(result.size());
+			return result;
+		}
+		/// <summary>
+		/// Keeps the items of this temporary list up to the first which does not satisfy the condition, discarding the rest in place.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied by every item kept.</param>
+		/// <returns>This list, moved out of the temporary.</returns>
+		template<class _Pr>
+		inline array take_while(_Pr &&condition) && {
+			core::stage_scope stage("take_while", this->size());
+			this->erase(::std::find_if_not(this->begin(), this->end(), stage.counted(condition)), this->end());
+			stage.output(this->size());
+			return ::std::move(*this);
+		}
+
+		/// <summary>
+		/// Finds the first <paramref name="count"/> items of this list by the predicate, in order, without sorting the whole
+		/// list. Small counts are selected with a bounded heap in O(n log k) time, holding no more than <paramref name="count"/>
+		/// copies; larger counts copy the list and partition it with <see cref="std::nth_element"/>. Items which are equal by
+		/// the predicate keep their order, so the result is always the start of the stable <see cref="orderby"/>.
+		/// </summary>
+		/// <param name="count">Maximum number of items to be kept.</param>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <returns>New list of the first <paramref name="count"/> items, sorted by the predicate.</returns>
+		template<class _Pr>
+		array top_k(::std::size_t count, _Pr &&pred) const & {
+			core::stage_scope stage("top_k", this->size());
+			auto &&counted = stage.counted(pred);
+			array result = count <= this->size() / 8 ? _adopt(_top_k(0, this->size(), count, counted).sorted()) : array(*this, this->get_allocator()).top_k(count, counted);
+			stage.output(result.size());
+			return result;
+		}
+		/// <summary>
+		/// Finds the first <paramref name="count"/> items of this temporary list by the predicate, in order, partitioning
+		/// the positions of the items with <see cref="std::nth_element"/> and sorting only the positions kept. Items which
+		/// are equal by the predicate keep their order.
+		/// </summary>
+		/// <param name="count">Maximum number of items to be kept.</param>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <returns>This list, moved out of the temporary and holding the first <paramref name="count"/> items in order.</returns>
+		template<class _Pr>
+		array top_k(::std::size_t count, _Pr &&pred) && {
+			core::stage_scope stage("top_k", this->size());
+			auto &&counted = stage.counted(pred);
+			::std::vector<::std::size_t> positions;
+			_top_k_positions(count, counted, positions);
+			base kept(this->get_allocator());
+			kept.reserve(positions.size());
+			for (::std::size_t position : positions) {
+				kept.push_back(::std::move((*this)[position]));
+			}
+			this->swap(kept);
+			stage.output(this->size());
+			return ::std::move(*this);
+		}
+		/// <summary>
+		/// Groups the items of this list into windows of <paramref name="size"/> consecutive items, one starting every
+		/// <paramref name="step"/> items, to be aggregated by the <see cref="windowed"/> returned. See <see cref="query::window"/>.
+		/// Each aggregate evaluates into a new array holding the result of every window. The list is not copied and must
+		/// outlive the returned windows.
+		/// </summary>
+		/// <param name="size">Number of items in each window.</param>
+		/// <param name="step">Number of items between the starts of two windows.</param>
+		/// <exception cref="std::logic_error">Thrown if the size or step is zero.</exception>
+		inline windowed<core::range_enumerator<typename array::const_iterator>, core::count_frame, true> window(::std::size_t size, ::std::size_t step) const {
+			return { lazy().get_enumerator(), core::count_frame(size, step), this->size() };
+		}
+		/// <summary>
+		/// Groups the items of this list into windows of time, to be aggregated by the <see cref="windowed"/> returned. See
+		/// <see cref="query::window"/>. Each aggregate evaluates into a new array holding the result of every window. The list
+		/// is not copied and must outlive the returned windows.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the time of each item, such as a timestamp.</param>
+		/// <param name="length">Length of each window, such as a <see cref="std::chrono::duration"/>.</param>
+		/// <param name="step">Time between the starts of two windows.</param>
+		/// <exception cref="std::logic_error">Thrown if the length or step is not greater than zero.</exception>
+		template<class _Fn, class _Dur, class _Step>
+		inline auto window(_Fn &&key_selector, _Dur length, _Step step) const {
+			typedef core::time_frame<::std::decay_t<_Fn>, ::std::common_type_t<_Dur, _Step>> frame;
+			return windowed<core::range_enumerator<typename array::const_iterator>, frame, true>(lazy().get_enumerator(),
+				frame(::std::forward<_Fn>(key_selector), length, step), this->size());
+		}
+
+
+		/// <summary>
+		/// Performs a join on the current list and the provided list and performs a merge of the paired items.
+		/// Every pair of elements is tested with the condition, so prefer the key based join when pairing on equal keys.
+		/// </summary>
+		/// <param name="arr">Array to be joined with this one.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <param name="on">Conditional lambda that determines if two elements should be paired.</param>
+		/// <typeparam name="_Ty2">(Optional) The type contained in the array being joined.</typeparam>
+		/// <typeparam name="_Ret">(Optional) The type to be returned in the new merged array; defaults to the return type of the merge.</typeparam>
+		/// <returns>New array of merged items.</returns>
+		template<class _Ty2 = void, class _Ret = void, class _Cont, class _Merge, class _On, class = ::std::enable_if_t<!is_execution_policy<_Cont>::value>>
+		inline auto join(const _Cont &arr, _Merge &&merge, _On &&on) const {
+			core::stage_scope stage("join", this->size());
+			auto result = _to_array(lazy().template join<_Ty2, _Ret>(arr, ::std::forward<_Merge>(merge), ::std::forward<_On>(on)));
+			const ::std::size_t pairs = this->size() * core::distance_hint(arr.begin(), arr.end());
+			stage.comparisons(pairs);
+			stage.calls(pairs + result.size());
+			stage.output(result.size());
+			return result;
+		}
+		/// <summary>
+		/// Performs a join on the current list and the provided list and pairs the items into <see cref="linq::core::merge_pair"/>.
+		/// </summary>
+		/// <param name="arr">Array to be joined with this one.</param>
+		/// <param name="on">Conditional lambda that determines if two elements should be paired.</param>
+		/// <typeparam name="_Ty2">(Optional) The type contained in the array being joined.</typeparam>
+		/// <returns>New array of paired items.</returns>
+		template<class _Ty2 = void, class _Cont, class _On, class = ::std::enable_if_t<!is_execution_policy<_Cont>::value>>
+		inline auto join(const _Cont &arr, _On &&on) const {
+			core::stage_scope stage("join", this->size());
+			auto result = _to_array(lazy().template join<_Ty2>(arr, ::std::forward<_On>(on)));
+			const ::std::size_t pairs = this->size() * core::distance_hint(arr.begin(), arr.end());
+			stage.comparisons(pairs);
+			stage.calls(pairs);
+			stage.output(result.size());
+			return result;
+		}
+
+		/// <summary>
+		/// Performs an equi-join on the current list and the provided list, pairing the elements whose keys are equal and merging them.
+		/// Each key is computed once. If both lists are already ordered by key they are merged in a single pass; otherwise the smaller
+		/// list is hashed and the larger one is streamed through it. Either way the result is in the same order as the predicate based join.
+		/// </summary>
+		/// <param name="arr">Random access list to be joined with this one.</param>
+		/// <param name="left_key">Lambda which selects the key of an element of this list.</param>
+		/// <param name="right_key">Lambda which selects the key of an element of the provided list.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <typeparam name="_Ty2">(Optional) The type contained in the array being joined.</typeparam>
+		/// <returns>New array of merged items.</returns>
+		template<class _Ty2 = void, class _Cont, class _LKey, class _RKey, class _Merge,
+			class = ::std::enable_if_t<!is_execution_policy<_Cont>::value && !core::is_output<::std::decay_t<_Merge>>::value>>
+		auto join(const _Cont &arr, _LKey &&left_key, _RKey &&right_key, _Merge &&merge) const {
+			typedef typename _Cont::value_type right_type;
+			core::stage_scope stage("join", this->size());
+			auto merged = _make<::std::decay_t<core::invoke_result_t<_Merge&, const _Ty&, const right_type&>>>();
+			stage.comparisons(_equi_join(arr, left_key, right_key, [&](::std::size_t l, const ::std::size_t *first, const ::std::size_t *last) {
+				for (; first != last; ++first) {
+					merged.emplace_back(merge((*this)[l], arr[*first]));
+				}
+			}));
+			stage.calls(this->size() + arr.size() + merged.size());
+			stage.output(merged.size());
+			return merged;
+		}
+		/// <summary>
+		/// Performs a left outer equi-join on the current list and the provided list. Behaves as the key based <see cref="join"/>,
+		/// except every element of this list without a match is still merged once, with a null right pointer.
+		/// The merge is given a pointer to the right element: merge(const left&amp;, const right*).
+		/// </summary>
+		/// <param name="arr">Random access list to be joined with this one.</param>
+		/// <param name="left_key">Lambda which selects the key of an element of this list.</param>
+		/// <param name="right_key">Lambda which selects the key of an element of the provided list.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <typeparam name="_Ty2">(Optional) The type contained in the array being joined.</typeparam>
+		/// <returns>New array of merged items.</returns>
+		template<class _Ty2 = void, class _Cont, class _LKey, class _RKey, class _Merge>
+		auto left_join(const _Cont &arr, _LKey &&left_key, _RKey &&right_key, _Merge &&merge) const {
+			typedef typename _Cont::value_type right_type;
+			core::stage_scope stage("left_join", this->size());
+			auto merged = _make<::std::decay_t<core::invoke_result_t<_Merge&, const _Ty&, const right_type*>>>();
+			stage.comparisons(_equi_join(arr, left_key, right_key, [&](::std::size_t l, const ::std::size_t *first, const ::std::size_t *last) {
+				if (first == last) {
+					merged.emplace_back(merge((*this)[l], static_cast<const right_type*>(nullptr)));
+				}
+				for (; first != last; ++first) {
+					merged.emplace_back(merge((*this)[l], ::std::addressof(arr[*first])));
+				}
+			}));
+			stage.calls(this->size() + arr.size() + merged.size());
+			stage.output(merged.size());
+			return merged;
+		}
+		/// <summary>
+		/// Performs a full outer equi-join on the current list and the provided list. Behaves as <see cref="left_join"/>, followed by
+		/// merging every element of the provided list which was never matched with a null left pointer.
+		/// The merge is given pointers to both elements: merge(const left*, const right*).
+		/// </summary>
+		/// <param name="arr">Random access list to be joined with this one.</param>
+		/// <param name="left_key">Lambda which selects the key of an element of this list.</param>
+		/// <param name="right_key">Lambda which selects the key of an element of the provided list.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <typeparam name="_Ty2">(Optional) The type contained in the array being joined.</typeparam>
+		/// <returns>New array of merged items.</returns>
+		template<class _Ty2 = void, class _Cont, class _LKey, class _RKey, class _Merge>
+		auto outer_join(const _Cont &arr, _LKey &&left_key, _RKey &&right_key, _Merge &&merge) const {
+			typedef typename _Cont::value_type right_type;
+			core::stage_scope stage("outer_join", this->size());
+			auto merged = _make<::std::decay_t<core::invoke_result_t<_Merge&, const _Ty*, const right_type*>>>();
+			::std::vector<bool> matched(arr.size(), false);
+			stage.comparisons(_equi_join(arr, left_key, right_key, [&](::std::size_t l, const ::std::size_t *first, const ::std::size_t *last) {
+				if (first == last) {
+					merged.emplace_back(merge(::std::addressof((*this)[l]), static_cast<const right_type*>(nullptr)));
+				}
+				for (; first != last; ++first) {
+					matched[*first] = true;
+					merged.emplace_back(merge(::std::addressof((*this)[l]), ::std::addressof(arr[*first])));
+				}
+			}));
+			for (::std::size_t r = 0, l = arr.size(); r < l; r++) {
+				if (!matched[r]) {
+					merged.emplace_back(merge(static_cast<const _Ty*>(nullptr), ::std::addressof(arr[r])));
+				}
+			}
+			stage.calls(this->size() + arr.size() + merged.size());
+			stage.output(merged.size());
+			return merged;
+		}
+		/// <summary>
+		/// Performs a group join on the current list and the provided list. Each element of this list produces exactly one merged
+		/// element, with the merge given a range over every element of the provided list with an equal key:
+		/// merge(const left&amp;, const core::indirect_range&amp;). The range is only valid during the merge.
+		/// </summary>
+		/// <param name="arr">Random access list to be joined with this one.</param>
+		/// <param name="left_key">Lambda which selects the key of an element of this list.</param>
+		/// <param name="right_key">Lambda which selects the key of an element of the provided list.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <typeparam name="_Ty2">(Optional) The type contained in the array being joined.</typeparam>
+		/// <returns>New array of merged items.</returns>
+		template<class _Ty2 = void, class _Cont, class _LKey, class _RKey, class _Merge>
+		auto group_join(const _Cont &arr, _LKey &&left_key, _RKey &&right_key, _Merge &&merge) const {
+			typedef core::indirect_range<typename _Cont::const_iterator> group_type;
+			core::stage_scope stage("group_join", this->size());
+			auto merged = _make<::std::decay_t<core::invoke_result_t<_Merge&, const _Ty&, const group_type&>>>();
+			merged.reserve(this->size());
+			stage.comparisons(_equi_join(arr, left_key, right_key, [&](::std::size_t l, const ::std::size_t *first, const ::std::size_t *last) {
+				merged.emplace_back(merge((*this)[l], group_type(arr.begin(), first, last)));
+			}));
+			stage.calls(this->size() + arr.size() + merged.size());
+			stage.output(merged.size());
+			return merged;
+		}
+
+
+	public:
+		/*** Execution policy overloads ***
+		 * Each operator below can be given linq::seq or linq::par as its first argument. The parallel versions split the list
+		 * into slices which are processed on a thread_pool, and always produce the same elements in the same order as the
+		 * sequential versions. The lambdas given to them must be safe to call concurrently.
+		 */
+
+		/// <summary>Runs the sequential <see cref="where"/>.</summary>
+		template<class _Pr>
+		inline array where(const sequenced_policy&, _Pr &&condition) const { return where(::std::forward<_Pr>(condition)); }
+		/// <summary>
+		/// Performs a conditional for filtering the list in parallel. The condition is tested once per element across the pool,
+		/// after which the kept elements are copied into place by each slice at the offset found from a prefix sum of the
+		/// slices' counts, preserving their order.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="condition">The lambda which determines if an item is to be added to the new list.</param>
+		/// <returns>The new list of filtered items.</returns>
+		template<class _Pr>
+		array where(const parallel_policy &policy, _Pr &&condition) const {
+			array result(this->get_allocator());
+			where(policy, condition, into(result));
+			return result;
+		}
+
+		/// <summary>Runs the sequential <see cref="select"/>.</summary>
+		template<class _Ret = void, class _Fn>
+		inline auto select(const sequenced_policy&, _Fn &&selector) const { return select<_Ret>(::std::forward<_Fn>(selector)); }
+		/// <summary>
+		/// Performs an item selection in parallel, with each slice writing its transformed items straight into the preallocated result.
+		/// Types which cannot be default constructed fall back to the sequential selection.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="selector">Lambda which defines how each item is transformed into the new type.</param>
+		/// <typeparam name="_Ret">(Optional) The new type being created; defaults to the return type of the selector.</typeparam>
+		/// <returns>The new array of transformed items.</returns>
+		template<class _Ret = void, class _Fn>
+		auto select(const parallel_policy &policy, _Fn &&selector) const {
+			typedef ::std::conditional_t<::std::is_void<_Ret>::value, ::std::decay_t<core::invoke_result_t<_Fn&, const _Ty&>>, _Ret> result_type;
+			core::stage_scope stage("select", this->size());
+			stage.calls(this->size());
+			stage.output(this->size());
+			return _select<result_type>(policy, selector, ::std::is_default_constructible<result_type>());
+		}
+
+		/// <summary>Runs the sequential <see cref="orderby"/>.</summary>
+		template<class _Pr>
+		inline array& orderby(const sequenced_policy&, const _Pr &pred) & { return orderby(pred); }
+		/// <summary>Runs the sequential <see cref="orderby"/> on this temporary list.</summary>
+		template<class _Pr>
+		inline array orderby(const sequenced_policy&, const _Pr &pred) && { return ::std::move(*this).orderby(pred); }
+		/// <summary>
+		/// Performs a parallel merge sort on this list. The sort is stable, so the result is identical to that of the
+		/// sequential <see cref="orderby"/>, including the order of items which are equal by the predicate.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <returns>A reference to this list (used for chaining calls).</returns>
+		template<class _Pr>
+		array& orderby(const parallel_policy &policy, _Pr pred) & {
+			core::stage_scope stage("orderby", this->size());
+			core::parallel_stable_sort(this->data(), this->size(), pred, policy.get_pool(), policy.grain);
+			stage.output(this->size());
+			return *this;
+		}
+		/// <summary>
+		/// Performs a parallel merge sort on this temporary list. See <see cref="orderby"/>.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <returns>This list, moved out of the temporary (used for chaining calls).</returns>
+		template<class _Pr>
+		inline array orderby(const parallel_policy &policy, _Pr pred) && {
+			orderby(policy, ::std::move(pred));
+			return ::std::move(*this);
+		}
+
+		/// <summary>Runs the sequential <see cref="top_k"/>.</summary>
+		template<class _Pr>
+		inline array top_k(const sequenced_policy&, ::std::size_t count, _Pr &&pred) const { return top_k(count, ::std::forward<_Pr>(pred)); }
+		/// <summary>
+		/// Finds the first <paramref name="count"/> items of this list by the predicate in parallel. Each slice of the list
+		/// keeps its own bounded heap, and the heaps of the slices are then merged into the result.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="count">Maximum number of items to be kept.</param>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right. Must be safe to call concurrently.</param>
+		/// <returns>New list of the first <paramref name="count"/> items, sorted by the predicate.</returns>
+		template<class _Pr>
+		array top_k(const parallel_policy &policy, ::std::size_t count, _Pr pred) const {
+			thread_pool &pool = policy.get_pool();
+			const ::std::size_t size = this->size(), tasks = pool.partition(size, policy.grain);
+			if (tasks <= 1) {
+				return top_k(count, pred);
+			}
+			core::stage_scope stage("top_k", size);
+			::std::vector<typename core::top_k_heap<_Ty, _Pr>::storage_type> heaps(tasks);
+			pool.parallel_for(tasks, [&](::std::size_t t) {
+				heaps[t] = _top_k(core::slice_begin(size, tasks, t), core::slice_begin(size, tasks, t + 1), count, pred).release();
+			});
+			// Every item keeps its position in this list, so ties are broken exactly as the sequential top_k breaks them
+			core::top_k_heap<_Ty, _Pr> merged(count, pred, size);
+			for (auto &heap : heaps) {
+				for (auto &kept : heap) {
+					merged.push(::std::move(kept.item), kept.position);
+				}
+			}
+			array result = _adopt(merged.sorted());
+			stage.output(result.size());
+			return result;
+		}
+
+		/// <summary>Runs the sequential condition based <see cref="join"/>.</summary>
+		template<class _Ty2 = void, class _Ret = void, class _Cont, class _Merge, class _On>
+		inline auto join(const sequenced_policy&, const _Cont &arr, _Merge &&merge, _On &&on) const {
+			return join<_Ty2, _Ret>(arr, ::std::forward<_Merge>(merge), ::std::forward<_On>(on));
+		}
+		/// <summary>
+		/// Performs the condition based join in parallel, with each slice of this list compared against the whole of the provided list.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="arr">Array to be joined with this one.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <param name="on">Conditional lambda that determines if two elements should be paired.</param>
+		/// <returns>New array of merged items.</returns>
+		template<class _Ty2 = void, class _Ret = void, class _Cont, class _Merge, class _On>
+		auto join(const parallel_policy &policy, const _Cont &arr, _Merge &&merge, _On &&on) const {
+			typedef ::std::conditional_t<::std::is_void<_Ret>::value,
+				::std::decay_t<core::invoke_result_t<_Merge&, const _Ty&, const typename _Cont::value_type&>>, _Ret> result_type;
+			core::stage_scope stage("join", this->size());
+			auto result = _parallel_probe<result_type>(policy, [&](const _Ty &left, ::std::vector<result_type> &out) {
+				for (const auto &right : arr) {
+					if (on(left, right)) {
+						out.emplace_back(merge(left, right));
+					}
+				}
+			});
+			const ::std::size_t pairs = this->size() * core::distance_hint(arr.begin(), arr.end());
+			stage.comparisons(pairs);
+			stage.calls(pairs + result.size());
+			stage.output(result.size());
+			return result;
+		}
+		/// <summary>Runs the sequential condition based <see cref="join"/> into <see cref="linq::core::merge_pair"/>.</summary>
+		template<class _Ty2 = void, class _Cont, class _On>
+		inline auto join(const sequenced_policy&, const _Cont &arr, _On &&on) const {
+			return join<_Ty2>(arr, ::std::forward<_On>(on));
+		}
+		/// <summary>
+		/// Performs the condition based join into <see cref="linq::core::merge_pair"/> in parallel.
+		/// </summary>
+		template<class _Ty2 = void, class _Cont, class _On>
+		inline auto join(const parallel_policy &policy, const _Cont &arr, _On &&on) const {
+			typedef ::std::conditional_t<::std::is_void<_Ty2>::value, typename _Cont::value_type, _Ty2> right_type;
+			return join<right_type, core::merge_pair<_Ty, right_type>>(policy, arr,
+				[](const _Ty &left, const right_type &right)->core::merge_pair<_Ty, right_type> { return { left, right }; }, ::std::forward<_On>(on));
+		}
+		/// <summary>Runs the sequential key based <see cref="join"/>.</summary>
+		template<class _Ty2 = void, class _Cont, class _LKey, class _RKey, class _Merge>
+		inline auto join(const sequenced_policy&, const _Cont &arr, _LKey &&left_key, _RKey &&right_key, _Merge &&merge) const {
+			return join<_Ty2>(arr, ::std::forward<_LKey>(left_key), ::std::forward<_RKey>(right_key), ::std::forward<_Merge>(merge));
+		}
+		/// <summary>
+		/// Performs the key based equi-join in parallel. The provided list is hashed once, then slices of this list probe the table
+		/// concurrently, each into its own buffer, and the buffers are concatenated in order.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="arr">Random access list to be joined with this one.</param>
+		/// <param name="left_key">Lambda which selects the key of an element of this list.</param>
+		/// <param name="right_key">Lambda which selects the key of an element of the provided list.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <returns>New array of merged items.</returns>
+		template<class _Ty2 = void, class _Cont, class _LKey, class _RKey, class _Merge>
+		auto join(const parallel_policy &policy, const _Cont &arr, _LKey &&left_key, _RKey &&right_key, _Merge &&merge) const {
+			typedef typename _Cont::value_type right_type;
+			typedef ::std::decay_t<core::invoke_result_t<_Merge&, const _Ty&, const right_type&>> result_type;
+			typedef core::join_key_t<_LKey, _RKey, _Ty, right_type> key_type;
+			core::stage_scope stage("join", this->size());
+			core::hash_index<key_type> table;
+			table.build(arr.begin(), arr.size(), right_key);
+			auto result = _parallel_probe<result_type>(policy, [&](const _Ty &left, ::std::vector<result_type> &out) {
+				table.for_each(left_key(left), [&](::std::size_t r) { out.emplace_back(merge(left, arr[r])); });
+			});
+			stage.comparisons(this->size());
+			stage.calls(this->size() + arr.size() + result.size());
+			stage.output(result.size());
+			return result;
+		}
+
+
+		/// <summary>Runs the sequential <see cref="sum"/>.</summary>
+		inline _Ty sum(const sequenced_policy&) const { return sum(); }
+		/// <summary>Runs the sequential <see cref="sum"/>.</summary>
+		template<class _Fn>
+		inline auto sum(const sequenced_policy&, _Fn &&selector) const { return sum(::std::forward<_Fn>(selector)); }
+		/// <summary>
+		/// Sums the items of the array in parallel. Floating point sums are split into the same blocks as the sequential
+		/// <see cref="sum"/>, whose sums are then added in the same order, so the result is identical to the sequential sum
+		/// whatever the size of the pool.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		inline _Ty sum(const parallel_policy &policy) const {
+			return _parallel_sum<_Ty>(policy, [this](::std::size_t first, ::std::size_t last) {
+				return _sum(first, last, core::simd::is_vector_element<_Ty>());
+			});
+		}
+		/// <summary>
+		/// Sums a value selected from each item of the array in parallel, giving the same result as the sequential <see cref="sum"/>.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="selector">Lambda which selects the value to be summed from each item.</param>
+		template<class _Fn>
+		auto sum(const parallel_policy &policy, _Fn &&selector) const {
+			typedef ::std::decay_t<core::invoke_result_t<_Fn&, const _Ty&>> result_type;
+			return _parallel_sum<result_type>(policy, [&](::std::size_t first, ::std::size_t last) {
+				core::summation<result_type> total;
+				for (::std::size_t c = first; c < last; c++) {
+					total.add(selector((*this)[c]));
+				}
+				return total.result();
+			});
+		}
+
+		/// <summary>Runs the sequential <see cref="min"/>.</summary>
+		inline _Ty min(const sequenced_policy&) const { return min(); }
+		/// <summary>Finds the smallest item of the array in parallel. See <see cref="min"/>.</summary>
+		inline _Ty min(const parallel_policy &policy) const { return minmax(policy).first; }
+		/// <summary>Runs the sequential <see cref="max"/>.</summary>
+		inline _Ty max(const sequenced_policy&) const { return max(); }
+		/// <summary>Finds the largest item of the array in parallel. See <see cref="max"/>.</summary>
+		inline _Ty max(const parallel_policy &policy) const { return minmax(policy).second; }
+		/// <summary>Runs the sequential <see cref="minmax"/>.</summary>
+		inline ::std::pair<_Ty, _Ty> minmax(const sequenced_policy&) const { return minmax(); }
+		/// <summary>
+		/// Finds both the smallest and largest items of the array in parallel, with each slice finding its own before they are combined in order.
+		/// Throws <see cref="std::logic_error"/> if the array is empty.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <exception cref="std::logic_error">Thrown if the array is empty.</exception>
+		::std::pair<_Ty, _Ty> minmax(const parallel_policy &policy) const {
+			if (this->empty()) {
+				core::throw_empty();
+			}
+			typedef ::std::pair<_Ty, _Ty> result_type;
+			return _parallel_reduce<result_type>(policy, [this](::std::size_t first, ::std::size_t last) {
+				return _extrema(first, last, core::simd::is_vector_element<_Ty>());
+			}, [](result_type &found, result_type &&slice) {
+				if (core::is_nan(found.first)) return;
+				if (core::is_nan(slice.first)) found = ::std::move(slice);
+				else {
+					if (slice.first < found.first) found.first = ::std::move(slice.first);
+					if (found.second < slice.second) found.second = ::std::move(slice.second);
+				}
+			});
+		}
+
+		/// <summary>Runs the sequential <see cref="average"/>.</summary>
+		inline core::average_t<_Ty> average(const sequenced_policy&) const { return average(); }
+		/// <summary>
+		/// Averages the items of the array in parallel. Integers are summed as 64-bit integers and averaged as a double.
+		/// Throws <see cref="std::logic_error"/> if the array is empty.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <exception cref="std::logic_error">Thrown if the array is empty.</exception>
+		core::average_t<_Ty> average(const parallel_policy &policy) const {
+			if (this->empty()) {
+				core::throw_empty();
+			}
+			return static_cast<core::average_t<_Ty>>(_parallel_average(policy, ::std::is_same<core::average_sum_t<_Ty>, _Ty>())) / static_cast<core::average_t<_Ty>>(this->size());
+		}
+
+		/// <summary>Runs the sequential <see cref="count"/>.</summary>
+		template<class _Pr>
+		inline ::std::size_t count(const sequenced_policy&, _Pr &&condition) const { return count(::std::forward<_Pr>(condition)); }
+		/// <summary>
+		/// Counts the items which satisfy the provided condition in parallel.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="condition">Condition to be satisfied.</param>
+		template<class _Pr>
+		::std::size_t count(const parallel_policy &policy, _Pr &&condition) const {
+			return _parallel_reduce<::std::size_t>(policy, [&](::std::size_t first, ::std::size_t last) {
+				return _count(first, last, condition, core::is_vector_filter<_Ty, ::std::decay_t<_Pr>>());
+			}, [](::std::size_t &total, ::std::size_t slice) { total += slice; });
+		}
+
+		/// <summary>Runs the sequential <see cref="aggregate"/>, which needs no combining lambda.</summary>
+		template<class _Acc, class _Fn, class _Combine>
+		inline _Acc aggregate(const sequenced_policy&, _Acc seed, _Fn &&fn, _Combine&&) const { return aggregate(::std::move(seed), ::std::forward<_Fn>(fn)); }
+		/// <summary>
+		/// Folds the items in parallel. Each slice of the array is folded from its own copy of the <paramref name="seed"/>, and the
+		/// results of the slices are then combined in order from the first slice to the last. The <paramref name="seed"/> must
+		/// therefore leave any value unchanged when combined with it, and combining must be associative.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="seed">The initial accumulated value of every slice.</param>
+		/// <param name="fn">Lambda of the form <c>_Acc(_Acc accumulated, const _Ty &amp;item)</c> returning the next accumulated value.</param>
+		/// <param name="combine">Lambda of the form <c>_Acc(_Acc left, _Acc right)</c> combining the results of two neighbouring slices.</param>
+		/// <returns>The final accumulated value; the <paramref name="seed"/> if the array is empty.</returns>
+		template<class _Acc, class _Fn, class _Combine>
+		_Acc aggregate(const parallel_policy &policy, _Acc seed, _Fn &&fn, _Combine &&combine) const {
+			if (this->empty()) {
+				return seed;
+			}
+			return _parallel_reduce<_Acc>(policy, [&](::std::size_t first, ::std::size_t last) {
+				_Acc total = seed;
+				for (::std::size_t c = first; c < last; c++) {
+					total = fn(::std::move(total), (*this)[c]);
+				}
+				return total;
+			}, [&](_Acc &total, _Acc &&slice) { total = combine(::std::move(total), ::std::move(slice)); });
+		}
+
+		/// <summary>Runs the sequential <see cref="distinct"/>.</summary>
+		template<class _Fn = core::identity>
+		inline array distinct(const sequenced_policy&, _Fn &&key_selector = _Fn()) const { return _set<core::set_operation::distinct>(*this, key_selector, "distinct"); }
+		/// <summary>
+		/// Removes the items whose key equals that of an item before them, in parallel. Both lists of a set operation are split
+		/// into hash partitions of their keys, each partition runs the sequential operation with a table of its own, and the
+		/// items kept are collected in order, so the result is identical to the sequential one. Small lists run sequentially.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="key_selector">(Optional) Lambda which selects the key of each item.</param>
+		template<class _Fn = core::identity>
+		inline array distinct(const parallel_policy &policy, _Fn &&key_selector = _Fn()) const { return _parallel_set<core::set_operation::distinct>(policy, *this, key_selector, "distinct"); }
+		/// <summary>Runs the sequential <see cref="union_with"/>.</summary>
+		template<class _Cont, class _Fn = core::identity>
+		inline array union_with(const sequenced_policy&, const _Cont &other, _Fn &&key_selector = _Fn()) const { return _set<core::set_operation::union_with>(other, key_selector, "union_with"); }
+		/// <summary>Runs <see cref="union_with"/> over hash partitions in parallel. See <see cref="distinct"/>.</summary>
+		template<class _Cont, class _Fn = core::identity>
+		inline array union_with(const parallel_policy &policy, const _Cont &other, _Fn &&key_selector = _Fn()) const { return _parallel_set<core::set_operation::union_with>(policy, other, key_selector, "union_with"); }
+		/// <summary>Runs the sequential <see cref="intersect"/>.</summary>
+		template<class _Cont, class _Fn = core::identity>
+		inline array intersect(const sequenced_policy&, const _Cont &other, _Fn &&key_selector = _Fn()) const { return _set<core::set_operation::intersect>(other, key_selector, "intersect"); }
+		/// <summary>Runs <see cref="intersect"/> over hash partitions in parallel. See <see cref="distinct"/>.</summary>
+		template<class _Cont, class _Fn = core::identity>
+		inline array intersect(const parallel_policy &policy, const _Cont &other, _Fn &&key_selector = _Fn()) const { return _parallel_set<core::set_operation::intersect>(policy, other, key_selector, "intersect"); }
+		/// <summary>Runs the sequential <see cref="except"/>.</summary>
+		template<class _Cont, class _Fn = core::identity>
+		inline array except(const sequenced_policy&, const _Cont &other, _Fn &&key_selector = _Fn()) const { return _set<core::set_operation::except>(other, key_selector, "except"); }
+		/// <summary>Runs <see cref="except"/> over hash partitions in parallel. See <see cref="distinct"/>.</summary>
+		template<class _Cont, class _Fn = core::identity>
+		inline array except(const parallel_policy &policy, const _Cont &other, _Fn &&key_selector = _Fn()) const { return _parallel_set<core::set_operation::except>(policy, other, key_selector, "except"); }
+
+	public:
+		/*** Output overloads ***
+
+		 * The operators below take a destination created by linq::into as their last argument, and write their results into
+		 * a container or through an iterator owned by the caller instead of returning a new array. Refilling the same
+		 * container keeps its storage, and any temporaries are kept in the query_context given to linq::into, so a query
+		 * run over and over stops allocating once it has warmed up. Items are constructed in place with emplace_back, so
+		 * they need not be default constructible.
+		 */
+
+		/// <summary>Filters the list into the provided output. See <see cref="where"/>.</summary>
+		/// <param name="condition">The lambda which determines if an item is to be written.</param>
+		/// <param name="out">Destination created by <see cref="linq::into"/>.</param>
+		/// <returns>The filled container, or the iterator past the last item written.</returns>
+		template<class _Pr, class _Out, class = ::std::enable_if_t<core::is_output<_Out>::value>>
+		inline typename _Out::result_type where(_Pr &&condition, _Out out) const {
+			core::stage_scope stage("where", this->size());
+			stage.calls(this->size());
+			typename _Out::result_type result = _where_into(condition, out, core::is_vector_filter<_Ty, ::std::decay_t<_Pr>>(),
+				::std::integral_constant<bool, ::std::is_arithmetic<_Ty>::value && core::is_container_output_of<_Out, _Ty>::value>());
+			stage.written(out);
+			return result;
+		}
+		/// <summary>
+		/// Filters the list in parallel into the provided output. The flags and offsets of the slices are kept in the
+		/// <see cref="query_context"/> of the output. See the parallel <see cref="where"/>.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="condition">The lambda which determines if an item is to be written.</param>
+		/// <param name="out">Destination created by <see cref="linq::into"/>.</param>
+		/// <returns>The filled container, or the iterator past the last item written.</returns>
+		template<class _Pr, class _Out, class = ::std::enable_if_t<core::is_output<_Out>::value>>
+		typename _Out::result_type where(const parallel_policy &policy, _Pr &&condition, _Out out) const {
+			thread_pool &pool = policy.get_pool();
+			const ::std::size_t count = this->size(), tasks = pool.partition(count, policy.grain);
+			if (tasks <= 1) {
+				return where(condition, out);
+			}
+			core::stage_scope stage("where", count);
+			stage.calls(count);
+			core::scratch<::std::vector<unsigned char>> keep(out.context());
+			core::scratch<::std::vector<::std::size_t>> offsets(out.context());
+			keep->resize(count);
+			offsets->assign(tasks + 1, 0);
+			pool.parallel_for(tasks, [&](::std::size_t t) {
+				::std::size_t kept = 0;
+				for (::std::size_t c = core::slice_begin(count, tasks, t), l = core::slice_begin(count, tasks, t + 1); c < l; c++) {
+					kept += (*keep)[c] = condition((*this)[c]) ? 1 : 0;
+				}
+				(*offsets)[t + 1] = kept;
+			});
+			for (::std::size_t t = 0; t < tasks; t++) {
+				(*offsets)[t + 1] += (*offsets)[t];
+			}
+			stage.output((*offsets)[tasks]);
+			return _compact(*keep, *offsets, pool, out, core::is_resizable_output<_Out>());
+		}
+
+		/// <summary>Transforms the items of the list into the provided output. See <see cref="select"/>.</summary>
+		/// <param name="selector">Lambda which defines how each item is transformed.</param>
+		/// <param name="out">Destination created by <see cref="linq::into"/>.</param>
+		/// <returns>The filled container, or the iterator past the last item written.</returns>
+		template<class _Fn, class _Out, class = ::std::enable_if_t<core::is_output<_Out>::value>>
+		typename _Out::result_type select(_Fn &&selector, _Out out) const {
+			core::stage_scope stage("select", this->size());
+			stage.calls(this->size());
+			stage.output(this->size());
+			out.start(this->size());
+			for (const _Ty &item : *this) {
+				out.emplace(selector(item));
+			}
+			return out.finish();
+		}
+		/// <summary>
+		/// Transforms the items of the list in parallel into the provided output. Containers of default constructible items
+		/// are resized and written to by every slice at once; anything else is written in order on the calling thread.
+		/// </summary>
+		/// <param name="policy">The parallel execution policy.</param>
+		/// <param name="selector">Lambda which defines how each item is transformed.</param>
+		/// <param name="out">Destination created by <see cref="linq::into"/>.</param>
+		/// <returns>The filled container, or the iterator past the last item written.</returns>
+		template<class _Fn, class _Out, class = ::std::enable_if_t<core::is_output<_Out>::value>>
+		inline typename _Out::result_type select(const parallel_policy &policy, _Fn &&selector, _Out out) const {
+			core::stage_scope stage("select", this->size());
+			stage.calls(this->size());
+			stage.output(this->size());
+			return _select_into(policy, selector, out, core::is_resizable_output<_Out>());
+		}
+
+		/// <summary>Joins the list with the provided list on equal keys into the provided output. See the key based <see cref="join"/>.</summary>
+		/// <param name="arr">Random access list to be joined with this one.</param>
+		/// <param name="left_key">Lambda which selects the key of an element of this list.</param>
+		/// <param name="right_key">Lambda which selects the key of an element of the provided list.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <param name="out">Destination created by <see cref="linq::into"/>. The keys and hash table are kept in its <see cref="query_context"/>.</param>
+		/// <returns>The filled container, or the iterator past the last item written.</returns>
+		template<class _Cont, class _LKey, class _RKey, class _Merge, class _Out, class = ::std::enable_if_t<core::is_output<_Out>::value>>
+		typename _Out::result_type join(const _Cont &arr, _LKey &&left_key, _RKey &&right_key, _Merge &&merge, _Out out) const {
+			core::stage_scope stage("join", this->size());
+			::std::size_t merged = 0;
+			out.start(0);
+			stage.comparisons(_equi_join(arr, left_key, right_key, [&](::std::size_t l, const ::std::size_t *first, const ::std::size_t *last) {
+				merged += last - first;
+				for (; first != last; ++first) {
+					out.emplace(merge((*this)[l], arr[*first]));
+				}
+			}, out.context()));
+			stage.calls(this->size() + arr.size() + merged);
+			stage.output(merged);
+			return out.finish();
+		}
+		/// <summary>Joins the list with the provided list on a condition into the provided output. See <see cref="join"/>.</summary>
+		/// <param name="arr">List to be joined with this one.</param>
+		/// <param name="merge">Lambda that performs the merge.</param>
+		/// <param name="on">Conditional lambda that determines if two elements should be paired.</param>
+		/// <param name="out">Destination created by <see cref="linq::into"/>.</param>
+		/// <returns>The filled container, or the iterator past the last item written.</returns>
+		template<class _Cont, class _Merge, class _On, class _Out, class = ::std::enable_if_t<core::is_output<_Out>::value>>
+		typename _Out::result_type join(const _Cont &arr, _Merge &&merge, _On &&on, _Out out) const {
+			core::stage_scope stage("join", this->size());
+			::std::size_t merged = 0;
+			out.start(0);
+			for (const _Ty &left : *this) {
+				for (const auto &right : arr) {
+					if (on(left, right)) {
+						out.emplace(merge(left, right));
+						merged++;
+					}
+				}
+			}
+			const ::std::size_t pairs = this->size() * core::distance_hint(arr.begin(), arr.end());
+			stage.comparisons(pairs);
+			stage.calls(pairs + merged);
+			stage.output(merged);
+			return out.finish();
+		}
+
+		/// <summary>
+		/// Writes the items of the list sorted by the predicate into the provided output, leaving the list as it is. A container
+		/// is filled and then sorted in place; an iterator is written to in the order found by sorting the positions of the
+		/// items, which are kept in the <see cref="query_context"/> of the output.
+		/// </summary>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <param name="out">Destination created by <see cref="linq::into"/>.</param>
+		/// <returns>The filled container, or the iterator past the last item written.</returns>
+		template<class _Pr, class _Out, class = ::std::enable_if_t<core::is_output<_Out>::value && !core::is_key_order<_Pr>::value>>
+		inline typename _Out::result_type orderby(const _Pr &pred, _Out out) const {
+			core::stage_scope stage("orderby", this->size());
+			stage.output(this->size());
+			return _orderby_into(stage.counted(pred), out, core::is_container_output_of<_Out, _Ty>());
+		}
+		/// <summary>
+		/// Writes the items of the list, sorted on the keys selected from each item, into the output given after the keys,
+		/// as in <c>orderby(linq::descending(by_score), linq::ascending(by_name), linq::into(buffer, context))</c>, leaving
+		/// the list as it is. The packed or cached keys are kept in the <see cref="query_context"/> of the output. See the
+		/// key <see cref="orderby"/>.
+		/// </summary>
+		/// <param name="order">The most significant key.</param>
+		/// <param name="rest">Less significant keys, in order of significance, then the destination created by <see cref="linq::into"/>.</param>
+		/// <returns>The filled container, or the iterator past the last item written.</returns>
+		template<class _Fn, bool _Descending, class... _Rest, class = ::std::enable_if_t<core::is_last_output<_Rest...>::value>>
+		inline typename core::last_of<_Rest...>::type::result_type orderby(const core::key_order<_Fn, _Descending> &order, const _Rest &...rest) const & {
+			return _orderby_keys_into(::std::forward_as_tuple(order, rest...), ::std::make_index_sequence<sizeof...(_Rest)>());
+		}
+		/// <summary>
+		/// Writes the first <paramref name="count"/> items of the list by the predicate, in order, into the provided output.
+		/// The items are selected in storage kept in the <see cref="query_context"/> of the output. See <see cref="top_k"/>.
+		/// </summary>
+		/// <param name="count">Maximum number of items to be written.</param>
+		/// <param name="pred">Predicate used to determine if the left element should go before the right.</param>
+		/// <param name="out">Destination created by <see cref="linq::into"/>.</param>
+		/// <returns>The filled container, or the iterator past the last item written.</returns>
+		template<class _Pr, class _Out, class = ::std::enable_if_t<core::is_output<_Out>::value>>
+		typename _Out::result_type top_k(::std::size_t count, _Pr &&pred, _Out out) const {
+			core::stage_scope stage("top_k", this->size());
+			auto &&counted = stage.counted(pred);
+			if (count <= this->size() / 8) {
+				core::scratch<typename core::top_k_heap<_Ty, ::std::remove_reference_t<decltype(counted)>>::storage_type> storage(out.context());
+				auto heap = _top_k(0, this->size(), count, counted, ::std::move(*storage));
+				auto &kept = heap.sort();
+				stage.output(kept.size());
+				out.start(kept.size());
+				for (auto &entry : kept) {
+					out.emplace(::std::move(entry.item));
+				}
+				*storage = heap.release();
+				storage->clear();
+			}
+			else {
+				core::scratch<::std::vector<::std::size_t>> positions(out.context());
+				_top_k_positions(count, counted, *positions);
+				stage.output(positions->size());
+				out.start(positions->size());
+				for (::std::size_t position : *positions) {
+					out.emplace((*this)[position]);
+				}
+			}
+			return out.finish();
+		}
+		/// <summary>Writes the first <paramref name="count"/> items of the list into the provided output.</summary>
+		/// <param name="count">Maximum number of items to be written.</param>
+		/// <param name="out">Destination created by <see cref="linq::into"/>.</param>
+		/// <returns>The filled container, or the iterator past the last item written.</returns>
+		template<class _Out, class = ::std::enable_if_t<core::is_output<_Out>::value>>
+		inline typename _Out::result_type take(::std::size_t count, _Out out) const {
+			core::stage_scope stage("take", this->size());
+			stage.output(::std::min(count, this->size()));
+			return _copy_into(this->begin(), this->begin() + ::std::min(count, this->size()), out);
+		}
+		/// <summary>Writes the items of the list after the first <paramref name="count"/> into the provided output.</summary>
+		/// <param name="count">Number of items to be skipped.</param>
+		/// <param name="out">Destination created by <see cref="linq::into"/>.</param>
+		/// <returns>The filled container, or the iterator past the last item written.</returns>
+		template<class _Out, class = ::std::enable_if_t<core::is_output<_Out>::value>>
+		inline typename _Out::result_type skip(::std::size_t count, _Out out) const {
+			core::stage_scope stage("skip", this->size());
+			stage.output(this->size() - ::std::min(count, this->size()));
+			return _copy_into(this->begin() + ::std::min(count, this->size()), this->end(), out);
+		}
+
+
+		/*** Searching ***
+		 * The searches below never throw to report a miss: they return a null pointer, false or linq::npos instead, and stop
+		 * at the first item which decides their result. The pointers point into the array, so nothing is copied, and stay
+		 * valid until the array is changed. first, last and their _or_default forms are written on top of them.
+		 */
+
+		/// <summary>Searches the array for the first item which satisfies the provided condition.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>Pointer to the first item which satisfies the condition; otherwise null.</returns>
+		template<class _Pr>
+		inline const _Ty* find_first(_Pr &&condition) const { return _find_first(this->data(), condition); }
+		/// <summary>Searches the array for the first item which satisfies the provided condition.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>Pointer to the first item which satisfies the condition; otherwise null.</returns>
+		template<class _Pr>
+		inline _Ty* find_first(_Pr &&condition) { return _find_first(this->data(), condition); }
+		/// <summary>Searches the array backwards for the last item which satisfies the provided condition.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>Pointer to the last item which satisfies the condition; otherwise null.</returns>
+		template<class _Pr>
+		inline const _Ty* find_last(_Pr &&condition) const { return _find_last(this->data(), condition); }
+		/// <summary>Searches the array backwards for the last item which satisfies the provided condition.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>Pointer to the last item which satisfies the condition; otherwise null.</returns>
+		template<class _Pr>
+		inline _Ty* find_last(_Pr &&condition) { return _find_last(this->data(), condition); }
+		/// <summary>Searches the array for the only item which satisfies the provided condition, stopping at the second one found.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>Pointer to the item if exactly one satisfies the condition; otherwise, when none or several do, null.</returns>
+		template<class _Pr>
+		const _Ty* single(_Pr &&condition) const {
+			const _Ty *found = _find_first(this->data(), condition);
+			if (!found) return nullptr;
+			const _Ty *end = this->data() + this->size();
+			for (const _Ty *it = found + 1; it != end; ++it) {
+				if (condition(*it)) {
+					return nullptr;
+				}
+			}
+			return found;
+		}
+		/// <summary>Finds the item at the provided position, without throwing when it is out of range.</summary>
+		/// <param name="index">Zero based position of the item.</param>
+		/// <returns>Pointer to the item at the position; otherwise, when the array is shorter, null.</returns>
+		inline const _Ty* element_at(::std::size_t index) const { return index < this->size() ? this->data() + index : nullptr; }
+		/// <summary>Searches the array for the first item which satisfies the provided condition.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>Zero based position of the first item which satisfies the condition; otherwise <see cref="linq::npos"/>.</returns>
+		template<class _Pr>
+		inline ::std::size_t index_of(_Pr &&condition) const {
+			const _Ty *found = _find_first(this->data(), condition);
+			return found ? static_cast<::std::size_t>(found - this->data()) : npos;
+		}
+		/// <summary>Checks whether any item equals the provided value, stopping at the first which does.</summary>
+		inline bool contains(const _Ty &value) const { return ::std::find(this->begin(), this->end(), value) != this->end(); }
+
+		/// <summary>
+		/// Searches the array for the first item which satisfies the provided condition.
+		/// Throws <see cref="std::logic_error"/> if the condition is never satisfied.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <exception cref="std::logic_error">Thrown if no items satisfy the condition.</exception>
+		/// <returns>The first item found which satisfies the condition; otherwise an error is thrown.</returns>
+		template<class _Pr>
+		_Ty first(_Pr &&condition) const {
+			const _Ty *found = find_first(condition);
+			if (!found) {
+				core::throw_no_match();
+			}
+			return *found;
+		}
+
+		/// <summary>
+		/// Searches the array for the first item which satisfies the provided condition.
+		/// Returns the provided <paramref name="defaultValue"/> if the condition is never satisfied.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <param name="defaultValue">Default value to be returned if no items satisfy the condition.</param>
+		/// <returns>The first item found which satisfies the condition; otherwise the provided <paramref name="defaultValue"/>.</returns>
+		template<class _Pr>
+		inline _Ty first_or_default(const _Ty &defaultValue, _Pr &&condition) const {
+			const _Ty *found = find_first(condition);
+			return found ? *found : defaultValue;
+		}
+
+		/// <summary>
+		/// Searches the array for the last item which satisfies the provided condition.
+		/// Throws <see cref="std::logic_error"/> if the condition is never satisfied.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <exception cref="std::logic_error">Thrown if no items satisfy the condition.</exception>
+		/// <returns>The last item found which satisfies the condition; otherwise an error is thrown.</returns>
+		template<class _Pr>
+		_Ty last(_Pr &&condition) const {
+			const _Ty *found = find_last(condition);
+			if (!found) {
+				core::throw_no_match();
+			}
+			return *found;
+		}
+		/// <summary>
+		/// Searches the array for the last item which satisfies the provided condition.
+		/// Returns the provided <paramref name="defaultValue"/> if the condition is never satisfied.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <param name="defaultValue">Default value to be returned if no items satisfy the condition.</param>
+		/// <returns>The last item found which satisfies the condition; otherwise the provided <paramref name="defaultValue"/>.</returns>
+		template<class _Pr>
+		inline _Ty last_or_default(const _Ty &defaultValue, _Pr &&condition) const {
+			const _Ty *found = find_last(condition);
+			return found ? *found : defaultValue;
+		}
+
+		/// <summary>
+		/// Sums the items of the array. Arrays of int, float and double are summed with vector instructions, and floating point
+		/// items are always summed pairwise in the same order, see <see cref="core::pairwise_sum"/>.
+		/// </summary>
+		/// <returns>The sum of the items; a default constructed value if there are none.</returns>
+		inline _Ty sum() const { return _sum(core::simd::is_vector_element<_Ty>()); }
+		/// <summary>
+		/// Sums a value selected from each item of the array, without creating an array of the selected values.
+		/// </summary>
+		/// <param name="selector">Lambda which selects the value to be summed from each item.</param>
+		/// <returns>The sum of the selected values; a default constructed value if there are none.</returns>
+		template<class _Fn, class = ::std::enable_if_t<!is_execution_policy<_Fn>::value>>
+		inline auto sum(_Fn &&selector) const { return lazy().sum(::std::forward<_Fn>(selector)); }
+
+		/// <summary>
+		/// Finds the smallest item of the array. A floating point NaN is returned if any item is NaN.
+		/// Throws <see cref="std::logic_error"/> if the array is empty.
+		/// </summary>
+		/// <exception cref="std::logic_error">Thrown if the array is empty.</exception>
+		inline _Ty min() const { return _min(core::simd::is_vector_element<_Ty>()); }
+		/// <summary>
+		/// Finds the smallest value selected from the items of the array. A floating point NaN is returned if any value is NaN.
+		/// Throws <see cref="std::logic_error"/> if the array is empty.
+		/// </summary>
+		/// <param name="selector">Lambda which selects the value to be compared from each item.</param>
+		/// <exception cref="std::logic_error">Thrown if the array is empty.</exception>
+		template<class _Fn, class = ::std::enable_if_t<!is_execution_policy<_Fn>::value>>
+		inline auto min(_Fn &&selector) const { return lazy().min(::std::forward<_Fn>(selector)); }
+		/// <summary>
+		/// Finds the largest item of the array. A floating point NaN is returned if any item is NaN.
+		/// Throws <see cref="std::logic_error"/> if the array is empty.
+		/// </summary>
+		/// <exception cref="std::logic_error">Thrown if the array is empty.</exception>
+		inline _Ty max() const { return _max(core::simd::is_vector_element<_Ty>()); }
+		/// <summary>
+		/// Finds the largest value selected from the items of the array. A floating point NaN is returned if any value is NaN.
+		/// Throws <see cref="std::logic_error"/> if the array is empty.
+		/// </summary>
+		/// <param name="selector">Lambda which selects the value to be compared from each item.</param>
+		/// <exception cref="std::logic_error">Thrown if the array is empty.</exception>
+		template<class _Fn, class = ::std::enable_if_t<!is_execution_policy<_Fn>::value>>
+		inline auto max(_Fn &&selector) const { return lazy().max(::std::forward<_Fn>(selector)); }
+		/// <summary>
+		/// Finds both the smallest and largest items of the array in a single pass.
+		/// Throws <see cref="std::logic_error"/> if the array is empty.
+		/// </summary>
+		/// <exception cref="std::logic_error">Thrown if the array is empty.</exception>
+		/// <returns>Pair of the smallest (first) and the largest (second) items.</returns>
+		inline ::std::pair<_Ty, _Ty> minmax() const {
+			if (this->empty()) {
+				core::throw_empty();
+			}
+			return _extrema(0, this->size(), core::simd::is_vector_element<_Ty>());
+		}
+		/// <summary>
+		/// Finds both the smallest and largest values selected from the items of the array in a single pass.
+		/// Throws <see cref="std::logic_error"/> if the array is empty.
+		/// </summary>
+		/// <param name="selector">Lambda which selects the value to be compared from each item.</param>
+		/// <exception cref="std::logic_error">Thrown if the array is empty.</exception>
+		/// <returns>Pair of the smallest (first) and the largest (second) values.</returns>
+		template<class _Fn, class = ::std::enable_if_t<!is_execution_policy<_Fn>::value>>
+		inline auto minmax(_Fn &&selector) const { return lazy().minmax(::std::forward<_Fn>(selector)); }
+
+		/// <summary>
+		/// Averages the items of the array. Integers are summed as 64-bit integers and averaged as a double.
+		/// Throws <see cref="std::logic_error"/> if the array is empty.
+		/// </summary>
+		/// <exception cref="std::logic_error">Thrown if the array is empty.</exception>
+		inline core::average_t<_Ty> average() const {
+			return _average(::std::integral_constant<bool, core::simd::is_vector_element<_Ty>::value && ::std::is_floating_point<_Ty>::value>());
+		}
+		/// <summary>
+		/// Averages a value selected from each item of the array. Integers are summed as 64-bit integers and averaged as a double.
+		/// Throws <see cref="std::logic_error"/> if the array is empty.
+		/// </summary>
+		/// <param name="selector">Lambda which selects the value to be averaged from each item.</param>
+		/// <exception cref="std::logic_error">Thrown if the array is empty.</exception>
+		template<class _Fn, class = ::std::enable_if_t<!is_execution_policy<_Fn>::value>>
+		inline auto average(_Fn &&selector) const { return lazy().average(::std::forward<_Fn>(selector)); }
+
+		/// <summary>
+		/// Counts the items which satisfy the provided condition. Structured conditions built with <see cref="linq::item"/>
+		/// are counted with vector instructions on arrays of int, float and double.
+		/// </summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		template<class _Pr>
+		inline ::std::size_t count(_Pr &&condition) const {
+			return _count(0, this->size(), condition, core::is_vector_filter<_Ty, ::std::decay_t<_Pr>>());
+		}
+		/// <summary>Checks whether the array has any items.</summary>
+		inline bool any() const { return !this->empty(); }
+		/// <summary>Checks whether any item satisfies the provided condition, stopping at the first which does.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		template<class _Pr>
+		inline bool any(_Pr &&condition) const { return lazy().any(::std::forward<_Pr>(condition)); }
+		/// <summary>Checks whether every item satisfies the provided condition, stopping at the first which does not.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		/// <returns>True if every item satisfies the condition, or the array is empty; otherwise false.</returns>
+		template<class _Pr>
+		inline bool all(_Pr &&condition) const { return lazy().all(::std::forward<_Pr>(condition)); }
+		/// <summary>Checks whether the array has no items.</summary>
+		inline bool none() const { return this->empty(); }
+		/// <summary>Checks whether no item satisfies the provided condition, stopping at the first which does.</summary>
+		/// <param name="condition">Condition to be satisfied.</param>
+		template<class _Pr>
+		inline bool none(_Pr &&condition) const { return _find_first(this->data(), condition) == nullptr; }
+
+
+		/// <summary>
+		/// Folds each item into an accumulated value from the first item to the last.
+		/// </summary>
+		/// <param name="seed">The initial accumulated value.</param>
+		/// <param name="fn">Lambda of the form <c>_Acc(_Acc accumulated, const _Ty &amp;item)</c> returning the next accumulated value.</param>
+		/// <returns>The final accumulated value; the <paramref name="seed"/> if the array is empty.</returns>
+		template<class _Acc, class _Fn>
+		inline _Acc aggregate(_Acc seed, _Fn &&fn) const { return lazy().aggregate(::std::move(seed), ::std::forward<_Fn>(fn)); }
+
+		/// <summary>
+		/// Groups the items by the key selected from each of them. The groups are found with an open addressing hash table
+		/// and their items are copied into one contiguous array, group after group; see <see cref="grouping"/>.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <typeparam name="_Key">(Optional) The key type; defaults to the return type of the key selector.</typeparam>
+		/// <returns>The groups, in the order their keys were first found.</returns>
+		template<class _Key = void, class _Fn>
+		inline grouping<core::group_key_t<_Key, _Fn, const _Ty&>, _Ty> groupby(_Fn &&key_selector) const & {
+			return _groupby<core::group_key_t<_Key, _Fn, const _Ty&>>(*this, key_selector, static_cast<core::less<>*>(nullptr));
+		}
+		/// <summary>
+		/// Groups the items of this temporary array by the key selected from each of them, moving the items into the groups.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <typeparam name="_Key">(Optional) The key type; defaults to the return type of the key selector.</typeparam>
+		/// <returns>The groups, in the order their keys were first found.</returns>
+		template<class _Key = void, class _Fn>
+		inline grouping<core::group_key_t<_Key, _Fn, const _Ty&>, _Ty> groupby(_Fn &&key_selector) && {
+			return _groupby<core::group_key_t<_Key, _Fn, const _Ty&>>(*this, key_selector, static_cast<core::less<>*>(nullptr));
+		}
+		/// <summary>
+		/// Groups the items by the key selected from each of them, sorting the groups by their keys.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <param name="order">Predicate the keys are sorted by, such as <see cref="linq::ascending"/>.</param>
+		/// <typeparam name="_Key">(Optional) The key type; defaults to the return type of the key selector.</typeparam>
+		template<class _Key = void, class _Fn, class _Pr, class = ::std::enable_if_t<!core::is_summarizer<::std::decay_t<_Pr>>::value>>
+		inline grouping<core::group_key_t<_Key, _Fn, const _Ty&>, _Ty> groupby(_Fn &&key_selector, _Pr &&order) const & {
+			return _groupby<core::group_key_t<_Key, _Fn, const _Ty&>>(*this, key_selector, &order);
+		}
+		/// <summary>
+		/// Groups the items of this temporary array by the key selected from each of them, moving the items into the groups
+		/// and sorting the groups by their keys.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <param name="order">Predicate the keys are sorted by, such as <see cref="linq::ascending"/>.</param>
+		/// <typeparam name="_Key">(Optional) The key type; defaults to the return type of the key selector.</typeparam>
+		template<class _Key = void, class _Fn, class _Pr, class = ::std::enable_if_t<!core::is_summarizer<::std::decay_t<_Pr>>::value>>
+		inline grouping<core::group_key_t<_Key, _Fn, const _Ty&>, _Ty> groupby(_Fn &&key_selector, _Pr &&order) && {
+			return _groupby<core::group_key_t<_Key, _Fn, const _Ty&>>(*this, key_selector, &order);
+		}
+		/// <summary>
+		/// Summarizes a value selected from the items of each group in a single pass, without copying any items into groups.
+		/// See <see cref="group_summary"/>.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <param name="summary">Selector of the value to be summarized, created by <see cref="linq::summarize"/>.</param>
+		/// <typeparam name="_Key">(Optional) The key type; defaults to the return type of the key selector.</typeparam>
+		/// <returns>Array holding the summary of every group, in the order their keys were first found.</returns>
+		template<class _Key = void, class _Fn, class _Sel>
+		inline auto groupby(_Fn &&key_selector, core::summarizer<_Sel> summary) const {
+			return lazy().template groupby<_Key>(::std::forward<_Fn>(key_selector), ::std::move(summary));
+		}
+		/// <summary>
+		/// Summarizes a value selected from the items of each group in a single pass, sorting the summaries by their keys.
+		/// See <see cref="group_summary"/>.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <param name="summary">Selector of the value to be summarized, created by <see cref="linq::summarize"/>.</param>
+		/// <param name="order">Predicate the keys are sorted by, such as <see cref="linq::ascending"/>.</param>
+		/// <typeparam name="_Key">(Optional) The key type; defaults to the return type of the key selector.</typeparam>
+		template<class _Key = void, class _Fn, class _Sel, class _Pr>
+		inline auto groupby(_Fn &&key_selector, core::summarizer<_Sel> summary, _Pr &&order) const {
+			return lazy().template groupby<_Key>(::std::forward<_Fn>(key_selector), ::std::move(summary), ::std::forward<_Pr>(order));
+		}
+
+		/*** Set operations ***
+		 * Each keeps only the first item with each key, in the order of its input, using one hash table of keys. Intersect
+		 * and except size that table to the smaller of the two lists, and screen the probes from a much larger list with a
+		 * bloom filter. The list given to union_with, intersect and except must have random access iterators. Without a key
+		 * selector the items themselves are the keys.
+		 */
+
+		/// <summary>Creates a new list without the items equal to one before them.</summary>
+		/// <returns>The first of each distinct item, in order.</returns>
+		inline array distinct() const { return _set<core::set_operation::distinct>(*this, core::identity(), "distinct"); }
+		/// <summary>Creates a new list without the items whose key equals that of an item before them.</summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <returns>The first item with each distinct key, in order.</returns>
+		template<class _Fn, class = ::std::enable_if_t<!is_execution_policy<_Fn>::value>>
+		inline array distinct(_Fn &&key_selector) const { return _set<core::set_operation::distinct>(*this, key_selector, "distinct"); }
+		/// <summary>Creates a new list of the distinct items of this list, followed by the items of another whose keys are not in it already.</summary>
+		/// <param name="other">List whose items are appended.</param>
+		/// <param name="key_selector">(Optional) Lambda which selects the key of each item of either list.</param>
+		template<class _Cont, class _Fn = core::identity, class = ::std::enable_if_t<!is_execution_policy<_Cont>::value>>
+		inline array union_with(const _Cont &other, _Fn &&key_selector = _Fn()) const { return _set<core::set_operation::union_with>(other, key_selector, "union_with"); }
+		/// <summary>Creates a new list of the distinct items of this list whose keys are found in another.</summary>
+		/// <param name="other">List whose keys are searched.</param>
+		/// <param name="key_selector">(Optional) Lambda which selects the key of each item of either list.</param>
+		template<class _Cont, class _Fn = core::identity, class = ::std::enable_if_t<!is_execution_policy<_Cont>::value>>
+		inline array intersect(const _Cont &other, _Fn &&key_selector = _Fn()) const { return _set<core::set_operation::intersect>(other, key_selector, "intersect"); }
+		/// <summary>Creates a new list of the distinct items of this list whose keys are not found in another.</summary>
+		/// <param name="other">List whose keys are excluded.</param>
+		/// <param name="key_selector">(Optional) Lambda which selects the key of each item of either list.</param>
+		template<class _Cont, class _Fn = core::identity, class = ::std::enable_if_t<!is_execution_policy<_Cont>::value>>
+		inline array except(const _Cont &other, _Fn &&key_selector = _Fn()) const { return _set<core::set_operation::except>(other, key_selector, "except"); }
+
+		/// <summary>
+		/// Builds a hash index on the key selected from each item, through which the items with a given key are found in
+		/// constant time instead of by scanning the array. The index reads this array, which must outlive it, and must be
+		/// rebuilt after the array changes. See <see cref="hashed_index"/>.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <returns>The index, built over the current items.</returns>
+		template<class _Fn>
+		inline hashed_index<array, ::std::decay_t<_Fn>> build_index(_Fn &&key_selector) const & {
+			return hashed_index<array, ::std::decay_t<_Fn>>(*this, ::std::forward<_Fn>(key_selector));
+		}
+		/// <summary>Indexing a temporary array would leave the index dangling.</summary>
+		template<class _Fn>
+		void build_index(_Fn &&key_selector) && = delete;
+		/// <summary>
+		/// Builds a sorted index on the key selected from each item, through which the items with a given key, or with keys
+		/// in a range, are found by binary search. The index reads this array, which must outlive it, and must be rebuilt
+		/// after the array changes. See <see cref="sorted_index"/>.
+		/// </summary>
+		/// <param name="key_selector">Lambda which selects the key of each item.</param>
+		/// <returns>The index, built over the current items.</returns>
+		template<class _Fn>
+		inline sorted_index<array, ::std::decay_t<_Fn>> build_sorted_index(_Fn &&key_selector) const & {
+			return sorted_index<array, ::std::decay_t<_Fn>>(*this, ::std::forward<_Fn>(key_selector));
+		}
+		/// <summary>Indexing a temporary array would leave the index dangling.</summary>
+		template<class _Fn>
+		void build_sorted_index(_Fn &&key_selector) && = delete;
+
+		/// <summary>
+		/// Helper method which converts this <see cref="linq::array"/> into a <see cref="std::vector"/>.
+		/// </summary>
+		/// <returns><see cref="std::vector"/> containing a copy of the elements of this <see cref="linq::array"/>.</returns>
+		inline base to_vector() const & {
+			return base(*this, this->get_allocator());
+		}
+		/// <summary>
+		/// Helper method which converts this temporary <see cref="linq::array"/> into a <see cref="std::vector"/>, handing over its storage.
+		/// </summary>
+		/// <returns><see cref="std::vector"/> which has taken the elements of this <see cref="linq::array"/>.</returns>
+		inline base to_vector() && {
+			return base(::std::move(static_cast<base&>(*this)));
+		}
+
+		/// <summary>
+		/// Starts a deferred <see cref="linq::query"/> over the elements of this array. The array is not copied
+		/// and must outlive the evaluation of the query.
+		/// </summary>
+		/// <returns>Query over the elements of this array.</returns>
+		inline query<core::range_enumerator<typename array::const_iterator>> lazy() const & {
+			return query<core::range_enumerator<typename array::const_iterator>>({ this->begin(), this->end() });
+		}
+		/// <summary>
+		/// Starts a deferred <see cref="linq::query"/> which takes ownership of the elements of this temporary array.
+		/// </summary>
+		/// <returns>Query over the elements of this array.</returns>
+		inline query<core::owning_enumerator<array>> lazy() && {
+			return query<core::owning_enumerator<array>>(core::owning_enumerator<array>(::std::move(*this)));
+		}
+
+	private:
+		/// <summary>Runs a set operation between this list and <paramref name="other"/> with <see cref="core::run_set"/>.</summary>
+		template<core::set_operation _Op, class _Cont, class _Fn>
+		array _set(const _Cont &other, const _Fn &key_selector, const char *name) const {
+			const ::std::size_t other_count = _Op == core::set_operation::distinct ? 0 : static_cast<::std::size_t>(other.end() - other.begin());
+			core::stage_scope stage(name, this->size() + other_count);
+			array result(this->get_allocator());
+			auto other_first = other.begin();
+			core::run_set<_Op, core::set_key_t<_Fn, _Ty>>(core::make_set_side(this->begin(), this->size(), key_selector), core::make_set_side(other_first, other_count, key_selector),
+				[&](bool right, ::std::size_t position) { _set_keep(result, other_first, right, position, ::std::integral_constant<bool, _Op == core::set_operation::union_with>()); });
+			stage.calls(this->size() + other_count);
+			stage.written(into(result));
+			return result;
+		}
+		/// <summary>
+		/// Runs a set operation between this list and <paramref name="other"/> over hash partitions of both, with a
+		/// <see cref="core::run_set"/> per partition on the pool. Each partition marks the items it keeps, and the marked
+		/// items are then collected in order, so the result is identical to the sequential operation.
+		/// </summary>
+		template<core::set_operation _Op, class _Cont, class _Fn>
+		array _parallel_set(const parallel_policy &policy, const _Cont &other, const _Fn &key_selector, const char *name) const {
+			typedef core::set_key_t<_Fn, _Ty> key_type;
+			thread_pool &pool = policy.get_pool();
+			const ::std::size_t other_count = _Op == core::set_operation::distinct ? 0 : static_cast<::std::size_t>(other.end() - other.begin());
+			if (pool.concurrency() == 1 || this->size() + other_count < policy.grain * 2) {
+				return _set<_Op>(other, key_selector, name);
+			}
+			core::stage_scope stage(name, this->size() + other_count);
+			unsigned bits = 0;
+			while ((::std::size_t(1) << bits) < pool.concurrency() * 4 && bits < 8) bits++;
+			auto other_first = other.begin();
+			core::hash_partition<key_type> left, right;
+			left.build(pool, policy.grain, this->begin(), this->size(), key_selector, bits);
+			right.build(pool, policy.grain, other_first, other_count, key_selector, bits);
+			::std::vector<char> keep_left(this->size(), 0), keep_right(other_count, 0);
+			pool.parallel_for(::std::size_t(1) << bits, [&](::std::size_t p) {
+				core::run_set<_Op, key_type>(left.side(p, this->begin(), key_selector), right.side(p, other_first, key_selector),
+					[&](bool from_right, ::std::size_t position) { (from_right ? keep_right : keep_left)[position] = 1; });
+			});
+			array result(this->get_allocator());
+			for (::std::size_t c = 0; c < this->size(); c++) {
+				if (keep_left[c]) result.push_back((*this)[c]);
+			}
+			for (::std::size_t c = 0; c < other_count; c++) {
+				if (keep_right[c]) _set_keep(result, other_first, true, c, ::std::integral_constant<bool, _Op == core::set_operation::union_with>());
+			}
+			stage.calls((this->size() + other_count) * 2);
+			stage.written(into(result));
+			return result;
+		}
+		/// <summary>Appends a kept item: from this list, or from the other list when the operation is a union.</summary>
+		template<class _Iter>
+		inline void _set_keep(array &result, _Iter other_first, bool right, ::std::size_t position, ::std::true_type) const {
+			if (right) result.push_back(other_first[position]);
+			else result.push_back((*this)[position]);
+		}
+		template<class _Iter>
+		inline void _set_keep(array &result, _Iter, bool, ::std::size_t position, ::std::false_type) const { result.push_back((*this)[position]); }
+		/// <summary>Scans forwards from <paramref name="data"/>, this array's storage, for the first item satisfying the condition.</summary>
+		template<class _Ptr, class _Pr>
+		_Ptr _find_first(_Ptr data, _Pr &condition) const {
+			_Ptr end = data + this->size(), found = ::std::find_if(data, end, ::std::ref(condition));
+			return found != end ? found : nullptr;
+		}
+		/// <summary>Scans backwards from the end of <paramref name="data"/>, this array's storage, for the last item satisfying the condition.</summary>
+		template<class _Ptr, class _Pr>
+		_Ptr _find_last(_Ptr data, _Pr &condition) const {
+			typedef ::std::reverse_iterator<_Ptr> reverse;
+			reverse found = ::std::find_if(reverse(data + this->size()), reverse(data), ::std::ref(condition));
+			return found != reverse(data) ? &*found : nullptr;
+		}
+		/// <summary>This array's allocator, rebound to elements of type <typeparamref name="_Ty2"/>.</summary>
+		template<class _Ty2>
+		inline typename rebind<_Ty2>::allocator_type _allocator() const { return typename rebind<_Ty2>::allocator_type(this->get_allocator()); }
+		/// <summary>Creates an empty array of <typeparamref name="_Ty2"/> using this array's allocator.</summary>
+		template<class _Ty2>
+		inline rebind<_Ty2> _make() const { return rebind<_Ty2>(_allocator<_Ty2>()); }
+		/// <summary>Evaluates a query over this array into an array using this array's allocator.</summary>
+		template<class _Enum>
+		inline rebind<typename _Enum::value_type> _to_array(const query<_Enum> &q) const { return q.to_array(_allocator<typename _Enum::value_type>()); }
+		/// <summary>
+		/// Takes the items of a vector built with the default allocator. They are handed over as they are when this array
+		/// uses the default allocator too, and moved into storage from this array's allocator otherwise.
+		/// </summary>
+		template<class _Ty2>
+		inline rebind<_Ty2> _adopt(::std::vector<_Ty2> &&items) const {
+			return _adopt(::std::move(items), ::std::is_same<typename rebind<_Ty2>::allocator_type, ::std::allocator<_Ty2>>());
+		}
+		template<class _Ty2>
+		inline rebind<_Ty2> _adopt(::std::vector<_Ty2> &&items, ::std::true_type) const { return rebind<_Ty2>(::std::move(items)); }
+		template<class _Ty2>
+		inline rebind<_Ty2> _adopt(::std::vector<_Ty2> &&items, ::std::false_type) const {
+			return rebind<_Ty2>(::std::make_move_iterator(items.begin()), ::std::make_move_iterator(items.end()), _allocator<_Ty2>());
+		}
+
+		template<class _Ret, class _Fn>
+		array _select_moved(_Fn &selector, ::std::true_type) && {
+			for (auto &item : *this) {
+				item = selector(::std::move(item));
+			}
+			return ::std::move(*this);
+		}
+		template<class _Ret, class _Fn>
+		rebind<_Ret> _select_moved(_Fn &selector, ::std::false_type) && {
+			rebind<_Ret> result(_allocator<_Ret>());
+			result.reserve(this->size());
+			for (auto &item : *this) {
+				result.emplace_back(selector(::std::move(item)));
+			}
+			return result;
+		}
+
+		/// <summary>
+		/// Writes the items sorted on the keys into the output. <paramref name="args"/> holds the keys, then the output, and
+		/// <typeparamref name="_I"/> indexes the keys.
+		/// </summary>
+		template<class _Args, ::std::size_t... _I>
+		typename ::std::decay_t<::std::tuple_element_t<sizeof...(_I), _Args>>::result_type _orderby_keys_into(const _Args &args, ::std::index_sequence<_I...>) const {
+			auto orders = ::std::make_tuple(::std::get<_I>(args)...);
+			static_assert(core::all_of({ core::is_key_order<::std::tuple_element_t<_I, decltype(orders)>>::value... }), "every key of a key orderby must be created with linq::ascending or linq::descending");
+			::std::decay_t<::std::tuple_element_t<sizeof...(_I), _Args>> out = ::std::get<sizeof...(_I)>(args);
+			core::stage_scope stage("orderby", this->size());
+			out.start(this->size());
+			_sort_positions(orders, out.context(), [&](::std::size_t position) { out.emplace((*this)[position]); });
+			stage.calls(this->size() * sizeof...(_I));
+			stage.output(this->size());
+			return out.finish();
+		}
+		/// <summary>
+		/// Sorts the positions of the items on the keys of the <see cref="core::key_order"/>s, keeping the temporaries in the
+		/// context when one is given, and calls <paramref name="emit"/> with every position in sorted order.
+		/// </summary>
+		template<class _Orders, class _Fn>
+		void _sort_positions(_Orders &orders, query_context *context, _Fn &&emit) const {
+			typedef core::key_sort_traits<_Ty, _Orders> traits;
+			if (this->size() <= 0xffffffffu) {
+				core::scratch<core::key_sort_scratch<traits, ::std::uint32_t>> scratch(context);
+				core::sort_by_keys(this->begin(), this->size(), orders, emit, *scratch);
+			}
+			else {
+				core::scratch<core::key_sort_scratch<traits, ::std::size_t>> scratch(context);
+				core::sort_by_keys(this->begin(), this->size(), orders, emit, *scratch);
+			}
+		}
+		/// <summary>Sorts on the keys of the <see cref="core::key_order"/>s, then moves the items into their sorted positions.</summary>
+		template<class _Orders>
+		void _sort_by_keys(_Orders orders) {
+			base sorted(this->get_allocator());
+			sorted.reserve(this->size());
+			core::sort_by_keys(this->begin(), this->size(), orders, [&](::std::size_t position) { sorted.push_back(::std::move((*this)[position])); });
+			this->swap(sorted);
+		}
+		/// <summary>
+		/// Fills <paramref name="positions"/> with the positions of the first <paramref name="count"/> items by the predicate,
+		/// in order, with items which are equal by the predicate ordered by position.
+		/// </summary>
+		template<class _Pr>
+		void _top_k_positions(::std::size_t count, _Pr &pred, ::std::vector<::std::size_t> &positions) const {
+			positions.resize(this->size());
+			for (::std::size_t c = 0, l = this->size(); c < l; c++) {
+				positions[c] = c;
+			}
+			auto before = [&](::std::size_t l, ::std::size_t r) { return core::before_at(pred, (*this)[l], l, (*this)[r], r); };
+			if (count < positions.size()) {
+				::std::nth_element(positions.begin(), positions.begin() + static_cast<::std::ptrdiff_t>(count), positions.end(), before);
+				positions.resize(count);
+			}
+			::std::sort(positions.begin(), positions.end(), before);
+		}
+		/// <summary>Selects the first <paramref name="count"/> items of [<paramref name="first"/>, <paramref name="last"/>) by the predicate.</summary>
+		template<class _Pr>
+		core::top_k_heap<_Ty, _Pr> _top_k(::std::size_t first, ::std::size_t last, ::std::size_t count, _Pr &pred) const {
+			core::top_k_heap<_Ty, _Pr> heap(count, pred, last - first);
+			for (::std::size_t c = first; c < last; c++) {
+				heap.push((*this)[c], c);
+			}
+			return heap;
+		}
+		/// <summary>Selects the first <paramref name="count"/> items by the predicate, keeping them in the provided storage.</summary>
+		template<class _Pr>
+		core::top_k_heap<_Ty, _Pr> _top_k(::std::size_t first, ::std::size_t last, ::std::size_t count, _Pr &pred, typename core::top_k_heap<_Ty, _Pr>::storage_type &&storage) const {
+			core::top_k_heap<_Ty, _Pr> heap(count, pred, last - first, ::std::move(storage));
+			for (::std::size_t c = first; c < last; c++) {
+				heap.push((*this)[c], c);
+			}
+			return heap;
+		}
+		/// <summary>
+		/// Groups the items of <paramref name="items"/>, which are moved into the groups unless the array is const. When
+		/// <paramref name="order"/> is given, the groups are numbered in key order rather than the order their keys were found.
+		/// </summary>
+		template<class _Key, class _Src, class _Fn, class _Pr>
+		static grouping<_Key, _Ty> _groupby(_Src &items, _Fn &key_selector, _Pr *order) {
+			typedef ::std::conditional_t<::std::is_const<_Src>::value, const _Ty&, _Ty&&> element;
+			const ::std::size_t count = items.size();
+			core::stage_scope stage("groupby", count);
+			stage.calls(count);
+			grouping<_Key, _Ty> result;
+			::std::vector<::std::uint32_t> ids(count);
+			for (::std::size_t c = 0; c < count; c++) {
+				ids[c] = static_cast<::std::uint32_t>(result._table.insert(key_selector(static_cast<const _Ty&>(items[c]))));
+			}
+			const ::std::size_t groups = result._table.size();
+			if (order) {
+				::std::vector<::std::size_t> sorted(groups), rank(groups);
+				for (::std::size_t g = 0; g < groups; g++) {
+					sorted[g] = g;
+				}
+				const ::std::vector<_Key> &keys = result._table.keys();
+				::std::sort(sorted.begin(), sorted.end(), [&](::std::size_t left, ::std::size_t right) { return (*order)(keys[left], keys[right]); });
+				for (::std::size_t g = 0; g < groups; g++) {
+					rank[sorted[g]] = g;
+				}
+				result._table.reorder(rank);
+				for (::std::uint32_t &id : ids) {
+					id = static_cast<::std::uint32_t>(rank[id]);
+				}
+			}
+			// Counting sort by group, keeping the original order within each group
+			result._offsets.assign(groups + 1, 0);
+			for (::std::uint32_t id : ids) {
+				result._offsets[id + 1]++;
+			}
+			for (::std::size_t g = 0; g < groups; g++) {
+				result._offsets[g + 1] += result._offsets[g];
+			}
+			_scatter<element>(items, ids, result._offsets, result._items, ::std::is_default_constructible<_Ty>());
+			stage.output(groups);
+			return result;
+		}
+		/// <summary>
+		/// Places every item at the next free position of its group, reading the items in order and writing to one run per group.
+		/// </summary>
+		template<class _Elem, class _Src>
+		static void _scatter(_Src &items, const ::std::vector<::std::uint32_t> &ids, const ::std::vector<::std::size_t> &offsets, ::std::vector<_Ty> &out, ::std::true_type) {
+			::std::vector<::std::size_t> fill(offsets.begin(), offsets.end() - 1);
+			out.resize(ids.size());
+			for (::std::size_t c = 0; c < ids.size(); c++) {
+				out[fill[ids[c]]++] = static_cast<_Elem>(items[c]);
+			}
+		}
+		/// <summary>
+		/// Items which cannot be default constructed are appended instead, group by group, after sorting their positions.
+		/// </summary>
+		template<class _Elem, class _Src>
+		static void _scatter(_Src &items, const ::std::vector<::std::uint32_t> &ids, const ::std::vector<::std::size_t> &offsets, ::std::vector<_Ty> &out, ::std::false_type) {
+			::std::vector<::std::size_t> fill(offsets.begin(), offsets.end() - 1), positions(ids.size());
+			for (::std::size_t c = 0; c < ids.size(); c++) {
+				positions[fill[ids[c]]++] = c;
+			}
+			out.reserve(ids.size());
+			for (::std::size_t p : positions) {
+				out.push_back(static_cast<_Elem>(items[p]));
+			}
+		}
+		/// <summary>
+		/// Computes the keys of both lists once and hands the matches of each element of this list to <paramref name="fn"/>.
+		/// </summary>
+		template<class _Cont, class _LKey, class _RKey, class _Fn>
+		::std::size_t _equi_join(const _Cont &arr, _LKey &left_key, _RKey &right_key, _Fn &&fn, query_context *context = nullptr) const {
+			typedef core::join_key_t<_LKey, _RKey, _Ty, typename _Cont::value_type> key_type;
+			core::scratch<core::join_scratch<key_type>> scratch(context);
+			scratch->lkeys.clear();
+			scratch->rkeys.clear();
+			scratch->lkeys.reserve(this->size());
+			scratch->rkeys.reserve(arr.size());
+			for (const _Ty &item : *this) scratch->lkeys.emplace_back(left_key(item));
+			for (const auto &item : arr) scratch->rkeys.emplace_back(right_key(item));
+			return core::equi_join(*scratch, ::std::forward<_Fn>(fn));
+		}
+		/// <summary>Sums the items of arrays with vector kernels, one block at a time.</summary>
+		_Ty _sum(::std::true_type) const {
+			const ::std::size_t block = core::pairwise_sum<_Ty>::block;
+			core::pairwise_sum<_Ty> total;
+			for (::std::size_t c = 0, l = this->size(); c < l; c += block) {
+				total.add_block(_sum(c, ::std::min(l, c + block), ::std::true_type()));
+			}
+			return total.result();
+		}
+		inline _Ty _sum(::std::false_type) const { return lazy().sum(); }
+		/// <summary>Sum of the items in [<paramref name="first"/>, <paramref name="last"/>), which is at most one block for floating point types.</summary>
+		_Ty _sum(::std::size_t first, ::std::size_t last, ::std::true_type) const {
+			_Ty lanes[core::simd::sum_lanes] = {};
+			core::simd::sum(this->data() + first, last - first, lanes);
+			return core::pairwise_sum<_Ty>::fold(lanes);
+		}
+		_Ty _sum(::std::size_t first, ::std::size_t last, ::std::false_type) const {
+			core::summation<_Ty> total;
+			for (::std::size_t c = first; c < last; c++) {
+				total.add((*this)[c]);
+			}
+			return total.result();
+		}
+		/// <summary>
+		/// Sums in parallel. Floating point sums are split into the blocks of <see cref="core::pairwise_sum"/>, which are summed
+		/// by <paramref name="range_sum"/> concurrently and then added in order, the same way the sequential sum adds them.
+		/// </summary>
+		template<class _Res, class _Fn>
+		_Res _parallel_sum(const parallel_policy &policy, _Fn &&range_sum) const {
+			const ::std::size_t count = this->size();
+			if (!::std::is_floating_point<_Res>::value) {
+				return _parallel_reduce<_Res>(policy, range_sum, [](_Res &total, _Res &&slice) { total = core::simd::wrapping_add(total, slice); });
+			}
+			const ::std::size_t block = core::pairwise_sum<_Res>::block, blocks = (count + block - 1) / block;
+			::std::vector<_Res> sums(blocks);
+			thread_pool &pool = policy.get_pool();
+			const ::std::size_t tasks = pool.partition(blocks, ::std::max<::std::size_t>(1, policy.grain / block));
+			pool.parallel_for(tasks, [&](::std::size_t t) {
+				for (::std::size_t b = core::slice_begin(blocks, tasks, t), l = core::slice_begin(blocks, tasks, t + 1); b < l; b++) {
+					sums[b] = range_sum(b * block, ::std::min(count, (b + 1) * block));
+				}
+			});
+			core::pairwise_sum<_Res> total;
+			for (auto &sum : sums) {
+				total.add_block(sum);
+			}
+			return total.result();
+		}
+		/// <summary>
+		/// Reduces the slices of the array with <paramref name="reduce"/> concurrently, then merges each slice's result into
+		/// the first in order with <paramref name="merge"/>. Empty arrays give a value initialized result.
+		/// </summary>
+		template<class _Res, class _Reduce, class _Merge>
+		_Res _parallel_reduce(const parallel_policy &policy, _Reduce &&reduce, _Merge &&merge) const {
+			const ::std::size_t count = this->size();
+			thread_pool &pool = policy.get_pool();
+			const ::std::size_t tasks = pool.partition(count, policy.grain);
+			if (tasks <= 1) {
+				return count ? reduce(0, count) : _Res();
+			}
+			::std::vector<core::optional<_Res>> slices(tasks);
+			pool.parallel_for(tasks, [&](::std::size_t t) {
+				slices[t].emplace(reduce(core::slice_begin(count, tasks, t), core::slice_begin(count, tasks, t + 1)));
+			});
+			_Res total = ::std::move(*slices[0]);
+			for (::std::size_t t = 1; t < tasks; t++) {
+				merge(total, ::std::move(*slices[t]));
+			}
+			return total;
+		}
+		inline _Ty _min(::std::true_type) const { return minmax().first; }
+		inline _Ty _min(::std::false_type) const { return lazy().min(); }
+		inline _Ty _max(::std::true_type) const { return minmax().second; }
+		inline _Ty _max(::std::false_type) const { return lazy().max(); }
+		/// <summary>Smallest and largest of the items in the non-empty range [<paramref name="first"/>, <paramref name="last"/>), or NaN for both if any item is NaN.</summary>
+		::std::pair<_Ty, _Ty> _extrema(::std::size_t first, ::std::size_t last, ::std::true_type) const {
+			_Ty low, high;
+			if (!core::simd::extrema(this->data() + first, last - first, low, high)) {
+				low = high = ::std::numeric_limits<_Ty>::quiet_NaN();
+			}
+			return { low, high };
+		}
+		::std::pair<_Ty, _Ty> _extrema(::std::size_t first, ::std::size_t last, ::std::false_type) const {
+			return query<core::range_enumerator<const _Ty*>>({ this->data() + first, this->data() + last }).minmax();
+		}
+		inline core::average_t<_Ty> _average(::std::true_type) const {
+			if (this->empty()) {
+				core::throw_empty();
+			}
+			return sum() / static_cast<_Ty>(this->size());
+		}
+		inline core::average_t<_Ty> _average(::std::false_type) const { return lazy().average(); }
+		inline _Ty _parallel_average(const parallel_policy &policy, ::std::true_type) const { return sum(policy); }
+		inline core::average_sum_t<_Ty> _parallel_average(const parallel_policy &policy, ::std::false_type) const {
+			return sum(policy, [](const _Ty &item) { return static_cast<core::average_sum_t<_Ty>>(item); });
+		}
+		/// <summary>Counts with the vector kernels, see <see cref="_filter"/>.</summary>
+		template<class _Pr>
+		::std::size_t _count(::std::size_t first, ::std::size_t last, const _Pr &condition, ::std::true_type) const {
+			core::compare_term<_Ty> terms[_Pr::size()];
+			for (::std::size_t t = 0; t < _Pr::size(); t++) {
+				if (!core::simd::narrow(condition[t], terms[t])) {
+					return _count(first, last, condition, ::std::false_type());
+				}
+			}
+			return core::simd::count(this->data() + first, last - first, terms, _Pr::size());
+		}
+		template<class _Pr>
+		::std::size_t _count(::std::size_t first, ::std::size_t last, _Pr &condition, ::std::false_type) const {
+			::std::size_t total = 0;
+			for (::std::size_t c = first; c < last; c++) {
+				total += condition((*this)[c]) ? 1 : 0;
+			}
+			return total;
+		}
+		/// <summary>
+		/// Filters arrays of arithmetic types, which are copied into the result without branching on the condition.
+		/// </summary>
+		template<class _Pr, class _Vector>
+		array _where(_Pr &condition, _Vector vector, ::std::true_type) const {
+			array result(this->get_allocator());
+			core::filter_blocks(this->data(), this->size(), result, [&](const _Ty *in, ::std::size_t count, _Ty *out) {
+				return _filter(in, count, out, condition, vector);
+			});
+			return result;
+		}
+		template<class _Pr, class _Vector>
+		inline array _where(_Pr &condition, _Vector, ::std::false_type) const {
+			return lazy().where(condition).to_array();
+		}
+		template<class _Pr, class _Vector>
+		array _where_moved(_Pr &condition, _Vector vector, ::std::true_type) && {
+			this->erase(this->begin() + static_cast<::std::ptrdiff_t>(_filter(this->data(), this->size(), this->data(), condition, vector)), this->end());
+			return ::std::move(*this);
+		}
+		template<class _Pr, class _Vector>
+		array _where_moved(_Pr &condition, _Vector, ::std::false_type) && {
+			auto out = this->begin();
+			for (auto it = this->begin(), end = this->end(); it != end; ++it) {
+				if (condition(static_cast<const _Ty&>(*it))) {
+					if (out != it) {
+						*out = ::std::move(*it);
+					}
+					++out;
+				}
+			}
+			this->erase(out, this->end());
+			return ::std::move(*this);
+		}
+		/// <summary>
+		/// Filters a structured condition with the vector kernels, following the rules of the <see cref="core::simd"/> kernels.
+		/// </summary>
+		template<class _Pr>
+		static ::std::size_t _filter(const _Ty *in, ::std::size_t count, _Ty *out, const _Pr &condition, ::std::true_type) {
+			core::compare_term<_Ty> terms[_Pr::size()];
+			for (::std::size_t t = 0; t < _Pr::size(); t++) {
+				if (!core::simd::narrow(condition[t], terms[t])) {
+					return _filter(in, count, out, condition, ::std::false_type());
+				}
+			}
+			return core::simd::filter(in, count, out, terms, _Pr::size());
+		}
+		/// <summary>
+		/// Filters any condition one element at a time, writing every element and only advancing past the kept ones, so the
+		/// loop never branches on the outcome of the condition.
+		/// </summary>
+		template<class _Pr>
+		static ::std::size_t _filter(const _Ty *in, ::std::size_t count, _Ty *out, _Pr &condition, ::std::false_type) {
+			::std::size_t kept = 0;
+			for (::std::size_t c = 0; c < count; c++) {
+				const _Ty item = in[c];
+				out[kept] = item;
+				kept += condition(item) ? 1 : 0;
+			}
+			return kept;
+		}
+		/// <summary>Filters arrays of arithmetic types into a container with the branchless kernels, see <see cref="_where"/>.</summary>
+		template<class _Pr, class _Out, class _Vector>
+		typename _Out::result_type _where_into(_Pr &condition, _Out &out, _Vector vector, ::std::true_type) const {
+			auto &target = out.container();
+			target.clear();
+			core::filter_blocks(this->data(), this->size(), target, [&](const _Ty *in, ::std::size_t count, _Ty *buffer) {
+				return _filter(in, count, buffer, condition, vector);
+			});
+			return out.finish();
+		}
+		template<class _Pr, class _Out, class _Vector>
+		typename _Out::result_type _where_into(_Pr &condition, _Out &out, _Vector, ::std::false_type) const {
+			out.start(0);
+			for (const _Ty &item : *this) {
+				if (condition(item)) {
+					out.emplace(item);
+				}
+			}
+			return out.finish();
+		}
+		/// <summary>Copies the kept elements into place in parallel, each slice starting at its offset.</summary>
+		template<class _Out>
+		typename _Out::result_type _compact(const ::std::vector<unsigned char> &keep, const ::std::vector<::std::size_t> &offsets, thread_pool &pool, _Out &out, ::std::true_type) const {
+			const ::std::size_t count = this->size(), tasks = offsets.size() - 1;
+			auto &target = out.container();
+			target.clear();
+			target.resize(offsets[tasks]);
+			pool.parallel_for(tasks, [&](::std::size_t t) {
+				::std::size_t next = offsets[t];
+				for (::std::size_t c = core::slice_begin(count, tasks, t), l = core::slice_begin(count, tasks, t + 1); c < l; c++) {
+					if (keep[c]) target[next++] = (*this)[c];
+				}
+			});
+			return out.finish();
+		}
+		/// <summary>Copies the kept elements in order, for outputs which cannot be resized up front.</summary>
+		template<class _Out>
+		typename _Out::result_type _compact(const ::std::vector<unsigned char> &keep, const ::std::vector<::std::size_t> &offsets, thread_pool&, _Out &out, ::std::false_type) const {
+			out.start(offsets.back());
+			for (::std::size_t c = 0, l = this->size(); c < l; c++) {
+				if (keep[c]) out.emplace((*this)[c]);
+			}
+			return out.finish();
+		}
+		template<class _Fn, class _Out>
+		typename _Out::result_type _select_into(const parallel_policy &policy, _Fn &selector, _Out &out, ::std::true_type) const {
+			thread_pool &pool = policy.get_pool();
+			const ::std::size_t count = this->size(), tasks = pool.partition(count, policy.grain);
+			auto &target = out.container();
+			target.clear();
+			target.resize(count);
+			pool.parallel_for(tasks, [&](::std::size_t t) {
+				for (::std::size_t c = core::slice_begin(count, tasks, t), l = core::slice_begin(count, tasks, t + 1); c < l; c++) {
+					target[c] = selector((*this)[c]);
+				}
+			});
+			return out.finish();
+		}
+		template<class _Fn, class _Out>
+		inline typename _Out::result_type _select_into(const parallel_policy&, _Fn &selector, _Out &out, ::std::false_type) const {
+			return select(selector, out);
+		}
+		/// <summary>Fills the container with copies of the items, then sorts it in place.</summary>
+		template<class _Pr, class _Out>
+		typename _Out::result_type _orderby_into(const _Pr &pred, _Out &out, ::std::true_type) const {
+			out.start(this->size());
+			for (const _Ty &item : *this) {
+				out.emplace(item);
+			}
+			::std::stable_sort(out.container().begin(), out.container().end(), pred);
+			return out.finish();
+		}
+		/// <summary>Sorts the positions of the items, then writes the items in that order.</summary>
+		template<class _Pr, class _Out>
+		typename _Out::result_type _orderby_into(const _Pr &pred, _Out &out, ::std::false_type) const {
+			core::scratch<::std::vector<::std::size_t>> positions(out.context());
+			positions->resize(this->size());
+			for (::std::size_t c = 0, l = this->size(); c < l; c++) {
+				(*positions)[c] = c;
+			}
+			::std::stable_sort(positions->begin(), positions->end(), [&](::std::size_t l, ::std::size_t r) { return pred((*this)[l], (*this)[r]); });
+			out.start(this->size());
+			for (::std::size_t position : *positions) {
+				out.emplace((*this)[position]);
+			}
+			return out.finish();
+		}
+		template<class _Iter, class _Out>
+		typename _Out::result_type _copy_into(_Iter first, _Iter last, _Out &out) const {
+			out.start(static_cast<::std::size_t>(last - first));
+			for (; first != last; ++first) {
+				out.emplace(*first);
+			}
+			return out.finish();
+		}
+		template<class _Ret, class _Fn>
+		rebind<_Ret> _select(const parallel_policy &policy, _Fn &selector, ::std::true_type) const {
+			thread_pool &pool = policy.get_pool();
+			const ::std::size_t count = this->size(), tasks = pool.partition(count, policy.grain);
+			rebind<_Ret> result(count, _allocator<_Ret>());
+			pool.parallel_for(tasks, [&](::std::size_t t) {
+				for (::std::size_t c = core::slice_begin(count, tasks, t), l = core::slice_begin(count, tasks, t + 1); c < l; c++) {
+					result[c] = selector((*this)[c]);
+				}
+			});
+			return result;
+		}
+		template<class _Ret, class _Fn>
+		inline rebind<_Ret> _select(const parallel_policy&, _Fn &selector, ::std::false_type) const {
+			return select<_Ret>(selector);
+		}
+		/// <summary>
+		/// Runs probe(left, out) for every element of this list in parallel slices, each slice appending to its own buffer,
+		/// then concatenates the buffers in slice order.
+		/// </summary>
+		template<class _Ret, class _Probe>
+		rebind<_Ret> _parallel_probe(const parallel_policy &policy, _Probe &&probe) const {
+			thread_pool &pool = policy.get_pool();
+			const ::std::size_t count = this->size(), tasks = pool.partition(count, policy.grain);
+			::std::vector<::std::vector<_Ret>> parts(tasks);
+			pool.parallel_for(tasks, [&](::std::size_t t) {
+				for (::std::size_t c = core::slice_begin(count, tasks, t), l = core::slice_begin(count, tasks, t + 1); c < l; c++) {
+					probe((*this)[c], parts[t]);
+				}
+			});
+			::std::size_t total = 0;
+			for (const auto &part : parts) total += part.size();
+			rebind<_Ret> result(_allocator<_Ret>());
+			result.reserve(total);
+			for (auto &part : parts) {
+				::std::move(part.begin(), part.end(), ::std::back_inserter(result));
+			}
+			return result;
+		}
+	};
+
+	/// <summary>
+	/// Helper function for converting a <see cref="std::vector"/> to an <see cref="linq::array"/>.
+	/// </summary>
+	/// <param name="vec">The <see cref="std::vector"/> to be converted to a <see cref="linq::array"/>.</param>
+	/// <returns><see cref="linq::array"/> containing a copy of the elements from the provided <paramref name="vec"/>.</returns>
+	template<class _Ty, class _Alloc>
+	inline array<_Ty, _Alloc> from(const ::std::vector<_Ty, _Alloc> &vec) { return array<_Ty, _Alloc>(vec, vec.get_allocator()); }
+	/// <summary>
+	/// Helper function for converting a temporary <see cref="std::vector"/> to an <see cref="linq::array"/> by adopting its storage.
+	/// </summary>
+	/// <param name="vec">The <see cref="std::vector"/> to be converted to a <see cref="linq::array"/>.</param>
+	/// <returns><see cref="linq::array"/> which has taken the elements of the provided <paramref name="vec"/>, without copying them.</returns>
+	template<class _Ty, class _Alloc>
+	inline array<_Ty, _Alloc> from(::std::vector<_Ty, _Alloc> &&vec) { return array<_Ty, _Alloc>(::std::move(vec)); }
+	/// <summary>
+	/// Helper function for converting a C-style array pointer into an <see cref="linq::array"/>.
+	/// </summary>
+	/// <param name="c_arr">The pointer to a C-Style array to be converted to a <see cref="linq::array"/>.</param>
+	/// <param name="size">The size of the C-Style array.</param>
+	/// <returns><see cref="linq::array"/> containing a copy of the elements from the provided <paramref name="c_arr"/>.</returns>
+	template<class _Ty>
+	inline array<_Ty> from(const _Ty *c_arr, const size_t &size) {
+		return array<_Ty>(c_arr, c_arr + size);
+	}
+	/// <summary>
+	/// Copies the elements of a <see cref="std::vector"/> into an <see cref="linq::array"/> allocated from the provided
+	/// <see cref="arena"/>. Every array the operators produce from it is allocated from the same arena.
+	/// </summary>
+	/// <param name="vec">The <see cref="std::vector"/> to be converted to a <see cref="linq::array"/>.</param>
+	/// <param name="scope">Arena the array and its query temporaries are allocated from, which must outlive them.</param>
+	template<class _Ty, class _Alloc>
+	inline array<_Ty, arena_allocator<_Ty>> from(const ::std::vector<_Ty, _Alloc> &vec, arena &scope) {
+		return array<_Ty, arena_allocator<_Ty>>(vec.begin(), vec.end(), arena_allocator<_Ty>(scope));
+	}
+	/// <summary>
+	/// Copies the elements of a C-style array into an <see cref="linq::array"/> allocated from the provided <see cref="arena"/>.
+	/// Every array the operators produce from it is allocated from the same arena.
+	/// </summary>
+	/// <param name="c_arr">The pointer to a C-Style array to be converted to a <see cref="linq::array"/>.</param>
+	/// <param name="size">The size of the C-Style array.</param>
+	/// <param name="scope">Arena the array and its query temporaries are allocated from, which must outlive them.</param>
+	template<class _Ty>
+	inline array<_Ty, arena_allocator<_Ty>> from(const _Ty *c_arr, const size_t &size, arena &scope) {
+		return array<_Ty, arena_allocator<_Ty>>(c_arr, c_arr + size, arena_allocator<_Ty>(scope));
+	}
+
+	/// <summary>
+	/// Starts a deferred <see cref="linq::query"/> over the provided <see cref="std::vector"/> without copying it.
+	/// The vector must outlive the evaluation of the query.
+	/// </summary>
+	/// <param name="vec">The <see cref="std::vector"/> to be queried.</param>
+	/// <returns><see cref="linq::query"/> over the elements of the provided <paramref name="vec"/>.</returns>
+	template<class _Ty, class _Alloc>
+	inline query<core::range_enumerator<typename ::std::vector<_Ty, _Alloc>::const_iterator>> lazy(const ::std::vector<_Ty, _Alloc> &vec) {
+		return query<core::range_enumerator<typename ::std::vector<_Ty, _Alloc>::const_iterator>>({ vec.begin(), vec.end() });
+	}
+	/// <summary>
+	/// Starts a deferred <see cref="linq::query"/> which takes ownership of the provided temporary <see cref="std::vector"/>.
+	/// </summary>
+	/// <param name="vec">The <see cref="std::vector"/> to be queried.</param>
+	/// <returns><see cref="linq::query"/> over the elements of the provided <paramref name="vec"/>.</returns>
+	template<class _Ty, class _Alloc>
+	inline query<core::owning_enumerator<::std::vector<_Ty, _Alloc>>> lazy(::std::vector<_Ty, _Alloc> &&vec) {
+		return query<core::owning_enumerator<::std::vector<_Ty, _Alloc>>>(core::owning_enumerator<::std::vector<_Ty, _Alloc>>(::std::move(vec)));
+	}
+	/// <summary>
+	/// Starts a deferred <see cref="linq::query"/> over the provided C-style array without copying it.
+	/// The C-style array must outlive the evaluation of the query.
+	/// </summary>
+	/// <param name="c_arr">The pointer to a C-Style array to be queried.</param>
+	/// <param name="size">The size of the C-Style array.</param>
+	/// <returns><see cref="linq::query"/> over the elements of the provided <paramref name="c_arr"/>.</returns>
+	template<class _Ty>
+	inline query<core::range_enumerator<const _Ty*>> lazy(const _Ty *c_arr, const size_t &size) {
+		return query<core::range_enumerator<const _Ty*>>({ c_arr, c_arr + size });
+	}
+	/// <summary>
+	/// Starts a deferred <see cref="linq::query"/> over the provided <see cref="linq::array"/> without copying it.
+	/// </summary>
+	template<class _Ty, class _Alloc>
+	inline auto lazy(const array<_Ty, _Alloc> &arr) { return arr.lazy(); }
+	/// <summary>
+	/// Starts a deferred <see cref="linq::query"/> which takes ownership of the provided temporary <see cref="linq::array"/>.
+	/// </summary>
+	template<class _Ty, class _Alloc>
+	inline auto lazy(array<_Ty, _Alloc> &&arr) { return ::std::move(arr).lazy(); }
+	/// <summary>
+	/// Pass-through function allowing an existing <see cref="linq::query"/> to be used wherever a query source is expected.
+	/// </summary>
+	template<class _Enum>
+	inline query<_Enum> lazy(const query<_Enum> &q) { return q; }
+
+	/// <summary>
+	/// Windows over a sequence, created by <see cref="query::window"/> or <see cref="array::window"/>, waiting for the
+	/// aggregate to compute over each of them. Every aggregate is updated as elements enter and leave the window, at O(1)
+	/// amortized cost per element however large the windows are: sums keep a running total, the smallest and largest values
+	/// a monotonic queue, and any other associative operation two stacks. Windows over a count of elements produce one value
+	/// per window; windows of time produce a <see cref="window_result"/>, which also holds the window's start and count.
+	/// </summary>
+	/// <typeparam name="_Enum">Enumerator of the windowed elements.</typeparam>
+	/// <typeparam name="_Frame">The shape of the windows: <see cref="core::count_frame"/> or <see cref="core::time_frame"/>.</typeparam>
+	/// <typeparam name="_Eager">
+	/// Whether the aggregates evaluate into a <see cref="linq::array"/> at once, as for an array; otherwise they extend a
+	/// lazy query which streams the windows without ever materializing one.
+	/// </typeparam>
+	template<class _Enum, class _Frame, bool _Eager>
+	class windowed {
+		typedef typename _Enum::reference reference;
+		typedef typename _Enum::value_type value_type;
+		template<class _Fn>
+		using selected_t = ::std::decay_t<core::invoke_result_t<_Fn&, reference>>;
+	public:
+		windowed(_Enum _Source, _Frame _Shape, ::std::size_t _Count) : _source(::std::move(_Source)), _frame(::std::move(_Shape)), _count(_Count) {}
+
+		/// <summary>Sums the items of each window. Floating point items are never subtracted, so no rounding error builds up as the window moves.</summary>
+		inline auto sum() const { return sum([](reference item) -> value_type { return item; }); }
+		/// <summary>Sums a value selected from each item of each window.</summary>
+		/// <param name="selector">Lambda which selects the value to be summed from each item.</param>
+		template<class _Fn>
+		inline auto sum(_Fn &&selector) const { return _run(::std::forward<_Fn>(selector), core::window_sum_t<selected_t<_Fn>>()); }
+
+		/// <summary>Finds the smallest item of each window. A floating point NaN is the result of every window holding one.</summary>
+		inline auto min() const { return min([](reference item) -> value_type { return item; }); }
+		/// <summary>Finds the smallest value selected from the items of each window.</summary>
+		/// <param name="selector">Lambda which selects the value to be compared from each item.</param>
+		template<class _Fn>
+		inline auto min(_Fn &&selector) const { return _run(::std::forward<_Fn>(selector), core::window_extreme<selected_t<_Fn>, core::less<>>()); }
+		/// <summary>Finds the largest item of each window. A floating point NaN is the result of every window holding one.</summary>
+		inline auto max() const { return max([](reference item) -> value_type { return item; }); }
+		/// <summary>Finds the largest value selected from the items of each window.</summary>
+		/// <param name="selector">Lambda which selects the value to be compared from each item.</param>
+		template<class _Fn>
+		inline auto max(_Fn &&selector) const { return _run(::std::forward<_Fn>(selector), core::window_extreme<selected_t<_Fn>, core::more<>>()); }
+
+		/// <summary>Averages the items of each window. Integers are summed as 64-bit integers and averaged as a double.</summary>
+		inline auto average() const { return average([](reference item) -> value_type { return item; }); }
+		/// <summary>Averages a value selected from each item of each window.</summary>
+		/// <param name="selector">Lambda which selects the value to be averaged from each item.</param>
+		template<class _Fn>
+		inline auto average(_Fn &&selector) const { return _run(::std::forward<_Fn>(selector), core::window_mean<selected_t<_Fn>>()); }
+
+		/// <summary>
+		/// Combines the items of each window with an associative operation, such as a product, a bitwise or, or the merge of
+		/// two partial statistics. The operation need not have an inverse.
+		/// </summary>
+		/// <param name="op">Lambda of the form <c>value_type(const value_type &amp;older, const value_type &amp;newer)</c>.</param>
+		template<class _Op>
+		inline auto aggregate(_Op &&op) const { return aggregate([](reference item) -> value_type { return item; }, ::std::forward<_Op>(op)); }
+		/// <summary>Combines a value selected from each item of each window with an associative operation. See <see cref="aggregate"/>.</summary>
+		/// <param name="selector">Lambda which selects the value to be combined from each item.</param>
+		/// <param name="op">Lambda combining an older value on the left with a newer one on the right.</param>
+		template<class _Fn, class _Op>
+		inline auto aggregate(_Fn &&selector, _Op &&op) const {
+			return _run(::std::forward<_Fn>(selector), core::window_fold<selected_t<_Fn>, ::std::decay_t<_Op>>(::std::forward<_Op>(op)));
+		}
+
+	private:
+		template<class _Fn, class _Agg>
+		inline auto _run(_Fn &&selector, _Agg aggregator) const {
+			typedef typename _Frame::template enumerator<_Enum, ::std::decay_t<_Fn>, _Agg> windows;
+			return _finish(windows(_source, _frame, ::std::forward<_Fn>(selector), ::std::move(aggregator)), ::std::integral_constant<bool, _Eager>());
+		}
+		template<class _Windows>
+		inline query<_Windows> _finish(_Windows windows, ::std::false_type) const { return query<_Windows>(::std::move(windows)); }
+		template<class _Windows>
+		array<typename _Windows::value_type> _finish(_Windows windows, ::std::true_type) const {
+			core::stage_scope stage("window", _count);
+			array<typename _Windows::value_type> result;
+			result.reserve(_frame.windows(_count));
+			while (windows.move_next()) {
+				result.emplace_back(windows.current());
+			}
+			stage.output(result.size());
+			return result;
+		}
+
+		_Enum _source;
+		_Frame _frame;
+		::std::size_t _count;
+	};
+
+	/// <summary>
+	/// Non-owning view over a contiguous run of elements living elsewhere, such as a C-style array, a shared memory segment,
+	/// a network buffer or a <see cref="mapped_file"/>. A view is a <see cref="linq::query"/>, so every query operator
+	/// is available on it, and nothing is copied until a terminal materializes the results. It can also be joined against
+	/// like any other random access container. The viewed memory must outlive the view and any query built from it.
+	/// </summary>
+	/// <typeparam name="_Ty">Type of the viewed elements.</typeparam>
+	template<class _Ty>
+	class view : public query<core::range_enumerator<const _Ty*>> {
+		typedef core::range_enumerator<const _Ty*> _Range;
+		typedef query<_Range> base;
+	public:
+		typedef _Ty value_type;
+		typedef const _Ty& reference;
+		typedef const _Ty& const_reference;
+		typedef const _Ty* pointer;
+		typedef const _Ty* iterator;
+		typedef const _Ty* const_iterator;
+		typedef ::std::size_t size_type;
+
+		view() : base(_Range(nullptr, nullptr)), _data(nullptr), _size(0) {}
+		view(const _Ty *_Data, ::std::size_t _Size) : base(_Range(_Data, _Data + _Size)), _data(_Data), _size(_Size) {}
+		view(const _Ty *_First, const _Ty *_Last) : base(_Range(_First, _Last)), _data(_First), _size(static_cast<::std::size_t>(_Last - _First)) {}
+		/// <summary>Views the elements of any contiguous container providing data() and size(), such as a <see cref="std::vector"/>.</summary>
+		template<class _Cont, class = ::std::enable_if_t<::std::is_convertible<decltype(::std::declval<const _Cont&>().data()), const _Ty*>::value>>
+		view(const _Cont &_Src) : view(_Src.data(), _Src.size()) {}
+
+		inline iterator begin() const { return _data; }
+		inline iterator end() const { return _data + _size; }
+		inline pointer data() const { return _data; }
+		inline ::std::size_t size() const { return _size; }
+		inline bool empty() const { return _size == 0; }
+		inline reference operator[](::std::size_t index) const { return _data[index]; }
+		inline reference front() const { return _data[0]; }
+		inline reference back() const { return _data[_size - 1]; }
+
+		/// <summary>
+		/// Narrows the view to a part of the viewed elements.
+		/// </summary>
+		/// <param name="offset">Index of the first element of the new view.</param>
+		/// <param name="count">Maximum number of elements in the new view.</param>
+		/// <returns>View over the elements [offset, offset + count), clamped to the end of this view.</returns>
+		inline view subview(::std::size_t offset, ::std::size_t count = ~::std::size_t(0)) const {
+			offset = ::std::min(offset, _size);
+			return view(_data + offset, ::std::min(count, _size - offset));
+		}
+
+	protected:
+		/// <summary>Points this view at a new run of elements.</summary>
+		inline void reset(const _Ty *_Data, ::std::size_t _Size) {
+			static_cast<base&>(*this) = base(_Range(_Data, _Data + _Size));
+			_data = _Data;
+			_size = _Size;
+		}
+
+	private:
+		const _Ty *_data;
+		::std::size_t _size;
+	};
+
+	/// <summary>
+	/// Creates a non-owning <see cref="linq::view"/> over a C-style array. Nothing is copied.
+	/// </summary>
+	/// <param name="c_arr">The pointer to a C-Style array to be viewed.</param>
+	/// <param name="size">The size of the C-Style array.</param>
+	/// <returns><see cref="linq::view"/> over the elements of the provided <paramref name="c_arr"/>.</returns>
+	template<class _Ty>
+	inline view<_Ty> view_of(const _Ty *c_arr, const size_t &size) { return view<_Ty>(c_arr, size); }
+	/// <summary>
+	/// Creates a non-owning <see cref="linq::view"/> over a C-style array of known size. Nothing is copied.
+	/// </summary>
+	template<class _Ty, ::std::size_t _Size>
+	inline view<_Ty> view_of(const _Ty(&c_arr)[_Size]) { return view<_Ty>(c_arr, _Size); }
+	/// <summary>
+	/// Creates a non-owning <see cref="linq::view"/> over a contiguous container providing data() and size(). Nothing is copied.
+	/// </summary>
+	/// <param name="cont">The container to be viewed, which must outlive the view.</param>
+	template<class _Cont>
+	inline auto view_of(const _Cont &cont) -> view<::std::remove_cv_t<::std::remove_pointer_t<decltype(cont.data())>>> {
+		return { cont.data(), cont.size() };
+	}
+	/// <summary>Viewing a temporary container would leave the view dangling.</summary>
+	template<class _Cont, class = ::std::enable_if_t<!::std::is_lvalue_reference<_Cont>::value>>
+	void view_of(_Cont &&cont) = delete;
+
+	/*** Compile-time queries ***
+	 * A fixed_array holds up to _Cap items inline, without an allocator, and every one of its operators is constexpr. Over a
+	 * constexpr table, created with linq::fixed from a C-style array or a std::array, a query can therefore be evaluated
+	 * entirely by the compiler and its result stored in read-only data. The same queries also run at runtime, without any
+	 * heap allocation. The items must be literal types to be evaluated at compile time, and the lambdas given to the
+	 * operators must be constexpr: function objects with a constexpr call operator in C++14, or lambdas from C++17 on.
+	 * An operator which would throw, such as first without a match, makes the evaluation fail to compile instead.
+	 */
+
+	/// <summary>
+	/// List of up to <typeparamref name="_Cap"/> items stored inline, whose operators can all be evaluated at compile time.
+	/// Filtering keeps the capacity, so the result of a query over a table of N items is a fixed_array of capacity N.
+	/// </summary>
+	/// <typeparam name="_Ty">Type of the items, which must be default constructible.</typeparam>
+	/// <typeparam name="_Cap">Maximum number of items.</typeparam>
+	template<class _Ty, ::std::size_t _Cap>
+	class fixed_array {
+	public:
+		typedef _Ty value_type;
+		typedef const _Ty* const_iterator;
+
+		constexpr fixed_array() : _items{}, _size(0) {}
+		/// <summary>Copies the first <paramref name="count"/> items of <paramref name="source"/>, a pointer or an indexable container, up to the capacity.</summary>
+		template<class _Src>
+		constexpr fixed_array(const _Src &source, ::std::size_t count) : _items{}, _size(0) {
+			for (; _size < count && _size < _Cap; ++_size) {
+				_items[_size] = source[_size];
+			}
+		}
+
+		constexpr ::std::size_t size() const { return _size; }
+		static constexpr ::std::size_t capacity() { return _Cap; }
+		constexpr bool empty() const { return _size == 0; }
+		constexpr const _Ty& operator[](::std::size_t index) const { return _items[index]; }
+		constexpr const _Ty* data() const { return _items; }
+		constexpr const _Ty* begin() const { return _items; }
+		constexpr const _Ty* end() const { return _items + _size; }
+		constexpr const _Ty& front() const { return _items[0]; }
+		constexpr const _Ty& back() const { return _items[_size - 1]; }
+
+		/// <summary>Appends an item. Throws <see cref="std::logic_error"/> if the list is full.</summary>
+		/// <exception cref="std::logic_error">Thrown if the list already holds <typeparamref name="_Cap"/> items.</exception>
+		constexpr void push_back(const _Ty &value) {
+			if (_size == _Cap) {
+				core::throw_full();
+			}
+			_items[_size++] = value;
+		}
+
+		/// <summary>Creates a new list of the items which satisfy the provided condition, in order.</summary>
+		/// <param name="condition">The lambda which determines if an item is to be kept.</param>
+		template<class _Pr>
+		constexpr fixed_array where(const _Pr &condition) const {
+			fixed_array result;
+			for (::std::size_t c = 0; c < _size; c++) {
+				if (condition(_items[c])) {
+					result._items[result._size++] = _items[c];
+				}
+			}
+			return result;
+		}
+		/// <summary>Creates a new list of the transformation of each item.</summary>
+		/// <param name="selector">Lambda which defines how each item is transformed.</param>
+		template<class _Fn>
+		constexpr auto select(const _Fn &selector) const {
+			fixed_array<::std::decay_t<core::invoke_result_t<const _Fn&, const _Ty&>>, _Cap> result;
+			for (::std::size_t c = 0; c < _size; c++) {
+				result.push_back(selector(_items[c]));
+			}
+			return result;
+		}
+		/// <summary>
+		/// Creates a sorted copy of the list. The sort is a stable bottom-up merge sort, so items which are equal by the
+		/// predicate keep their order.
+		/// </summary>
+		/// <param name="pred">Predicate used to determine if the left item should go before the right, such as <see cref="linq::ascending"/>.</param>
+		template<class _Pr>
+		constexpr fixed_array orderby(const _Pr &pred) const {
+			fixed_array result = *this, buffer;
+			fixed_array *src = &result, *dst = &buffer;
+			for (::std::size_t width = 1; width < _size; width *= 2) {
+				for (::std::size_t low = 0; low < _size; low += width * 2) {
+					const ::std::size_t mid = _size - low < width ? _size : low + width, high = _size - mid < width ? _size : mid + width;
+					::std::size_t l = low, r = mid, out = low;
+					while (l < mid && r < high) {
+						dst->_items[out++] = pred(src->_items[r], src->_items[l]) ? src->_items[r++] : src->_items[l++];
+					}
+					while (l < mid) dst->_items[out++] = src->_items[l++];
+					while (r < high) dst->_items[out++] = src->_items[r++];
+				}
+				fixed_array *merged = dst;
+				dst = src;
+				src = merged;
+			}
+			src->_size = _size;
+			return *src;
+		}
+		/// <summary>Creates a new list of the first <paramref name="count"/> items.</summary>
+		constexpr fixed_array take(::std::size_t count) const { return fixed_array(begin(), count < _size ? count : _size); }
+		/// <summary>Creates a new list without the first <paramref name="count"/> items.</summary>
+		constexpr fixed_array skip(::std::size_t count) const { return count < _size ? fixed_array(begin() + count, _size - count) : fixed_array(); }
+
+
+		/// <summary>Searches for the position of the first item which satisfies the provided condition.</summary>
+		/// <returns>Zero based position of the item; otherwise <see cref="linq::npos"/>.</returns>
+		template<class _Pr>
+		constexpr ::std::size_t index_of(const _Pr &condition) const {
+			for (::std::size_t c = 0; c < _size; c++) {
+				if (condition(_items[c])) {
+					return c;
+				}
+			}
+			return npos;
+		}
+		/// <summary>
+		/// Searches for the first item which satisfies the provided condition. Throws <see cref="std::logic_error"/>, or
+		/// fails to compile when evaluated at compile time, if the condition is never satisfied.
+		/// </summary>
+		/// <exception cref="std::logic_error">Thrown if no items satisfy the condition.</exception>
+		template<class _Pr>
+		constexpr const _Ty& first(const _Pr &condition) const {
+			const ::std::size_t found = index_of(condition);
+			if (found == npos) {
+				core::throw_no_match();
+			}
+			return _items[found];
+		}
+		/// <summary>Searches for the first item which satisfies the provided condition, returning <paramref name="defaultValue"/> if there is none.</summary>
+		template<class _Pr>
+		constexpr _Ty first_or_default(const _Ty &defaultValue, const _Pr &condition) const {
+			const ::std::size_t found = index_of(condition);
+			return found == npos ? defaultValue : _items[found];
+		}
+		/// <summary>Checks whether any item equals the provided value.</summary>
+		constexpr bool contains(const _Ty &value) const {
+			for (::std::size_t c = 0; c < _size; c++) {
+				if (_items[c] == value) {
+					return true;
+				}
+			}
+			return false;
+		}
+		/// <summary>Checks whether any item satisfies the provided condition.</summary>
+		template<class _Pr>
+		constexpr bool any(const _Pr &condition) const { return index_of(condition) != npos; }
+		/// <summary>Checks whether every item satisfies the provided condition.</summary>
+		template<class _Pr>
+		constexpr bool all(const _Pr &condition) const {
+			for (::std::size_t c = 0; c < _size; c++) {
+				if (!condition(_items[c])) {
+					return false;
+				}
+			}
+			return true;
+		}
+		/// <summary>Counts the items which satisfy the provided condition.</summary>
+		template<class _Pr>
+		constexpr ::std::size_t count(const _Pr &condition) const {
+			::std::size_t total = 0;
+			for (::std::size_t c = 0; c < _size; c++) {
+				total += condition(_items[c]) ? 1 : 0;
+			}
+			return total;
+		}
+
+		/// <summary>Folds each item into an accumulated value from the first item to the last.</summary>
+		/// <param name="seed">The initial accumulated value.</param>
+		/// <param name="fn">Lambda of the form <c>_Acc(_Acc accumulated, const _Ty &amp;item)</c> returning the next accumulated value.</param>
+		template<class _Acc, class _Fn>
+		constexpr _Acc aggregate(_Acc seed, const _Fn &fn) const {
+			for (::std::size_t c = 0; c < _size; c++) {
+				seed = fn(seed, _items[c]);
+			}
+			return seed;
+		}
+		/// <summary>Sums the items; a default constructed value if there are none.</summary>
+		constexpr _Ty sum() const { return aggregate(_Ty(), core::plus()); }
+		/// <summary>Sums a value selected from each item; a default constructed value if there are none.</summary>
+		template<class _Fn>
+		constexpr auto sum(const _Fn &selector) const { return select(selector).sum(); }
+		/// <summary>Finds the smallest item. Throws <see cref="std::logic_error"/> if the list is empty.</summary>
+		constexpr _Ty min() const { return _extreme(core::less<>()); }
+		/// <summary>Finds the largest item. Throws <see cref="std::logic_error"/> if the list is empty.</summary>
+		constexpr _Ty max() const { return _extreme(core::more<>()); }
+		/// <summary>Averages the items. Integers are averaged as a double. Throws <see cref="std::logic_error"/> if the list is empty.</summary>
+		constexpr core::average_t<_Ty> average() const {
+			if (_size == 0) {
+				core::throw_empty();
+			}
+			return static_cast<core::average_t<_Ty>>(sum()) / static_cast<core::average_t<_Ty>>(_size);
+		}
+
+		/// <summary>
+		/// Copies the items into a <see cref="std::array"/> of exactly <typeparamref name="_Size"/> items, which is usually
+		/// the <see cref="size"/> of a constexpr result. Throws <see cref="std::logic_error"/> if the sizes differ.
+		/// </summary>
+		/// <example>constexpr auto codes = linq::fixed(table).where(is_error()); constexpr auto exact = codes.to_std_array&lt;codes.size()&gt;();</example>
+		template<::std::size_t _Size>
+		constexpr ::std::array<_Ty, _Size> to_std_array() const {
+			static_assert(_Size <= _Cap, "the std::array cannot be larger than the capacity of the fixed_array");
+			if (_Size != _size) {
+				core::throw_size_mismatch();
+			}
+			return _to_std_array(::std::make_index_sequence<_Size>());
+		}
+		/// <summary>Copies the items into a new <see cref="linq::array"/>. Not available at compile time.</summary>
+		inline array<_Ty> to_array() const { return array<_Ty>(begin(), end()); }
+		/// <summary>Starts a deferred <see cref="linq::query"/> over the items in place, for the operators not available on a fixed_array.</summary>
+		inline view<_Ty> lazy() const { return view<_Ty>(_items, _size); }
+
+		template<class _Ty2, ::std::size_t _Cap2>
+		friend class fixed_array;
+
+	private:
+		template<class _Pr>
+		constexpr _Ty _extreme(const _Pr &pred) const {
+			if (_size == 0) {
+				core::throw_empty();
+			}
+			_Ty found = _items[0];
+			for (::std::size_t c = 1; c < _size; c++) {
+				if (pred(_items[c], found)) {
+					found = _items[c];
+				}
+			}
+			return found;
+		}
+		template<::std::size_t... _I>
+		constexpr ::std::array<_Ty, sizeof...(_I)> _to_std_array(::std::index_sequence<_I...>) const { return {{ _items[_I]... }}; }
+
+		_Ty _items[_Cap ? _Cap : 1];
+		::std::size_t _size;
+	};
+
+	/// <summary>Creates a <see cref="fixed_array"/> holding a copy of a C-style array, usable in constant expressions.</summary>
+	/// <example>constexpr int codes[] = { 404, 500, 503 }; constexpr auto server = linq::fixed(codes).where(is_server_error());</example>
+	template<class _Ty, ::std::size_t _Size>
+	constexpr fixed_array<::std::remove_cv_t<_Ty>, _Size> fixed(const _Ty(&c_arr)[_Size]) { return { c_arr, _Size }; }
+	/// <summary>Creates a <see cref="fixed_array"/> holding a copy of a <see cref="std::array"/>, usable in constant expressions.</summary>
+	template<class _Ty, ::std::size_t _Size>
+	constexpr fixed_array<_Ty, _Size> fixed(const ::std::array<_Ty, _Size> &arr) { return { arr, _Size }; }
+
+
+	/// <summary>
+	/// Elements of one group of a <see cref="grouping"/>, viewed in place along with the key they share.
+	/// </summary>
+	/// <typeparam name="_Key">Type of the group key.</typeparam>
+	/// <typeparam name="_Ty">Type of the grouped elements.</typeparam>
+	template<class _Key, class _Ty>
+	class group : public view<_Ty> {
+	public:
+		group(const _Key &_GroupKey, const _Ty *_Data, ::std::size_t _Size) : view<_Ty>(_Data, _Size), _key(&_GroupKey) {}
+
+		/// <summary>The key shared by every element of the group.</summary>
+		inline const _Key& key() const { return *_key; }
+
+	private:
+		const _Key *_key;
+	};
+
+	/// <summary>
+	/// Elements of a list grouped by key, created by <see cref="array::groupby"/>. The elements of all of the groups are
+	/// held in one contiguous array, group after group, so a grouping costs a handful of allocations however many groups
+	/// it has, and each <see cref="group"/> is a view over its run of that array. The groups are in the order their keys
+	/// were first found, unless the keys were sorted, and the elements of each group keep their original order.
+	/// </summary>
+	/// <typeparam name="_Key">Type of the group key.</typeparam>
+	/// <typeparam name="_Ty">Type of the grouped elements.</typeparam>
+	template<class _Key, class _Ty>
+	class grouping {
+	public:
+		typedef _Key key_type;
+		typedef group<_Key, _Ty> value_type;
+		typedef ::std::size_t size_type;
+
+		class iterator {
+		public:
+			typedef ::std::random_access_iterator_tag iterator_category;
+			typedef typename grouping::value_type value_type;
+			typedef value_type reference;
+			typedef ::std::ptrdiff_t difference_type;
+			typedef void pointer;
+
+			iterator() : _owner(nullptr), _index(0) {}
+			iterator(const grouping *owner, ::std::size_t index) : _owner(owner), _index(index) {}
+			inline reference operator*() const { return (*_owner)[_index]; }
+			inline reference operator[](difference_type offset) const { return (*_owner)[_index + offset]; }
+			inline iterator& operator++() { ++_index; return *this; }
+			inline iterator operator++(int) { iterator tmp = *this; ++_index; return tmp; }
+			inline iterator& operator--() { --_index; return *this; }
+			inline iterator operator--(int) { iterator tmp = *this; --_index; return tmp; }
+			inline iterator& operator+=(difference_type offset) { _index += offset; return *this; }
+			inline iterator& operator-=(difference_type offset) { _index -= offset; return *this; }
+			inline iterator operator+(difference_type offset) const { return iterator(_owner, _index + offset); }
+			inline iterator operator-(difference_type offset) const { return iterator(_owner, _index - offset); }
+			inline difference_type operator-(const iterator &_Right) const { return static_cast<difference_type>(_index) - static_cast<difference_type>(_Right._index); }
+			inline bool operator==(const iterator &_Right) const { return _index == _Right._index; }
+			inline bool operator!=(const iterator &_Right) const { return _index != _Right._index; }
+			inline bool operator<(const iterator &_Right) const { return _index < _Right._index; }
+		private:
+			const grouping *_owner;
+			::std::size_t _index;
+		};
+		typedef iterator const_iterator;
+
+		grouping() : _offsets(1, 0) {}
+
+		inline iterator begin() const { return iterator(this, 0); }
+		inline iterator end() const { return iterator(this, size()); }
+		/// <summary>Number of groups.</summary>
+		inline ::std::size_t size() const { return _offsets.size() - 1; }
+		inline bool empty() const { return size() == 0; }
+		inline value_type operator[](::std::size_t index) const {
+			return value_type(_table.keys()[index], _items.data() + _offsets[index], _offsets[index + 1] - _offsets[index]);
+		}
+
+		/// <summary>Finds the group with the provided key.</summary>
+		/// <returns>Iterator to the group; otherwise <see cref="end"/>.</returns>
+		inline iterator find(const _Key &key) const {
+			::std::size_t index = _table.find(key);
+			return index == core::group_table<_Key>::npos ? end() : begin() + static_cast<::std::ptrdiff_t>(index);
+		}
+		/// <summary>Checks whether there is a group with the provided key.</summary>
+		inline bool contains(const _Key &key) const { return _table.find(key) != core::group_table<_Key>::npos; }
+		/// <summary>
+		/// Finds the group with the provided key. Throws <see cref="std::logic_error"/> if there is none.
+		/// </summary>
+		/// <exception cref="std::logic_error">Thrown if no group has the key.</exception>
+		value_type at(const _Key &key) const {
+			::std::size_t index = _table.find(key);
+			if (index == core::group_table<_Key>::npos) {
+				throw ::std::logic_error("no group has the given key");
+			}
+			return (*this)[index];
+		}
+		/// <summary>The key of every group, in the order of the groups.</summary>
+		inline const ::std::vector<_Key>& keys() const { return _table.keys(); }
+		/// <summary>Every grouped element, group after group.</summary>
+		inline view<_Ty> items() const { return view<_Ty>(_items.data(), _items.size()); }
+
+	private:
+		template<class _Ty2, class _Alloc>
+		friend class array;
+
+		core::group_table<_Key> _table;
+		::std::vector<_Ty> _items;
+		::std::vector<::std::size_t> _offsets;
+	};
+
+	template<class _Row, class... _Fields>
+	class column_selection;
+
+	namespace core {
+		/// <summary>
+		/// Enumerates the values of one column at the rows listed in a selection vector, in the order of the selection.
+		/// </summary>
+		/// <typeparam name="_Ty">Type of the values in the column.</typeparam>
+		template<class _Ty>
+		class gather_enumerator {
+		public:
+			typedef const _Ty& reference;
+			typedef _Ty value_type;
+
+			gather_enumerator(const _Ty *values, const ::std::size_t *first, const ::std::size_t *last) : _values(values), _cur(first), _next(first), _last(last) {}
+
+			inline bool move_next() {
+				if (_next == _last) return false;
+				_cur = _next++;
+				return true;
+			}
+			inline reference current() const { return _values[*_cur]; }
+			inline ::std::size_t size_hint() const { return static_cast<::std::size_t>(_last - _next); }
+
+		private:
+			const _Ty *_values;
+			const ::std::size_t *_cur, *_next, *_last;
+		};
+
+		/// <summary>Key selector reading the key of a row from its column, so that a selection vector can be sorted on it.</summary>
+		template<class _Field>
+		struct column_key {
+			const _Field *values;
+			inline const _Field& operator()(::std::size_t row) const { return values[row]; }
+		};
+	}
+
+	/// <summary>
+	/// Rows stored column by column (a struct of arrays): each listed member of the row type is kept in its own contiguous
+	/// <see cref="linq::array"/>. A filter or sort on one member only reads that member's column, instead of pulling whole
+	/// rows through the cache. The operators produce a <see cref="column_selection"/>, which lists the positions of the
+	/// selected rows, and rows are only put back together by the terminals which need them. Columns are named by member
+	/// pointer, as in <c>where(&amp;employee::proj_id, linq::item == 2)</c>.
+	/// </summary>
+	/// <typeparam name="_Row">The row type. Must be default constructible for rows to be put back together.</typeparam>
+	/// <typeparam name="_Fields">Type of each stored member, in the order of the member pointers.</typeparam>
+	template<class _Row, class... _Fields>
+	class columns {
+		static_assert(sizeof...(_Fields) > 0, "columns must store at least one member");
+	public:
+		typedef _Row value_type;
+		typedef column_selection<_Row, _Fields...> selection_type;
+
+		/// <summary>Creates empty columns for the provided members of the row type.</summary>
+		explicit columns(_Fields _Row::*...members) : _members(members...) {}
+		/// <summary>Stores the rows of a container or C-style array, splitting each one into the provided members.</summary>
+		template<class _Cont>
+		columns(const _Cont &rows, _Fields _Row::*...members) : _members(members...) {
+			reserve(core::distance_hint(::std::begin(rows), ::std::end(rows)));
+			for (const _Row &item : rows) {
+				push_back(item);
+			}
+		}
+
+		inline ::std::size_t size() const { return ::std::get<0>(_columns).size(); }
+		inline bool empty() const { return size() == 0; }
+		/// <summary>Makes room in every column for <paramref name="count"/> rows.</summary>
+		void reserve(::std::size_t count) { _reserve(count, ::std::index_sequence_for<_Fields...>()); }
+		/// <summary>Removes every row.</summary>
+		void clear() { _clear(::std::index_sequence_for<_Fields...>()); }
+		/// <summary>Appends a row, copying each stored member into its column.</summary>
+		void push_back(const _Row &item) { _push_back(item, ::std::index_sequence_for<_Fields...>()); }
+
+		/// <summary>
+		/// The column holding the provided member. Throws <see cref="std::logic_error"/> if the member is not stored.
+		/// </summary>
+		/// <exception cref="std::logic_error">Thrown if the member is not one of the columns.</exception>
+		template<class _Field>
+		inline const array<_Field>& column(_Field _Row::*member) const {
+			static_assert(!core::all_of({ !::std::is_same<_Fields, _Field>::value... }), "no column has the type of the member");
+			return *_find<0>(member);
+		}
+		/// <summary>The column at the provided position in the list of members.</summary>
+		template<::std::size_t _I>
+		inline const auto& column() const { return ::std::get<_I>(_columns); }
+		/// <summary>Puts the row at the provided position back together. Members which are not stored are value initialized.</summary>
+		_Row row(::std::size_t index) const {
+			_Row item{};
+			_assign(item, index, ::std::index_sequence_for<_Fields...>());
+			return item;
+		}
+
+		/// <summary>Selects every row, in order.</summary>
+		selection_type all() const {
+			::std::vector<::std::size_t> rows(size());
+			for (::std::size_t r = 0; r < rows.size(); r++) {
+				rows[r] = r;
+			}
+			return selection_type(*this, ::std::move(rows));
+		}
+		/// <summary>
+		/// Selects the rows whose member satisfies the condition, reading only the column of that member. Structured conditions
+		/// built with <see cref="linq::item"/> work as well as lambdas.
+		/// </summary>
+		/// <param name="member">The member tested.</param>
+		/// <param name="condition">Lambda given the value of the member, which determines if the row is selected.</param>
+		/// <returns>Selection of the matching rows, in order.</returns>
+		template<class _Field, class _Pr>
+		selection_type where(_Field _Row::*member, _Pr &&condition) const {
+			const array<_Field> &values = column(member);
+			core::stage_scope stage("where", values.size());
+			stage.calls(values.size());
+			::std::vector<::std::size_t> rows(values.size());
+			::std::size_t kept = 0;
+			for (::std::size_t r = 0; r < values.size(); r++) {
+				rows[kept] = r;
+				kept += condition(values[r]) ? 1 : 0;
+			}
+			rows.resize(kept);
+			stage.output(kept);
+			return selection_type(*this, ::std::move(rows));
+		}
+		/// <summary>Selects every row, sorted on the keys of the provided members. See <see cref="column_selection::orderby"/>.</summary>
+		template<class _Field, bool _Descending, class... _More>
+		inline selection_type orderby(const core::key_order<_Field _Row::*, _Descending> &order, const _More &...more) const {
+			return all().orderby(order, more...);
+		}
+		/// <summary>Selects the first <paramref name="count"/> rows.</summary>
+		inline selection_type take(::std::size_t count) const { return all().take(count); }
+		/// <summary>Selects the rows after the first <paramref name="count"/>.</summary>
+		inline selection_type skip(::std::size_t count) const { return all().skip(count); }
+
+		/// <summary>Copies the column of the provided member.</summary>
+		template<class _Field>
+		inline array<_Field> select(_Field _Row::*member) const { return column(member); }
+		/// <summary>Transforms every row. See <see cref="column_selection::select"/>.</summary>
+		template<class _Fn, class... _Used>
+		inline auto select(_Fn &&selector, _Used _Row::*...members) const { return all().select(::std::forward<_Fn>(selector), members...); }
+		/// <summary>Joins every row with the rows of other columns on equal keys. See <see cref="column_selection::join"/>.</summary>
+		template<class _Other, class _Key, class _Key2, class _Row2, class _Merge>
+		inline auto join(const _Other &other, _Key _Row::*left_key, _Key2 _Row2::*right_key, _Merge &&merge) const {
+			return all().join(other, left_key, right_key, ::std::forward<_Merge>(merge));
+		}
+
+		/// <summary>Sums the column of the provided member, with the vector instructions of <see cref="array::sum"/>.</summary>
+		template<class _Field>
+		inline _Field sum(_Field _Row::*member) const { return column(member).sum(); }
+		/// <summary>Finds the smallest value of the member. Throws <see cref="std::logic_error"/> if there are no rows.</summary>
+		template<class _Field>
+		inline _Field min(_Field _Row::*member) const { return column(member).min(); }
+		/// <summary>Finds the largest value of the member. Throws <see cref="std::logic_error"/> if there are no rows.</summary>
+		template<class _Field>
+		inline _Field max(_Field _Row::*member) const { return column(member).max(); }
+		/// <summary>Averages the member over every row. Throws <see cref="std::logic_error"/> if there are no rows.</summary>
+		template<class _Field>
+		inline core::average_t<_Field> average(_Field _Row::*member) const { return column(member).average(); }
+
+		/// <summary>Puts every row back together into a new <see cref="linq::array"/>.</summary>
+		array<_Row> to_array() const {
+			array<_Row> result(size());
+			_materialize(result.data(), nullptr, size(), ::std::index_sequence_for<_Fields...>());
+			return result;
+		}
+
+	private:
+		friend class column_selection<_Row, _Fields...>;
+
+		template<::std::size_t... _I>
+		void _reserve(::std::size_t count, ::std::index_sequence<_I...>) {
+			int expand[] = { (::std::get<_I>(_columns).reserve(count), 0)... };
+			(void)expand;
+		}
+		template<::std::size_t... _I>
+		void _clear(::std::index_sequence<_I...>) {
+			int expand[] = { (::std::get<_I>(_columns).clear(), 0)... };
+			(void)expand;
+		}
+		template<::std::size_t... _I>
+		void _push_back(const _Row &item, ::std::index_sequence<_I...>) {
+			int expand[] = { (::std::get<_I>(_columns).push_back(item.*::std::get<_I>(_members)), 0)... };
+			(void)expand;
+		}
+		template<::std::size_t... _I>
+		void _assign(_Row &item, ::std::size_t index, ::std::index_sequence<_I...>) const {
+			int expand[] = { (item.*::std::get<_I>(_members) = ::std::get<_I>(_columns)[index], 0)... };
+			(void)expand;
+		}
+		/// <summary>
+		/// Writes the members of <paramref name="count"/> rows into <paramref name="out"/> one column at a time, reading the
+		/// rows listed in <paramref name="rows"/>, or the first rows in order when it is null.
+		/// </summary>
+		template<::std::size_t... _I>
+		void _materialize(_Row *out, const ::std::size_t *rows, ::std::size_t count, ::std::index_sequence<_I...>) const {
+			int expand[] = { (_materialize(out, rows, count, ::std::get<_I>(_members), ::std::get<_I>(_columns)), 0)... };
+			(void)expand;
+		}
+		template<class _Field>
+		static void _materialize(_Row *out, const ::std::size_t *rows, ::std::size_t count, _Field _Row::*member, const array<_Field> &values) {
+			for (::std::size_t c = 0; c < count; c++) {
+				out[c].*member = values[rows ? rows[c] : c];
+			}
+		}
+
+		template<::std::size_t _I, class _Field>
+		inline ::std::enable_if_t<(_I == sizeof...(_Fields)), const array<_Field>*> _find(_Field _Row::*) const {
+			throw ::std::logic_error("the member is not stored in the columns");
+		}
+		template<::std::size_t _I, class _Field>
+		inline ::std::enable_if_t<(_I < sizeof...(_Fields)), const array<_Field>*> _find(_Field _Row::*member) const {
+			return _match<_I>(member, ::std::is_same<::std::tuple_element_t<_I, ::std::tuple<_Fields...>>, _Field>());
+		}
+		template<::std::size_t _I, class _Field>
+		inline const array<_Field>* _match(_Field _Row::*member, ::std::true_type) const {
+			return ::std::get<_I>(_members) == member ? &::std::get<_I>(_columns) : _find<_I + 1>(member);
+		}
+		template<::std::size_t _I, class _Field>
+		inline const array<_Field>* _match(_Field _Row::*member, ::std::false_type) const { return _find<_I + 1>(member); }
+
+		::std::tuple<_Fields _Row::*...> _members;
+		::std::tuple<array<_Fields>...> _columns;
+	};
+
+	/// <summary>
+	/// Rows of a <see cref="columns"/> chosen by its operators, held as a selection vector: the positions of the rows, in the
+	/// order they were selected or sorted into. Filtering, sorting and paging only rewrite the positions and read the columns
+	/// they are given; the terminals read just the columns they need, and <see cref="to_array"/> puts whole rows back together.
+	/// The columns must outlive the selection and must not be changed while it is in use.
+	/// </summary>
+	/// <typeparam name="_Row">The row type.</typeparam>
+	/// <typeparam name="_Fields">Type of each stored member.</typeparam>
+	template<class _Row, class... _Fields>
+	class column_selection {
+	public:
+		typedef _Row value_type;
+		typedef columns<_Row, _Fields...> source_type;
+
+		column_selection(const source_type &source, ::std::vector<::std::size_t> rows) : _source(&source), _rows(::std::move(rows)) {}
+
+		inline ::std::size_t size() const { return _rows.size(); }
+		inline bool empty() const { return _rows.empty(); }
+		/// <summary>Position in the columns of every selected row, in order.</summary>
+		inline const ::std::vector<::std::size_t>& rows() const { return _rows; }
+		/// <summary>The columns the rows were selected from.</summary>
+		inline const source_type& source() const { return *_source; }
+		/// <summary>Puts the selected row at the provided index back together.</summary>
+		inline _Row row(::std::size_t index) const { return _source->row(_rows[index]); }
+
+		/// <summary>
+		/// Narrows the selection to the rows whose member satisfies the condition, reading only the selected values of its column.
+		/// </summary>
+		/// <param name="member">The member tested.</param>
+		/// <param name="condition">Lambda given the value of the member, which determines if the row is kept.</param>
+		/// <returns>The narrowed selection, in the same order.</returns>
+		template<class _Field, class _Pr>
+		inline column_selection where(_Field _Row::*member, _Pr &&condition) const & { return column_selection(*this).where(member, condition); }
+		/// <summary>Narrows this temporary selection in place. See <see cref="where"/>.</summary>
+		template<class _Field, class _Pr>
+		column_selection where(_Field _Row::*member, _Pr &&condition) && {
+			const _Field *values = _source->column(member).data();
+			core::stage_scope stage("where", _rows.size());
+			stage.calls(_rows.size());
+			::std::size_t kept = 0;
+			for (::std::size_t r : _rows) {
+				_rows[kept] = r;
+				kept += condition(values[r]) ? 1 : 0;
+			}
+			_rows.resize(kept);
+			stage.output(kept);
+			return ::std::move(*this);
+		}
+		/// <summary>
+		/// Sorts the selection on the keys of one or more members, created with <see cref="linq::ascending"/> or
+		/// <see cref="linq::descending"/>, such as <c>orderby(linq::descending(&amp;row::score), linq::ascending(&amp;row::id))</c>.
+		/// Only the columns of the keys are read, and the sort is stable. Integral, float and double keys which fit in 64 bits
+		/// together are radix sorted, as in <see cref="array::orderby"/>.
+		/// </summary>
+		/// <returns>The sorted selection.</returns>
+		template<class _Field, bool _Descending, class... _More>
+		inline column_selection orderby(const core::key_order<_Field _Row::*, _Descending> &order, const _More &...more) const & {
+			return column_selection(*this).orderby(order, more...);
+		}
+		/// <summary>Sorts this temporary selection. See <see cref="orderby"/>.</summary>
+		template<class _Field, bool _Descending, class... _More>
+		column_selection orderby(const core::key_order<_Field _Row::*, _Descending> &order, const _More &...more) && {
+			core::stage_scope stage("orderby", _rows.size());
+			auto orders = ::std::make_tuple(_column_order(order), _column_order(more)...);
+			::std::vector<::std::size_t> sorted;
+			sorted.reserve(_rows.size());
+			core::sort_by_keys(_rows.data(), _rows.size(), orders, [&](::std::size_t position) { sorted.push_back(_rows[position]); });
+			_rows.swap(sorted);
+			stage.output(_rows.size());
+			return ::std::move(*this);
+		}
+		/// <summary>Keeps the first <paramref name="count"/> selected rows.</summary>
+		inline column_selection take(::std::size_t count) const & { return column_selection(*this).take(count); }
+		/// <summary>Keeps the first <paramref name="count"/> selected rows of this temporary selection.</summary>
+		column_selection take(::std::size_t count) && {
+			_rows.resize(::std::min(count, _rows.size()));
+			return ::std::move(*this);
+		}
+		/// <summary>Drops the first <paramref name="count"/> selected rows.</summary>
+		inline column_selection skip(::std::size_t count) const & { return column_selection(*this).skip(count); }
+		/// <summary>Drops the first <paramref name="count"/> selected rows of this temporary selection.</summary>
+		column_selection skip(::std::size_t count) && {
+			_rows.erase(_rows.begin(), _rows.begin() + ::std::min(count, _rows.size()));
+			return ::std::move(*this);
+		}
+
+		/// <summary>
+		/// Starts a lazy <see cref="linq::query"/> over the selected values of one member, so that every lazy operator and
+		/// terminal, such as sum, count or distinct, can be used on them. The selection must outlive the query.
+		/// </summary>
+		template<class _Field>
+		inline query<core::gather_enumerator<_Field>> values(_Field _Row::*member) const {
+			return query<core::gather_enumerator<_Field>>(core::gather_enumerator<_Field>(_source->column(member).data(), _rows.data(), _rows.data() + _rows.size()));
+		}
+		/// <summary>Copies the selected values of one member, reading nothing but its column.</summary>
+		template<class _Field>
+		array<_Field> select(_Field _Row::*member) const {
+			const array<_Field> &values = _source->column(member);
+			array<_Field> result;
+			result.reserve(_rows.size());
+			for (::std::size_t r : _rows) {
+				result.push_back(values[r]);
+			}
+			return result;
+		}
+		/// <summary>
+		/// Transforms the selected rows, handing the selector the values of the listed members only, as in
+		/// <c>select([](int id, const std::string &amp;name) { ... }, &amp;row::id, &amp;row::name)</c>.
+		/// </summary>
+		/// <param name="selector">Lambda given the values of the listed members of each row.</param>
+		/// <param name="member">The first member handed to the selector.</param>
+		/// <param name="more">The members handed to the selector after the first.</param>
+		/// <returns>The new array of transformed items.</returns>
+		template<class _Fn, class _Field, class... _More>
+		auto select(_Fn &&selector, _Field _Row::*member, _More _Row::*...more) const {
+			typedef ::std::decay_t<core::invoke_result_t<_Fn&, const _Field&, const _More&...>> result_type;
+			core::stage_scope stage("select", _rows.size());
+			stage.calls(_rows.size());
+			stage.output(_rows.size());
+			return _select<result_type>(selector, ::std::make_tuple(_source->column(member).data(), _source->column(more).data()...), ::std::index_sequence_for<_Field, _More...>());
+		}
+		/// <summary>Transforms the selected rows, putting each one back together for the selector.</summary>
+		/// <param name="selector">Lambda given each selected row.</param>
+		template<class _Fn, class = ::std::enable_if_t<!::std::is_member_pointer<::std::decay_t<_Fn>>::value>>
+		auto select(_Fn &&selector) const {
+			typedef ::std::decay_t<core::invoke_result_t<_Fn&, const _Row&>> result_type;
+			array<result_type> result;
+			result.reserve(_rows.size());
+			for (::std::size_t r : _rows) {
+				result.push_back(selector(static_cast<const _Row&>(_source->row(r))));
+			}
+			return result;
+		}
+
+		/// <summary>
+		/// Joins the selected rows with the rows of other columns, or of a selection of them, on equal keys. The keys of the
+		/// other rows are hashed and the keys of these rows are looked up, reading nothing but the two key columns; only the
+		/// pairs which match are put back together, in the order of these rows.
+		/// </summary>
+		/// <param name="other">The <see cref="columns"/> or <see cref="column_selection"/> to be joined with.</param>
+		/// <param name="left_key">The key member of these rows.</param>
+		/// <param name="right_key">The key member of the other rows.</param>
+		/// <param name="merge">Lambda given each matching pair of rows, which performs the merge.</param>
+		/// <returns>New array of merged items.</returns>
+		template<class _Row2, class... _Fields2, class _Key, class _Key2, class _Merge>
+		inline auto join(const columns<_Row2, _Fields2...> &other, _Key _Row::*left_key, _Key2 _Row2::*right_key, _Merge &&merge) const {
+			return join(other.all(), left_key, right_key, ::std::forward<_Merge>(merge));
+		}
+		template<class _Row2, class... _Fields2, class _Key, class _Key2, class _Merge>
+		auto join(const column_selection<_Row2, _Fields2...> &other, _Key _Row::*left_key, _Key2 _Row2::*right_key, _Merge &&merge) const {
+			typedef ::std::common_type_t<_Key, _Key2> key_type;
+			typedef ::std::decay_t<core::invoke_result_t<_Merge&, const _Row&, const _Row2&>> result_type;
+			core::stage_scope stage("join", _rows.size());
+			const array<_Key> &left = _source->column(left_key);
+			const array<_Key2> &right = other.source().column(right_key);
+			::std::vector<key_type> keys;
+			keys.reserve(other.size());
+			for (::std::size_t r : other.rows()) {
+				keys.emplace_back(right[r]);
+			}
+			core::hash_index<key_type> table;
+			table.build(::std::move(keys));
+			array<result_type> result;
+			for (::std::size_t l : _rows) {
+				::std::size_t found = table.find(left[l]);
+				if (found == core::hash_index<key_type>::npos) continue;
+				const _Row item = _source->row(l);
+				for (; found != core::hash_index<key_type>::npos; found = table.find_next(found)) {
+					result.push_back(merge(item, static_cast<const _Row2&>(other.row(found))));
+				}
+			}
+			stage.comparisons(_rows.size());
+			stage.calls(result.size());
+			stage.output(result.size());
+			return result;
+		}
+
+		/// <summary>Sums the selected values of the member.</summary>
+		template<class _Field>
+		inline _Field sum(_Field _Row::*member) const { return values(member).sum(); }
+		/// <summary>Finds the smallest selected value of the member. Throws <see cref="std::logic_error"/> if nothing is selected.</summary>
+		template<class _Field>
+		inline _Field min(_Field _Row::*member) const { return values(member).min(); }
+		/// <summary>Finds the largest selected value of the member. Throws <see cref="std::logic_error"/> if nothing is selected.</summary>
+		template<class _Field>
+		inline _Field max(_Field _Row::*member) const { return values(member).max(); }
+		/// <summary>Averages the selected values of the member. Throws <see cref="std::logic_error"/> if nothing is selected.</summary>
+		template<class _Field>
+		inline core::average_t<_Field> average(_Field _Row::*member) const { return values(member).average(); }
+
+		/// <summary>Puts the selected rows back together into a new <see cref="linq::array"/>, one column at a time.</summary>
+		array<_Row> to_array() const {
+			array<_Row> result(_rows.size());
+			_source->_materialize(result.data(), _rows.data(), _rows.size(), ::std::index_sequence_for<_Fields...>());
+			return result;
+		}
+
+	private:
+		template<class _Field, bool _Descending>
+		inline core::key_order<core::column_key<_Field>, _Descending> _column_order(const core::key_order<_Field _Row::*, _Descending> &order) const {
+			return { { _source->column(order.selector).data() } };
+		}
+		template<class _Ret, class _Fn, class _Columns, ::std::size_t... _I>
+		array<_Ret> _select(_Fn &selector, const _Columns &values, ::std::index_sequence<_I...>) const {
+			array<_Ret> result;
+			result.reserve(_rows.size());
+			for (::std::size_t r : _rows) {
+				result.push_back(selector(::std::get<_I>(values)[r]...));
+			}
+			return result;
+		}
+
+		const source_type *_source;
+		::std::vector<::std::size_t> _rows;
+	};
+
+	/// <summary>
+	/// Stores the rows of a container or C-style array as <see cref="linq::columns"/> of the provided members, such as
+	/// <c>linq::columns_of(employees, &amp;employee::id, &amp;employee::proj_id)</c>.
+	/// </summary>
+	/// <param name="rows">The rows to be stored.</param>
+	/// <param name="members">The members to be stored, one column each.</param>
+	template<class _Cont, class _Row, class... _Fields>
+	inline columns<_Row, _Fields...> columns_of(const _Cont &rows, _Fields _Row::*...members) { return columns<_Row, _Fields...>(rows, members...); }
+
+	/// <summary>
+	/// Items found through an index, read in place from the indexed list in the order the index holds them. A range is a
+	/// lazy <see cref="linq::query"/>, so every lazy operator and terminal is available on it, and it can be iterated and
+	/// indexed directly. It is only valid until its index is rebuilt or the list is changed.
+	/// </summary>
+	/// <typeparam name="_Ty">Type of the indexed items.</typeparam>
+	template<class _Ty>
+	class index_range : public query<core::gather_enumerator<_Ty>> {
+		typedef query<core::gather_enumerator<_Ty>> base;
+	public:
+		/// <summary>Forward iterator over the items of the range.</summary>
+		class iterator {
+		public:
+			typedef ::std::forward_iterator_tag iterator_category;
+			typedef _Ty value_type;
+			typedef ::std::ptrdiff_t difference_type;
+			typedef const _Ty* pointer;
+			typedef const _Ty& reference;
+
+			iterator(const _Ty *values, const ::std::size_t *position) : _values(values), _position(position) {}
+
+			inline reference operator*() const { return _values[*_position]; }
+			inline pointer operator->() const { return _values + *_position; }
+			inline iterator& operator++() { ++_position; return *this; }
+			inline iterator operator++(int) { iterator prev = *this; ++_position; return prev; }
+			inline bool operator==(const iterator &other) const { return _position == other._position; }
+			inline bool operator!=(const iterator &other) const { return _position != other._position; }
+
+		private:
+			const _Ty *_values;
+			const ::std::size_t *_position;
+		};
+		typedef iterator const_iterator;
+		typedef _Ty value_type;
+
+		index_range(const _Ty *values, const ::std::size_t *first, const ::std::size_t *last)
+			: base(core::gather_enumerator<_Ty>(values, first, last)), _values(values), _first(first), _last(last) {}
+
+		inline iterator begin() const { return iterator(_values, _first); }
+		inline iterator end() const { return iterator(_values, _last); }
+		inline ::std::size_t size() const { return static_cast<::std::size_t>(_last - _first); }
+		inline bool empty() const { return _first == _last; }
+		inline const _Ty& operator[](::std::size_t index) const { return _values[_first[index]]; }
+		inline const _Ty& front() const { return _values[*_first]; }
+		inline const _Ty& back() const { return _values[_last[-1]]; }
+		/// <summary>Position in the indexed list of every item of the range, in order.</summary>
+		inline const ::std::size_t* positions() const { return _first; }
+
+	private:
+		const _Ty *_values;
+		const ::std::size_t *_first, *_last;
+	};
+
+	namespace core {
+		/// <summary>
+		/// Lookups shared by <see cref="hashed_index"/> and <see cref="sorted_index"/>, written in terms of the equal_range of
+		/// <typeparamref name="_Index"/>, along with the checks which keep a changed list from being read through a stale index.
+		/// </summary>
+		/// <typeparam name="_Index">The index type deriving from this one.</typeparam>
+		/// <typeparam name="_Cont">The indexed list, which must be contiguous, such as a <see cref="linq::array"/>.</typeparam>
+		/// <typeparam name="_Fn">Type of the key selector.</typeparam>
+		template<class _Index, class _Cont, class _Fn>
+		class list_index {
+		public:
+			typedef typename _Cont::value_type value_type;
+			typedef ::std::decay_t<invoke_result_t<_Fn&, const value_type&>> key_type;
+
+			/// <summary>Finds the first item with the provided key, or null if there is none.</summary>
+			inline const value_type* find(const key_type &key) const {
+				index_range<value_type> found = _self().equal_range(key);
+				return found.empty() ? nullptr : &found.front();
+			}
+			/// <summary>Checks whether any item has the provided key.</summary>
+			inline bool contains(const key_type &key) const { return !_self().equal_range(key).empty(); }
+			/// <summary>Counts the items with the provided key.</summary>
+			inline ::std::size_t count(const key_type &key) const { return _self().equal_range(key).size(); }
+			/// <summary>Copies the items with the provided key into a new array, in the order the index holds them.</summary>
+			inline array<value_type> where(const key_type &key) const { return _self().equal_range(key).to_array(); }
+
+			/// <summary>
+			/// Index nested loop join: looks up the key of every item of <paramref name="outer"/> in the index, and merges
+			/// the item with each indexed item found. Only the outer list is read in full.
+			/// </summary>
+			/// <param name="outer">List whose items are looked up.</param>
+			/// <param name="outer_key">Lambda which selects the key of an item of the outer list.</param>
+			/// <param name="merge">Lambda given each outer item and indexed item with equal keys, which performs the merge.</param>
+			/// <returns>New array of merged items, in the order of the outer list.</returns>
+			template<class _Outer, class _OKey, class _Merge>
+			auto join(const _Outer &outer, _OKey &&outer_key, _Merge &&merge) const {
+				typedef typename _Outer::value_type outer_type;
+				typedef ::std::decay_t<invoke_result_t<_Merge&, const outer_type&, const value_type&>> result_type;
+				stage_scope stage("join", distance_hint(outer.begin(), outer.end()));
+				array<result_type> result;
+				for (const outer_type &item : outer) {
+					for (const value_type &match : _self().equal_range(outer_key(item))) {
+						result.push_back(merge(item, match));
+					}
+				}
+				stage.comparisons(distance_hint(outer.begin(), outer.end()));
+				stage.calls(distance_hint(outer.begin(), outer.end()) + result.size());
+				stage.output(result.size());
+				return result;
+			}
+
+			/// <summary>The indexed list.</summary>
+			inline const _Cont& source() const { return *_source; }
+			/// <summary>
+			/// Whether the list may have changed since the index was built: it was invalidated, or the list was resized or
+			/// reallocated. Items changed in place cannot be seen, so call <see cref="invalidate"/> or rebuild after doing so.
+			/// </summary>
+			inline bool stale() const { return _invalid || _source->data() != _data || _source->size() != _size; }
+			/// <summary>Marks the index as out of date, so that lookups throw until it is rebuilt.</summary>
+			inline void invalidate() { _invalid = true; }
+
+		protected:
+			list_index(const _Cont &source, _Fn selector) : _source(&source), _selector(::std::move(selector)), _data(nullptr), _size(0), _invalid(true) {}
+
+			/// <summary>Records the state of the list the index was just built from.</summary>
+			inline void _built() {
+				_data = _source->data();
+				_size = _source->size();
+				_invalid = false;
+			}
+			/// <summary>Throws <see cref="std::logic_error"/> if the index is <see cref="stale"/>.</summary>
+			inline void _check() const {
+				if (stale()) {
+					throw ::std::logic_error("the index is stale; rebuild it after changing the list");
+				}
+			}
+			inline index_range<value_type> _range(const ::std::size_t *first, const ::std::size_t *last) const { return index_range<value_type>(_source->data(), first, last); }
+
+			const _Cont *_source;
+			_Fn _selector;
+			::std::vector<::std::size_t> _positions;
+
+		private:
+			inline const _Index& _self() const { return static_cast<const _Index&>(*this); }
+
+			const value_type *_data;
+			::std::size_t _size;
+			bool _invalid;
+		};
+	}
+
+	/// <summary>
+	/// Hash index on the key selected from each item of a list, created by <see cref="array::build_index"/>. The items with
+	/// a given key are found in constant time, in the order they appear in the list. The index reads the list it was built
+	/// from, which must outlive it. Lookups throw <see cref="std::logic_error"/> once the index is <see cref="stale"/>:
+	/// after the list is resized or reallocated, or after <see cref="invalidate"/>. Call <see cref="rebuild"/> to bring it
+	/// up to date.
+	/// </summary>
+	/// <typeparam name="_Cont">The indexed list.</typeparam>
+	/// <typeparam name="_Fn">Type of the key selector.</typeparam>
+	template<class _Cont, class _Fn>
+	class hashed_index : public core::list_index<hashed_index<_Cont, _Fn>, _Cont, _Fn> {
+		typedef core::list_index<hashed_index<_Cont, _Fn>, _Cont, _Fn> base;
+	public:
+		typedef typename base::value_type value_type;
+		typedef typename base::key_type key_type;
+
+		hashed_index(const _Cont &source, _Fn selector) : base(source, ::std::move(selector)) { rebuild(); }
+
+		/// <summary>Finds the items with the provided key, in the order they appear in the list.</summary>
+		/// <exception cref="std::logic_error">Thrown if the index is stale.</exception>
+		index_range<value_type> equal_range(const key_type &key) const {
+			this->_check();
+			const ::std::size_t group = _table.find(key);
+			if (group == core::group_table<key_type>::npos) {
+				return this->_range(nullptr, nullptr);
+			}
+			return this->_range(this->_positions.data() + _offsets[group], this->_positions.data() + _offsets[group + 1]);
+		}
+		/// <summary>The distinct keys, in the order they are first found in the list.</summary>
+		inline const ::std::vector<key_type>& keys() const { return _table.keys(); }
+
+		/// <summary>Indexes the list again, reading every item.</summary>
+		void rebuild() {
+			const _Cont &source = *this->_source;
+			const ::std::size_t count = source.size();
+			core::group_table<key_type> table;
+			::std::vector<::std::uint32_t> ids(count);
+			for (::std::size_t c = 0; c < count; c++) {
+				ids[c] = static_cast<::std::uint32_t>(table.insert(this->_selector(source[c])));
+			}
+			// Counting sort of the positions by key, keeping the order of the list within each key
+			_offsets.assign(table.size() + 1, 0);
+			for (::std::uint32_t id : ids) {
+				_offsets[id + 1]++;
+			}
+			for (::std::size_t g = 0; g < table.size(); g++) {
+				_offsets[g + 1] += _offsets[g];
+			}
+			::std::vector<::std::size_t> fill(_offsets.begin(), _offsets.end() - 1);
+			this->_positions.resize(count);
+			for (::std::size_t c = 0; c < count; c++) {
+				this->_positions[fill[ids[c]]++] = c;
+			}
+			_table = ::std::move(table);
+			this->_built();
+		}
+
+	private:
+		core::group_table<key_type> _table;
+		::std::vector<::std::size_t> _offsets;
+	};
+
+	/// <summary>
+	/// Sorted index on the key selected from each item of a list, created by <see cref="array::build_sorted_index"/>. The items
+	/// with a given key, or with keys in a range, are found by binary search in O(log n), in ascending key order and then in
+	/// the order they appear in the list. Keys are compared with operator&lt;. The index reads the list it was built from,
+	/// which must outlive it, and is invalidated and rebuilt as a <see cref="hashed_index"/> is.
+	/// </summary>
+	/// <typeparam name="_Cont">The indexed list.</typeparam>
+	/// <typeparam name="_Fn">Type of the key selector.</typeparam>
+	template<class _Cont, class _Fn>
+	class sorted_index : public core::list_index<sorted_index<_Cont, _Fn>, _Cont, _Fn> {
+		typedef core::list_index<sorted_index<_Cont, _Fn>, _Cont, _Fn> base;
+	public:
+		typedef typename base::value_type value_type;
+		typedef typename base::key_type key_type;
+		using base::where;
+
+		sorted_index(const _Cont &source, _Fn selector) : base(source, ::std::move(selector)) { rebuild(); }
+
+		/// <summary>Finds the items with the provided key.</summary>
+		/// <exception cref="std::logic_error">Thrown if the index is stale.</exception>
+		inline index_range<value_type> equal_range(const key_type &key) const {
+			this->_check();
+			auto found = ::std::equal_range(_keys.begin(), _keys.end(), key);
+			return _range(found.first, found.second);
+		}
+		/// <summary>Finds the items with keys from <paramref name="low"/> to <paramref name="high"/> inclusive, in key order.</summary>
+		/// <exception cref="std::logic_error">Thrown if the index is stale.</exception>
+		inline index_range<value_type> range(const key_type &low, const key_type &high) const {
+			this->_check();
+			auto first = ::std::lower_bound(_keys.begin(), _keys.end(), low);
+			return _range(first, high < low ? first : ::std::upper_bound(first, _keys.end(), high));
+		}
+		/// <summary>Copies the items with keys from <paramref name="low"/> to <paramref name="high"/> inclusive into a new array, in key order.</summary>
+		inline array<value_type> where(const key_type &low, const key_type &high) const { return range(low, high).to_array(); }
+		/// <summary>Every item, in key order.</summary>
+		inline index_range<value_type> all() const {
+			this->_check();
+			return _range(_keys.begin(), _keys.end());
+		}
+		/// <summary>The key of every item, in ascending order.</summary>
+		inline const ::std::vector<key_type>& keys() const { return _keys; }
+
+		/// <summary>Indexes the list again, reading every item.</summary>
+		void rebuild() {
+			const _Cont &source = *this->_source;
+			auto orders = ::std::make_tuple(ascending(this->_selector));
+			this->_positions.clear();
+			this->_positions.reserve(source.size());
+			core::sort_by_keys(source.begin(), source.size(), orders, [this](::std::size_t position) { this->_positions.push_back(position); });
+			_keys.clear();
+			_keys.reserve(source.size());
+			for (::std::size_t position : this->_positions) {
+				_keys.emplace_back(this->_selector(source[position]));
+			}
+			this->_built();
+		}
+
+	private:
+		typedef typename ::std::vector<key_type>::const_iterator key_iterator;
+
+		inline index_range<value_type> _range(key_iterator first, key_iterator last) const {
+			const ::std::size_t *positions = this->_positions.data();
+			return base::_range(positions + (first - _keys.begin()), positions + (last - _keys.begin()));
+		}
+
+		::std::vector<key_type> _keys;
+	};
+
+#ifdef LINQ_USE_MMAP
+	/// <summary>
+	/// Read-only memory mapping of a file of fixed size records, viewed as a <see cref="linq::view"/> of those records.
+	/// The operating system pages the records in as the queries touch them, so querying a file never requires reading
+	/// it into memory first. Only available when <c>LINQ_USE_MMAP</c> is defined before including linq.h.
+	/// </summary>
+	/// <typeparam name="_Ty">The record type. Must be trivially copyable, as records are read straight from the file's bytes.</typeparam>
+	template<class _Ty>
+	class mapped_file : public view<_Ty> {
+		static_assert(::std::is_trivially_copyable<_Ty>::value, "mapped_file records must be trivially copyable");
+	public:
+		/// <summary>
+		/// Maps the file at the provided path.
+		/// </summary>
+		/// <param name="path">Path of the file to be mapped.</param>
+		/// <exception cref="std::system_error">Thrown if the file cannot be opened or mapped.</exception>
+		/// <exception cref="std::runtime_error">Thrown if the file's size is not a whole number of records.</exception>
+		explicit mapped_file(const ::std::string &path) : _address(nullptr), _bytes(0) {
+			_map(path);
+			if (_bytes % sizeof(_Ty) != 0) {
+				_unmap();
+				throw ::std::runtime_error("file size is not a multiple of the record size: " + path);
+			}
+			this->reset(static_cast<const _Ty*>(_address), _bytes / sizeof(_Ty));
+		}
+		mapped_file(mapped_file &&_Right) : view<_Ty>(_Right), _address(_Right._address), _bytes(_Right._bytes) {
+			_Right._address = nullptr;
+			_Right._bytes = 0;
+			_Right.reset(nullptr, 0);
+		}
+		mapped_file& operator=(mapped_file &&_Right) {
+			if (this != &_Right) {
+				_unmap();
+				static_cast<view<_Ty>&>(*this) = _Right;
+				_address = _Right._address;
+				_bytes = _Right._bytes;
+				_Right._address = nullptr;
+				_Right._bytes = 0;
+				_Right.reset(nullptr, 0);
+			}
+			return *this;
+		}
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+		~mapped_file() { _unmap(); }
+
+	private:
+#ifdef _WIN32
+		void _map(const ::std::string &path) {
+			HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				throw ::std::system_error(static_cast<int>(::GetLastError()), ::std::system_category(), "unable to open " + path);
+			}
+			LARGE_INTEGER size;
+			if (!::GetFileSizeEx(file, &size)) {
+				DWORD error = ::GetLastError();
+				::CloseHandle(file);
+				throw ::std::system_error(static_cast<int>(error), ::std::system_category(), "unable to size " + path);
+			}
+			_bytes = static_cast<::std::size_t>(size.QuadPart);
+			if (_bytes != 0) {
+				HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (mapping != nullptr) {
+					_address = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+					::CloseHandle(mapping);
+				}
+				if (_address == nullptr) {
+					DWORD error = ::GetLastError();
+					::CloseHandle(file);
+					throw ::std::system_error(static_cast<int>(error), ::std::system_category(), "unable to map " + path);
+				}
+			}
+			::CloseHandle(file);
+		}
+		void _unmap() {
+			if (_address != nullptr) {
+				::UnmapViewOfFile(_address);
+				_address = nullptr;
+			}
+		}
+#else
+		void _map(const ::std::string &path) {
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0) {
+				throw ::std::system_error(errno, ::std::generic_category(), "unable to open " + path);
+			}
+			struct stat info;
+			if (::fstat(fd, &info) != 0) {
+				int error = errno;
+				::close(fd);
+				throw ::std::system_error(error, ::std::generic_category(), "unable to size " + path);
+			}
+			_bytes = static_cast<::std::size_t>(info.st_size);
+			if (_bytes != 0) {
+				void *address = ::mmap(nullptr, _bytes, PROT_READ, MAP_SHARED, fd, 0);
+				if (address == MAP_FAILED) {
+					int error = errno;
+					::close(fd);
+					throw ::std::system_error(error, ::std::generic_category(), "unable to map " + path);
+				}
+				// Queries scan front to back, so ask for aggressive read-ahead
+				::madvise(address, _bytes, MADV_SEQUENTIAL);
+				_address = address;
+			}
+			::close(fd);
+		}
+		void _unmap() {
+			if (_address != nullptr) {
+				::munmap(_address, _bytes);
+				_address = nullptr;
+			}
+		}
+#endif
+
+		void *_address;
+		::std::size_t _bytes;
+	};
+#endif
+
+	/// <summary>
+	/// One line of text read by <see cref="from_stream"/> or <see cref="from_file"/>, without its line break (either
+	/// <c>\n</c> or <c>\r\n</c>). The characters are only valid until the parser the line is passed to returns. They are
+	/// always followed by a null character, so <see cref="c_str"/> can be handed straight to functions such as <c>std::strtol</c>.
+	/// </summary>
+	class text_line {
+	public:
+		text_line(const char *_Data, ::std::size_t _Size) : _data(_Data), _size(_Size) {}
+
+		inline const char* data() const { return _data; }
+		inline const char* c_str() const { return _data; }
+		inline ::std::size_t size() const { return _size; }
+		inline bool empty() const { return _size == 0; }
+		inline const char* begin() const { return _data; }
+		inline const char* end() const { return _data + _size; }
+		inline char operator[](::std::size_t index) const { return _data[index]; }
+		/// <summary>Copies the line into a string which outlives it.</summary>
+		inline ::std::string str() const { return ::std::string(_data, _size); }
+
+	private:
+		const char *_data;
+		::std::size_t _size;
+	};
+
+	namespace core {
+		/// <summary>Size of the chunks streamed queries read at a time, unless told otherwise.</summary>
+		static const ::std::size_t stream_chunk_size = ::std::size_t(1) << 20;
+
+		/// <summary>Record format of a text stream: each line is a record, made by the parser. See <see cref="linq::lines"/>.</summary>
+		template<class _Fn>
+		struct line_format {
+			_Fn parser;
+		};
+		/// <summary>Record format of a binary stream: fixed size records back to back. See <see cref="linq::records"/>.</summary>
+		template<class _Ty>
+		struct record_format {};
+		template<class _Ty>
+		struct is_stream_format : ::std::false_type {};
+		template<class _Fn>
+		struct is_stream_format<line_format<_Fn>> : ::std::true_type {};
+		template<class _Ty>
+		struct is_stream_format<record_format<_Ty>> : ::std::true_type {};
+
+		/// <summary>Line parser keeping each line as a string.</summary>
+		struct line_string {
+			inline ::std::string operator()(const text_line &line) const { return line.str(); }
+		};
+
+		/// <summary>
+		/// Reads a stream in fixed size chunks on a background thread, one chunk ahead of the consumer: while the consumer
+		/// works through one chunk, the next is read into the other of two buffers. However long the stream is, the reader
+		/// never holds more than those two chunks.
+		/// </summary>
+		class chunk_reader {
+		public:
+			/// <param name="stream">Stream to be read, which must outlive the reader.</param>
+			/// <param name="chunk_size">Size of each chunk in bytes.</param>
+			/// <param name="owned">Stream owned by the reader, such as a file it opened; otherwise null.</param>
+			chunk_reader(::std::istream &stream, ::std::size_t chunk_size, ::std::unique_ptr<::std::istream> owned = nullptr)
+				: _owned(::std::move(owned)), _stream(&stream), _chunk_size(::std::max<::std::size_t>(chunk_size, 1)),
+				_sizes(), _filled(0), _released(0), _taken(0), _done(false), _stop(false) {
+				for (auto &buffer : _buffers) {
+					buffer.reset(new char[_chunk_size]);
+				}
+				_thread = ::std::thread([this] { _read(); });
+			}
+			~chunk_reader() {
+				{
+					::std::lock_guard<::std::mutex> lock(_lock);
+					_stop = true;
+				}
+				_changed.notify_all();
+				_thread.join();
+			}
+			chunk_reader(const chunk_reader&) = delete;
+			chunk_reader& operator=(const chunk_reader&) = delete;
+
+			/// <summary>
+			/// Hands back the chunk returned by the previous call, and returns the next one, waiting for it to be read if it
+			/// has not been yet. Every chunk but the last holds exactly the chunk size. The chunk may be modified in place.
+			/// </summary>
+			/// <param name="data">Set to the first byte of the chunk.</param>
+			/// <param name="size">Set to the number of bytes in the chunk.</param>
+			/// <returns>True if a chunk was returned; false once the stream has ended.</returns>
+			/// <exception cref="std::runtime_error">Thrown, once the chunks before it are consumed, if reading the stream failed.</exception>
+			bool next(char *&data, ::std::size_t &size) {
+				::std::unique_lock<::std::mutex> lock(_lock);
+				if (_taken != _released) {
+					_released = _taken;
+					_changed.notify_all();
+				}
+				_changed.wait(lock, [this] { return _filled != _taken || _done; });
+				if (_filled == _taken) {
+					if (_error) {
+						::std::rethrow_exception(_error);
+					}
+					return false;
+				}
+				data = _buffers[_taken % 2].get();
+				size = _sizes[_taken % 2];
+				_taken++;
+				return true;
+			}
+
+		private:
+			void _read() {
+				try {
+					for (::std::size_t chunk = 0;; chunk++) {
+						{
+							// The consumer holds one chunk, so this one may only be read once the one before it was handed back
+							::std::unique_lock<::std::mutex> lock(_lock);
+							_changed.wait(lock, [&] { return chunk - _released < 2 || _stop; });
+							if (_stop) return;
+						}
+						_stream->read(_buffers[chunk % 2].get(), static_cast<::std::streamsize>(_chunk_size));
+						const ::std::size_t size = static_cast<::std::size_t>(_stream->gcount());
+						if (_stream->bad()) {
+							throw ::std::runtime_error("unable to read the stream");
+						}
+						const bool last = size < _chunk_size;
+						{
+							::std::lock_guard<::std::mutex> lock(_lock);
+							if (size != 0) {
+								_sizes[chunk % 2] = size;
+								_filled++;
+							}
+							_done = last;
+						}
+						_changed.notify_all();
+						if (last) return;
+					}
+				}
+				catch (...) {
+					{
+						::std::lock_guard<::std::mutex> lock(_lock);
+						_error = ::std::current_exception();
+						_done = true;
+					}
+					_changed.notify_all();
+				}
+			}
+
+			::std::unique_ptr<::std::istream> _owned;
+			::std::istream *_stream;
+			::std::size_t _chunk_size;
+			::std::unique_ptr<char[]> _buffers[2];
+			::std::size_t _sizes[2];
+			// Chunks read so far, handed back by the consumer, and handed to the consumer
+			::std::size_t _filled, _released, _taken;
+			bool _done, _stop;
+			::std::exception_ptr _error;
+			::std::mutex _lock;
+			::std::condition_variable _changed;
+			::std::thread _thread;
+		};
+
+		/// <summary>
+		/// Where a streamed query reads from: either a stream owned by the caller, which is read once, or a file which every
+		/// evaluation of the query opens and reads anew.
+		/// </summary>
+		class stream_source {
+		public:
+			stream_source(::std::istream &stream, ::std::size_t chunk_size) : _stream(&stream), _chunk_size(chunk_size), _binary(false) {}
+			stream_source(::std::string path, ::std::size_t chunk_size, bool binary)
+				: _stream(nullptr), _path(::std::move(path)), _chunk_size(chunk_size), _binary(binary) {}
+
+			/// <summary>
+			/// Starts reading the source, in chunks of the chunk size rounded down to a whole number of records.
+			/// </summary>
+			/// <param name="record_size">Size of each record, which no chunk may split; one for text.</param>
+			/// <exception cref="std::system_error">Thrown if the file cannot be opened.</exception>
+			::std::unique_ptr<chunk_reader> open(::std::size_t record_size) const {
+				const ::std::size_t chunk_size = ::std::max(_chunk_size - _chunk_size % record_size, record_size);
+				if (_stream != nullptr) {
+					return ::std::unique_ptr<chunk_reader>(new chunk_reader(*_stream, chunk_size));
+				}
+				::std::unique_ptr<::std::istream> file(new ::std::ifstream(_path, _binary ? ::std::ios::in | ::std::ios::binary : ::std::ios::in));
+				if (!*file) {
+					throw ::std::system_error(errno, ::std::generic_category(), "unable to open " + _path);
+				}
+				::std::istream &stream = *file;
+				return ::std::unique_ptr<chunk_reader>(new chunk_reader(stream, chunk_size, ::std::move(file)));
+			}
+
+		private:
+			::std::istream *_stream;
+			::std::string _path;
+			::std::size_t _chunk_size;
+			bool _binary;
+		};
+
+		/// <summary>
+		/// Enumerates the records a parser makes of each line of a stream, which is read in chunks by a <see cref="chunk_reader"/>.
+		/// Lines are parsed straight from the chunk they were read into; only a line split between two chunks is copied.
+		/// </summary>
+		template<class _Fn>
+		class line_enumerator {
+		public:
+			typedef ::std::decay_t<invoke_result_t<_Fn&, const text_line&>> value_type;
+			typedef const value_type& reference;
+
+			line_enumerator(stream_source _Source, _Fn _Parser) : _source(::std::move(_Source)), _parser(::std::move(_Parser)) {}
+
+			bool move_next() {
+				if (!_state) {
+					_state = ::std::make_shared<state>(_source.open(1));
+				}
+				state &s = *_state;
+				if (s.finished) return false;
+				s.split.clear();
+				while (true) {
+					if (s.next != s.last) {
+						char *end = static_cast<char*>(::std::memchr(s.next, '\n', static_cast<::std::size_t>(s.last - s.next)));
+						if (end != nullptr) {
+							char *first = s.next;
+							s.next = end + 1;
+							if (s.split.empty()) {
+								return _parse(s, first, end);
+							}
+							s.split.append(first, end);
+							return _parse_split(s);
+						}
+						// The rest of the line is in the next chunk, and this one is about to be handed back
+						s.split.append(s.next, s.last);
+						s.next = s.last;
+					}
+					::std::size_t size;
+					if (!s.reader->next(s.next, size)) {
+						s.finished = true;
+						return !s.split.empty() && _parse_split(s);
+					}
+					s.last = s.next + size;
+				}
+			}
+			inline reference current() const { return *_state->current; }
+			inline ::std::size_t size_hint() const { return 0; }
+
+		private:
+			struct state {
+				explicit state(::std::unique_ptr<chunk_reader> _Reader) : reader(::std::move(_Reader)), next(nullptr), last(nullptr), finished(false) {}
+				::std::unique_ptr<chunk_reader> reader;
+				char *next, *last;
+				::std::string split;
+				optional<value_type> current;
+				bool finished;
+			};
+
+			bool _parse(state &s, char *first, char *end) {
+				if (end != first && end[-1] == '\r') --end;
+				*end = '\0';
+				s.current.emplace(_parser(text_line(first, static_cast<::std::size_t>(end - first))));
+				return true;
+			}
+			bool _parse_split(state &s) {
+				if (!s.split.empty() && s.split.back() == '\r') s.split.pop_back();
+				s.current.emplace(_parser(text_line(s.split.c_str(), s.split.size())));
+				return true;
+			}
+
+			stream_source _source;
+			_Fn _parser;
+			// Created by the first move_next, so every copy of an unstarted enumerator reads on its own
+			::std::shared_ptr<state> _state;
+		};
+
+		/// <summary>
+		/// Enumerates the fixed size records of a binary stream, which is read in chunks by a <see cref="chunk_reader"/>.
+		/// Chunks hold a whole number of records, and each record is viewed in place in the chunk it was read into.
+		/// </summary>
+		template<class _Ty>
+		class record_enumerator {
+			static_assert(::std::is_trivially_copyable<_Ty>::value, "streamed records must be trivially copyable");
+			static_assert(alignof(_Ty) <= alignof(::std::max_align_t), "streamed records cannot be over-aligned");
+		public:
+			typedef _Ty value_type;
+			typedef const _Ty& reference;
+
+			explicit record_enumerator(stream_source _Source) : _source(::std::move(_Source)) {}
+
+			bool move_next() {
+				if (!_state) {
+					_state = ::std::make_shared<state>(_source.open(sizeof(_Ty)));
+				}
+				state &s = *_state;
+				if (s.current != nullptr) {
+					s.next += sizeof(_Ty);
+				}
+				while (s.next == s.last) {
+					::std::size_t size;
+					if (!s.reader->next(s.next, size)) {
+						s.current = nullptr;
+						s.last = s.next;
+						return false;
+					}
+					if (size % sizeof(_Ty) != 0) {
+						throw ::std::runtime_error("stream size is not a multiple of the record size");
+					}
+					s.last = s.next + size;
+				}
+				s.current = reinterpret_cast<const _Ty*>(s.next);
+				return true;
+			}
+			inline reference current() const { return *_state->current; }
+			inline ::std::size_t size_hint() const { return 0; }
+
+		private:
+			struct state {
+				explicit state(::std::unique_ptr<chunk_reader> _Reader) : reader(::std::move(_Reader)), next(nullptr), last(nullptr), current(nullptr) {}
+				::std::unique_ptr<chunk_reader> reader;
+				char *next, *last;
+				const _Ty *current;
+			};
+
+			stream_source _source;
+			::std::shared_ptr<state> _state;
+		};
+	}
+
+	/// <summary>
+	/// Record format for <see cref="from_stream"/> and <see cref="from_file"/> in which each line of text is a record, made
+	/// by the parser from the <see cref="text_line"/>.
+	/// </summary>
+	/// <param name="parser">Callable of the form <c>record (const linq::text_line &amp;line)</c>.</param>
+	template<class _Fn>
+	inline core::line_format<::std::decay_t<_Fn>> lines(_Fn &&parser) { return { ::std::forward<_Fn>(parser) }; }
+	/// <summary>
+	/// Record format for <see cref="from_stream"/> and <see cref="from_file"/> in which each line of text is a record, kept as a <see cref="std::string"/>.
+	/// </summary>
+	inline core::line_format<core::line_string> lines() { return {}; }
+	/// <summary>
+	/// Record format for <see cref="from_stream"/> and <see cref="from_file"/> of a binary stream of fixed size records
+	/// of type <typeparamref name="_Ty"/>, back to back, such as one written out from an array of them.
+	/// </summary>
+	/// <typeparam name="_Ty">The record type. Must be trivially copyable, as records are read straight from the stream's bytes.</typeparam>
+	template<class _Ty>
+	inline core::record_format<_Ty> records() { return {}; }
+
+	/// <summary>
+	/// Starts a deferred <see cref="linq::query"/> over the records of a stream. The stream is read in chunks, on a
+	/// background thread which reads the next chunk while the query works through the current one, and each chunk is handed
+	/// back once the query is done with it. However large the stream, the query holds two chunks plus whatever its stages
+	/// and terminal keep, so filtering, projecting and aggregating a stream takes the same memory for any length.
+	/// The stream is read once: another evaluation of the query carries on from where the last one stopped reading, which
+	/// may be up to two chunks past the last record it used.
+	/// </summary>
+	/// <param name="stream">Stream to be read, which must outlive the query.</param>
+	/// <param name="format">Format of the records: <see cref="lines"/> or <see cref="records"/>.</param>
+	/// <param name="chunk_size">Size in bytes of the chunks read at a time.</param>
+	template<class _Fn>
+	inline query<core::line_enumerator<_Fn>> from_stream(::std::istream &stream, core::line_format<_Fn> format, ::std::size_t chunk_size = core::stream_chunk_size) {
+		return query<core::line_enumerator<_Fn>>(core::line_enumerator<_Fn>(core::stream_source(stream, chunk_size), ::std::move(format.parser)));
+	}
+	template<class _Ty>
+	inline query<core::record_enumerator<_Ty>> from_stream(::std::istream &stream, core::record_format<_Ty>, ::std::size_t chunk_size = core::stream_chunk_size) {
+		return query<core::record_enumerator<_Ty>>(core::record_enumerator<_Ty>(core::stream_source(stream, chunk_size)));
+	}
+	/// <summary>
+	/// Starts a deferred <see cref="linq::query"/> over the records the parser makes of each line of a text stream. See
+	/// <see cref="from_stream"/>.
+	/// </summary>
+	/// <param name="stream">Stream to be read, which must outlive the query.</param>
+	/// <param name="parser">Callable of the form <c>record (const linq::text_line &amp;line)</c>.</param>
+	/// <param name="chunk_size">Size in bytes of the chunks read at a time.</param>
+	template<class _Fn, class = ::std::enable_if_t<!core::is_stream_format<::std::decay_t<_Fn>>::value>>
+	inline query<core::line_enumerator<::std::decay_t<_Fn>>> from_stream(::std::istream &stream, _Fn &&parser, ::std::size_t chunk_size = core::stream_chunk_size) {
+		return from_stream(stream, lines(::std::forward<_Fn>(parser)), chunk_size);
+	}
+	/// <summary>
+	/// Starts a deferred <see cref="linq::query"/> over the records of a file, read in chunks like <see cref="from_stream"/>.
+	/// The file is opened by each evaluation of the query, so unlike a stream it can be queried any number of times.
+	/// </summary>
+	/// <param name="path">Path of the file to be read.</param>
+	/// <param name="format">Format of the records: <see cref="lines"/> or <see cref="records"/>.</param>
+	/// <param name="chunk_size">Size in bytes of the chunks read at a time.</param>
+	/// <exception cref="std::system_error">Thrown by the evaluation of the query if the file cannot be opened.</exception>
+	template<class _Fn>
+	inline query<core::line_enumerator<_Fn>> from_file(const ::std::string &path, core::line_format<_Fn> format, ::std::size_t chunk_size = core::stream_chunk_size) {
+		return query<core::line_enumerator<_Fn>>(core::line_enumerator<_Fn>(core::stream_source(path, chunk_size, false), ::std::move(format.parser)));
+	}
+	template<class _Ty>
+	inline query<core::record_enumerator<_Ty>> from_file(const ::std::string &path, core::record_format<_Ty>, ::std::size_t chunk_size = core::stream_chunk_size) {
+		return query<core::record_enumerator<_Ty>>(core::record_enumerator<_Ty>(core::stream_source(path, chunk_size, true)));
+	}
+
+	template<class _Ty>
+	class channel;
+
+	namespace core {
+		/// <summary>Size of a cache line, by which the positions shared between the threads of a <see cref="channel"/> are kept apart.</summary>
+		static const ::std::size_t cache_line = 64;
+		/// <summary>Number of times a <see cref="channel"/> retries before putting a waiting thread to sleep.</summary>
+		static const ::std::size_t channel_spins = 64;
+
+		/// <summary>Thrown when a batch is sent to a <see cref="channel"/> which has been closed.</summary>
+		inline void throw_closed() {
+			throw ::std::logic_error("the channel is closed");
+		}
+
+		/// <summary>
+		/// Enumerates the items received from a <see cref="channel"/>, a batch at a time, waiting while it is empty and ending
+		/// once it is closed and drained. Each batch is handed back to the producers for reuse when the next one is received.
+		/// </summary>
+		template<class _Ty>
+		class channel_enumerator {
+		public:
+			typedef _Ty value_type;
+			typedef const _Ty& reference;
+
+			explicit channel_enumerator(channel<_Ty> &_Source) : _channel(&_Source) {}
+
+			bool move_next() {
+				if (!_state) {
+					_state = ::std::make_shared<state>();
+				}
+				state &s = *_state;
+				if (++s.next < s.batch.size()) return true;
+				s.next = 0;
+				return _channel->receive(s.batch);
+			}
+			inline reference current() const { return _state->batch[_state->next]; }
+			inline ::std::size_t size_hint() const { return 0; }
+
+		private:
+			struct state {
+				state() : next(0) {}
+				::std::vector<_Ty> batch;
+				::std::size_t next;
+			};
+
+			channel<_Ty> *_channel;
+			// Created by the first move_next, so every copy of an unstarted enumerator receives on its own
+			::std::shared_ptr<state> _state;
+		};
+	}
+
+	/// <summary>
+	/// Bounded queue of batches of items, handed from producer threads to a consumer without locks. A query started with
+	/// <see cref="lazy"/> runs on the consumer thread as the batches arrive, so items are filtered, projected and aggregated
+	/// while producers are still making more, and a streaming query hands on its results as soon as each batch is through.
+	/// <para>
+	/// The queue is a ring of batch slots, each with a sequence number telling whether it is free or filled for the
+	/// current lap. Any number of producers claim free slots with a compare-and-swap, and a single consumer takes filled
+	/// slots in order. Batches are <see cref="std::vector"/>s swapped in and out of the slots, so the storage of a batch
+	/// the consumer is done with goes back to a producer, and a channel in steady state allocates nothing.
+	/// </para>
+	/// <para>
+	/// A full ring is backpressure: <see cref="send"/> waits for the consumer to take a batch, while <see cref="try_send"/>
+	/// returns false. A waiting thread retries briefly, then sleeps until it is woken; threads which never wait never take
+	/// a lock. <see cref="close"/> ends the stream once the batches already sent are consumed.
+	/// </para>
+	/// </summary>
+	/// <typeparam name="_Ty">Type of the items.</typeparam>
+	template<class _Ty>
+	class channel {
+	public:
+		/// <summary>
+		/// Batches items on a producer thread and sends each batch once it holds <see cref="batch_size"/> items. Give each
+		/// producer thread its own writer. Destroying the writer sends the last, partly filled batch.
+		/// </summary>
+		class writer {
+		public:
+			explicit writer(channel &target) : _channel(&target) { _items.reserve(target.batch_size()); }
+			~writer() {
+				try { flush(); }
+				catch (...) {}
+			}
+			writer(const writer&) = delete;
+			writer& operator=(const writer&) = delete;
+
+			/// <summary>Adds an item to the batch, sending the batch if that fills it.</summary>
+			inline void push(const _Ty &item) { emplace(item); }
+			inline void push(_Ty &&item) { emplace(::std::move(item)); }
+			/// <summary>Constructs an item in place in the batch, sending the batch if that fills it.</summary>
+			template<class... _Args>
+			inline void emplace(_Args &&...args) {
+				_items.emplace_back(::std::forward<_Args>(args)...);
+				if (_items.size() >= _channel->batch_size()) flush();
+			}
+			/// <summary>
+			/// Sends the items batched so far without waiting for the batch to fill, waiting while the channel is full. Call it
+			/// when items arrive slowly, so the consumer does not wait on a partly filled batch.
+			/// </summary>
+			/// <exception cref="std::logic_error">Thrown if the channel is closed.</exception>
+			void flush() {
+				if (_items.empty()) return;
+				_channel->send(_items);
+				if (_items.capacity() < _channel->batch_size()) _items.reserve(_channel->batch_size());
+			}
+
+		private:
+			channel *_channel;
+			::std::vector<_Ty> _items;
+		};
+
+		/// <param name="capacity">Number of batches the ring holds, rounded up to a power of two of at least two.</param>
+		/// <param name="batch_size">Number of items a <see cref="writer"/> batches before sending them.</param>
+		explicit channel(::std::size_t capacity = 64, ::std::size_t batch_size = 1024)
+			: _batch_size(::std::max<::std::size_t>(batch_size, 1)), _tail(0), _head(0), _closed(false), _sleepers(0) {
+			// A slot holding a batch must never look free to the producers of the next position, so there are at least two
+			::std::size_t slots = 2;
+			while (slots < capacity) slots *= 2;
+			_cells.reset(new cell[slots]);
+			_mask = slots - 1;
+			for (::std::size_t c = 0; c < slots; c++) {
+				_cells[c].sequence.store(c, ::std::memory_order_relaxed);
+			}
+		}
+		channel(const channel&) = delete;
+		channel& operator=(const channel&) = delete;
+
+		/// <summary>Number of batches the ring holds.</summary>
+		inline ::std::size_t capacity() const { return _mask + 1; }
+		/// <summary>Number of items a <see cref="writer"/> batches before sending them.</summary>
+		inline ::std::size_t batch_size() const { return _batch_size; }
+		/// <summary>Whether <see cref="close"/> has been called.</summary>
+		inline bool closed() const { return _closed.load(::std::memory_order_acquire); }
+
+		/// <summary>
+		/// Sends a batch if the ring has room for it, without waiting. Safe to call from any number of producer threads.
+		/// </summary>
+		/// <param name="batch">The items to be sent. On success it is swapped for an empty batch whose storage can be reused.</param>
+		/// <returns>True if the batch was sent, or was empty; false if the ring is full.</returns>
+		/// <exception cref="std::logic_error">Thrown if the channel is closed.</exception>
+		bool try_send(::std::vector<_Ty> &batch) {
+			if (batch.empty()) return true;
+			if (_closed.load(::std::memory_order_relaxed)) core::throw_closed();
+			::std::size_t pos = _tail.load(::std::memory_order_relaxed);
+			for (;;) {
+				const ::std::ptrdiff_t lap = static_cast<::std::ptrdiff_t>(_cells[pos & _mask].sequence.load(::std::memory_order_acquire) - pos);
+				if (lap == 0) {
+					if (_tail.compare_exchange_weak(pos, pos + 1, ::std::memory_order_relaxed)) break;
+				}
+				else if (lap < 0) {
+					// The slot still holds the batch sent a lap ago
+					return false;
+				}
+				else {
+					pos = _tail.load(::std::memory_order_relaxed);
+				}
+			}
+			cell &slot = _cells[pos & _mask];
+			slot.items.swap(batch);
+			slot.sequence.store(pos + 1, ::std::memory_order_release);
+			_notify();
+			return true;
+		}
+		/// <summary>
+		/// Sends a batch, waiting while the ring is full. Safe to call from any number of producer threads.
+		/// </summary>
+		/// <param name="batch">The items to be sent. It is swapped for an empty batch whose storage can be reused.</param>
+		/// <exception cref="std::logic_error">Thrown if the channel is closed, including while waiting.</exception>
+		void send(::std::vector<_Ty> &batch) {
+			for (::std::size_t spins = 0; !try_send(batch); spins++) {
+				if (spins < core::channel_spins) {
+					::std::this_thread::yield();
+					continue;
+				}
+				_wait([this] {
+					const ::std::size_t pos = _tail.load(::std::memory_order_relaxed);
+					return _cells[pos & _mask].sequence.load(::std::memory_order_acquire) == pos || _closed.load(::std::memory_order_relaxed);
+				});
+			}
+		}
+
+		/// <summary>
+		/// Receives the next batch if one has arrived, without waiting. Only one thread may receive from a channel at a time.
+		/// </summary>
+		/// <param name="batch">Replaced by the items of the next batch. Its storage is handed back to the producers.</param>
+		/// <returns>True if a batch was received; otherwise false, leaving <paramref name="batch"/> empty.</returns>
+		bool try_receive(::std::vector<_Ty> &batch) {
+			batch.clear();
+			cell &slot = _cells[_head & _mask];
+			if (slot.sequence.load(::std::memory_order_acquire) != _head + 1) return false;
+			slot.items.swap(batch);
+			slot.sequence.store(_head + _mask + 1, ::std::memory_order_release);
+			_head++;
+			_notify();
+			return true;
+		}
+		/// <summary>
+		/// Receives the next batch, waiting until one arrives. Only one thread may receive from a channel at a time.
+		/// </summary>
+		/// <param name="batch">Replaced by the items of the next batch. Its storage is handed back to the producers.</param>
+		/// <returns>True if a batch was received; false once the channel is closed and every batch sent has been received.</returns>
+		/// <exception cref="std::exception">Rethrows the error the channel was closed with, once every batch sent has been received.</exception>
+		bool receive(::std::vector<_Ty> &batch) {
+			for (::std::size_t spins = 0;; spins++) {
+				if (try_receive(batch)) return true;
+				if (_drained()) {
+					if (_error) ::std::rethrow_exception(_error);
+					return false;
+				}
+				if (spins < core::channel_spins) {
+					::std::this_thread::yield();
+					continue;
+				}
+				_wait([this] { return _cells[_head & _mask].sequence.load(::std::memory_order_acquire) == _head + 1 || _drained(); });
+			}
+		}
+
+		/// <summary>
+		/// Ends the stream: the consumer receives the batches already sent, then finds the end. Call it once every producer
+		/// has finished sending, after flushing their writers.
+		/// </summary>
+		void close() {
+			_closed.store(true);
+			{
+				::std::lock_guard<::std::mutex> lock(_lock);
+			}
+			_changed.notify_all();
+		}
+		/// <summary>
+		/// Ends the stream with an error, such as one caught by a producer, which the consumer rethrows after receiving the
+		/// batches already sent.
+		/// </summary>
+		void close(::std::exception_ptr error) {
+			_error = ::std::move(error);
+			close();
+		}
+
+		/// <summary>
+		/// Starts a deferred <see cref="linq::query"/> over the items received from this channel. Evaluating the query, on
+		/// the consumer thread, receives batches until the channel is closed; stages such as where and select handle each
+		/// batch as it arrives, and iterating the query hands on every result as soon as it is made. Items are received only
+		/// once, so another evaluation carries on from where the last one stopped. The channel must outlive the query.
+		/// </summary>
+		inline query<core::channel_enumerator<_Ty>> lazy() { return query<core::channel_enumerator<_Ty>>(core::channel_enumerator<_Ty>(*this)); }
+
+	private:
+		struct cell {
+			// The position in the stream of the next batch the slot can take, or that plus one once it holds that batch
+			::std::atomic<::std::size_t> sequence;
+			::std::vector<_Ty> items;
+		};
+
+		/// <summary>Whether the channel is closed and every batch claimed by a producer has been received.</summary>
+		inline bool _drained() const { return _closed.load(::std::memory_order_acquire) && _tail.load(::std::memory_order_acquire) == _head; }
+		/// <summary>
+		/// Sleeps until the condition holds. Both registering as a sleeper and checking for sleepers in <see cref="_notify"/>
+		/// modify the count, and so are ordered: a change made by another thread is either seen by the condition, or that
+		/// thread sees the sleeper and wakes it.
+		/// </summary>
+		template<class _Pr>
+		void _wait(_Pr condition) {
+			::std::unique_lock<::std::mutex> lock(_lock);
+			_sleepers.fetch_add(1, ::std::memory_order_acq_rel);
+			_changed.wait(lock, condition);
+			_sleepers.fetch_sub(1, ::std::memory_order_relaxed);
+		}
+		/// <summary>Wakes the sleeping threads, if there are any, after a batch was sent or received.</summary>
+		inline void _notify() {
+			if (_sleepers.fetch_add(0, ::std::memory_order_acq_rel) == 0) return;
+			{
+				::std::lock_guard<::std::mutex> lock(_lock);
+			}
+			_changed.notify_all();
+		}
+
+		::std::unique_ptr<cell[]> _cells;
+		::std::size_t _mask, _batch_size;
+		// The positions written by the producers and by the consumer are kept on cache lines of their own
+		char _pad0[core::cache_line];
+		::std::atomic<::std::size_t> _tail;
+		char _pad1[core::cache_line];
+		::std::size_t _head;
+		char _pad2[core::cache_line];
+		::std::atomic<bool> _closed;
+		::std::atomic<::std::size_t> _sleepers;
+		::std::exception_ptr _error;
+		::std::mutex _lock;
+		::std::condition_variable _changed;
+	};
+
+	/// <summary>
+	/// Starts a deferred <see cref="linq::query"/> over the items received from the provided <see cref="channel"/>. See <see cref="channel::lazy"/>.
+	/// </summary>
+	template<class _Ty>
+	inline query<core::channel_enumerator<_Ty>> lazy(channel<_Ty> &source) { return source.lazy(); }
+}
+
+
+#ifdef LINQ_CHECK_ALLOCATIONS
+// Counts every heap allocation made by the program, for linq::allocation_guard and the profiler, by replacing the global
+// operator new and delete. As the replacements are not inline, define LINQ_CHECK_ALLOCATIONS in exactly one translation unit of the program,
+// such as the one holding its tests.
+#include <cstdlib>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+namespace linq {
+	/// <summary>
+	/// Test helper asserting that a query has reached a steady state, in which running it again allocates nothing. Create
+	/// the guard after warming the query up, run it as often as needed, then call <see cref="check"/>. Allocations are counted
+	/// across the whole program, so nothing else should be allocating while a guard is checked.
+	/// </summary>
+	class allocation_guard {
+	public:
+		allocation_guard() : _start(core::allocations().count.load()) {}
+
+		/// <summary>Number of heap allocations made since the guard was created or last reset.</summary>
+		inline ::std::size_t allocations() const { return core::allocations().count.load() - _start; }
+		/// <summary>Starts counting again from zero.</summary>
+		inline void reset() { _start = core::allocations().count.load(); }
+		/// <summary>
+		/// Throws <see cref="std::logic_error"/> if anything was allocated since the guard was created or last reset.
+		/// </summary>
+		/// <exception cref="std::logic_error">Thrown if any heap allocation was made.</exception>
+		void check() const {
+			const ::std::size_t count = allocations();
+			if (count != 0) {
+				throw ::std::logic_error(::std::to_string(count) + " heap allocation(s) made in steady state");
+			}
+		}
+
+	private:
+		::std::size_t _start;
+	};
+}
+
+void* operator new(::std::size_t size) {
+	linq::core::allocations().count.fetch_add(1, ::std::memory_order_relaxed);
+	linq::core::allocations().bytes.fetch_add(size, ::std::memory_order_relaxed);
+	if (void *ptr = ::std::malloc(size ? size : 1)) return ptr;
+	throw ::std::bad_alloc();
+}
+void* operator new[](::std::size_t size) { return ::operator new(size); }
+void* operator new(::std::size_t size, const ::std::nothrow_t&) noexcept {
+	try { return ::operator new(size); }
+	catch (...) { return nullptr; }
+}
+void* operator new[](::std::size_t size, const ::std::nothrow_t&) noexcept { return ::operator new(size, ::std::nothrow); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+// The replacements free what the replaced operator new took from malloc, which GCC cannot see once they are inlined
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *ptr) noexcept { ::std::free(ptr); }
+void operator delete[](void *ptr) noexcept { ::std::free(ptr); }
+void operator delete(void *ptr, ::std::size_t) noexcept { ::std::free(ptr); }
+void operator delete[](void *ptr, ::std::size_t) noexcept { ::std::free(ptr); }
+#ifdef __cpp_aligned_new
+// Over-aligned types (C++17) go through their own overloads, which have to be counted as well
+void* operator new(::std::size_t size, ::std::align_val_t align) {
+	linq::core::allocations().count.fetch_add(1, ::std::memory_order_relaxed);
+	linq::core::allocations().bytes.fetch_add(size, ::std::memory_order_relaxed);
+	const ::std::size_t alignment = static_cast<::std::size_t>(align);
+	// aligned_alloc wants a size which is a multiple of the alignment
+	const ::std::size_t rounded = size ? (size + alignment - 1) / alignment * alignment : alignment;
+#ifdef _WIN32
+	if (void *ptr = ::_aligned_malloc(rounded, alignment)) return ptr;
+#else
+	if (void *ptr = ::std::aligned_alloc(alignment, rounded)) return ptr;
+#endif
+	throw ::std::bad_alloc();
+}
+void* operator new[](::std::size_t size, ::std::align_val_t align) { return ::operator new(size, align); }
+void* operator new(::std::size_t size, ::std::align_val_t align, const ::std::nothrow_t&) noexcept {
+	try { return ::operator new(size, align); }
+	catch (...) { return nullptr; }
+}
+void* operator new[](::std::size_t size, ::std::align_val_t align, const ::std::nothrow_t&) noexcept { return ::operator new(size, align, ::std::nothrow); }
+#ifdef _WIN32
+void operator delete(void *ptr, ::std::align_val_t) noexcept { ::_aligned_free(ptr); }
+#else
+void operator delete(void *ptr, ::std::align_val_t) noexcept { ::std::free(ptr); }
+#endif
+void operator delete[](void *ptr, ::std::align_val_t align) noexcept { ::operator delete(ptr, align); }
+void operator delete(void *ptr, ::std::size_t, ::std::align_val_t align) noexcept { ::operator delete(ptr, align); }
+void operator delete[](void *ptr, ::std::size_t, ::std::align_val_t align) noexcept { ::operator delete(ptr, align); }
+#endif
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+#endif
 
 #ifdef LINQ_USE_MACROS
 #ifndef FROM
@@ -361,8 +9546,27 @@ namespace linq {
 	/// </summary>
 	/// <param name="arr">The array to be passed through as a result.</param>
 	/// <returns>The same provided <see cref="arr"/>.</returns>
-	template<class _Ty>
-	inline array<_Ty> from(const array<_Ty> &arr) { return arr; }
+	template<class _Ty, class _Alloc>
+	inline array<_Ty, _Alloc> from(const array<_Ty, _Alloc> &arr) { return arr; }
+	/// <summary>
+	/// Pass-through function to make things uniform with the <see cref="FROM"/> macro, moving the provided temporary array.
+	/// </summary>
+	/// <param name="arr">The array to be passed through as a result.</param>
+	/// <returns>The same provided <see cref="arr"/>.</returns>
+	template<class _Ty, class _Alloc>
+	inline array<_Ty, _Alloc> from(array<_Ty, _Alloc> &&arr) { return ::std::move(arr); }
+	/// <summary>
+	/// Pass-through function to make things uniform with the <see cref="FROM"/> macro when given a deferred query.
+	/// </summary>
+	/// <param name="q">The query to be passed through as a result.</param>
+	/// <returns>The same provided <see cref="q"/>.</returns>
+	template<class _Enum>
+	inline query<_Enum> from(const query<_Enum> &q) { return q; }
+	/// <summary>
+	/// Pass-through function allowing a <see cref="linq::fixed_array"/> to be queried with the macros, at compile time too.
+	/// </summary>
+	template<class _Ty, ::std::size_t _Cap>
+	constexpr const fixed_array<_Ty, _Cap>& from(const fixed_array<_Ty, _Cap> &arr) { return arr; }
 }
 #endif
 #endif